@@ -1,11 +1,14 @@
 #include "Core/ImGuiManager.h"
 #include "Core/ErrorManager.h"
+#include "Core/Benchmark.h"
 
 #include "Renderer/VertexBuffer.h"
 #include "Renderer/IndexBuffer.h"
 #include "Renderer/VertexBufferLayout.h"
 #include "Renderer/VertexArray.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/FrameUniforms.h"
 #include "Renderer/Shader.h"
 
 #include "EntityManager/DrawList.h"
@@ -90,8 +93,8 @@ int main(int, char**)
 	float unit_shape_length = 1.0f;
 
 	// Enable blending for supporting transparent shapes
-	__glCallVoid(glEnable(GL_BLEND));
-	__glCallVoid(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	RenderState::set_blend(true);
+	RenderState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	// Line width for GL_LINES
 	__glCallVoid(glLineWidth(5.0f));
@@ -129,21 +132,18 @@ int main(int, char**)
 	// Sheet initializations
 	Angel::mat4 model_sheet_matrix = Angel::Translate(sheet_pos)
 		* Angel::Scale(Angel::vec3((float)width, (float)height, 1.0f));
-	Angel::mat4 MVP_mat_sheet = projection_matrix * view_matrix * model_sheet_matrix;
 
 	// Selection initializations
 	Angel::vec3 selector_pos(0.0f, 0.0f, 0.0f);
 	Angel::vec3 selector_scale(1, 1, 1.0f); // 1px selector box
 	Angel::mat4 model_selector_box = Angel::Translate(selector_pos)
 		* Angel::Scale(selector_scale);
-	Angel::mat4 MVP_selector_box = projection_matrix * view_matrix * model_selector_box;
 
 	// Drawer Box initializations
 	Angel::vec3 drawer_pos(0.0f, 0.0f, 0.0f);
 	Angel::vec3 drawer_scale(1, 1, 1.0f); // 1px selector box
 	Angel::mat4 model_drawer_box = Angel::Translate(drawer_pos)
 		* Angel::Scale(drawer_scale);
-	Angel::mat4 MVP_drawer_box = projection_matrix * view_matrix * model_drawer_box;
 
 	// Selection State
 	std::vector<ShapeModel*> cur_selections{};
@@ -153,6 +153,10 @@ int main(int, char**)
 
 	// DrawList
 	DrawList list(projection_matrix, view_matrix);
+	list.set_draw_mode(DrawList::DrawMode::Batched);
+	list.set_lod(true);
+	// Arena the next scene is loaded into, handed over to the list once a load succeeds
+	SceneArena* load_arena = nullptr;
 
 	// UndoRedo States
 	UndoRedoStack undo_redo(&list);
@@ -182,7 +186,6 @@ int main(int, char**)
 	Angel::vec3 polygon_add_vertex_line_scale;
 	Angel::vec3 polygon_add_vertex_line_rotation;
 	Angel::mat4 model_polygon_add_vertex_line;
-	Angel::mat4 MVP_polygon_add_vertex_line;
 
 	// Other States
 	bool should_update_sheet = true;
@@ -208,6 +211,8 @@ int main(int, char**)
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		RenderState::begin_frame();
+		GLErrorCheck::begin_frame();
 		// Old mouse pos & state
 		Angel::vec2 old_mouse_pos((float)window_input.m_mouse_x, (float)window_input.m_mouse_y);
 		Input::ButtonState mouse_previous_state = window_input.m_lmb_state;
@@ -288,18 +293,17 @@ int main(int, char**)
 				{
 					ShapeModel* clipboard_item;
 					ShapeModel::StaticShape type = selected_item->shape_def();
-					Angel::vec4* colour = new Angel::vec4(selected_item->color());
 					if (type == ShapeModel::StaticShape::NONE)
 					{
-						std::vector<Angel::vec3> poly_coords = selected_item->model_coords();
-						clipboard_item = new ShapeModel(poly_coords, colour);
+						clipboard_item = new ShapeModel(selected_item->model_coords(), selected_item->color());
 					}
 					else
 					{
-						Angel::vec3* pos = new Angel::vec3(selected_item->position());
-						Angel::vec3* rot = new Angel::vec3(selected_item->rotation());
-						Angel::vec3* scale = new Angel::vec3(selected_item->scale());
-						clipboard_item = new ShapeModel(type, pos, rot, scale, colour);
+						clipboard_item = new ShapeModel(type,
+							selected_item->position(),
+							selected_item->rotation(),
+							selected_item->scale(),
+							selected_item->color());
 					}
 					clipboard.push_back(clipboard_item);
 				}
@@ -338,18 +342,17 @@ int main(int, char**)
 				{
 					ShapeModel* pasted_shape;
 					ShapeModel::StaticShape type = clipboard_item->shape_def();
-					Angel::vec4* colour = new Angel::vec4(clipboard_item->color());
 					if (type == ShapeModel::StaticShape::NONE)
 					{
-						std::vector<Angel::vec3> poly_coords = clipboard_item->model_coords();
-						pasted_shape = new ShapeModel(poly_coords, colour);
+						pasted_shape = new ShapeModel(clipboard_item->model_coords(), clipboard_item->color());
 					}
 					else
 					{
-						Angel::vec3* pos = new Angel::vec3(clipboard_item->position());
-						Angel::vec3* rot = new Angel::vec3(clipboard_item->rotation());
-						Angel::vec3* scale = new Angel::vec3(clipboard_item->scale());
-						pasted_shape = new ShapeModel(type, pos, rot, scale, colour);
+						pasted_shape = new ShapeModel(type,
+							clipboard_item->position(),
+							clipboard_item->rotation(),
+							clipboard_item->scale(),
+							clipboard_item->color());
 					}
 					pasted_shapes.push_back(pasted_shape);
 				}
@@ -486,7 +489,6 @@ int main(int, char**)
 					ShapeModel* s_release = list.frontmost_shape_2d(OrthogtraphicCamera::map_from_global(window_input.m_mouse_release_x, window_input.m_mouse_release_y));
 					if (s_press != nullptr && s_release != nullptr && s_release == s_press)
 					{
-						undo_redo.clear_stacks();
 						bool in_selections = false;
 						for (auto* selection : cur_selections)
 						{
@@ -498,7 +500,7 @@ int main(int, char**)
 						if (!in_selections ||
 							in_selections && cur_selections.size() < 2)
 						{
-							list.remove_shape(s_release);
+							undo_redo.remove_shape(s_release);
 							cur_selections.clear();
 						}
 						else
@@ -510,7 +512,7 @@ int main(int, char**)
 							}
 							for (auto& item : cur_selections)
 							{
-								list.remove_shape(item);
+								undo_redo.remove_shape(item);
 							}
 							cur_selections.clear();
 						}
@@ -553,15 +555,13 @@ int main(int, char**)
 
 						if (radio_button_cur != (int)RadioButtons::DrawPoly)
 						{
-							auto* shape_pos = new Angel::vec3(mid_point);
-							auto* shape_rot = new Angel::vec3(0.0f, 0.0f, 0.0f);
-							auto* shape_scale = new Angel::vec3(std::abs(drawer_scale.x), std::abs(drawer_scale.y), drawer_scale.z);
-							auto* shape_color = new Angel::vec4(color_draw[0],
+							Angel::vec3 shape_scale(std::abs(drawer_scale.x), std::abs(drawer_scale.y), drawer_scale.z);
+							Angel::vec4 shape_color(color_draw[0],
 								color_draw[1],
 								color_draw[2],
 								color_draw[3]);
 
-							auto* new_shape = new ShapeModel(shape_def, shape_pos, shape_rot, shape_scale, shape_color);
+							auto* new_shape = new ShapeModel(shape_def, mid_point, Angel::vec3(0.0f, 0.0f, 0.0f), shape_scale, shape_color);
 							list.add_shape(new_shape);
 							cur_selections.clear();
 							new_shape->select();
@@ -605,7 +605,7 @@ int main(int, char**)
 					}
 					else if (polygon_mouse_model_coords.size() == 3)
 					{
-						auto* shape_color = new Angel::vec4(color_draw[0],
+						Angel::vec4 shape_color(color_draw[0],
 							color_draw[1],
 							color_draw[2],
 							color_draw[3]);
@@ -616,6 +616,7 @@ int main(int, char**)
 					{
 						ASSERT(new_polygon != nullptr);
 						new_polygon->push_back_vertex(poly_vertex);
+						list.on_shape_modified(new_polygon);
 					}
 				}
 			}
@@ -664,7 +665,7 @@ int main(int, char**)
 			{
 				if (radio_button_cur == (int)RadioButtons::Select)
 				{
-					unsigned int num_selections = (uint16_t)cur_selections.size();
+					unsigned int num_selections = (unsigned int)cur_selections.size();
 					ShapeModel* new_selected = list.frontmost_shape_2d(OrthogtraphicCamera::map_from_global(window_input.m_mouse_x, window_input.m_mouse_y));
 					if (num_selections == 1
 						&& cur_selections[0] == new_selected)
@@ -677,6 +678,7 @@ int main(int, char**)
 						Angel::vec3 v_new = OrthogtraphicCamera::map_from_global(window_input.m_mouse_x, window_input.m_mouse_y);
 						Angel::vec3 drag_vector = v_new - v_old;
 						new_selected->position() += drag_vector;
+						list.on_shape_modified(new_selected);
 					}
 					else if (num_selections > 1)
 					{
@@ -765,6 +767,7 @@ int main(int, char**)
 						Angel::vec3 v_new = OrthogtraphicCamera::map_from_global(window_input.m_mouse_x, window_input.m_mouse_y);
 						Angel::vec3 drag_vector = v_new - v_old;
 						old_selected->position() += drag_vector;
+						list.on_shape_modified(old_selected);
 					}
 					else
 					{
@@ -973,15 +976,23 @@ int main(int, char**)
 							if (open_file_path != NULL)
 							{
 								std::filesystem::path std_open_file_path(open_file_path);
-								std::vector<ShapeModel*> loaded_scene = DSerializer::deserialize_drawlist(std_open_file_path);
+								if (load_arena == nullptr)
+								{
+									load_arena = new SceneArena;
+								}
+								std::vector<ShapeModel*> loaded_scene = DSerializer::deserialize_drawlist(std_open_file_path, load_arena);
 								if (loaded_scene.empty())
 								{
 									std::cout << "Warning, loaded scene was empty, load was aborted" << std::endl;
+									// Nothing in the arena is alive, reset it in place for the next load
+									load_arena->release();
 								}
 								else
 								{
-									list.shutdown();
+									list.clear();
 									undo_redo.clear_stacks();
+									list.set_scene_arena(load_arena);
+									load_arena = nullptr;
 									for (auto& shape : loaded_scene)
 									{
 										list.add_shape(shape);
@@ -1004,7 +1015,7 @@ int main(int, char**)
 					}
 					if (ImGui::BeginTabItem("Selection"))
 					{
-						unsigned int n_selections = (uint16_t)cur_selections.size();
+						unsigned int n_selections = (unsigned int)cur_selections.size();
 						if (n_selections == 0)
 						{
 							ImGui::Text("Currently, there is no shape selected");
@@ -1013,20 +1024,26 @@ int main(int, char**)
 						{
 							ImGui::ColorEdit4("Shape Color", &(cur_selections[0]->color()).x, f);
 							ImGui::SameLine();
-							ImGui::SliderFloat("Rotation Degree", &(cur_selections[0]->rotation()).z, 0.0f, 360, "%.3f", 1.0f);
+							bool rotated = ImGui::SliderFloat("Rotation Degree", &(cur_selections[0]->rotation()).z, 0.0f, 360, "%.3f", 1.0f);
 							if (ImGui::Button("Rotate 30 Degrees"))
 							{
 								(cur_selections[0]->rotation()).z += 30.0f;
 								Operation rotate(Operation::OperationType::RotateShape, cur_selections[0], Angel::vec3(0, 0, 0), Angel::vec3(0, 0, 30));
 								undo_redo.on_operation_performed(rotate);
+								rotated = true;
 							}
 							if (ImGui::Button("Rotate -30 Degrees"))
 							{
 								(cur_selections[0]->rotation()).z -= 30.0f;
 								Operation rotate(Operation::OperationType::RotateShape, cur_selections[0], Angel::vec3(0, 0, 0), Angel::vec3(0, 0, -30));
 								undo_redo.on_operation_performed(rotate);
+								rotated = true;
 							}
 							(cur_selections[0]->rotation()).z = (float)(((int)(cur_selections[0]->rotation()).z + 360) % 360);
+							if (rotated)
+							{
+								list.on_shape_modified(cur_selections[0]);
+							}
 						}
 						else
 						{
@@ -1034,6 +1051,95 @@ int main(int, char**)
 						}
 						ImGui::EndTabItem();
 					}
+					if (ImGui::BeginTabItem("Diagnostics"))
+					{
+						bool use_spatial_index = list.spatial_indexing();
+						if (ImGui::Checkbox("Spatial Indexing", &use_spatial_index))
+						{
+							list.set_spatial_indexing(use_spatial_index);
+						}
+						ImGui::SameLine();
+						if (ImGui::Button("Run Picking Benchmark"))
+						{
+							Benchmark::spatial_index_2d(projection_matrix, view_matrix);
+						}
+						if (ImGui::Button("Run Point In Polygon Benchmark"))
+						{
+							Benchmark::point_in_polygon();
+						}
+						ImGui::SameLine();
+						if (ImGui::Button("Run Allocation Benchmark"))
+						{
+							Benchmark::allocations();
+						}
+						ImGui::SameLine();
+						if (ImGui::Button("Run Software Rasterizer Benchmark"))
+						{
+							Benchmark::software_rasterizer();
+						}
+						ImGui::Text("Benchmark results are printed to the console");
+						int draw_mode = (int)list.draw_mode();
+						ImGui::RadioButton("Immediate Rendering", &draw_mode, (int)DrawList::DrawMode::Immediate);
+						ImGui::SameLine();
+						ImGui::RadioButton("Batched Rendering", &draw_mode, (int)DrawList::DrawMode::Batched);
+						ImGui::SameLine();
+						ImGui::RadioButton("Instanced Rendering", &draw_mode, (int)DrawList::DrawMode::Instanced);
+						list.set_draw_mode((DrawList::DrawMode)draw_mode);
+						if (ImGui::Button("Add 50k Random Shapes"))
+						{
+							Benchmark::populate_random_2d(list, 50000, 20000.0f);
+						}
+						ImGui::Text("Shapes: %d, Draw calls: %d", (int)list.num_shapes(), list.num_draw_calls());
+						ImGui::Text("GL binds: %u issued, %u elided",
+							RenderState::last_frame_counters().num_binds,
+							RenderState::last_frame_counters().num_elided_binds);
+						ImGui::Text("Render queue: %u commands, %u draw calls, %u shader changes",
+							list.render_queue_stats().num_commands,
+							list.render_queue_stats().num_draw_calls,
+							list.render_queue_stats().num_shader_changes);
+						GeometryArena::Report arena_report = Shape::basic_arena().report();
+						ImGui::Text("Geometry arena: %u / %u KB, %u growths",
+							arena_report.used_bytes() / 1024, arena_report.reserved_bytes() / 1024, arena_report.num_growths);
+						ImGui::Text("Free blocks: %u vertex, %u index, fragmentation %.0f%% / %.0f%%",
+							arena_report.num_vertex_free_blocks, arena_report.num_index_free_blocks,
+							100.0f * arena_report.vertex_fragmentation(), 100.0f * arena_report.index_fragmentation());
+						int gl_error_mode = (int)GLErrorCheck::mode();
+						if (ImGui::Combo("GL Error Checks", &gl_error_mode, "Off\0Sampled\0Full\0Debug Output\0"))
+						{
+							GLErrorCheck::set_mode((GLErrorMode)gl_error_mode);
+						}
+						bool use_view_culling = list.view_culling();
+						if (ImGui::Checkbox("View Culling", &use_view_culling))
+						{
+							list.set_view_culling(use_view_culling);
+						}
+						ImGui::SameLine();
+						ImGui::Text("Submitted: %d, Culled: %d", list.num_submitted(), list.num_culled());
+						bool use_lod = list.lod();
+						if (ImGui::Checkbox("Level Of Detail", &use_lod))
+						{
+							list.set_lod(use_lod);
+						}
+						ImGui::SameLine();
+						bool lod_tiny_as_points = list.lod_tiny_as_points();
+						if (ImGui::Checkbox("Draw Tiny Shapes As Points", &lod_tiny_as_points))
+						{
+							list.set_lod_tiny_as_points(lod_tiny_as_points);
+						}
+						float lod_min_screen_size = list.lod_min_screen_size();
+						if (ImGui::SliderFloat("Min Screen Size (px)", &lod_min_screen_size, 0.0f, 16.0f))
+						{
+							list.set_lod_min_screen_size(lod_min_screen_size);
+						}
+						float lod_tolerance = list.lod_tolerance();
+						if (ImGui::SliderFloat("Simplification Tolerance (px)", &lod_tolerance, 0.1f, 8.0f))
+						{
+							list.set_lod_tolerance(lod_tolerance);
+						}
+						ImGui::Text("Skipped: %d, Points: %d, Simplified: %d",
+							list.num_lod_skipped(), list.num_lod_points(), list.num_lod_simplified());
+						ImGui::EndTabItem();
+					}
 					ImGui::EndTabBar();
 				}
 				ImGui::End();
@@ -1047,6 +1153,9 @@ int main(int, char**)
 
 		// Get cursor model coordinates
 
+		// Camera & light of the frame, read by the shaders from the FrameData block
+		FrameUniforms::update(projection_matrix, view_matrix, view_matrix * Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f));
+
 		// Draw sheet
 		Shape::basic_shader()->bind();
 		Shape::basic_shader()->set_uniform_4f("u_color",
@@ -1054,11 +1163,15 @@ int main(int, char**)
 			color_sheet[1],
 			color_sheet[2],
 			color_sheet[3]);
-		MVP_mat_sheet = projection_matrix * view_matrix * model_sheet_matrix;
-		Shape::basic_shader()->set_uniform_mat4f("u_MVP", MVP_mat_sheet);
+		Shape::basic_shader()->set_uniform_mat4f("u_model", model_sheet_matrix);
 		Renderer::draw_triangles(Shape::unit_square()->vertex_array(), Shape::unit_square()->index_buffer(), Shape::basic_shader());
 
-		// Draw the draw list
+		// Draw the draw list, only the shapes on the screen
+		Angel::vec3 view_top_left = OrthogtraphicCamera::map_from_global(0.0, 0.0);
+		Angel::vec3 view_bottom_right = OrthogtraphicCamera::map_from_global((double)width, (double)height);
+		list.set_view_rect({
+			std::min(view_top_left.x, view_bottom_right.x), std::max(view_top_left.x, view_bottom_right.x),
+			std::min(view_top_left.y, view_bottom_right.y), std::max(view_top_left.y, view_bottom_right.y) });
 		list.draw_all();
 
 		// Draw box around multiple selections
@@ -1079,14 +1192,13 @@ int main(int, char**)
 			};
 			Angel::mat4 model_mat_multiple_selection_box = Angel::Translate(multiple_selection_pos)
 				* Angel::Scale(multiple_selection_pos_scale);
-			Angel::mat4 MVP_mat_multiple_selection_box = projection_matrix * view_matrix * model_mat_multiple_selection_box;
 			Shape::basic_shader()->bind();
 			Shape::basic_shader()->set_uniform_4f("u_color",
 				drawer_box_col[0],
 				drawer_box_col[1],
 				drawer_box_col[2],
 				drawer_box_col[3]);
-			Shape::basic_shader()->set_uniform_mat4f("u_MVP", MVP_mat_multiple_selection_box);
+			Shape::basic_shader()->set_uniform_mat4f("u_model", model_mat_multiple_selection_box);
 			Renderer::draw_lines(Shape::unit_square()->vertex_array(), Shape::unit_square()->index_buffer(), Shape::basic_shader());
 		}
 
@@ -1101,8 +1213,7 @@ int main(int, char**)
 				selector_box_col[3]);
 			model_selector_box = Angel::Translate(selector_pos)
 				* Angel::Scale(selector_scale);
-			MVP_selector_box = projection_matrix * view_matrix * model_selector_box;
-			Shape::basic_shader()->set_uniform_mat4f("u_MVP", MVP_selector_box);
+			Shape::basic_shader()->set_uniform_mat4f("u_model", model_selector_box);
 			Renderer::draw_triangles(Shape::unit_square()->vertex_array(), Shape::unit_square()->index_buffer(), Shape::basic_shader());
 		}
 
@@ -1117,8 +1228,7 @@ int main(int, char**)
 				drawer_box_col[3]);
 			model_drawer_box = Angel::Translate(drawer_pos)
 				* Angel::Scale(drawer_scale);
-			MVP_drawer_box = projection_matrix * view_matrix * model_drawer_box;
-			Shape::basic_shader()->set_uniform_mat4f("u_MVP", MVP_drawer_box);
+			Shape::basic_shader()->set_uniform_mat4f("u_model", model_drawer_box);
 			Renderer::draw_lines(Shape::unit_square()->vertex_array(), Shape::unit_square()->index_buffer(), Shape::basic_shader());
 		}
 
@@ -1134,8 +1244,7 @@ int main(int, char**)
 			model_polygon_add_vertex_line = Angel::Translate(polygon_add_vertex_line_pos)
 				* Angel::RotateZ(polygon_add_vertex_line_rotation.z)
 				* Angel::Scale(polygon_add_vertex_line_scale);
-			MVP_polygon_add_vertex_line = projection_matrix * view_matrix * model_polygon_add_vertex_line;
-			Shape::basic_shader()->set_uniform_mat4f("u_MVP", MVP_polygon_add_vertex_line);
+			Shape::basic_shader()->set_uniform_mat4f("u_model", model_polygon_add_vertex_line);
 			Renderer::draw_lines(Shape::unit_square()->vertex_array(), Shape::unit_square()->index_buffer(), Shape::basic_shader());
 		}
 
@@ -1148,6 +1257,7 @@ int main(int, char**)
 
 	// Clear the draw list & delete the VB/IB/VA objects for polygons
 	list.shutdown();
+	delete load_arena;
 
 	// Clear heap memory for predefined shapes & delete the VB/IB/VA objects for predefined shapes
 	Shape::destroy_static_members_allocated_on_the_heap();
@@ -0,0 +1,326 @@
+#include "Core/ErrorManager.h"
+#include "Core/ThreadPool.h"
+#include "Core/ImageWriter.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/FrameUniforms.h"
+#include "Renderer/FrameBuffer.h"
+#include "Renderer/PixelReadback.h"
+#include "Renderer/SoftwareRasterizer.h"
+
+#include "EntityManager/DrawList.h"
+#include "EntityManager/Shape.h"
+#include "EntityManager/DSerializer.h"
+
+#include "Angel-maths/mat.h"
+#include <glew.h>
+#include <glfw3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <semaphore>
+#include <string>
+#include <vector>
+
+// Renders saved .drawlist scenes into PNG images without showing a window.
+// Scene N is rendered while the pixels of scene N - 1 are still being copied
+// back through the pixel buffers, and the images are encoded on worker threads.
+// With --cpu the scenes are drawn by the software rasterizer, no GL context is created.
+
+static void glfw_error_callback(int error, const char* description)
+{
+	fprintf(stderr, "GlFW Error %d: %s\n", error, description);
+}
+
+static void print_usage()
+{
+	std::cout << "Usage: DrawListBatchRenderer [options] <scene.drawlist | directory>..." << std::endl
+		<< "\t-o <directory>\tdirectory of the images, next to each scene otherwise" << std::endl
+		<< "\t-s <width>x<height>\timage size, 1280x720 by default" << std::endl
+		<< "\t-j <threads>\tencoding threads, one per hardware thread by default" << std::endl
+		<< "\t--alpha\t\tkeep the alpha channel, the background is transparent" << std::endl
+		<< "\t--cpu\t\trender with the software rasterizer, for machines without a GPU" << std::endl;
+}
+
+/// <summary>
+/// View matrix that fits the 2D bounds of the scene into the image, with a margin,
+/// for the y down pixel projection of the paint app
+/// </summary>
+static Angel::mat4 fit_view(const std::array<float, 6>& bounds, int width, int height)
+{
+	const float margin = 0.05f;
+	float scene_width = std::max(bounds[1] - bounds[0], 1.0f);
+	float scene_height = std::max(bounds[3] - bounds[2], 1.0f);
+	float scale = (1.0f - 2.0f * margin) * std::min((float)width / scene_width, (float)height / scene_height);
+	Angel::vec3 center((bounds[0] + bounds[1]) / 2.0f, (bounds[2] + bounds[3]) / 2.0f, 0.0f);
+	return Angel::Translate((float)width / 2.0f, (float)height / 2.0f, 0.0f)
+		* Angel::Scale(scale, scale, 1.0f)
+		* Angel::Translate(-center);
+}
+
+int main(int argc, char** argv)
+{
+	// Command line
+	int width = 1280, height = 720;
+	unsigned int num_threads = ThreadPool::s_hardware_threads;
+	bool alpha = false;
+	bool cpu = false;
+	std::filesystem::path output_directory;
+	std::vector<std::filesystem::path> scene_paths;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc)
+		{
+			output_directory = argv[++i];
+		}
+		else if (arg == "-s" && i + 1 < argc)
+		{
+			if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+			{
+				print_usage();
+				return -1;
+			}
+		}
+		else if (arg == "-j" && i + 1 < argc)
+		{
+			// The calling thread renders, the pool only encodes
+			num_threads = (unsigned int)std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--alpha")
+		{
+			alpha = true;
+		}
+		else if (arg == "--cpu")
+		{
+			cpu = true;
+		}
+		else if (std::filesystem::is_directory(arg))
+		{
+			std::vector<std::filesystem::path> directory_scenes;
+			for (const auto& entry : std::filesystem::directory_iterator(arg))
+			{
+				if (entry.is_regular_file() && entry.path().extension() == ".drawlist")
+				{
+					directory_scenes.push_back(entry.path());
+				}
+			}
+			std::sort(directory_scenes.begin(), directory_scenes.end());
+			scene_paths.insert(scene_paths.end(), directory_scenes.begin(), directory_scenes.end());
+		}
+		else if (std::filesystem::is_regular_file(arg))
+		{
+			scene_paths.push_back(arg);
+		}
+		else
+		{
+			std::cout << "Warning, " << arg << " is not an option, a scene or a directory" << std::endl;
+		}
+	}
+	if (scene_paths.empty())
+	{
+		print_usage();
+		return -1;
+	}
+	if (!output_directory.empty())
+	{
+		std::filesystem::create_directories(output_directory);
+	}
+	std::vector<std::filesystem::path> image_paths;
+	for (const auto& scene_path : scene_paths)
+	{
+		std::filesystem::path directory = output_directory.empty() ? scene_path.parent_path() : output_directory;
+		image_paths.push_back(directory / scene_path.stem().replace_extension(".png"));
+	}
+
+	// Hidden window, it only provides the context, all the rendering goes to the frame buffer.
+	// The software rasterizer needs none, only the CPU copies of the shapes are made then
+	GLFWwindow* window = nullptr;
+	if (!cpu)
+	{
+		glfwSetErrorCallback(glfw_error_callback);
+		if (!glfwInit())
+			return -1;
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(1, 1, "DrawList Batch Renderer", nullptr, nullptr);
+		if (!window)
+		{
+			glfwTerminate();
+			return -1;
+		}
+		glfwMakeContextCurrent(window);
+		if (glewInit() != GLEW_OK)
+		{
+			std::cout << "Could not init GLEW..." << std::endl;
+			glfwDestroyWindow(window);
+			glfwTerminate();
+			return -1;
+		}
+
+		RenderState::set_blend(true);
+		RenderState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+	Shape::init_static_members(VertexFormat::Float, !cpu);
+
+	// The sheet of the paint app is white
+	float clear_color[4] = { 1.0f, 1.0f, 1.0f, alpha ? 0.0f : 1.0f };
+	Angel::mat4 projection_matrix = Angel::Ortho2D(0.0f, (float)width, (float)height, 0.0f);
+	Angel::mat4 view_matrix;
+	auto* list = new DrawList(projection_matrix, view_matrix);
+	list->set_lod(true);
+	FrameBuffer* frame_buffer = nullptr;
+	PixelReadback* readback = nullptr;
+	ThreadPool* raster_pool = nullptr;
+	SoftwareRasterizer* rasterizer = nullptr;
+	if (cpu)
+	{
+		// The tiles get their own workers, so that the encoding does not delay the frames
+		raster_pool = new ThreadPool;
+		rasterizer = new SoftwareRasterizer(width, height, *raster_pool);
+	}
+	else
+	{
+		list->set_draw_mode(DrawList::DrawMode::Batched);
+		frame_buffer = new FrameBuffer(width, height, FrameBuffer::ColorFormat::RGBA);
+		readback = new PixelReadback(3);
+	}
+
+	// Encoding, a pixel copy per image in flight bounds the memory if the encoders fall behind
+	auto* pool = new ThreadPool(num_threads);
+	const unsigned int max_images_in_flight = 2 * std::max(pool->num_threads(), 1u);
+	std::counting_semaphore<> encode_slots(max_images_in_flight);
+	std::atomic<unsigned int> num_written(0);
+	std::atomic<unsigned int> num_failed(0);
+	auto encode = [&](PixelReadback::Image& image)
+	{
+		encode_slots.acquire();
+		auto* pixels = new std::vector<uint8_t>(std::move(image.pixels));
+		const std::filesystem::path& image_path = image_paths[image.tag];
+		int image_width = image.width, image_height = image.height;
+		pool->submit([&, pixels, image_path, image_width, image_height]()
+			{
+				if (ImageWriter::write_png(image_path, pixels->data(), image_width, image_height, true, alpha))
+				{
+					num_written++;
+				}
+				else
+				{
+					num_failed++;
+				}
+				delete pixels;
+				encode_slots.release();
+			});
+	};
+
+	auto start = std::chrono::high_resolution_clock::now();
+	double load_ms = 0.0, render_ms = 0.0;
+	unsigned int num_empty = 0;
+	PixelReadback::Image image;
+	for (size_t i = 0; i < scene_paths.size(); i++)
+	{
+		auto load_start = std::chrono::high_resolution_clock::now();
+		auto* scene_arena = new SceneArena;
+		std::vector<ShapeModel*> scene = DSerializer::deserialize_drawlist(scene_paths[i], scene_arena);
+		if (scene.empty())
+		{
+			std::cout << "Warning, " << scene_paths[i].string() << " is empty or could not be read, skipped" << std::endl;
+			delete scene_arena;
+			num_empty++;
+			continue;
+		}
+		list->clear();
+		list->set_scene_arena(scene_arena);
+		for (auto& shape : scene)
+		{
+			list->add_shape(shape);
+		}
+		view_matrix = fit_view(ShapeModel::bounding_cube(scene), width, height);
+		auto render_start = std::chrono::high_resolution_clock::now();
+
+		Angel::vec4 light_position = view_matrix * Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f);
+		if (cpu)
+		{
+			rasterizer->set_frame(projection_matrix, view_matrix, light_position);
+			rasterizer->clear(Angel::vec4(clear_color[0], clear_color[1], clear_color[2], clear_color[3]));
+			list->draw_all(*rasterizer);
+			rasterizer->flush();
+			// Same layout as the pixels read back from the frame buffer
+			image.pixels.assign(rasterizer->pixels(), rasterizer->pixels() + (size_t)width * height * 4);
+			image.width = width;
+			image.height = height;
+			image.tag = i;
+			encode(image);
+		}
+		else
+		{
+			FrameUniforms::update(projection_matrix, view_matrix, light_position);
+			frame_buffer->on_update([&]()
+				{
+					Renderer::clear(clear_color);
+					list->draw_all();
+				});
+			// The oldest read has had a whole scene of time, waiting for it rarely stalls
+			while (readback->full())
+			{
+				readback->collect(image, true);
+				encode(image);
+			}
+			readback->read(*frame_buffer, i);
+			while (readback->collect(image, false))
+			{
+				encode(image);
+			}
+		}
+		auto render_end = std::chrono::high_resolution_clock::now();
+		load_ms += std::chrono::duration<double, std::milli>(render_start - load_start).count();
+		render_ms += std::chrono::duration<double, std::milli>(render_end - render_start).count();
+	}
+	while (readback != nullptr && readback->collect(image, true))
+	{
+		encode(image);
+	}
+	pool->wait();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	double total_s = std::chrono::duration<double>(end - start).count();
+	std::cout << num_written << " images written in " << total_s << " s, " << (double)num_written / total_s << " images per second" << std::endl;
+	if (cpu)
+	{
+		std::cout << "\tloading " << load_ms << " ms, software rendering " << render_ms << " ms" << std::endl;
+	}
+	else
+	{
+		std::cout << "\tloading " << load_ms << " ms, rendering and readback " << render_ms << " ms, "
+			<< readback->stats().num_stalls << " of " << readback->stats().num_reads << " readbacks waited for the GPU" << std::endl;
+	}
+	if (num_failed != 0 || num_empty != 0)
+	{
+		std::cout << "\t" << num_failed << " images could not be written, " << num_empty << " scenes were skipped" << std::endl;
+	}
+
+	delete pool;
+	delete rasterizer;
+	delete raster_pool;
+	delete readback;
+	delete frame_buffer;
+	list->shutdown();
+	delete list;
+	Shape::destroy_static_members_allocated_on_the_heap();
+	if (window != nullptr)
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+
+	return num_failed == 0 ? 0 : -1;
+}
@@ -6,6 +6,8 @@
 #include "Renderer/VertexBufferLayout.h"
 #include "Renderer/VertexArray.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/FrameUniforms.h"
 #include "Renderer/Shader.h"
 
 #include "EntityManager/Shape.h"
@@ -101,16 +103,18 @@ int main(int, char**)
 	ImVec4 clear_col = { 0.6f, 0.6f, 0.6f, 1.0f };
 	Renderer renderer;
 	int radio_button_cur = (int)ParametricMesh::DisplayType::Wireframe;
+	bool packed_vertices = false;
+	bool triangle_strips = false;
 
 	// Enable blending
-	__glCallVoid(glEnable(GL_BLEND));
-	__glCallVoid(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	RenderState::set_blend(true);
+	RenderState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	renderer.clear(&clear_col.x);
 
 	// Enable Depth Test for displaying inside of the objects as well
-	__glCallVoid(glEnable(GL_DEPTH_TEST));
-	__glCallVoid(glDepthFunc(GL_LEQUAL));
+	RenderState::set_depth_test(true);
+	RenderState::set_depth_func(GL_LEQUAL);
 	__glCallVoid(glEnable(GL_POLYGON_OFFSET_FILL));
 	__glCallVoid(glPolygonOffset(1.0f, 2.0f));
 
@@ -142,6 +146,7 @@ int main(int, char**)
 	// Rendering & Event Loop
 	while (!glfwWindowShouldClose(window))
 	{
+		GLErrorCheck::begin_frame();
 		auto time = glfwGetTime();
 		// Compute time between frames
 		float delta_time_seconds = static_cast<float>(time - last_frame_time);
@@ -379,12 +384,17 @@ int main(int, char**)
 						ImGui::SliderFloat("q", &q, 0.1f, 40.0f, "%.3f", 1.0f);
 						ImGui::SliderInt("Row Subdiv.", (int*)&rsbd, 20, 200, "%d", 0);
 						ImGui::SliderInt("Col Subdiv.", (int*)&csbd, 20, 200, "%d", 0);
+						ImGui::Checkbox("Packed Vertices", &packed_vertices);
+						ImGui::SameLine();
+						ImGui::Checkbox("Triangle Strips", &triangle_strips);
 						four_i->set_R(R);
 						four_i->set_r(r);
 						four_i->set_l(l);
 						four_i->set_q(q);
 						four_i->set_row_subdiv(rsbd);
 						four_i->set_col_subdiv(csbd);
+						four_i->set_vertex_format(packed_vertices ? VertexFormat::Packed : VertexFormat::Float);
+						four_i->set_triangle_strips(triangle_strips);
 						ImGui::EndTabItem();
 					}
 					if (ImGui::BeginTabItem("Lighting & Shading"))
@@ -424,6 +434,8 @@ int main(int, char**)
 		Renderer::set_viewport(window);
 		Renderer::clear(&clear_col.x);
 
+		// The light follows the camera, it is given in view space
+		FrameUniforms::update(proj_matrix, view_matrix, Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f));
 		four_i->update_and_draw(proj_matrix, view_matrix, (ParametricMesh::DisplayType)radio_button_cur);
 
 		// Always draw ImGui on top of the app
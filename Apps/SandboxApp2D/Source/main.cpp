@@ -6,6 +6,8 @@
 #include "Renderer/VertexBufferLayout.h"
 #include "Renderer/VertexArray.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/FrameUniforms.h"
 #include "Renderer/Shader.h"
 
 #include "EntityManager/DrawList.h"
@@ -91,18 +93,18 @@ int main(int, char**)
 	float init_shape_length = width / 8.0f;
 
 	// Enable blending
-	__glCallVoid(glEnable(GL_BLEND));
-	__glCallVoid(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	RenderState::set_blend(true);
+	RenderState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	// Line width for GL_LINES
 	__glCallVoid(glLineWidth(5.0f));
 
 	// Specify the color of the triangle
 	float color_sheet[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	Angel::vec4* color_a = new Angel::vec4{ 0.6f, 0.9f, 0.0f, 1.0f };
-	Angel::vec4* color_b = new Angel::vec4{ 0.9f, 0.6f, 0.0f, 1.0f };
-	Angel::vec4* color_c = new Angel::vec4{ 1.0f, 0.0f, 0.0f, 1.0f };
-	Angel::vec4* color_d = new Angel::vec4{ 0.0f, 0.0f, 1.0f, 1.0f };
+	Angel::vec4 color_a{ 0.6f, 0.9f, 0.0f, 1.0f };
+	Angel::vec4 color_b{ 0.9f, 0.6f, 0.0f, 1.0f };
+	Angel::vec4 color_c{ 1.0f, 0.0f, 0.0f, 1.0f };
+	Angel::vec4 color_d{ 0.0f, 0.0f, 1.0f, 1.0f };
 
 	Shape::init_static_members();
 	// Texture
@@ -120,18 +122,18 @@ int main(int, char**)
 
 	// Initialize shapes
 	// positions - respect to their initial 0th vertex positions
-	auto* model_a_pos = new Angel::vec3(0, 0.0f, 0.0f);
-	auto* model_b_pos = new Angel::vec3(width / 2.0f - init_shape_length / 2, height / 2.0f - init_shape_length / 2, 0.0f);
-	auto* model_c_pos = new Angel::vec3(width / 4.0f - init_shape_length / 2, height / 4.0f - init_shape_length / 2, 0.0f);
+	Angel::vec3 model_a_pos(0, 0.0f, 0.0f);
+	Angel::vec3 model_b_pos(width / 2.0f - init_shape_length / 2, height / 2.0f - init_shape_length / 2, 0.0f);
+	Angel::vec3 model_c_pos(width / 4.0f - init_shape_length / 2, height / 4.0f - init_shape_length / 2, 0.0f);
 
 	// rotation - in radians (x, y, z axises respectively)
-	auto* model_a_rot = new Angel::vec3(0.0f, 0.0f, 0.0f);
-	auto* model_b_rot = new Angel::vec3(0.0f, 0.0f, 0.0f);
-	auto* model_c_rot = new Angel::vec3(0.0f, 0.0f, 0.0f);
+	Angel::vec3 model_a_rot(0.0f, 0.0f, 0.0f);
+	Angel::vec3 model_b_rot(0.0f, 0.0f, 0.0f);
+	Angel::vec3 model_c_rot(0.0f, 0.0f, 0.0f);
 	// scale   
-	auto* model_a_scale = new Angel::vec3(320.0f, 320.0f, 1.0f);
-	auto* model_b_scale = new Angel::vec3(320.0f, 320.0f, 1.0f);
-	auto* model_c_scale = new Angel::vec3(320.0f, 320.0f, 1.0f);
+	Angel::vec3 model_a_scale(320.0f, 320.0f, 1.0f);
+	Angel::vec3 model_b_scale(320.0f, 320.0f, 1.0f);
+	Angel::vec3 model_c_scale(320.0f, 320.0f, 1.0f);
 
 	ShapeModel *model_a = new ShapeModel(ShapeModel::StaticShape::RECTANGLE,
 		model_a_pos,
@@ -183,7 +185,6 @@ int main(int, char**)
 	// Sheet initializations
 	Angel::mat4 model_sheet_matrix = Angel::Translate(sheet_pos)
 		* Angel::Scale(Angel::vec3((float)width, (float)height, 1.0f));
-	Angel::mat4 MVP_mat_sheet = projection_matrix * view_matrix * model_sheet_matrix;
 
 	DrawList list(projection_matrix, view_matrix);
 	list.add_shape(model_a);
@@ -207,6 +208,7 @@ int main(int, char**)
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		GLErrorCheck::begin_frame();
 		// Old mouse pos & state
 		Angel::vec2 old_mouse_pos((float)window_input.m_mouse_x, (float)window_input.m_mouse_y);
 		Input::ButtonState mouse_previous_state = window_input.m_lmb_state;
@@ -415,26 +417,26 @@ int main(int, char**)
 			{
 				ImGui::Text("This is some useful text.");
 
-				ImGui::SliderFloat("Model A-Xpos", &model_a_pos->x, 0.0f, (float)mode->width, "%.1f", 1.0f);
-				ImGui::SliderFloat("Model A-Ypos", &model_a_pos->y, 0.0f, (float)mode->height, "%.1f", 1.0f);
-				ImGui::SliderFloat("Model A-zrot", &model_a_rot->z, 0.0f, 360, "%.3f", 1.0f);
-				ImGui::SliderFloat2("Model A-scale", &model_a_scale->x, -init_shape_length, init_shape_length, "%.3f", 1.0f);
+				ImGui::SliderFloat("Model A-Xpos", &model_a->position().x, 0.0f, (float)mode->width, "%.1f", 1.0f);
+				ImGui::SliderFloat("Model A-Ypos", &model_a->position().y, 0.0f, (float)mode->height, "%.1f", 1.0f);
+				ImGui::SliderFloat("Model A-zrot", &model_a->rotation().z, 0.0f, 360, "%.3f", 1.0f);
+				ImGui::SliderFloat2("Model A-scale", &model_a->scale().x, -init_shape_length, init_shape_length, "%.3f", 1.0f);
 				ImGui::Text("Size of Model A: %f, %f", size_a.x, size_a.y);
 				ImGui::Text("Position of the Center of Model A: %f, %f", center_a.x, center_a.y);
 				ImGui::NewLine();
 
-				ImGui::SliderFloat("Model B-XPos", &model_b_pos->x, 0.0f, (float)mode->width, "%.1f", 1.0f);
-				ImGui::SliderFloat("Model B-YPos", &model_b_pos->y, 0.0f, (float)mode->height, "%.1f", 1.0f);
-				ImGui::SliderFloat("Model B-zrot", &model_b_rot->z, 0.0f, 360, "%.3f", 1.0f);
-				ImGui::SliderFloat2("Model B-scale", &model_b_scale->x, -init_shape_length, init_shape_length, "%.3f", 1.0f);
+				ImGui::SliderFloat("Model B-XPos", &model_b->position().x, 0.0f, (float)mode->width, "%.1f", 1.0f);
+				ImGui::SliderFloat("Model B-YPos", &model_b->position().y, 0.0f, (float)mode->height, "%.1f", 1.0f);
+				ImGui::SliderFloat("Model B-zrot", &model_b->rotation().z, 0.0f, 360, "%.3f", 1.0f);
+				ImGui::SliderFloat2("Model B-scale", &model_b->scale().x, -init_shape_length, init_shape_length, "%.3f", 1.0f);
 				ImGui::Text("Size of Model A: %f, %f", size_b.x, size_b.y);
 				ImGui::Text("Position of the Center of Model B: %f, %f", center_b.x, center_b.y);
 				ImGui::NewLine();
 
-				ImGui::SliderFloat("Model C-XPos", &model_c_pos->x, 0.0f, (float)mode->width, "%.1f", 1.0f);
-				ImGui::SliderFloat("Model C-YPos", &model_c_pos->y, 0.0f, (float)mode->height, "%.1f", 1.0f);
-				ImGui::SliderFloat("Model C-zrot", &model_c_rot->z, 0.0f, 360, "%.3f", 1.0f);
-				ImGui::SliderFloat2("Model C-scale", &model_c_scale->x, -init_shape_length, init_shape_length, "%.3f", 1.0f);
+				ImGui::SliderFloat("Model C-XPos", &model_c->position().x, 0.0f, (float)mode->width, "%.1f", 1.0f);
+				ImGui::SliderFloat("Model C-YPos", &model_c->position().y, 0.0f, (float)mode->height, "%.1f", 1.0f);
+				ImGui::SliderFloat("Model C-zrot", &model_c->rotation().z, 0.0f, 360, "%.3f", 1.0f);
+				ImGui::SliderFloat2("Model C-scale", &model_c->scale().x, -init_shape_length, init_shape_length, "%.3f", 1.0f);
 				ImGui::Text("Size of Model C: %f, %f", size_c.x, size_c.y);
 				ImGui::Text("Position of the Center of Model C: %f, %f", center_c.x, center_c.y);
 				ImGui::NewLine();
@@ -450,13 +452,13 @@ int main(int, char**)
 
 				if (!has_texture)
 				{
-					ImGui::ColorEdit4("Model A Color", &color_a->x, f);
+					ImGui::ColorEdit4("Model A Color", &model_a->color().x, f);
 					ImGui::SameLine();
-					ImGui::ColorEdit4("Model B Color", &color_b->x, f);
+					ImGui::ColorEdit4("Model B Color", &model_b->color().x, f);
 					ImGui::SameLine();
-					ImGui::ColorEdit4("Model C Color", &color_c->x, f);
+					ImGui::ColorEdit4("Model C Color", &model_c->color().x, f);
 					ImGui::SameLine();
-					ImGui::ColorEdit4("Model D Color", &color_d->x, f);
+					ImGui::ColorEdit4("Model D Color", &model_d->color().x, f);
 					ImGui::NewLine();
 				}
 
@@ -484,8 +486,8 @@ int main(int, char**)
 			color_sheet[2],
 			color_sheet[3]);
 		OrthogtraphicCamera::update();
-		MVP_mat_sheet = projection_matrix * view_matrix * model_sheet_matrix;
-		Shape::basic_shader()->set_uniform_mat4f("u_MVP", MVP_mat_sheet);
+		FrameUniforms::update(projection_matrix, view_matrix, view_matrix * Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f));
+		Shape::basic_shader()->set_uniform_mat4f("u_model", model_sheet_matrix);
 
 		// Draw the sheet
 		Renderer::draw_triangles(Shape::unit_square()->vertex_array(), Shape::unit_square()->index_buffer(), Shape::basic_shader());
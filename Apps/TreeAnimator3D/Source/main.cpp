@@ -6,6 +6,9 @@
 #include "Renderer/VertexBufferLayout.h"
 #include "Renderer/VertexArray.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/FrameUniforms.h"
+#include "Renderer/RenderQueue.h"
 #include "Renderer/Shader.h"
 
 #include "EntityManager/DrawList.h"
@@ -96,13 +99,13 @@ int main(int, char**)
 	Renderer renderer;
 
 	// Enable blending
-	__glCallVoid(glEnable(GL_BLEND));
-	__glCallVoid(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	RenderState::set_blend(true);
+	RenderState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	renderer.clear();
 
 	// Enable Depth Test & Back-Face Culling
-	__glCallVoid(glEnable(GL_DEPTH_TEST));
+	RenderState::set_depth_test(true);
 	__glCallVoid(glDepthMask(GL_TRUE));
 	__glCallVoid(glEnable(GL_CULL_FACE));
 	__glCallVoid(glFrontFace(GL_CCW));
@@ -131,19 +134,19 @@ int main(int, char**)
 
 	// Draw List
 	DrawList list(proj_matrix, view_matrix);
+	list.set_draw_mode(DrawList::DrawMode::Instanced);
 	// Platform surface
-	Angel::vec3* platform_surface_pos, * platform_surface_rot, * platform_surface_scale;
-	platform_surface_pos = new Angel::vec3(0.0f, -300.0f, 0.0f);
-	platform_surface_rot = new Angel::vec3(0.0f, 0.0f, 0.0f);
-	platform_surface_scale = new Angel::vec3((float)width, 20.0f, (float)height);
 	ShapeModel* platform_surface = new ShapeModel(ShapeModel::StaticShape::COL_CUBE,
-		platform_surface_pos, platform_surface_rot, platform_surface_scale);
+		Angel::vec3(0.0f, -300.0f, 0.0f),
+		Angel::vec3(0.0f, 0.0f, 0.0f),
+		Angel::vec3((float)width, 20.0f, (float)height));
 	list.add_shape(platform_surface);
 
 	// Articulated Tree Model
 	auto hierarchical_model = new ArticulatedModel(Angel::vec3(0.0f, -280.0f, 0.0f), 
 		tree_surface_texture_obj, 0,
 		proj_matrix, view_matrix);
+	hierarchical_model->set_instancing(true);
 
 	// Selection System
 	SelectionSystem3D* selection_system = new SelectionSystem3D(&list, hierarchical_model, width, height);
@@ -168,9 +171,13 @@ int main(int, char**)
 	int min_children_per_branch = 2;
 	Angel::vec3 initial_trunk_size = { 30.0f, 300.0f, 30.0f };
 
+	// Draw commands of a frame, sorted before they are executed
+	RenderQueue frame_queue;
+
 	// Rendering & Event Loop
 	while (!glfwWindowShouldClose(window))
 	{
+		GLErrorCheck::begin_frame();
 		auto time = glfwGetTime();
 		// Compute time between frames
 		float delta_time_seconds = static_cast<float>(time - last_frame_time);
@@ -540,6 +547,9 @@ int main(int, char**)
 		}
 		ImGui::EndFrame();
 
+		// Camera & light of the frame, shared by the picking and the drawing passes
+		FrameUniforms::update(proj_matrix, view_matrix, view_matrix * Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f));
+
 		// Update the selection system
 		if (old_width != width || old_height != height)
 		{
@@ -569,11 +579,10 @@ int main(int, char**)
 		Renderer::set_viewport(window);
 		Renderer::clear();
 
-		// Draw the draw list
-		list.draw_all();
-
-		// Draw the model
-		hierarchical_model->draw_model();
+		// Draw the draw list and the model, their cubes are sorted together by state and depth
+		list.draw_all(&frame_queue);
+		hierarchical_model->draw_model(&frame_queue);
+		frame_queue.flush();
 
 		// Always draw ImGui on top of the app
 		render_imgui();
@@ -0,0 +1,26 @@
+#pragma once
+#include "Angel-maths/mat.h"
+
+class DrawList;
+
+namespace Benchmark
+{
+	// Fills the list with random rectangles and triangles over a square of the given size
+	void populate_random_2d(DrawList& list, unsigned int num_shapes, float world_size, unsigned int seed = 42);
+
+	// Compares spatially indexed hit-testing and box selection of the DrawList
+	// against the linear scan, for 10k and 100k shapes. Requires a GL context.
+	void spatial_index_2d(const Angel::mat4& proj, const Angel::mat4& view);
+
+	// Compares the reference, scalar and vectorized point-in-polygon tests on random
+	// star shaped polygons of 8, 64 and 1024 corners. Does not need a GL context.
+	void point_in_polygon();
+
+	// Creates and deletes rectangles and polygons with the global allocator, the object
+	// pools and a scene arena, counting the system allocations. Requires a GL context.
+	void allocations();
+
+	// Renders random overlapping blended triangles with the software rasterizer, on one
+	// thread and on all of them, and checks that the images match. Does not need a GL context.
+	void software_rasterizer();
+}
@@ -28,21 +28,115 @@ else \
 	GENERAL_BREAK();\
 }\
 
+// Per call GL error checks. Release builds compile them away, define
+// GL_ERROR_CHECKS to 1 to keep them, or to 0 to drop them in debug builds.
+#ifndef GL_ERROR_CHECKS
+#ifdef NDEBUG
+#define GL_ERROR_CHECKS 0
+#else
+#define GL_ERROR_CHECKS 1
+#endif
+#endif
+
+enum class GLErrorMode
+{
+	Off,			// no checks at all
+	Sampled,		// full checks during one frame out of every sample interval
+	Full,			// glGetError around every call
+	DebugOutput,	// driver callback (KHR_debug), reported with the last call as breadcrumb
+};
+
+/// <summary>
+/// Error checking policy of the __glCall macros. Without GL_ERROR_CHECKS the
+/// macros only make the call, Sampled and Full then fall back to one glGetError
+/// poll per sampled frame, and DebugOutput still reports the driver messages.
+/// </summary>
+class GLErrorCheck
+{
+public:
+	struct Breadcrumb
+	{
+		const char* call;
+		std::source_location location;
+	};
+
+	static bool s_check_calls;			// read by the macros
+	static bool s_record_breadcrumbs;
+	static Breadcrumb s_breadcrumb;
+private:
+	static GLErrorMode s_mode;
+	static unsigned int s_sample_interval;
+	static unsigned int s_frame;
+	static bool s_debug_output_enabled;
+
+	static void update_flags();
+	static bool enable_debug_output(bool enable);
+public:
+	// Needs a current context for DebugOutput, returns false when the mode is not available
+	static bool set_mode(GLErrorMode mode, unsigned int sample_interval = 60);
+	inline static GLErrorMode mode() { return s_mode; }
+	inline static unsigned int sample_interval() { return s_sample_interval; }
+
+	// Advances the sampling, to be called at the start of every frame
+	static void begin_frame();
+
+	inline static void leave_breadcrumb(const char* call, const std::source_location& location)
+	{
+		s_breadcrumb = { call, location };
+	}
+};
+
+#if GL_ERROR_CHECKS
+#define __glCallVoid(x) \
+	{\
+		if (GLErrorCheck::s_check_calls)\
+		{\
+			std::source_location sloc = std::source_location::current();\
+			__glClearErrors();\
+			x;\
+			ASSERT(!__glLogCall(#x, sloc.file_name(), sloc.line(), sloc.column(), sloc.function_name()))\
+		}\
+		else\
+		{\
+			if (GLErrorCheck::s_record_breadcrumbs)\
+			{\
+				GLErrorCheck::leave_breadcrumb(#x, std::source_location::current());\
+			}\
+			x;\
+		}\
+	}\
+
+#define __glCallReturn(x, out) \
+	{\
+		if (GLErrorCheck::s_check_calls)\
+		{\
+			std::source_location sloc = std::source_location::current();\
+			__glClearErrors();\
+			out = x;\
+			ASSERT(!__glLogCall(#x, sloc.file_name(), sloc.line(), sloc.column(), sloc.function_name()))\
+		}\
+		else\
+		{\
+			if (GLErrorCheck::s_record_breadcrumbs)\
+			{\
+				GLErrorCheck::leave_breadcrumb(#x, std::source_location::current());\
+			}\
+			out = x;\
+		}\
+	}\
+
+#else
 #define __glCallVoid(x) \
 	{\
-		std::source_location sloc = std::source_location::current();\
-		__glClearErrors();\
 		x;\
-		ASSERT(!__glLogCall(#x, sloc.file_name(), sloc.line(), sloc.column(), sloc.function_name()))\
 	}\
 
 #define __glCallReturn(x, out) \
 	{\
-		std::source_location sloc = std::source_location::current();\
-		__glClearErrors();\
 		out = x;\
-		ASSERT(!__glLogCall(#x, sloc.file_name(), sloc.line(), sloc.column(), sloc.function_name()))\
 	}\
 
+#endif
+
 void __glClearErrors();
 bool __glLogCall(const char* function, const char* file, int line, int column, const char* func);
@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+/// <summary>
+/// PNG encoding of RGBA8 images, without dependencies. Every row gets the PNG filter
+/// that makes it the most compressible, then the image is deflated with fixed Huffman
+/// codes and a single entry hash table for the matches: flat and repeating areas,
+/// which make up most of the rendered scenes, compress well at a low CPU cost.
+/// The functions keep no state, they can run on several threads at once.
+/// </summary>
+namespace ImageWriter
+{
+	// bottom_row_first flips the rows, for pixels read back from GL.
+	// Without alpha, the alpha channel of the pixels is dropped.
+	std::vector<uint8_t> encode_png(const uint8_t* rgba, int width, int height, bool bottom_row_first, bool alpha);
+
+	bool write_png(const std::filesystem::path& path, const uint8_t* rgba, int width, int height, bool bottom_row_first, bool alpha);
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include "Core/SceneArena.h"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <new>
+
+/// <summary>
+/// Fixed size storage for the objects of one class. Slots are carved out of chunks that
+/// are never returned to the system, freed slots are chained into a free list and reused
+/// by the next allocation. Only the memory is managed, construction is left to new.
+/// </summary>
+/// <typeparam name="T"></typeparam>
+template <typename T>
+class ObjectPool
+{
+private:
+	union Slot
+	{
+		Slot* next_free;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+	static constexpr size_t s_slots_per_chunk = 256;
+
+	std::vector<Slot*> m_chunks;			// sorted by address, for owns
+	Slot* m_first_free;
+	size_t m_num_live;
+	size_t m_num_allocations;
+
+	ObjectPool() : m_first_free(nullptr), m_num_live(0), m_num_allocations(0) {}
+	~ObjectPool()
+	{
+		for (Slot* chunk : m_chunks)
+		{
+			::operator delete(chunk, std::align_val_t(alignof(Slot)));
+		}
+	}
+	ObjectPool(const ObjectPool&) = delete;
+public:
+	static ObjectPool& get_instance()
+	{
+		static ObjectPool pool;
+		return pool;
+	}
+
+	void* allocate()
+	{
+		if (m_first_free == nullptr)
+		{
+			Slot* chunk = static_cast<Slot*>(::operator new(s_slots_per_chunk * sizeof(Slot), std::align_val_t(alignof(Slot))));
+			m_chunks.insert(std::upper_bound(m_chunks.begin(), m_chunks.end(), chunk, std::less<Slot*>()), chunk);
+			for (size_t i = 0; i < s_slots_per_chunk; i++)
+			{
+				chunk[i].next_free = (i + 1 < s_slots_per_chunk) ? &chunk[i + 1] : nullptr;
+			}
+			m_first_free = chunk;
+		}
+		Slot* slot = m_first_free;
+		m_first_free = slot->next_free;
+		m_num_live++;
+		m_num_allocations++;
+		return slot->storage;
+	}
+
+	void deallocate(void* p)
+	{
+		Slot* slot = reinterpret_cast<Slot*>(p);
+		slot->next_free = m_first_free;
+		m_first_free = slot;
+		m_num_live--;
+	}
+
+	bool owns(const void* p) const
+	{
+		const Slot* slot = static_cast<const Slot*>(p);
+		auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), slot, std::less<const Slot*>());
+		if (it == m_chunks.begin())
+		{
+			return false;
+		}
+		const Slot* chunk = *(it - 1);
+		return std::less_equal<const Slot*>()(chunk, slot) && std::less<const Slot*>()(slot, chunk + s_slots_per_chunk);
+	}
+
+	inline size_t num_live() const { return m_num_live; }
+	inline size_t num_allocations() const { return m_num_allocations; }
+	inline size_t num_chunk_allocations() const { return m_chunks.size(); }
+};
+
+/// <summary>
+/// Routing of the class specific new/delete of the pooled classes
+/// </summary>
+namespace PooledAllocation
+{
+	// When disabled, the pooled classes fall back to the global new/delete, for comparisons
+	extern bool s_enabled;
+	// Global new/delete calls made on behalf of the pooled classes, either by the fallback
+	// or for new pool chunks & arena blocks
+	extern size_t s_num_system_allocations;
+
+	template <typename T>
+	void* allocate(size_t size)
+	{
+		if (size != sizeof(T) || !s_enabled)
+		{
+			s_num_system_allocations++;
+			return ::operator new(size);
+		}
+		if (SceneArena* arena = SceneArena::current())
+		{
+			size_t num_blocks = arena->num_block_allocations();
+			void* p = arena->allocate(size, alignof(T));
+			s_num_system_allocations += arena->num_block_allocations() - num_blocks;
+			return p;
+		}
+		ObjectPool<T>& pool = ObjectPool<T>::get_instance();
+		size_t num_chunks = pool.num_chunk_allocations();
+		void* p = pool.allocate();
+		s_num_system_allocations += pool.num_chunk_allocations() - num_chunks;
+		return p;
+	}
+
+	template <typename T>
+	void deallocate(void* p, size_t size)
+	{
+		if (p == nullptr)
+		{
+			return;
+		}
+		if (SceneArena* arena = SceneArena::owner_of(p))
+		{
+			// Reused by the next object of the class created in the arena
+			arena->deallocate(p, size, alignof(T));
+			return;
+		}
+		ObjectPool<T>& pool = ObjectPool<T>::get_instance();
+		if (size != sizeof(T) || !pool.owns(p))
+		{
+			// Allocated while pooling was disabled
+			::operator delete(p);
+			return;
+		}
+		pool.deallocate(p);
+	}
+}
+
+// Adds class specific new/delete to a class, so that its objects come from
+// ObjectPool<T>, or from the current SceneArena
+#define POOLED_ALLOCATION(T) \
+	static void* operator new(size_t size) { return PooledAllocation::allocate<T>(size); } \
+	static void operator delete(void* p, size_t size) { PooledAllocation::deallocate<T>(p, size); }
@@ -0,0 +1,43 @@
+#pragma once
+#include "Angel-maths/mat.h"
+#include <vector>
+#include <cstdint>
+
+// Instruction set of the point-in-polygon kernels, picked at compile time
+#if defined(__AVX2__)
+#define PIP_USE_AVX2 1
+#define PIP_USE_SSE 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIP_USE_AVX2 0
+#define PIP_USE_SSE 1
+#else
+#define PIP_USE_AVX2 0
+#define PIP_USE_SSE 0
+#endif
+
+/// <summary>
+/// Even-odd crossing tests over polygons stored as separate x and y arrays.
+/// The polygon is closed implicitly, i.e. the last corner connects to the first.
+/// None of the kernels allocate.
+/// </summary>
+namespace PointInPolygon
+{
+	// One point against all edges of the polygon, the edges are processed in SIMD lanes
+	bool contains(const float* xs, const float* ys, unsigned int num_corners, float px, float py);
+
+	// Many points against one polygon, the points are processed in SIMD lanes. out[i] is 1 if point i is inside.
+	void contains_many(const float* xs, const float* ys, unsigned int num_corners,
+		const float* pxs, const float* pys, unsigned int num_points, uint8_t* out);
+
+	// True if at least one of the points is inside the polygon
+	bool contains_any(const float* xs, const float* ys, unsigned int num_corners,
+		const float* pxs, const float* pys, unsigned int num_points);
+
+	// Plain C++ versions of the kernels above, always available
+	bool contains_scalar(const float* xs, const float* ys, unsigned int num_corners, float px, float py);
+
+	// Segment intersection based test that ShapeModel::contains_2d used before, kept for comparisons
+	bool contains_reference(const std::vector<Angel::vec3>& corners, const Angel::vec3& point);
+
+	const char* instruction_set();
+}
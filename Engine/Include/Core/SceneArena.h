@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+/// <summary>
+/// Bump allocator for the objects of one scene, e.g. everything a loaded .drawlist creates.
+/// Pooled classes allocate from the arena of the innermost active Scope. Deleting such an
+/// object runs its destructor and chains its memory into a free list of its size, which the
+/// next allocation of that size reuses. The blocks are only given back when the whole arena
+/// is released, in one shot. Not thread safe, like the rest of the entity management.
+/// </summary>
+class SceneArena
+{
+private:
+	struct Block
+	{
+		char* data;
+		size_t size;
+		size_t used;
+	};
+	// Freed objects of one size, linked through their first bytes
+	struct FreeList
+	{
+		size_t size;
+		size_t alignment;
+		void* first;
+	};
+	// Block of a live arena, for finding the owner of a pointer
+	struct BlockRange
+	{
+		const char* begin;
+		const char* end;
+		SceneArena* arena;
+	};
+	std::vector<Block> m_blocks;
+	std::vector<FreeList> m_free_lists;		// one per pooled class, only a few
+	size_t m_block_size;
+	size_t m_num_allocations;
+	size_t m_num_block_allocations;
+
+	static SceneArena* s_current;
+	static std::vector<BlockRange> s_block_ranges;		// sorted by address
+
+	FreeList& free_list(size_t size, size_t alignment);
+public:
+	/// <summary>
+	/// Makes the arena the allocation target of the pooled classes while the scope is alive
+	/// </summary>
+	class Scope
+	{
+	private:
+		SceneArena* m_previous;
+	public:
+		Scope(SceneArena* arena);
+		~Scope();
+		Scope(const Scope&) = delete;
+	};
+
+	SceneArena(size_t block_size = 256 * 1024);
+	~SceneArena();
+	SceneArena(const SceneArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+	void deallocate(void* p, size_t size, size_t alignment);
+	bool owns(const void* p) const;
+	void release();
+
+	inline size_t num_allocations() const { return m_num_allocations; }
+	inline size_t num_block_allocations() const { return m_num_block_allocations; }
+	size_t bytes_used() const;
+
+	inline static SceneArena* current() { return s_current; }
+	static SceneArena* owner_of(const void* p);
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+
+/// <summary>
+/// Outline simplification for the level of detail of 2D polygons.
+/// Corners are given as separate x and y arrays in winding order.
+/// </summary>
+namespace Simplification
+{
+	// Douglas-Peucker over a closed polygon. Writes the indices of the kept corners in
+	// increasing order, every dropped corner is closer than tolerance to the simplified outline.
+	// At least 3 corners are kept, so that the result can still be filled.
+	void douglas_peucker_closed(const float* xs, const float* ys, unsigned int num_corners,
+		float tolerance, std::vector<unsigned int>& out_kept);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/// <summary>
+/// Fixed set of worker threads that run jobs from a shared queue. Jobs must not
+/// touch GL or the entity management, which are bound to the main thread.
+/// </summary>
+class ThreadPool
+{
+private:
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_job_available;
+	std::condition_variable m_idle;
+	unsigned int m_num_busy;
+	bool m_stopping;
+
+	void worker_loop();
+public:
+	// One worker per hardware thread, minus the calling one
+	static constexpr unsigned int s_hardware_threads = 0xFFFFFFFF;
+
+	// Without workers, the jobs run on the calling thread
+	ThreadPool(unsigned int num_threads = s_hardware_threads);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> job);
+	// Returns once the queue is empty and no job is running
+	void wait();
+	// Runs body(i) for every i in [0, count), the calling thread takes part too
+	void parallel_for(unsigned int count, const std::function<void(unsigned int)>& body);
+
+	inline unsigned int num_threads() const { return (unsigned int)m_workers.size(); }
+};
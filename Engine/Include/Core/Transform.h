@@ -0,0 +1,20 @@
+#pragma once
+#include "Angel-maths/mat.h"
+
+/// <summary>
+/// Closed form builders for the model matrices. Rotations are Euler angles in degrees,
+/// applied in the order RotateX * RotateY * RotateZ, like the Angel generators.
+/// </summary>
+namespace Transform
+{
+	// RotateX(euler.x) * RotateY(euler.y) * RotateZ(euler.z)
+	Angel::mat4 rotation(const Angel::vec3& euler);
+
+	// Translate(translation) * rotation(euler) * Scale(scale) * Translate(-pivot),
+	// built directly instead of with four matrix products
+	Angel::mat4 trs(const Angel::vec3& translation, const Angel::vec3& euler,
+		const Angel::vec3& scale, const Angel::vec3& pivot);
+
+	// Scale(scale) * Translate(-pivot)
+	Angel::mat4 scale_pivot(const Angel::vec3& scale, const Angel::vec3& pivot);
+}
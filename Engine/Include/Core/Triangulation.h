@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+
+/// <summary>
+/// Triangulation of simple polygons given as separate x and y arrays in winding order,
+/// either clockwise or counter clockwise. The output is a GL_TRIANGLES index list into
+/// the given corners, all triangles have the winding of the input polygon.
+/// </summary>
+namespace Triangulation
+{
+	// Ear clipping, only the reflex corners are tested against the candidate ears, O(n * r) for r reflex corners.
+	// Returns false if the polygon is not simple, in which case the missing triangles
+	// are filled in as a fan so that the output still has num_corners - 2 triangles.
+	bool ear_clip(const float* xs, const float* ys, unsigned int num_corners, std::vector<unsigned int>& out_indices);
+}
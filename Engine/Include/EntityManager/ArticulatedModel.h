@@ -1,5 +1,6 @@
 #pragma once
 #include "EntityManager/ArticulatedModelNode.h"
+#include "EntityManager/ShapeInstancer.h"
 
 class ArticulatedModel
 {
@@ -10,6 +11,8 @@ private:
 	Texture* m_texture;
 	int m_texture_slot;
 	unsigned int m_num_nodes;
+	bool m_use_instancing;
+	ShapeInstancer* m_instancer;
 
 	void init_static_tree();
 	ArticulatedModelNode* insert_child_to(ArticulatedModelNode* parent,
@@ -44,11 +47,15 @@ public:
 		int max_children_per_trunk,
 		const Angel::vec3& initial_trunk_size);
 	void destroy_tree();
-	void draw_model();
+	// Without instancing the branches are submitted to the given queue, which the caller
+	// flushes, or to an immediate queue
+	void draw_model(RenderQueue* queue = nullptr);
 	void traverse_all_nodes(const std::function<void(ArticulatedModelNode*)>& function);
 	ArticulatedModelNode* get_node(unsigned int entity_id);
 	std::vector<Angel::vec3*> collect_rotations();
 	inline Angel::vec3& position() { return m_position; }
+	inline void set_instancing(bool enabled) { m_use_instancing = enabled; }
+	inline bool instancing() const { return m_use_instancing; }
 	inline const ArticulatedModelNode* torso() { return m_model_root; }
 	inline const unsigned int& num_nodes() { return m_num_nodes; }
 	static inline const unsigned int max_entity_id() { return static_cast<unsigned int>(pow(2, 24)) - 1; }
@@ -25,6 +25,13 @@ private:
 	/// </summary>
 	Angel::vec3 m_rotation;
 
+	/// <summary>
+	/// T(q) * R(u) * T(-p), rebuilt only after u was changed
+	/// </summary>
+	Angel::mat4 m_local_matrix;
+	Angel::vec3 m_local_matrix_rotation;
+	bool m_local_matrix_valid;
+
 	/// <summary>
 	/// p = (0, -0.5, 0), every branch will rotate around its bottom
 	/// </summary>
@@ -52,6 +59,7 @@ public:
 		int texture_slot,
 		unsigned int entity_id);
 
+	const Angel::mat4& local_matrix();
 	Angel::mat4 model_matrix();
 	Angel::mat4 cube_model_matrix();
 	const Texture* cube_texture();
@@ -61,11 +69,19 @@ public:
 	const Angel::vec3& cube_scale();
 	inline unsigned int entity_id() { return m_entity_id; }
 	inline void set_selected(bool selected) { m_is_selected = selected; }
+	inline bool is_selected() const { return m_is_selected; }
+	inline ShapeModel* cube() { return m_cube; }
 	void draw_node(
 		const Angel::mat4& proj,
 		const Angel::mat4& view,
 		const Angel::vec3& model_position
 	);
+	void submit_node(
+		RenderQueue& queue,
+		const Angel::mat4& proj,
+		const Angel::mat4& view,
+		const Angel::vec3& model_position
+	);
 	void traverse_all(const std::function<void(ArticulatedModelNode*)>& f);
 	void destroy_children();
 };
\ No newline at end of file
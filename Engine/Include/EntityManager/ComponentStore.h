@@ -0,0 +1,60 @@
+#pragma once
+#include "Angel-maths/mat.h"
+
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// Transform and color components of the shape models, kept as structure of arrays.
+/// Every component type lives in its own contiguous array and the arrays are packed,
+/// removal moves the last entity into the freed position. Entities are stable ids
+/// that map to the current position in the arrays, so passes over all shapes
+/// (transform updates, culling, batching) can walk the arrays linearly.
+/// References returned by the accessors are invalidated by create and destroy.
+/// </summary>
+class ComponentStore
+{
+public:
+	using Entity = uint32_t;
+	static constexpr Entity null_entity = UINT32_MAX;
+private:
+	// Packed components, the same dense index in every array
+	std::vector<Angel::vec3> m_positions;
+	std::vector<Angel::vec3> m_rotations;	// in angles
+	std::vector<Angel::vec3> m_scales;
+	std::vector<Angel::vec4> m_colors;
+	std::vector<Entity> m_entities;			// entity of each dense index
+
+	// Entity to dense index, free entity ids are chained through m_next_free
+	std::vector<uint32_t> m_dense_indices;
+	std::vector<Entity> m_next_free;
+	Entity m_first_free;
+
+	ComponentStore() : m_first_free(null_entity) {};
+	~ComponentStore() {};
+	ComponentStore(const ComponentStore&) = delete;
+public:
+	static ComponentStore& get_instance();
+
+	Entity create(const Angel::vec3& position,
+		const Angel::vec3& rotation,
+		const Angel::vec3& scale,
+		const Angel::vec4& color);
+	void destroy(Entity e);
+	bool is_alive(Entity e) const;
+	void reserve(size_t num_entities);
+
+	inline uint32_t dense_index(Entity e) const			{ return m_dense_indices[e]; }
+	inline Angel::vec3& position(Entity e)				{ return m_positions[m_dense_indices[e]]; }
+	inline Angel::vec3& rotation(Entity e)				{ return m_rotations[m_dense_indices[e]]; }
+	inline Angel::vec3& scale(Entity e)					{ return m_scales[m_dense_indices[e]]; }
+	inline Angel::vec4& color(Entity e)					{ return m_colors[m_dense_indices[e]]; }
+
+	// Packed arrays, for passes over all entities
+	inline size_t size() const							{ return m_entities.size(); }
+	inline const std::vector<Angel::vec3>& positions() const	{ return m_positions; }
+	inline const std::vector<Angel::vec3>& rotations() const	{ return m_rotations; }
+	inline const std::vector<Angel::vec3>& scales() const		{ return m_scales; }
+	inline const std::vector<Angel::vec4>& colors() const		{ return m_colors; }
+	inline const std::vector<Entity>& entities() const			{ return m_entities; }
+};
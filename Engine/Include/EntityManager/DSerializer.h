@@ -1,10 +1,12 @@
 #pragma once
 #include "EntityManager/ShapeModel.h"
+#include "Core/SceneArena.h"
 #include <filesystem>
 
 class DSerializer
 {
 public:
 	static void serialize_drawlist(const std::vector<ShapeModel*>& drawlist, const std::filesystem::path& serialize_path);
-	static std::vector<ShapeModel*> deserialize_drawlist(const std::filesystem::path& file_path);
+	// The loaded shapes are allocated into the arena, if one is given
+	static std::vector<ShapeModel*> deserialize_drawlist(const std::filesystem::path& file_path, SceneArena* arena = nullptr);
 };
@@ -2,27 +2,119 @@
 #include "Renderer/Renderer.h"
 #include "Renderer/VertexBuffer.h"
 #include "Renderer/IndexBuffer.h"
+#include "Renderer/BatchRenderer2D.h"
 #include "EntityManager/ShapeModel.h"
+#include "EntityManager/SpatialIndex2D.h"
+#include "EntityManager/ShapeInstancer.h"
+#include "EntityManager/SlotMap.h"
+#include "Core/SceneArena.h"
 #include "Angel-maths/mat.h"
 
+#include <unordered_map>
+
 class DrawList
 {
+public:
+	enum class DrawMode
+	{
+		Immediate,	// one draw call per shape
+		Batched,	// 2D shapes are streamed into a single batch
+		Instanced,	// predefined unit shapes are drawn with instancing
+	};
 private:
+	struct Entry
+	{
+		ShapeModel* shape;
+		uint64_t order;		// draw order key, larger is drawn later
+	};
+
+	// Shapes are owned through the slot map, the draw order is kept separately.
+	// m_shape_models is sorted on the order keys, which only grow: added shapes are appended,
+	// removed ones leave a null that is compacted away the next time the shapes are iterated.
+	SlotMap<Entry> m_entries;
+	std::unordered_map<ShapeModel*, SlotHandle> m_handles;
 	std::vector<ShapeModel*> m_shape_models;
+	std::vector<uint64_t> m_shape_model_orders;
+	size_t m_num_removed_shape_models;
+	// Memory of a loaded scene, released at shutdown after its shapes were deleted
+	SceneArena* m_scene_arena;
 	Angel::mat4* m_proj_mat;
 	Angel::mat4* m_view_mat;
+
+	// 2D hit-testing acceleration
+	SpatialIndex2D m_spatial_index;
+	bool m_use_spatial_index;
+	uint64_t m_next_draw_order;
+	std::vector<const SpatialIndex2D::Entry*> m_query_candidates;
+
+	static SpatialIndex2D::Bounds bounds_2d_of(ShapeModel* s);
+	ShapeModel* frontmost_shape_2d_linear(const Angel::vec3& cursor_model_pos);
+	const std::vector<ShapeModel*> shapes_contained_in_2d_linear(const Angel::vec3& selector_pos, const Angel::vec3& selector_scale);
+
+	// Rendering
+	DrawMode m_draw_mode;
+	BatchRenderer2D* m_batch_renderer;
+	ShapeInstancer* m_instancer;
+	RenderQueue m_render_queue;
+	unsigned int m_num_draw_calls;
+	static constexpr float s_outline_width_px = 2.0f;
+
+	// 2D view culling, shapes whose bounds are outside the visible world rectangle are skipped
+	bool m_use_view_culling;
+	bool m_has_view_rect;
+	SpatialIndex2D::Bounds m_view_rect;
+	SpatialIndex2D::Bounds m_cull_rect;	// view rectangle padded by the outline width
+	unsigned int m_num_submitted;
+	unsigned int m_num_culled;
+
+	// Zoom dependent level of detail for 2D shapes
+	enum class LodTier
+	{
+		Skip,		// smaller than the threshold, not drawn
+		Point,		// smaller than the threshold, drawn as a single point
+		Simplified,	// large polygon drawn from its simplified outline
+		Full,
+	};
+	bool m_use_lod;
+	bool m_lod_tiny_as_points;
+	float m_lod_min_screen_size_px;
+	float m_lod_tolerance_px;
+	unsigned int m_num_lod_skipped;
+	unsigned int m_num_lod_points;
+	unsigned int m_num_lod_simplified;
+	std::vector<Angel::vec3> m_lod_coords;
+	static constexpr unsigned int s_lod_min_simplified_vertices = 32;
+	static constexpr float s_lod_full_detail_zoom_ratio = 100.0f;	// zoomed in at least this much, polygons are not simplified
+
+	void begin_draw_all();
+	bool cull(ShapeModel* s);
+	LodTier lod_tier(ShapeModel* s, float pixels_per_unit);
+	void draw_all_immediate(RenderQueue& queue);
+	void draw_all_batched();
+	void draw_all_instanced();
+	void append_shape_model(ShapeModel* s, uint64_t order);
+	void erase_shape_model(uint64_t order);
 public:
 	DrawList(const Angel::mat4& proj, const Angel::mat4& view);
 	~DrawList();
 
-	void add_shape(ShapeModel* s);
+	SlotHandle add_shape(ShapeModel* s);
 	void remove_shape(ShapeModel* s);
+	void remove_shape(SlotHandle handle);
 	void move_shape_to_frontview(ShapeModel* s);
+	ShapeModel* get(SlotHandle handle);
+	SlotHandle handle_of(ShapeModel* s) const;
+	void on_shape_modified(ShapeModel* s);
+	void set_scene_arena(SceneArena* arena);
+	inline SceneArena* scene_arena() { return m_scene_arena; }
 
 	ShapeModel* frontmost_shape_2d(const Angel::vec3& cursor_model_pos);
 	const std::vector<ShapeModel*> shapes_contained_in_2d(const Angel::vec3& selector_pos, const Angel::vec3& selector_scale);
-	const std::vector<ShapeModel*>& shape_models() { return m_shape_models; }
+	const std::vector<ShapeModel*>& shape_models();
+	inline size_t num_shapes() const { return m_entries.size(); }
 	unsigned int idx_of(ShapeModel* s);
+	inline void set_spatial_indexing(bool enabled) { m_use_spatial_index = enabled; }
+	inline bool spatial_indexing() const { return m_use_spatial_index; }
 
 	void undo_add_predefined(ShapeModel* s);
 	void redo_add_predefined(ShapeModel* s);
@@ -36,6 +128,32 @@ public:
 	inline const Angel::mat4& projection_matrix() { return *m_proj_mat; }
 	inline const Angel::mat4& view_matrix() { return *m_view_mat; }
 
+	inline void set_draw_mode(DrawMode mode) { m_draw_mode = mode; }
+	inline DrawMode draw_mode() const { return m_draw_mode; }
+	inline unsigned int num_draw_calls() const { return m_num_draw_calls; }
+	void set_view_rect(const SpatialIndex2D::Bounds& world_rect);
+	inline void set_view_culling(bool enabled) { m_use_view_culling = enabled; }
+	inline bool view_culling() const { return m_use_view_culling; }
+	inline unsigned int num_submitted() const { return m_num_submitted; }
+	inline unsigned int num_culled() const { return m_num_culled; }
+	inline void set_lod(bool enabled) { m_use_lod = enabled; }
+	inline bool lod() const { return m_use_lod; }
+	inline void set_lod_tiny_as_points(bool as_points) { m_lod_tiny_as_points = as_points; }
+	inline bool lod_tiny_as_points() const { return m_lod_tiny_as_points; }
+	inline void set_lod_min_screen_size(float size_px) { m_lod_min_screen_size_px = size_px; }
+	inline float lod_min_screen_size() const { return m_lod_min_screen_size_px; }
+	inline void set_lod_tolerance(float tolerance_px) { m_lod_tolerance_px = tolerance_px; }
+	inline float lod_tolerance() const { return m_lod_tolerance_px; }
+	inline const RenderQueue::Stats& render_queue_stats() const { return m_render_queue.last_stats(); }
+	inline unsigned int num_lod_skipped() const { return m_num_lod_skipped; }
+	inline unsigned int num_lod_points() const { return m_num_lod_points; }
+	inline unsigned int num_lod_simplified() const { return m_num_lod_simplified; }
+
+	void clear();
 	void shutdown();
-	void draw_all();
+	// In immediate mode the shapes are submitted to the given queue, which the caller flushes,
+	// or to the queue of the list, which is flushed right away
+	void draw_all(RenderQueue* queue = nullptr);
+	// Draws with the CPU backend, whatever the draw mode, e.g. when there is no GL context
+	void draw_all(SoftwareRasterizer& rasterizer);
 };
\ No newline at end of file
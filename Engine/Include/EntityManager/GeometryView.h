@@ -0,0 +1,36 @@
+#pragma once
+#include "Angel-maths/mat.h"
+
+#include <span>
+
+/// <summary>
+/// Non-owning view over one attribute of interleaved vertex data, e.g. the positions
+/// of a textured cube whose vertices also hold uv coordinates and normals.
+/// The viewed storage must outlive the view, and it is invalidated when the
+/// geometry is modified.
+/// </summary>
+struct VertexView
+{
+	const float* data = nullptr;	// first component of the attribute of the first vertex
+	unsigned int count = 0;			// number of vertices
+	unsigned int stride = 0;		// floats from one vertex to the next
+	unsigned int components = 0;	// floats of the attribute
+
+	inline unsigned int size() const { return count; }
+	inline bool empty() const { return count == 0; }
+	inline const float* operator[](unsigned int i) const { return data + (size_t)i * stride; }
+	inline Angel::vec3 vec3_at(unsigned int i) const
+	{
+		const float* v = (*this)[i];
+		return Angel::vec3(v[0], v[1], v[2]);
+	}
+	inline VertexView subview(unsigned int first, unsigned int num) const
+	{
+		return { data + (size_t)first * stride, num, stride, components };
+	}
+};
+
+/// <summary>
+/// Non-owning view over an index list
+/// </summary>
+using IndexView = std::span<const unsigned int>;
@@ -1,5 +1,6 @@
 #pragma once
 #include "EntityManager/ShapeModel.h"
+#include "EntityManager/SlotMap.h"
 #include <iostream>
 
 class Operation
@@ -14,6 +15,7 @@ public:
 	};
 private:
 	ShapeModel* m_shape_manipulated;
+	SlotHandle m_shape_handle;	// set by the undo/redo stack, resolves to null once the shape is removed
 	Angel::vec3 m_move_amount;
 	Angel::vec3 m_rotate_amount;
 	OperationType m_type;
@@ -40,6 +42,8 @@ public:
 	}
 
 	ShapeModel* shape_manipulated() {	return m_shape_manipulated;	}
+	const SlotHandle& shape_handle() { return m_shape_handle; }
+	void set_shape_handle(const SlotHandle& handle) { m_shape_handle = handle; }
 	const Angel::vec3& move_amount() { return m_move_amount; }
 	const Angel::vec3& rotate_amount() { return m_rotate_amount; }
 	const OperationType type() { return m_type; }
@@ -5,8 +5,10 @@
 #include "Renderer/Shader.h"
 #include "Renderer/VertexBufferLayout.h"
 #include "Renderer/VertexArray.h"
+#include "Renderer/GeometryArena.h"
 #include "Renderer/IndexBuffer.h"
 #include "Renderer/BumpMap.h"
+#include "Renderer/RenderQueue.h"
 
 #include <vector>
 
@@ -20,12 +22,12 @@ public:
 		Phong
 	};
 private:
-	// Mesh Data -> 50-1x50-1x11 mesh data (u, v, element, coordinate)
+	// Mesh Data -> 50x50x11 mesh data (u, v, element, coordinate)
 	Angel::vec3** m_mesh_points;
 	Angel::vec3** m_mesh_normals;
 	float* m_mesh_buffer_data;
 
-	VertexArray* m_vao;
+	VertexArray* m_vao;		// of the arena
 	VertexBuffer* m_vbo;
 	IndexBuffer* m_ibo;
 	IndexBuffer* m_wireframe_ibo;
@@ -44,31 +46,50 @@ private:
 	float m_R, m_r, m_l, m_q;
 	unsigned int m_row_subdiv, m_col_subdiv, m_old_row_subdiv, m_old_col_subdiv;
 
+	// Packed meshes live in their own arena, the layout differs
+	VertexFormat m_vertex_format;
+	// One strip per row of quads instead of a triangle list, about a third of the indices
+	bool m_triangle_strips;
+	bool m_rebuild_indices;
 	bool m_just_changed;
 
 	static Shader* s_g_shader; // Gouraud Shading
 	static Shader* s_p_shader; // Phong Shading
 	static Shader* s_wireframe_shader;
 	static VertexBufferLayout* s_parametric_mesh_layout;
+	static GeometryArena* s_arena;
+	static VertexBufferLayout* s_packed_layout;
+	static GeometryArena* s_packed_arena;
 
 	void construct_mesh();
+	inline GeometryArena* arena() const { return (m_vertex_format == VertexFormat::Packed) ? s_packed_arena : s_arena; }
 public:
 
 	ParametricMesh(float R, float r, float l,  float q,
 		unsigned int row_subdiv, unsigned int col_subdiv, 
-		const Angel::vec4& col, BumpMap* bumpmap);
+		const Angel::vec4& col, BumpMap* bumpmap,
+		VertexFormat vertex_format = VertexFormat::Float);
 	~ParametricMesh();
 	
+	// The mesh is submitted to the given queue, which the caller flushes,
+	// or drawn right away without one
 	void update_and_draw(
 		const Angel::mat4& proj, 
 		const Angel::mat4& view, 
-		DisplayType display_type);
+		DisplayType display_type,
+		RenderQueue* queue = nullptr);
 	void set_R(float R);
 	void set_r(float r);
 	void set_l(float l);
 	void set_q(float q);
 	void set_row_subdiv(unsigned int r_sbd);
 	void set_col_subdiv(unsigned int c_sbd);
+	// Packed vertices take 24 bytes instead of 44: float positions, 10-10-10-2 normals
+	// and tangents, 16 bit parametric coordinates
+	void set_vertex_format(VertexFormat vertex_format);
+	inline VertexFormat vertex_format() const { return m_vertex_format; }
+	void set_triangle_strips(bool triangle_strips);
+	inline bool triangle_strips() const { return m_triangle_strips; }
 	inline Angel::vec4& color() { return m_color; }
 	inline Angel::vec4& ambient() { return m_ambient; }
 	inline Angel::vec4& diffuse() { return m_diffuse; }
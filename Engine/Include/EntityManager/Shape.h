@@ -2,27 +2,72 @@
 #include "Renderer/VertexBuffer.h"
 #include "Renderer/IndexBuffer.h"
 #include "Renderer/VertexArray.h"
+#include "Renderer/GeometryArena.h"
 #include "Renderer/Shader.h"
+#include "Core/ObjectPool.h"
+#include "EntityManager/GeometryView.h"
 
 #include "Angel-maths/mat.h"
 
 #include <vector>
 #include <array>
+#include <map>
 #include <string>
 
 #define NUM_COORDINATES 3
 #define NUM_TEXTURE_COORDINATES 2
 #define NUM_RGBA 4
+// Per-instance attributes start after the largest vertex layout (position, uv, normal)
+#define FIRST_INSTANCE_ATTRIBUTE 3
 
 class Shape
 {
+public:
+	/// <summary>
+	/// Simplified version of a polygon for one zoom level. Only the index lists are
+	/// simplified, the vertices are shared with the full resolution polygon.
+	/// </summary>
+	struct PolygonLod
+	{
+		float tolerance;						// in the raw space of the shape
+		std::vector<unsigned int> corners;		// kept corners, in winding order
+		std::vector<unsigned int> triangles;	// triangle list into corners
+		IndexBuffer* fill_index_buffer;			// triangles, over the vertex array of the shape
+		IndexBuffer* outline_index_buffer;		// line loop of the kept corners
+		unsigned int last_use;					// for evicting the least recently used level
+	};
 private:
 	// True shape defs that are constant for predefined shapes
 	std::vector<float>* m_no_transform_vertex_positions;
 	std::vector<unsigned int>* m_indices;
+	// Floats per vertex, the positions are followed by the other attributes for cubes
+	unsigned int m_vertex_stride;
+	// The vertex array is the one of the arena that holds the buffers
 	VertexArray* m_vertex_array;
 	VertexBuffer* m_vertex_buffer;
 	IndexBuffer* m_index_buffer;
+	// Sum of the polygon corners, the centroid is maintained incrementally
+	Angel::vec3 m_vertex_sum;
+	// Incremented whenever the vertex positions change, lets the models invalidate their caches
+	unsigned int m_revision;
+	// Polygons only: triangle list over the corners, rebuilt when the revision changes.
+	// The corner indices start from 0, the GPU copy is offset by the fan center.
+	std::vector<unsigned int> m_triangle_indices;
+	IndexBuffer* m_triangle_index_buffer;
+	unsigned int m_triangulation_revision;
+	bool m_triangulation_valid;
+	bool m_triangle_index_buffer_valid;
+	// A self intersecting polygon is reported once, not on every edit
+	bool m_self_intersection_reported;
+	// Polygons only: simplified outlines, keyed on the zoom level they were built for
+	std::map<int, PolygonLod*> m_lods;
+	unsigned int m_lods_revision;
+	unsigned int m_lods_clock;
+	static constexpr size_t s_max_polygon_lods = 8;
+
+	void update_triangulation();
+	void clear_polygon_lods();
+	void rebase_index_buffers();
 
 	// Static members
 	static Shader* s_basic_shader;
@@ -31,6 +76,20 @@ private:
 	static VertexBufferLayout* s_basic_layout;
 	static VertexBufferLayout* s_textured_layout;
 	static VertexBufferLayout* s_colored_layout;
+	// Cube layouts of VertexFormat::Packed: half float positions, with unorm8 colors or
+	// with unorm16 uvs and 10-10-10-2 normals
+	static VertexBufferLayout* s_packed_textured_layout;
+	static VertexBufferLayout* s_packed_colored_layout;
+	static VertexFormat s_cube_format;
+	// Instancing, the instance layout is: model matrix (column major), color, selection flag
+	static Shader* s_instanced_basic_shader;
+	static Shader* s_instanced_colored_shader;
+	static Shader* s_instanced_textured_shader;
+	static VertexBufferLayout* s_instance_layout;
+	// Shared geometry storage, one arena per vertex layout
+	static GeometryArena* s_basic_arena;
+	static GeometryArena* s_textured_arena;
+	static GeometryArena* s_colored_arena;
 	// Predefined shapes
 
 	/// <summary>
@@ -93,26 +152,47 @@ private:
 	static Shape* s_textured_unit_cube;
 public:
 	Shape() : 
-		m_index_buffer(nullptr) , 
+		m_no_transform_vertex_positions(nullptr),
+		m_indices(nullptr),
+		m_vertex_stride(NUM_COORDINATES),
 		m_vertex_array(nullptr), 
 		m_vertex_buffer(nullptr),
-		m_indices(nullptr),
-		m_no_transform_vertex_positions(nullptr) {}
-	// Convex polygon constructor
+		m_index_buffer(nullptr),
+		m_revision(0),
+		m_triangle_index_buffer(nullptr),
+		m_triangulation_revision(0),
+		m_triangulation_valid(false),
+		m_triangle_index_buffer_valid(false),
+		m_self_intersection_reported(false),
+		m_lods_revision(0),
+		m_lods_clock(0) {}
+	// Polygon constructor
 	Shape(const std::vector<Angel::vec3>& model_coords_center_translated_to_origin);
 	~Shape();
 
-	Angel::vec3 push_back_vertex(
-		const Angel::vec3& new_vertex_pos_where_origin_is_old_center, 
-		const Angel::vec3& old_center);
+	Angel::vec3 push_back_vertex(const Angel::vec3& raw_vertex_pos);
+	const std::vector<unsigned int>& polygon_triangles();
+	const IndexBuffer* polygon_triangle_index_buffer();
+	PolygonLod& polygon_lod(int zoom_key, float tolerance);
+	void upload_polygon_lod(PolygonLod& lod);
 
-	std::vector<float> vertices();
+	VertexView positions() const;
+	VertexView attribute(unsigned int offset, unsigned int components) const;
+	IndexView indices() const;
+	inline std::span<const float> interleaved_vertices() const	{ return *m_no_transform_vertex_positions; }
+	inline unsigned int vertex_stride() const					{ return m_vertex_stride; }
+	inline unsigned int revision() const						{ return m_revision; }
 
-	inline unsigned int num_vertices()							{ return (uint16_t)m_no_transform_vertex_positions->size() / NUM_COORDINATES; }
+	inline unsigned int num_vertices() const					{ return (unsigned int)m_no_transform_vertex_positions->size() / m_vertex_stride; }
+	inline Angel::vec3 polygon_centroid() const					{ return Angel::vec3((*m_no_transform_vertex_positions)[0], (*m_no_transform_vertex_positions)[1], (*m_no_transform_vertex_positions)[2]); }
 	inline const VertexArray* vertex_array() const				{ return m_vertex_array; }
+	inline const VertexBuffer* vertex_buffer() const			{ return m_vertex_buffer; }
 	inline const IndexBuffer* index_buffer() const				{ return m_index_buffer; }
 
-	static void init_static_members();
+	static unsigned int polygon_capacity_for(unsigned int num_vertices);
+	// The cubes are uploaded in cube_format, the vertices kept on the CPU are always floats.
+	// Without gpu only the CPU copies are made, for the software rasterizer when there is no GL context
+	static void init_static_members(VertexFormat cube_format = VertexFormat::Float, bool gpu = true);
 	static void destroy_static_members_allocated_on_the_heap();
 	inline static Shader* basic_shader()						{ return s_basic_shader; }
 	inline static Shader* textured_shader()						{ return s_textured_shader; }
@@ -120,8 +200,19 @@ public:
 	inline static const VertexBufferLayout& basic_layout()		{ return *s_basic_layout; }
 	inline static const VertexBufferLayout& textured_layout()	{ return *s_textured_layout; }
 	inline static const VertexBufferLayout& colored_layout()	{ return *s_colored_layout; }
+	inline static VertexFormat cube_format()					{ return s_cube_format; }
+	// Layouts of the GPU copies of the cubes
+	inline static const VertexBufferLayout& textured_cube_layout()	{ return (s_cube_format == VertexFormat::Packed) ? *s_packed_textured_layout : *s_textured_layout; }
+	inline static const VertexBufferLayout& colored_cube_layout()	{ return (s_cube_format == VertexFormat::Packed) ? *s_packed_colored_layout : *s_colored_layout; }
+	inline static Shader* instanced_basic_shader()				{ return s_instanced_basic_shader; }
+	inline static Shader* instanced_colored_shader()			{ return s_instanced_colored_shader; }
+	inline static Shader* instanced_textured_shader()			{ return s_instanced_textured_shader; }
+	inline static const VertexBufferLayout& instance_layout()	{ return *s_instance_layout; }
+	inline static const GeometryArena& basic_arena()			{ return *s_basic_arena; }
 	inline static const Shape* unit_square()					{ return s_unit_square; }
 	inline static const Shape* unit_eq_triangle()				{ return s_unit_eq_triangle; }
 	inline static const Shape* colored_unit_cube()				{ return s_colored_unit_cube; }
 	inline static const Shape* textured_unit_cube()				{ return s_textured_unit_cube; }
+
+	POOLED_ALLOCATION(Shape)
 };
\ No newline at end of file
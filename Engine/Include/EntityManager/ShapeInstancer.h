@@ -0,0 +1,50 @@
+#pragma once
+#include "EntityManager/ShapeModel.h"
+#include "Renderer/InstanceBatch.h"
+
+/// <summary>
+/// Draws the predefined unit shapes with hardware instancing. Consecutive
+/// submissions of the same unit shape are collected into one instance batch,
+/// a batch is drawn when a different shape type (or texture) is submitted,
+/// so that the submission order is kept between the batches.
+/// Selected 2D shapes also end the batch, their outlines are drawn right after.
+/// </summary>
+class ShapeInstancer
+{
+private:
+	struct Instance
+	{
+		float model[16];	// column major
+		float color[NUM_RGBA];
+		float selected;
+	};
+
+	InstanceBatch* m_rect_batch;
+	InstanceBatch* m_tri_batch;
+	InstanceBatch* m_col_cube_batch;
+	InstanceBatch* m_tex_cube_batch;
+
+	ShapeModel::StaticShape m_pending_def;
+	InstanceBatch* m_pending_batch;
+	Texture* m_pending_texture;
+	int m_pending_texture_slot;
+	bool m_pending_has_selection;
+
+	Angel::mat4 m_proj, m_view;
+	unsigned int m_num_draw_calls;
+
+	InstanceBatch* batch_of(ShapeModel::StaticShape def);
+public:
+	ShapeInstancer();
+	~ShapeInstancer();
+
+	static bool is_instanceable(ShapeModel::StaticShape def);
+
+	void begin(const Angel::mat4& proj, const Angel::mat4& view);
+	void submit(ShapeModel* s);
+	void submit(ShapeModel* s, const Angel::mat4& model_matrix, bool selected);
+	void flush();
+	void end();
+
+	inline unsigned int num_draw_calls() const { return m_num_draw_calls; }
+};
@@ -1,6 +1,11 @@
 #pragma once
 #include "EntityManager/Shape.h"
 #include "Renderer/Texture.h"
+#include "Renderer/RenderQueue.h"
+#include "EntityManager/ComponentStore.h"
+#include "Core/ObjectPool.h"
+
+class SoftwareRasterizer;
 
 class ShapeModel
 {
@@ -22,61 +27,101 @@ private:
 	int m_texture_slot = -1;
 	Texture* m_texture = nullptr;
 
-	// Model dependent members
-	Angel::vec3* m_position; // middle point of the geometric shape
-	Angel::vec3* m_rotation; // in angles
-	Angel::vec3* m_scale;	 // scaling from the middle point
-	Angel::vec4* m_color;
+	// Model dependent members live in the component store:
+	// position is the middle point of the geometric shape, rotation is in angles,
+	// scale is applied from the middle point
+	ComponentStore::Entity m_entity;
+	bool m_scale_only = false;
+
+	// Geometry caches, the transform & geometry they were computed from are kept
+	// so that they are only rebuilt after the shape was actually modified
+	std::vector<Angel::vec3> m_world_coords;
+	std::vector<float> m_world_xs, m_world_ys;	// same outline, split per axis for the hit-test kernels
+	std::array<float, 6> m_world_bounding_cube = { 0, 0, 0, 0, 0, 0 };
+	Angel::vec3 m_cached_position, m_cached_rotation, m_cached_scale;
+	unsigned int m_world_cache_revision = 0;
+	bool m_world_cache_valid = false;
+
+	Angel::vec3 m_raw_center, m_raw_center_bottom;
+	unsigned int m_raw_cache_revision = 0;
+	bool m_raw_cache_valid = false;
+
+	// Model matrix, rebuilt only after the transform or the geometry was changed
+	Angel::mat4 m_model_matrix;
+	Angel::vec3 m_matrix_position, m_matrix_rotation, m_matrix_scale;
+	unsigned int m_matrix_revision = 0;
+	bool m_matrix_valid = false;
+
+	void update_raw_cache();
+	void update_world_cache();
 public:
 	// For predefined unit colored shapes
 	// Colored cube is also supported here
 	ShapeModel(StaticShape def,
-		Angel::vec3* pos,
-		Angel::vec3* rot,
-		Angel::vec3* scale,
-		Angel::vec4* rgba = nullptr);
+		const Angel::vec3& pos,
+		const Angel::vec3& rot,
+		const Angel::vec3& scale,
+		const Angel::vec4& rgba = Angel::vec4(0.0f, 0.0f, 0.0f, 0.0f));
 
-	// For convex polygons with varying vertex numbers
+	// For simple polygons with varying vertex numbers, convex or not
 	ShapeModel(const std::vector<Angel::vec3>& poly_mouse_model_coords,
-		Angel::vec4* rgba);
+		const Angel::vec4& rgba);
 
 	// For textured shapes, currently only cubes support textures
+	// The components are copied, a null position and rotation means only the scale is applied
 	ShapeModel(StaticShape def,
-		Angel::vec3* pos,
-		Angel::vec3* rot,
-		Angel::vec3* scale,
+		const Angel::vec3* pos,
+		const Angel::vec3* rot,
+		const Angel::vec3* scale,
 		int texture_slot,
 		Texture* texture);
 
 	~ShapeModel();
+	POOLED_ALLOCATION(ShapeModel)
+	ShapeModel(const ShapeModel&) = delete;
+	ShapeModel& operator=(const ShapeModel&) = delete;
 
-	inline Angel::vec3& position() { return *m_position; }
-	inline Angel::vec3& rotation() { return *m_rotation; }
-	inline Angel::vec3& scale() { return *m_scale; }
-	inline Angel::vec4& color() { return *m_color; }
+	inline ComponentStore::Entity entity() const { return m_entity; }
+	inline Angel::vec3& position() { return ComponentStore::get_instance().position(m_entity); }
+	inline Angel::vec3& rotation() { return ComponentStore::get_instance().rotation(m_entity); }
+	inline Angel::vec3& scale() { return ComponentStore::get_instance().scale(m_entity); }
+	inline Angel::vec4& color() { return ComponentStore::get_instance().color(m_entity); }
 	inline bool& is_hidden() { return m_is_hidden; }
 	inline Texture* texture() { return m_texture; }
 	inline int texture_slot() { return m_texture_slot; }
 	inline const VertexArray* vertex_array() { return m_shape_def->vertex_array(); }
 	inline const IndexBuffer* index_buffer() { return m_shape_def->index_buffer(); }
+	inline const IndexBuffer* polygon_triangle_index_buffer() { return m_shape_def->polygon_triangle_index_buffer(); }
+	inline const std::vector<unsigned int>& polygon_triangles() { return m_shape_def->polygon_triangles(); }
 	inline void select() { m_is_selected = true; }
 	inline void deselect() { m_is_selected = false; }
 	inline bool is_selected() { return m_is_selected; }
 	inline StaticShape shape_def() { return m_e_def; }
 	inline const float is_poly() { return m_is_poly; }
-	inline std::vector<float> raw_vertices() { return m_shape_def->vertices(); }
+	inline VertexView raw_positions() const { return m_shape_def->positions(); }
+	inline IndexView raw_indices() const { return m_shape_def->indices(); }
 
 	bool contains_2d(const Angel::vec3& model_pos);
+	bool contains_any_2d(const float* xs, const float* ys, unsigned int num_points);
 	unsigned int true_num_vertices();
-	std::vector<Angel::vec3> model_coords();
-	Angel::mat4 model_matrix();
+	const std::vector<Angel::vec3>& model_coords();
+	const std::vector<float>& world_xs();
+	const std::vector<float>& world_ys();
+	const Angel::mat4& model_matrix();
 	void push_back_vertex(const Angel::vec3& mouse_model_pos);
 	Angel::vec3 center_raw();
 	Angel::vec3 center_raw_bottom();
 	Angel::vec3 center_true();
-	std::array<float, 6> shape_bounding_cube();
+	const std::array<float, 6>& shape_bounding_cube();
 	Angel::vec3 shape_size();
 	void draw_shape(const Angel::mat4& proj, const Angel::mat4& view);
+	void submit_shape(RenderQueue& queue, const Angel::mat4& proj, const Angel::mat4& view);
+	Shape::PolygonLod& polygon_lod(float pixels_per_unit, float tolerance_px);
+	void draw_polygon_lod(Shape::PolygonLod& lod);
+	void submit_polygon_lod(RenderQueue& queue, Shape::PolygonLod& lod);
+	void draw_point();
+	void submit_point(RenderQueue& queue);
+	void submit_software(SoftwareRasterizer& rasterizer);
 
 	static std::array<float, 6> bounding_cube(const std::vector<ShapeModel*>& shapes);
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+/// <summary>
+/// Stable reference to an item of a SlotMap. The generation is bumped
+/// every time a slot is freed, so handles to removed items never resolve
+/// to a newer item that reuses the same slot.
+/// </summary>
+struct SlotHandle
+{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	inline bool is_null() const { return index == UINT32_MAX; }
+	inline bool operator==(const SlotHandle& o) const { return index == o.index && generation == o.generation; }
+	inline bool operator!=(const SlotHandle& o) const { return !(*this == o); }
+};
+
+/// <summary>
+/// Dense storage with O(1) insertion, lookup and removal through generational handles.
+/// Items are kept contiguous, removal moves the last item into the freed position.
+/// The iteration order of the items is therefore arbitrary.
+/// </summary>
+/// <typeparam name="T"></typeparam>
+template <typename T>
+class SlotMap
+{
+private:
+	struct Slot
+	{
+		uint32_t dense_index;	// position in m_items, or the next free slot
+		uint32_t generation;
+		bool occupied;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<T> m_items;
+	std::vector<uint32_t> m_item_slots;	// slot of each item in m_items
+	uint32_t m_free_head = UINT32_MAX;
+public:
+	SlotHandle insert(const T& item)
+	{
+		uint32_t slot_index;
+		if (m_free_head != UINT32_MAX)
+		{
+			slot_index = m_free_head;
+			m_free_head = m_slots[slot_index].dense_index;
+		}
+		else
+		{
+			slot_index = (uint32_t)m_slots.size();
+			m_slots.push_back({ 0, 0, false });
+		}
+		m_slots[slot_index].dense_index = (uint32_t)m_items.size();
+		m_slots[slot_index].occupied = true;
+		m_items.push_back(item);
+		m_item_slots.push_back(slot_index);
+		return { slot_index, m_slots[slot_index].generation };
+	}
+
+	bool remove(SlotHandle handle)
+	{
+		if (!contains(handle))
+		{
+			return false;
+		}
+		Slot& slot = m_slots[handle.index];
+		uint32_t dense_index = slot.dense_index;
+		uint32_t last = (uint32_t)m_items.size() - 1;
+		if (dense_index != last)
+		{
+			m_items[dense_index] = std::move(m_items[last]);
+			m_item_slots[dense_index] = m_item_slots[last];
+			m_slots[m_item_slots[dense_index]].dense_index = dense_index;
+		}
+		m_items.pop_back();
+		m_item_slots.pop_back();
+		slot.generation++;
+		slot.occupied = false;
+		slot.dense_index = m_free_head;
+		m_free_head = handle.index;
+		return true;
+	}
+
+	inline bool contains(SlotHandle handle) const
+	{
+		return handle.index < m_slots.size()
+			&& m_slots[handle.index].occupied
+			&& m_slots[handle.index].generation == handle.generation;
+	}
+
+	inline T* get(SlotHandle handle)
+	{
+		return contains(handle) ? &m_items[m_slots[handle.index].dense_index] : nullptr;
+	}
+
+	void clear()
+	{
+		// Keep the generations so that the old handles stay invalid
+		for (uint32_t i = 0; i < m_slots.size(); i++)
+		{
+			if (m_slots[i].occupied)
+			{
+				m_slots[i].generation++;
+				m_slots[i].occupied = false;
+				m_slots[i].dense_index = m_free_head;
+				m_free_head = i;
+			}
+		}
+		m_items.clear();
+		m_item_slots.clear();
+	}
+
+	inline size_t size() const { return m_items.size(); }
+	inline std::vector<T>& items() { return m_items; }
+	inline const std::vector<T>& items() const { return m_items; }
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class ShapeModel;
+
+/// <summary>
+/// Uniform grid over the 2D world plane, used by the DrawList for
+/// hit-testing and box selection. Every indexed shape is registered
+/// in all the cells its axis aligned bounding box overlaps, together
+/// with a draw order key, so that queries only visit nearby candidates
+/// and the caller can still resolve the frontmost shape.
+/// </summary>
+class SpatialIndex2D
+{
+public:
+	struct Bounds
+	{
+		float x_min, x_max, y_min, y_max;
+
+		inline bool contains(float x, float y) const
+		{
+			return x >= x_min && x <= x_max && y >= y_min && y <= y_max;
+		}
+		inline bool overlaps(const Bounds& o) const
+		{
+			return x_min <= o.x_max && x_max >= o.x_min && y_min <= o.y_max && y_max >= o.y_min;
+		}
+	};
+
+	struct Entry
+	{
+		ShapeModel* shape;
+		Bounds bounds;
+		uint64_t order;			// larger means drawn later, i.e. closer to the viewer
+	private:
+		friend class SpatialIndex2D;
+		int cx_min, cx_max, cy_min, cy_max;	// covered cell range, or oversized
+		bool oversized;
+		mutable unsigned int last_query;
+	};
+private:
+	float m_cell_size;
+	unsigned int m_query_stamp;
+	std::unordered_map<ShapeModel*, Entry> m_entries;
+	std::unordered_map<int64_t, std::vector<Entry*>> m_cells;
+
+	/// <summary>
+	/// Shapes covering more cells than this are kept in a separate list
+	/// that every query visits, instead of being smeared across the grid
+	/// </summary>
+	static constexpr int s_max_cells_per_entry = 1024;
+	std::vector<Entry*> m_oversized;
+
+	int cell_coord(float v) const;
+	static int64_t cell_key(int cx, int cy);
+	void link(Entry* e);
+	void unlink(Entry* e);
+	unsigned int next_query_stamp();
+public:
+	SpatialIndex2D(float cell_size = 256.0f);
+	~SpatialIndex2D();
+
+	void insert(ShapeModel* s, const Bounds& bounds, uint64_t order);
+	void update(ShapeModel* s, const Bounds& bounds);
+	void set_order(ShapeModel* s, uint64_t order);
+	void remove(ShapeModel* s);
+	void clear();
+	bool contains(ShapeModel* s) const;
+
+	void query_point(float x, float y, std::vector<const Entry*>& out);
+	void query_rect(const Bounds& rect, std::vector<const Entry*>& out);
+
+	inline size_t size() const { return m_entries.size(); }
+	inline float cell_size() const { return m_cell_size; }
+};
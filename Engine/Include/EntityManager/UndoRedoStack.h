@@ -10,12 +10,15 @@ private:
 	std::stack<Operation> m_undo_stack;
 	std::stack<Operation> m_redo_stack;
 	DrawList* m_draw_list;
+
+	static void erase_operations_on(std::stack<Operation>& stack, const SlotHandle& handle);
 public:
 	UndoRedoStack(DrawList* list);;
 
 	void on_operation_performed(const Operation&);
 	void on_undo();
 	void on_redo();
+	void remove_shape(ShapeModel* s);
 	bool is_undo_empty();
 	bool is_redo_empty();
 	void clear_stacks();
@@ -0,0 +1,56 @@
+#pragma once
+#include "Renderer/VertexArray.h"
+#include "Renderer/StreamingBuffer.h"
+#include "Renderer/Shader.h"
+#include "Angel-maths/mat.h"
+
+#include <vector>
+
+/// <summary>
+/// Collects colored geometry that is already transformed into the world space
+/// and draws it with as few draw calls as possible. Everything submitted between
+/// begin and end is streamed into a pair of vertex/index rings and drawn in
+/// submission order, so that painter's order is kept without a depth buffer.
+/// The shader is expected to take a position and a per-vertex color, like the
+/// colored shader does.
+/// </summary>
+class BatchRenderer2D
+{
+public:
+	struct Vertex
+	{
+		float x, y, z;
+		float r, g, b, a;
+	};
+private:
+	std::vector<Vertex> m_vertices;
+	std::vector<unsigned int> m_indices;
+	VertexArray* m_vertex_array;
+	StreamingBuffer* m_vertex_stream;
+	StreamingBuffer* m_index_stream;
+	Shader* m_shader;
+	Angel::mat4 m_view_proj;
+	unsigned int m_max_vertices;
+	unsigned int m_num_draw_calls;
+
+	// The rings hold this many frames of a typical size before a range is reused
+	static constexpr unsigned int s_frames_in_flight = 3;
+	static constexpr unsigned int s_typical_frame_vertices = 1 << 17;
+
+	void reserve(unsigned int num_vertices);
+	void push_vertex(const Angel::vec3& pos, const Angel::vec4& color);
+public:
+	BatchRenderer2D(Shader* shader, const VertexBufferLayout& layout, unsigned int max_vertices = 1 << 20);
+	~BatchRenderer2D();
+
+	void begin(const Angel::mat4& view_proj);
+	void submit_convex_polygon(const std::vector<Angel::vec3>& world_coords, const Angel::vec4& color);
+	void submit_triangles(const std::vector<Angel::vec3>& world_coords, const std::vector<unsigned int>& indices, const Angel::vec4& color);
+	void submit_point(const Angel::vec3& world_pos, float size, const Angel::vec4& color);
+	void submit_outline(const std::vector<Angel::vec3>& world_coords, float width, const Angel::vec4& color);
+	void flush();
+	void end();
+
+	inline unsigned int num_draw_calls() const { return m_num_draw_calls; }
+	inline const StreamingBuffer::Stats& vertex_stream_stats() const { return m_vertex_stream->stats(); }
+};
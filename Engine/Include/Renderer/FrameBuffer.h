@@ -13,13 +13,22 @@ namespace std {
 
 class FrameBuffer
 {
+public:
+	enum class ColorFormat
+	{
+		IntegerRGB,	// GL_RGB8UI, ids written by the entity picker
+		RGBA,		// GL_RGBA8, can be blended into and read back as an image
+	};
 private:
 	unsigned int m_frame_buffer_id;  // The frame buffer object
 	unsigned int m_fb_texture_id;	// The texture to be displayed in this frame buffer
 	unsigned int m_fb_depth_buffer_id;	// Depth buffer of this FB
 	int m_viewport_width, m_viewport_height; // Cached viewport size of this FB
+	ColorFormat m_color_format;
+
+	void allocate_attachments();
 public:
-	FrameBuffer(int width, int height);
+	FrameBuffer(int width, int height, ColorFormat color_format = ColorFormat::IntegerRGB);
 	~FrameBuffer();
 
 	void on_update(const std::function<void(void)>& draw_function);
@@ -28,5 +37,7 @@ public:
 	void unbind();
 	std::array<uint8_t, 3> read_pixel(int pixel_x, int pixel_y);
 	std::array<int, 2> viewport_size();
+	inline unsigned int id() const { return m_frame_buffer_id; }
+	inline ColorFormat color_format() const { return m_color_format; }
 
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include "Angel-maths/mat.h"
+
+/// <summary>
+/// Uniform buffer holding the data that stays the same over a frame: the camera
+/// matrices and the light. It is uploaded once per frame and read by every shader
+/// that declares the FrameData block, so that the draws only set their per-object
+/// uniforms. Angel matrices are row major, the block is declared row_major in GLSL
+/// so they are copied as they are.
+/// </summary>
+class FrameUniforms
+{
+public:
+	// std140 layout of the FrameData block
+	struct Block
+	{
+		Angel::mat4 proj;
+		Angel::mat4 view;
+		Angel::vec4 light_position;		// view space
+	};
+	static_assert(sizeof(Block) == 2 * 16 * sizeof(float) + 4 * sizeof(float), "FrameData must match the std140 layout");
+
+	static constexpr const char* s_block_name = "FrameData";
+	static constexpr unsigned int s_binding_point = 0;
+private:
+	static unsigned int s_buffer_id;
+	static Block s_block;
+	static unsigned int s_num_uploads;
+public:
+	static void update(const Angel::mat4& proj, const Angel::mat4& view, const Angel::vec4& light_position);
+	static void bind_block(unsigned int program_id);
+	static void destroy();
+
+	inline static const Block& block() { return s_block; }
+	inline static unsigned int num_uploads() { return s_num_uploads; }
+};
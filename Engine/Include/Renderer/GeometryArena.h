@@ -0,0 +1,95 @@
+#pragma once
+#include "Renderer/VertexArray.h"
+#include "Renderer/VertexBuffer.h"
+#include "Renderer/IndexBuffer.h"
+#include "Renderer/VertexBufferLayout.h"
+#include <map>
+
+/// <summary>
+/// First fit allocator of element ranges. The free blocks are kept sorted by their
+/// first element, so a freed range is merged with the free blocks around it.
+/// </summary>
+class RangeAllocator
+{
+private:
+	std::map<unsigned int, unsigned int> m_free_blocks;		// first element -> count
+	unsigned int m_capacity;
+	unsigned int m_used;
+public:
+	static constexpr unsigned int s_invalid = 0xFFFFFFFF;
+
+	RangeAllocator(unsigned int capacity);
+
+	// Returns the first element of the range, or s_invalid if no free block is large enough
+	unsigned int allocate(unsigned int count);
+	void free(unsigned int first, unsigned int count);
+	// Appends free elements up to the new capacity
+	void grow(unsigned int capacity);
+
+	inline unsigned int capacity() const { return m_capacity; }
+	inline unsigned int used() const { return m_used; }
+	inline unsigned int num_free_blocks() const { return (unsigned int)m_free_blocks.size(); }
+	unsigned int largest_free_block() const;
+};
+
+/// <summary>
+/// One large vertex buffer and index buffer pair for all the geometry of a vertex layout,
+/// with a single vertex array over them. VertexBuffer and IndexBuffer objects created on an
+/// arena own a range of it instead of a GL buffer; the index ranges are drawn with the first
+/// vertex of their vertex range as the base vertex, so the indices stay local to their mesh.
+/// Draws from the same arena share the vertex array and the element buffer binding, and can
+/// be merged into one glMultiDrawElementsBaseVertex. Index ranges are counted in 32 bit slots,
+/// a range of 16 bit indices takes half as many. The buffers double when they are full;
+/// their names do not change, so other vertex arrays that read from them stay valid.
+/// </summary>
+class GeometryArena
+{
+public:
+	struct Report
+	{
+		unsigned int vertex_size;				// in bytes
+		unsigned int vertex_capacity;			// in vertices
+		unsigned int num_vertices;				// allocated
+		unsigned int num_vertex_free_blocks;
+		unsigned int largest_vertex_free_block;
+		unsigned int index_capacity;			// in 32 bit slots
+		unsigned int num_indices;				// allocated slots
+		unsigned int num_index_free_blocks;
+		unsigned int largest_index_free_block;
+		unsigned int num_growths;
+
+		// 0 when the free space is one block, close to 1 when it is scattered in small ones
+		float vertex_fragmentation() const;
+		float index_fragmentation() const;
+		unsigned int reserved_bytes() const;
+		unsigned int used_bytes() const;
+	};
+private:
+	unsigned int m_vertex_size;
+	VertexBuffer* m_vertex_storage;
+	IndexBuffer* m_index_storage;
+	VertexArray* m_vertex_array;
+	RangeAllocator m_vertices;
+	RangeAllocator m_indices;
+	unsigned int m_num_growths;
+
+	void grow_storage(unsigned int target, unsigned int buffer_id, unsigned int old_size, unsigned int new_size);
+public:
+	GeometryArena(const VertexBufferLayout& layout, unsigned int vertex_capacity, unsigned int index_capacity);
+	~GeometryArena();
+
+	unsigned int allocate_vertices(unsigned int count);
+	unsigned int allocate_indices(unsigned int count);
+	void free_vertices(unsigned int first, unsigned int count);
+	void free_indices(unsigned int first, unsigned int count);
+
+	// Offsets and sizes are relative to the whole arena
+	void upload_vertices(const void* data, unsigned int offset, unsigned int size);
+	void upload_indices(const void* data, unsigned int offset, unsigned int size);
+
+	inline VertexArray* vertex_array() const { return m_vertex_array; }
+	inline unsigned int vertex_buffer_id() const { return m_vertex_storage->id(); }
+	inline unsigned int index_buffer_id() const { return m_index_storage->id(); }
+	inline unsigned int vertex_size() const { return m_vertex_size; }
+	Report report() const;
+};
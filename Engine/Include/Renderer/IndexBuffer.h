@@ -1,17 +1,70 @@
 #pragma once
+#include "Core/ObjectPool.h"
+#include <vector>
 
+class GeometryArena;
+
+/// <summary>
+/// Indices are given as unsigned int, and stored as 16 bit values when the largest index
+/// fits, 32 bit otherwise. s_restart_index in the given indices restarts the strip, it is
+/// stored as the all ones value of the storage type, which is never a valid index.
+/// </summary>
 class IndexBuffer
 {
 private:
 	unsigned int m_index_buffer_id;
 	unsigned int m_count;
+	unsigned int m_capacity;	// in indices of the current type
+	unsigned int m_index_type;	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	GeometryArena* m_arena;		// nullptr when the buffer owns its storage
+	unsigned int m_first_slot;	// of the range in the arena, the arena counts 32 bit slots
+	unsigned int m_num_slots;
+	int m_base_vertex;			// added to the indices, the first vertex of the mesh in the arena
+
+	void upload(const unsigned int* data, unsigned int first, unsigned int count);
 public:
+	static constexpr unsigned int s_restart_index = 0xFFFFFFFF;
+
+	POOLED_ALLOCATION(IndexBuffer)
+
 	IndexBuffer();
 	IndexBuffer(const unsigned int*, unsigned int);
+	// Empty range of the arena, reallocate or set_data gives it a storage
+	IndexBuffer(GeometryArena& arena, int base_vertex);
 	~IndexBuffer();
 
 	void bind() const;
 	void unbind() const;
+	void set_data(const unsigned int* data, unsigned int count);
+	// max_index is the largest index that later updates will write, the type must already hold it
+	void reallocate(const unsigned int* data, unsigned int count, unsigned int capacity, unsigned int max_index = 0);
+	void update(const unsigned int* data, unsigned int first, unsigned int count);
+	inline void set_base_vertex(int base_vertex) { m_base_vertex = base_vertex; }
 
+	inline unsigned int id() const { return m_index_buffer_id; }
 	inline unsigned int count() const { return m_count; }
+	inline unsigned int capacity() const { return m_capacity; }
+	inline bool in_arena() const { return m_arena != nullptr; }
+	inline int base_vertex() const { return m_base_vertex; }
+	// Type to pass to the draw calls
+	inline unsigned int index_type() const { return m_index_type; }
+	inline unsigned int index_size() const { return size_of_type(m_index_type); }
+	// Whether update can write the index without a reallocation
+	inline bool holds(unsigned int index) const { return index < restart_index(); }
+	// Stored value of s_restart_index, for glPrimitiveRestartIndex
+	inline unsigned int restart_index() const { return restart_index_of(m_index_type); }
+	// Byte offset of the given index of the buffer in the bound element buffer, for the draw calls
+	inline const void* offset_of(unsigned int index) const
+	{
+		return (const void*)((unsigned long long)m_first_slot * sizeof(unsigned int) + (unsigned long long)index * index_size());
+	}
+
+	// Smallest type that holds the index without taking the restart value
+	static unsigned int type_for(unsigned int max_index);
+	static unsigned int size_of_type(unsigned int index_type);
+	static unsigned int restart_index_of(unsigned int index_type);
+	// Strip indices of a grid of num_rows x num_columns vertices, vertex (i, j) being i * num_columns + j.
+	// One strip per pair of rows, separated by s_restart_index, with the winding of the
+	// triangles (i, j) (i + 1, j) (i + 1, j + 1).
+	static void grid_triangle_strips(unsigned int num_rows, unsigned int num_columns, std::vector<unsigned int>& strips);
 };
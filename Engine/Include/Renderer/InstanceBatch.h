@@ -0,0 +1,38 @@
+#pragma once
+#include "Renderer/VertexArray.h"
+#include "Renderer/VertexBuffer.h"
+#include "Renderer/IndexBuffer.h"
+#include "Renderer/VertexBufferLayout.h"
+
+#include <vector>
+
+/// <summary>
+/// Pairs a mesh with a per-instance attribute buffer, so that
+/// many copies of the mesh are drawn with a single draw call.
+/// The mesh buffers are not owned by the batch.
+/// </summary>
+class InstanceBatch
+{
+private:
+	VertexArray* m_vertex_array;
+	VertexBuffer* m_instance_buffer;
+	const IndexBuffer* m_index_buffer;
+	std::vector<float> m_instance_data;
+	unsigned int m_floats_per_instance;
+	unsigned int m_num_instances;
+public:
+	InstanceBatch(const VertexBuffer& vertex_buffer,
+		const VertexBufferLayout& vertex_layout,
+		const IndexBuffer& index_buffer,
+		const VertexBufferLayout& instance_layout,
+		unsigned int first_instance_attribute);
+	~InstanceBatch();
+
+	void clear();
+	void push_instance(const float* data);
+	void upload();
+
+	inline unsigned int num_instances() const { return m_num_instances; }
+	inline const VertexArray* vertex_array() const { return m_vertex_array; }
+	inline const IndexBuffer* index_buffer() const { return m_index_buffer; }
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+struct __GLsync;
+class FrameBuffer;
+
+/// <summary>
+/// Asynchronous glReadPixels through a ring of pixel buffer objects. A read only
+/// queues the copy of the color attachment into the next buffer and fences it; the
+/// buffer is mapped once its fence has signaled, typically after the next frame was
+/// submitted, so the transfer of one frame overlaps the rendering of the next one.
+/// </summary>
+class PixelReadback
+{
+public:
+	struct Image
+	{
+		std::vector<uint8_t> pixels;	// RGBA8, bottom row first
+		int width = 0;
+		int height = 0;
+		uint64_t tag = 0;				// given to read
+	};
+
+	struct Stats
+	{
+		unsigned int num_reads;
+		unsigned int num_stalls;		// collects that had to wait for the GPU
+	};
+private:
+	struct Slot
+	{
+		unsigned int buffer_id;
+		unsigned int capacity;			// in bytes
+		__GLsync* sync;					// guards the pending read
+		int width, height;
+		uint64_t tag;
+	};
+
+	std::vector<Slot> m_slots;
+	unsigned int m_next_slot;			// slot of the next read
+	unsigned int m_num_pending;			// reads not collected yet, the oldest ones are before m_next_slot
+	Stats m_stats;
+public:
+	PixelReadback(unsigned int num_buffers = 3);
+	~PixelReadback();
+	PixelReadback(const PixelReadback&) = delete;
+
+	// Queues the copy of the whole color attachment, the frame buffer must be ColorFormat::RGBA
+	// and the ring must not be full
+	void read(FrameBuffer& frame_buffer, uint64_t tag);
+	// Copies the oldest pending read into the image. Without waiting, returns
+	// false while the GPU has not finished it; always false when nothing is pending.
+	bool collect(Image& image, bool wait);
+
+	inline bool full() const { return m_num_pending == m_slots.size(); }
+	inline unsigned int num_pending() const { return m_num_pending; }
+	inline const Stats& stats() const { return m_stats; }
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include "Renderer/VertexArray.h"
+#include "Renderer/IndexBuffer.h"
+#include "Renderer/Shader.h"
+#include "Renderer/Texture.h"
+#include "Angel-maths/mat.h"
+
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// Deferred draw calls of a frame. Every submission records its state and uniforms
+/// together with a packed 64 bit sort key, the commands are radix sorted by the key
+/// at flush and then executed. From the most significant bit, a key holds:
+///		layer (2), translucency (1), then for opaque commands
+///		shader (10), texture (10), vertex array (12), depth front to back (24),
+///		and for ordered commands
+///		depth back to front or the submission order (24), shader, texture, vertex array.
+/// Opaque 3D commands are therefore grouped by state, translucent ones are drawn
+/// back to front, and the World2D layer keeps the painter's order of the submissions.
+/// Consecutive commands with the same state and uniforms, e.g. ranges of one GeometryArena,
+/// are drawn with a single glMultiDrawElementsBaseVertex.
+/// </summary>
+class RenderQueue
+{
+public:
+	enum class Layer : uint8_t
+	{
+		Scene = 0,		// 3D geometry with depth test
+		World2D = 1,	// 2D shapes, always drawn in submission order
+		Overlay = 2,	// drawn last, in submission order
+	};
+
+	enum class Primitive : uint8_t
+	{
+		Triangles,
+		TriangleStrip,	// strips separated by IndexBuffer::s_restart_index
+		Lines,
+		LineStrip,
+		LineLoop,
+		Points,
+	};
+
+	struct DrawCommand
+	{
+		Layer layer = Layer::Scene;
+		bool translucent = false;
+		float depth = 0.0f;						// distance from the camera, in view space
+		Shader* shader = nullptr;
+		const Texture* texture = nullptr;
+		unsigned int texture_slot = 0;
+		const VertexArray* vertex_array = nullptr;
+		const IndexBuffer* index_buffer = nullptr;
+		Primitive primitive = Primitive::Triangles;
+		int count = -1;							// -1 draws the whole index buffer
+		unsigned int first_index = 0;
+	};
+
+	struct Stats
+	{
+		unsigned int num_commands;
+		unsigned int num_shader_changes;
+		unsigned int num_texture_changes;
+		unsigned int num_vertex_array_changes;
+		unsigned int num_draw_calls;			// merged commands count once
+	};
+private:
+	enum class UniformType : uint8_t
+	{
+		Int,
+		Float,
+		Vec4,
+		Mat4,
+	};
+
+	struct Uniform
+	{
+		unsigned int index;		// of the ShaderUniform handle
+		UniformType type;
+		int i;
+		float f[16];
+	};
+
+	struct Command
+	{
+		DrawCommand draw;
+		unsigned int first_uniform;
+		unsigned int num_uniforms;
+	};
+
+	std::vector<Command> m_commands;
+	std::vector<Uniform> m_uniforms;
+	std::vector<uint64_t> m_keys;
+	std::vector<uint32_t> m_order, m_order_scratch;
+	uint32_t m_sequence;
+	Stats m_last_stats;
+	std::vector<int> m_multi_counts;
+	std::vector<const void*> m_multi_offsets;
+	std::vector<int> m_multi_base_vertices;
+
+	static constexpr uint32_t s_depth_bits = 24;
+
+	uint64_t sort_key(const DrawCommand& draw);
+	Uniform& push_uniform(unsigned int index, UniformType type);
+	void radix_sort();
+	void apply_state(const Command& command);
+	bool can_merge(const Command& first, const Command& second) const;
+	void execute(uint32_t begin, uint32_t end);
+public:
+	RenderQueue();
+
+	// The uniforms set after a submission belong to it
+	void submit(const DrawCommand& draw);
+	void uniform_1i(const ShaderUniform<int>& uniform, int value);
+	void uniform_1f(const ShaderUniform<float>& uniform, float value);
+	void uniform_4f(const ShaderUniform<Angel::vec4>& uniform, const Angel::vec4& value);
+	void uniform_mat4f(const ShaderUniform<Angel::mat4>& uniform, const Angel::mat4& value);
+
+	// Sorts and executes the commands, then clears the queue
+	void flush();
+	void clear();
+
+	inline unsigned int size() const { return (unsigned int)m_commands.size(); }
+	inline const Stats& last_stats() const { return m_last_stats; }
+
+	// Queue for the draw_* helpers that flush right after their submissions
+	static RenderQueue& immediate();
+};
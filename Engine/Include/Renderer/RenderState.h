@@ -0,0 +1,66 @@
+#pragma once
+
+/// <summary>
+/// Cache of the GL state that the engine changes, so that binding an object that
+/// is already bound does not reach the driver. All the binds of the renderer classes
+/// go through here; code that changes the state behind its back must call invalidate.
+/// The element buffer binding is part of the vertex array state, so it is remembered
+/// per vertex array.
+/// </summary>
+class RenderState
+{
+public:
+	struct Counters
+	{
+		unsigned int num_binds;			// state changes that were sent to GL
+		unsigned int num_elided_binds;	// requests that matched the cached state
+	};
+private:
+	static constexpr unsigned int s_unknown = 0xFFFFFFFF;
+	static constexpr unsigned int s_max_texture_units = 32;
+
+	static unsigned int s_program;
+	static unsigned int s_vertex_array;
+	static unsigned int s_array_buffer;
+	static unsigned int s_active_texture_unit;
+	static unsigned int s_textures[s_max_texture_units];
+	static int s_blend;				// -1 while unknown
+	static int s_depth_test;
+	static int s_primitive_restart;
+	static long long s_primitive_restart_index;	// every unsigned int is a valid index, -1 while unknown
+	static unsigned int s_blend_src, s_blend_dst;
+	static unsigned int s_depth_func;
+
+	static Counters s_frame_counters;
+	static Counters s_last_frame_counters;
+
+	static bool changes(unsigned int& cached, unsigned int value);
+	static unsigned int& element_buffer_of_current_vertex_array();
+public:
+	static void use_program(unsigned int program_id);
+	static void bind_vertex_array(unsigned int vertex_array_id);
+	static void bind_element_buffer(unsigned int buffer_id);
+	static void bind_array_buffer(unsigned int buffer_id);
+	static void bind_texture(unsigned int texture_id);
+	static void bind_texture(unsigned int unit, unsigned int texture_id);
+	static void set_blend(bool enabled);
+	static void set_blend_func(unsigned int src, unsigned int dst);
+	static void set_depth_test(bool enabled);
+	static void set_depth_func(unsigned int func);
+	// Only the strip draws enable it, the index depends on the index type of the draw
+	static void set_primitive_restart(bool enabled, unsigned int index = 0);
+
+	// Called before the objects are deleted, GL resets the bindings of deleted names
+	static void on_delete_program(unsigned int program_id);
+	static void on_delete_vertex_array(unsigned int vertex_array_id);
+	static void on_delete_buffer(unsigned int buffer_id);
+	static void on_delete_texture(unsigned int texture_id);
+
+	// Forgets the whole cached state, the next binds are all sent to GL
+	static void invalidate();
+
+	// Starts counting the binds of a new frame
+	static void begin_frame();
+	inline static const Counters& last_frame_counters() { return s_last_frame_counters; }
+	inline static const Counters& frame_counters() { return s_frame_counters; }
+};
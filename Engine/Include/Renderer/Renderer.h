@@ -12,6 +12,11 @@ public:
 		const IndexBuffer* index_buffer_obj,
 		const Shader* shader_obj);
 
+	// Strips separated by IndexBuffer::s_restart_index
+	static void draw_triangle_strips(const VertexArray* vertex_array_obj,
+		const IndexBuffer* index_buffer_obj,
+		const Shader* shader_obj);
+
 	static void draw_polygon(const VertexArray* vertex_array_obj,
 			const IndexBuffer* index_buffer_obj,
 			const Shader* shader_obj);
@@ -20,6 +25,21 @@ public:
 		const IndexBuffer* index_buffer_obj,
 		const Shader* shader_obj, int count = -1, const void* offset = nullptr);
 
+	static void draw_triangles_instanced(const VertexArray* vertex_array_obj,
+		const IndexBuffer* index_buffer_obj,
+		const Shader* shader_obj,
+		unsigned int instance_count);
+
+	static void draw_lines_instanced(const VertexArray* vertex_array_obj,
+		const IndexBuffer* index_buffer_obj,
+		const Shader* shader_obj,
+		unsigned int instance_count,
+		int count = -1);
+
+	static void draw_points(const VertexArray* vertex_array_obj,
+		const IndexBuffer* index_buffer_obj,
+		const Shader* shader_obj, int count = -1);
+
 	static void draw_seperate_lines(const VertexArray* vertex_array_obj,
 		const IndexBuffer* index_buffer_obj,
 		const Shader* shader_obj);
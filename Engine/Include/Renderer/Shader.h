@@ -1,13 +1,44 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include "Angel-maths/mat.h"
+
+class VertexBufferLayout;
+template <typename T> class ShaderUniform;
+
 class Shader
 {
+public:
+	/// <summary>
+	/// Active uniform reported by GL after linking. Uniforms that live in
+	/// a uniform block have no location, block_index tells which block.
+	/// </summary>
+	struct UniformInfo
+	{
+		std::string name;		// without the [0] suffix of arrays
+		int location;
+		unsigned int type;		// GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+		int size;				// number of array elements, 1 otherwise
+		int block_index;		// -1 for default block uniforms
+	};
+
+	struct AttributeInfo
+	{
+		std::string name;
+		int location;
+		unsigned int type;
+		int size;
+	};
 private:
+	static constexpr int s_unresolved = -2;
+
 	unsigned int m_shader_id;
 	std::string m_shader_path;
 	std::unordered_map<std::string, int> m_uniform_location_cache;
+	std::vector<int> m_handle_locations;	// indexed by the ShaderUniform handles
+	std::vector<UniformInfo> m_uniforms;
+	std::vector<AttributeInfo> m_attributes;
 public:
 	Shader() : m_shader_id(0), m_shader_path(""), m_uniform_location_cache({}) {}
 	Shader(const char* path);
@@ -15,6 +46,7 @@ public:
 
 	void bind() const;
 	void unbind() const;
+	inline unsigned int id() const { return m_shader_id; }
 
 	void set_uniform_1i(const std::string& name, int value);
 	void set_uniform_3ui(const std::string& name, unsigned int v0, unsigned int v1, unsigned int v2);
@@ -22,11 +54,55 @@ public:
 	void set_uniform_4f(const std::string& name, float v0, float v1, float v2, float v3);
 	void set_uniform_mat4f(const std::string& name, Angel::mat4 mat);
 
+	// Handle based setters, no string is built or hashed
+	void set_uniform(const ShaderUniform<int>& uniform, int value);
+	void set_uniform(const ShaderUniform<float>& uniform, float value);
+	void set_uniform(const ShaderUniform<Angel::vec4>& uniform, const Angel::vec4& value);
+	void set_uniform(const ShaderUniform<Angel::mat4>& uniform, const Angel::mat4& value);
+
+	// Reflection of the linked program
+	inline const std::vector<UniformInfo>& uniforms() const { return m_uniforms; }
+	inline const std::vector<AttributeInfo>& attributes() const { return m_attributes; }
+	const UniformInfo* find_uniform(const std::string& name) const;
+	const AttributeInfo* find_attribute(const std::string& name) const;
+	template <typename T>
+	bool has_uniform(const ShaderUniform<T>& uniform) const;
+	bool check_layout(const VertexBufferLayout& layout) const;
+
 	static unsigned int get_glsl_version();
+
+	// Registry of the uniform names used by the handles
+	static unsigned int register_uniform(const char* name);
+	static const std::string& uniform_name(unsigned int index);
 private:
 	int uniform_location(const std::string& name);
+	int handle_location(unsigned int index);
+	void reflect();
 
 	static std::string parse_shader_file(const char* file_path);
 	static unsigned int create_program_from_shaders(const std::string& shader);
 	static unsigned int compile_shader(unsigned int type, const std::string& shader_source_code);
-};
\ No newline at end of file
+};
+
+/// <summary>
+/// Uniform name resolved once to a small index, meant to be kept in a static
+/// next to the code that sets it. Every Shader maps the index to its own location
+/// through a plain array that is filled on first use. T is the C++ side of the
+/// GLSL type: int (also bool and samplers), float, Angel::vec4 or Angel::mat4.
+/// </summary>
+/// <typeparam name="T"></typeparam>
+template <typename T>
+class ShaderUniform
+{
+private:
+	unsigned int m_index;
+
+	explicit ShaderUniform(unsigned int index) : m_index(index) {}
+public:
+	explicit ShaderUniform(const char* name) : m_index(Shader::register_uniform(name)) {}
+
+	inline unsigned int index() const { return m_index; }
+	inline const std::string& name() const { return Shader::uniform_name(m_index); }
+
+	inline static ShaderUniform from_index(unsigned int index) { return ShaderUniform(index); }
+};
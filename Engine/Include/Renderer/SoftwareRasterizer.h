@@ -0,0 +1,155 @@
+#pragma once
+#include "EntityManager/GeometryView.h"
+#include "Angel-maths/mat.h"
+
+#include <vector>
+#include <cstdint>
+
+// Instruction set of the edge function kernels, picked at compile time
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SR_USE_SSE 1
+#else
+#define SR_USE_SSE 0
+#endif
+
+class ThreadPool;
+
+/// <summary>
+/// CPU backend that produces the same pixels as the GL path without a context, for
+/// machines that have no GPU. Draws take the same inputs the GL path binds: vertex
+/// attributes, an index list with a base vertex, and the uniforms of one of the engine
+/// shaders. The frame data (projection, view, light) mirrors FrameUniforms.
+///
+/// Each draw is transformed, clipped and binned into 64x64 pixel tiles right away, in
+/// submission order. flush rasterizes the tiles in parallel, every tile applies its
+/// triangles in order, so the painter's order of 2D scenes and blending match GL.
+/// Coverage uses integer edge functions with 4 bits of sub-pixel precision and the
+/// top-left fill rule, evaluated 4 pixels at a time. Only triangles are rasterized.
+/// </summary>
+class SoftwareRasterizer
+{
+public:
+	// The engine shader that a draw replicates
+	enum class Shading : uint8_t
+	{
+		Flat,		// triangle.glsl, u_color
+		Colored,	// colored_triangle.glsl, per vertex colors
+		Textured,	// textured_shaded_triangle.glsl, texture modulated by Phong lighting
+		Phong,		// p_shaded_triangle.glsl, u_color lit per pixel, optionally with a normal map
+	};
+
+	// RGBA8 pixels with the bottom row first, like the images that Texture uploads
+	struct Image
+	{
+		const uint8_t* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+	};
+
+	struct Material
+	{
+		Angel::vec4 ambient = { 0.32f, 0.173f, 0.118f, 1.0f };
+		Angel::vec4 diffuse = { 0.75f, 0.5f, 0.0f, 1.0f };
+		Angel::vec4 specular = { 1.0f, 1.0f, 1.0f, 1.0f };
+		float shininess = 50.0f;
+	};
+
+	/// <summary>
+	/// One draw call. The views must stay valid until the next flush.
+	/// </summary>
+	struct Mesh
+	{
+		VertexView positions;
+		VertexView colors;				// Colored
+		VertexView uvs;					// Textured, and Phong with a normal map
+		VertexView normals;				// Textured and Phong
+		VertexView tangents;			// Phong with a normal map
+		IndexView indices;				// triangle list
+		int base_vertex = 0;			// added to the indices, e.g. 1 for the corner indices of polygons
+		Shading shading = Shading::Flat;
+		Angel::mat4 model;
+		Angel::vec4 color = { 1.0f, 1.0f, 1.0f, 1.0f };	// Flat and Phong
+		const Image* texture = nullptr;	// Textured: albedo, Phong: tangent space normal map
+		Material material;
+		bool selected = false;			// Textured, like u_selected
+		bool depth_test = true;			// GL_LEQUAL
+		bool cull_back_faces = false;	// clockwise triangles in window space, like GL_CULL_FACE
+		bool blend = true;				// GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, as the apps set it
+	};
+
+	struct Stats
+	{
+		unsigned int num_triangles;		// submitted
+		unsigned int num_clipped;		// outside the view volume or degenerate
+		unsigned int num_bin_entries;	// triangle and tile pairs
+		unsigned int num_tiles;			// that had at least one triangle
+	};
+private:
+	static constexpr int s_tile_size = 64;
+	static constexpr int s_sub_pixel_bits = 4;
+	static constexpr int s_max_varyings = 12;
+	static constexpr int s_max_size = 8192;
+
+	struct ClipVertex
+	{
+		Angel::vec4 position;			// clip space
+		float varyings[s_max_varyings];
+	};
+
+	struct Triangle
+	{
+		int32_t x[3], y[3];				// window space, in sub-pixels
+		float z[3];						// depth in [0, 1]
+		float inv_w[3];
+		float varyings[3][s_max_varyings];	// divided by w, for perspective correct interpolation
+		int32_t a[3], b[3];				// edge functions a * x + b * y + c, edge i is opposite of vertex i
+		int64_t c[3];
+		bool top_left[3];
+		int64_t area;					// twice the area, in sub-pixels squared
+		int min_x, min_y, max_x, max_y;	// pixel bounds, inclusive
+		unsigned int mesh;
+	};
+
+	int m_width, m_height;
+	int m_tiles_x, m_tiles_y;
+	ThreadPool& m_pool;
+	std::vector<uint32_t> m_color;		// RGBA8, bottom row first
+	std::vector<float> m_depth;
+	std::vector<Mesh> m_meshes;
+	std::vector<unsigned int> m_num_varyings;	// per mesh
+	std::vector<Triangle> m_triangles;
+	std::vector<std::vector<uint32_t>> m_bins;	// triangle indices per tile
+	std::vector<ClipVertex> m_clip_vertices;	// scratch of the vertex stage
+	Angel::mat4 m_proj, m_view;
+	Angel::vec4 m_light_position;
+	Stats m_stats, m_last_stats;
+
+	unsigned int shade_vertices(const Mesh& mesh);
+	void clip_and_setup(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int num_varyings);
+	void setup(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int num_varyings);
+	void rasterize_tile(unsigned int tile);
+	void rasterize(const Triangle& triangle, int tile_x, int tile_y);
+	void write_pixel(const Triangle& triangle, int x, int y);
+	Angel::vec4 shade_pixel(const Mesh& mesh, const float* varyings) const;
+public:
+	SoftwareRasterizer(int width, int height, ThreadPool& pool);
+
+	void resize(int width, int height);
+	// Same data as FrameUniforms::update, the light is in view space
+	void set_frame(const Angel::mat4& proj, const Angel::mat4& view, const Angel::vec4& light_position);
+	// Like glClearColor and glClear of the color and depth buffers
+	void clear(const Angel::vec4& color, float depth = 1.0f);
+	void draw(const Mesh& mesh);
+	// Rasterizes the binned triangles into the buffers, then forgets the draws
+	void flush();
+
+	inline int width() const { return m_width; }
+	inline int height() const { return m_height; }
+	// RGBA8, bottom row first like glReadPixels
+	inline const uint8_t* pixels() const { return (const uint8_t*)m_color.data(); }
+	inline const std::vector<float>& depth() const { return m_depth; }
+	inline const Stats& last_stats() const { return m_last_stats; }
+
+	// Bilinear, clamped to the edges, like the GL_LINEAR textures of the engine
+	static Angel::vec4 sample(const Image& image, float u, float v);
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <deque>
+
+struct __GLsync;
+
+/// <summary>
+/// Ring buffer for geometry that is rewritten every frame. Each write takes the
+/// next free range of the ring through an unsynchronized map, and the ranges of
+/// a frame are guarded by a fence once the frame ends. A range is reused only after
+/// its fence has signaled; if the GPU is still behind, the storage is orphaned
+/// instead of waiting, so the CPU never stalls on the buffer. The buffer name stays
+/// the same, vertex arrays that reference it remain valid.
+/// </summary>
+class StreamingBuffer
+{
+public:
+	struct Stats
+	{
+		unsigned int num_bytes;			// written since the last end_frame
+		unsigned int num_orphans;		// storage replaced because the GPU was behind
+		unsigned int num_reallocations;	// storage grown for a write larger than the ring
+	};
+private:
+	struct Fence
+	{
+		__GLsync* sync;
+		unsigned int begin, end;		// byte range written before the fence
+	};
+
+	unsigned int m_buffer_id;
+	unsigned int m_capacity;
+	unsigned int m_head;				// next free byte
+	unsigned int m_pending_begin;		// first byte written since the last fence
+	std::deque<Fence> m_fences;			// oldest first
+	Stats m_stats;
+
+	void allocate_storage(unsigned int capacity);
+	void fence_pending();
+	void delete_fences();
+	void retire_signaled_fences();
+	bool is_free(unsigned int begin, unsigned int end);
+	unsigned int reserve(unsigned int size, unsigned int alignment);
+public:
+	StreamingBuffer(unsigned int capacity);
+	~StreamingBuffer();
+
+	// Copies the data into the ring and returns its offset in bytes,
+	// the offset is a multiple of the alignment, which needs not be a power of two
+	unsigned int push(const void* data, unsigned int size, unsigned int alignment = 4);
+	void end_frame();
+
+	void bind_as_vertex_buffer() const;
+	void bind_as_index_buffer() const;
+
+	inline unsigned int id() const { return m_buffer_id; }
+	inline unsigned int capacity() const { return m_capacity; }
+	inline const Stats& stats() const { return m_stats; }
+};
@@ -17,6 +17,7 @@ public:
 	void bind(unsigned int slot_number = 0) const;
 	void unbind() const;
 
+	inline unsigned int id() const { return m_texture_id; }
 	inline int width() { return m_width; };
 	inline int height() { return m_height; };
 };
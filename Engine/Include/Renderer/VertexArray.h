@@ -1,18 +1,26 @@
 #pragma once
 #include "Renderer/VertexBuffer.h"
 #include "Renderer/VertexBufferLayout.h"
+#include "Renderer/StreamingBuffer.h"
+#include "Core/ObjectPool.h"
 
 class VertexArray
 {
 	unsigned int m_vertex_array_id;
 	unsigned int m_num_vertices;
 private:
+	void set_attribute_pointers(const VertexBufferLayout& layout, unsigned int first_attribute, unsigned int divisor);
 
 public:
+	POOLED_ALLOCATION(VertexArray)
+
 	VertexArray();
 	~VertexArray();
 
 	void add_buffer(const VertexBuffer& vertex_buffer, const VertexBufferLayout& layout); 
+	void add_instance_buffer(const VertexBuffer& instance_buffer, const VertexBufferLayout& layout, unsigned int first_attribute);
+	void add_stream(const StreamingBuffer& stream, const VertexBufferLayout& layout);
 	void bind() const;
 	void unbind() const;
+	inline unsigned int id() const { return m_vertex_array_id; }
 };
\ No newline at end of file
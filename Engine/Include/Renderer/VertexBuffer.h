@@ -1,16 +1,33 @@
 #pragma once
+#include "Core/ObjectPool.h"
+
+class GeometryArena;
 
 class VertexBuffer
 {
 private:
 	unsigned int m_vertex_buffer_id;
 	unsigned int m_size;
+	unsigned int m_capacity;
+	GeometryArena* m_arena;			// nullptr when the buffer owns its storage
+	unsigned int m_first_vertex;	// of the range in the arena
 public:
+	POOLED_ALLOCATION(VertexBuffer)
+
 	VertexBuffer();
 	VertexBuffer(const void*, unsigned int);
+	// Empty range of the arena, reallocate or set_data gives it a storage
+	VertexBuffer(GeometryArena& arena);
 	~VertexBuffer();
 
 	void bind() const;
 	void unbind() const;
+	void set_data(const void* data, unsigned int size);
+	void reallocate(const void* data, unsigned int size, unsigned int capacity);
+	void update(const void* data, unsigned int offset, unsigned int size);
+	inline unsigned int id() const { return m_vertex_buffer_id; }
 	inline unsigned int size() const { return m_size; } ;
+	inline unsigned int capacity() const { return m_capacity; }
+	inline bool in_arena() const { return m_arena != nullptr; }
+	inline unsigned int first_vertex() const { return m_first_vertex; }
 };
@@ -1,5 +1,22 @@
 #pragma once
 #include <vector>
+#include <cstdint>
+
+// Registered packed types for push_back_elements, filled with the VertexPacking functions.
+// Half float components, 2 bytes each
+struct HalfFloat { uint16_t bits; };
+// Signed normalized 10-10-10-2, a whole vec4 in 4 bytes (x, y, z with 10 bits, w with 2),
+// for unit vectors like normals and tangents
+struct PackedNormal { uint32_t bits; };
+
+/// <summary>
+/// Meshes that can upload their vertices in either precision
+/// </summary>
+enum class VertexFormat
+{
+	Float,		// 32 bit floats for every attribute
+	Packed		// half float, 10-10-10-2, 16 and 8 bit normalized attributes
+};
 
 struct VertexBufferElement
 {
@@ -8,6 +25,8 @@ struct VertexBufferElement
 	unsigned char normalized;
 
 	static unsigned int get_size_of_type(unsigned int type);
+	// Bytes of the element in a vertex, packed types hold all their components in one value
+	unsigned int size() const;
 };
 
 class VertexBufferLayout
@@ -20,7 +39,8 @@ public:
 	VertexBufferLayout() : m_stride(0), m_tot_elemets(0) {};
 
 	/// <summary>
-	/// Accept only registered templates
+	/// Accept only registered templates. unsigned char and unsigned short are normalized to [0, 1],
+	/// a PackedNormal element must have a count of 1 and gives the shader a vec4.
 	/// </summary>
 	/// <typeparam name="T"></typeparam>
 	/// <param name="count"></param>
@@ -31,3 +51,15 @@ public:
 	unsigned int stride() const;
 	unsigned int tot_elements() const;
 };
+
+/// <summary>
+/// Conversions of float attributes into the packed types, values out of range are clamped
+/// </summary>
+namespace VertexPacking
+{
+	HalfFloat half(float value);
+	// w is 0 for directions, it only has the values -1, 0 and 1
+	PackedNormal snorm_10_10_10_2(float x, float y, float z, float w = 0.0f);
+	uint16_t unorm16(float value);
+	uint8_t unorm8(float value);
+}
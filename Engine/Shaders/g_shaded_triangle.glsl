@@ -9,9 +9,13 @@ layout(location = 3) in vec4 v_tangent_vector;
 
 out vec4 f_color;
 
-uniform mat4 u_MV;
-uniform mat4 u_P;
-uniform vec4 u_light_position;
+layout(std140, row_major) uniform FrameData
+{
+	mat4 u_P;
+	mat4 u_V;
+	vec4 u_light_position;	// view space
+};
+uniform mat4 u_model;
 uniform vec4 u_ambient;	 
 uniform vec4 u_diffuse;	 
 uniform vec4 u_specular; 
@@ -20,11 +24,13 @@ uniform sampler2D u_bump_texture;
 
 void main()
 {
-	vec3 vertex_pos = (u_MV * v_position).xyz;
+	mat4 MV = u_V * u_model;
+	vec4 vertex_pos_view = MV * v_position;
+	vec3 vertex_pos = vertex_pos_view.xyz;
 	vec3 N, L, E, H;
 	vec3 T, B;
 
-	mat4 normal_matrix = transpose(inverse(u_MV));
+	mat4 normal_matrix = transpose(inverse(MV));
     N = normalize(vec3(normal_matrix * v_normal).xyz);
 	T  = normalize(vec3(normal_matrix * v_tangent_vector).xyz);
     B = cross(N, T);
@@ -68,7 +74,7 @@ void main()
     f_color = ambient + diffuse + specular;
     f_color.a = 1.0;
 
-	gl_Position = u_P * u_MV * v_position;
+	gl_Position = u_P * vertex_pos_view;
 }
 
 // Pixel (fragment) shader
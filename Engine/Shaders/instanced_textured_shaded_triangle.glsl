@@ -0,0 +1,79 @@
+#version 150 core
+
+// Vertex shader
+#ifdef COMPILING_VS
+layout(location = 0) in vec4 v_position;
+layout(location = 1) in vec2 v_text_coord;
+layout(location = 2) in vec4 v_normal;
+layout(location = 3) in mat4 i_model;
+layout(location = 8) in float i_selected;
+
+out vec3 N, L, E;
+out vec2 f_text_coord;
+flat out float f_selected;
+
+uniform mat4 u_V;
+uniform mat4 u_P;
+uniform vec4 u_light_position;
+
+void main()
+{
+	mat4 MV = u_V * i_model;
+	vec3 vertex_pos = (MV * v_position).xyz;
+
+	mat4 normal_matrix = transpose(inverse(MV));
+	if(u_light_position.w == 0.0)
+	{
+		L = normalize(u_light_position.xyz);
+	}
+    else
+	{
+		L = normalize(u_light_position.xyz - vertex_pos);
+	}
+	E =  -normalize(vertex_pos);
+    N = normalize(vec3(normal_matrix * v_normal).xyz);
+
+	gl_Position = u_P * MV * v_position;
+	f_text_coord = v_text_coord;
+	f_selected = i_selected;
+}
+
+// Pixel (fragment) shader
+#elif defined (COMPILING_FS)
+in vec2 f_text_coord;
+in vec3 N, L, E;
+flat in float f_selected;
+uniform vec4 u_ambient;	 
+uniform vec4 u_diffuse;	 
+uniform vec4 u_specular; 
+uniform float u_shininess; 
+uniform sampler2D u_texture;
+
+void main()
+{    
+	vec4 texture_color = texture(u_texture, f_text_coord);
+    vec4 fragment_color;
+    vec3 H = normalize( L + E );
+    vec4 ambient_color = u_ambient;
+
+    float Kd = max( dot(L, N), 0.0 );
+    vec4  diffuse_color = Kd*u_diffuse;
+
+    float Ks = pow( max(dot(N, H), 0.0), u_shininess );
+    vec4  specular_color = Ks * u_specular;
+    
+    if( dot(L, N) < 0.0 ) 
+	{
+		specular_color = vec4(0.0, 0.0, 0.0, 1.0);
+	}
+
+    fragment_color = (ambient_color + diffuse_color + specular_color) * texture_color;
+    fragment_color.a = 1.0;
+	
+	if (f_selected != 0.0)
+	{
+		fragment_color.rb = vec2(0.0, 0.0);
+	}
+	gl_FragColor = fragment_color;
+}
+#endif
\ No newline at end of file
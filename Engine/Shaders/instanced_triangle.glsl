@@ -0,0 +1,36 @@
+#version 150 core
+
+// Vertex shader
+#ifdef COMPILING_VS
+layout(location = 0) in vec4 v_position;
+layout(location = 3) in mat4 i_model;
+layout(location = 7) in vec4 i_color;
+layout(location = 8) in float i_selected;
+
+out vec4 f_color;
+
+uniform mat4 u_VP;
+uniform bool u_outline_pass;
+
+void main()
+{
+	if (u_outline_pass && i_selected == 0.0)
+	{
+		// Only the selected instances have outlines, move the rest out of the clip volume
+		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+		f_color = vec4(0.0);
+		return;
+	}
+	gl_Position = u_VP * i_model * v_position;
+	f_color = u_outline_pass ? vec4(0.0, 0.0, 0.0, 1.0) : i_color;
+}
+
+// Pixel (fragment) shader
+#elif defined (COMPILING_FS)
+in vec4 f_color;
+
+void main()
+{
+	gl_FragColor = f_color;
+}
+#endif
\ No newline at end of file
@@ -10,16 +10,22 @@ layout(location = 3) in vec4 v_tangent_vector;
 out vec3 L, E;
 out vec2 f_parametric_coords;
 
-uniform mat4 u_MV;
-uniform mat4 u_P;
-uniform vec4 u_light_position;
+layout(std140, row_major) uniform FrameData
+{
+	mat4 u_P;
+	mat4 u_V;
+	vec4 u_light_position;	// view space
+};
+uniform mat4 u_model;
 
 void main()
 {
-	vec3 vertex_pos = (u_MV * v_position).xyz;
+	mat4 MV = u_V * u_model;
+	vec4 vertex_pos_view = MV * v_position;
+	vec3 vertex_pos = vertex_pos_view.xyz;
 	vec3 T, B;
 
-	mat4 normal_matrix = transpose(inverse(u_MV));
+	mat4 normal_matrix = transpose(inverse(MV));
     vec3 N = normalize(vec3(normal_matrix * v_normal).xyz);
 	T  = normalize(vec3(normal_matrix * v_tangent_vector).xyz);
     B = cross(N, T);
@@ -43,7 +49,7 @@ void main()
     E.z = dot(N, -vertex_pos);
 	E = normalize(E);
 
-	gl_Position = u_P * u_MV * v_position;
+	gl_Position = u_P * vertex_pos_view;
 	f_parametric_coords = v_parametric_coords;
 }
 
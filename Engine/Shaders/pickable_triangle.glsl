@@ -4,11 +4,17 @@
 #ifdef COMPILING_VS
 layout(location = 0) in vec4 v_position;
 
-uniform mat4 u_MVP;
+layout(std140, row_major) uniform FrameData
+{
+	mat4 u_P;
+	mat4 u_V;
+	vec4 u_light_position;	// view space
+};
+uniform mat4 u_model;
 
 void main()
 {
-	gl_Position = u_MVP * v_position;
+	gl_Position = u_P * (u_V * (u_model * v_position));
 	gl_Position.y = -gl_Position.y; // vertically flip the texture
 }
 
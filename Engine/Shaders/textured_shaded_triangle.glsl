@@ -9,15 +9,21 @@ layout(location = 2) in vec4 v_normal;
 out vec3 N, L, E;
 out vec2 f_text_coord;
 
-uniform mat4 u_MV;
-uniform mat4 u_P;
-uniform vec4 u_light_position;
+layout(std140, row_major) uniform FrameData
+{
+	mat4 u_P;
+	mat4 u_V;
+	vec4 u_light_position;	// view space
+};
+uniform mat4 u_model;
 
 void main()
 {
-	vec3 vertex_pos = (u_MV * v_position).xyz;
+	mat4 MV = u_V * u_model;
+	vec4 vertex_pos_view = MV * v_position;
+	vec3 vertex_pos = vertex_pos_view.xyz;
 
-	mat4 normal_matrix = transpose(inverse(u_MV));
+	mat4 normal_matrix = transpose(inverse(MV));
 	if(u_light_position.w == 0.0)
 	{
 		L = normalize(u_light_position.xyz);
@@ -29,7 +35,7 @@ void main()
 	E =  -normalize(vertex_pos);
     N = normalize(vec3(normal_matrix * v_normal).xyz);
 
-	gl_Position = u_P * u_MV * v_position;
+	gl_Position = u_P * vertex_pos_view;
 	f_text_coord = v_text_coord;
 }
 
@@ -0,0 +1,327 @@
+#include "Core/Benchmark.h"
+#include "EntityManager/DrawList.h"
+#include "EntityManager/ShapeModel.h"
+#include "Core/PointInPolygon.h"
+#include "Core/ObjectPool.h"
+#include "Core/SceneArena.h"
+#include "Core/ThreadPool.h"
+#include "Renderer/SoftwareRasterizer.h"
+
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace Benchmark
+{
+	// The colors come from their own generator, so that the shapes and whatever is drawn
+	// from the same generator afterwards stay the same as in the runs before colors were added
+	static void populate_random_2d(DrawList& list, unsigned int num_shapes, float world_size, std::mt19937& rng)
+	{
+		std::mt19937 color_rng(num_shapes);
+		std::uniform_real_distribution<float> pos_dist(0.0f, world_size);
+		std::uniform_real_distribution<float> size_dist(10.0f, 200.0f);
+		std::uniform_real_distribution<float> rot_dist(0.0f, 360.0f);
+		std::uniform_real_distribution<float> col_dist(0.0f, 1.0f);
+		for (unsigned int i = 0; i < num_shapes; i++)
+		{
+			Angel::vec3 pos(pos_dist(rng), pos_dist(rng), 0.0f);
+			Angel::vec3 rot(0.0f, 0.0f, rot_dist(rng));
+			Angel::vec3 scale(size_dist(rng), size_dist(rng), 1.0f);
+			Angel::vec4 color(col_dist(color_rng), col_dist(color_rng), col_dist(color_rng), 1.0f);
+			ShapeModel::StaticShape def = (i % 2 == 0) ? ShapeModel::StaticShape::RECTANGLE : ShapeModel::StaticShape::ISOSCELES_TRIANGLE;
+			list.add_shape(new ShapeModel(def, pos, rot, scale, color));
+		}
+	}
+
+	void populate_random_2d(DrawList& list, unsigned int num_shapes, float world_size, unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+		populate_random_2d(list, num_shapes, world_size, rng);
+	}
+
+	template<typename F>
+	static double time_ms(F&& f)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		f();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	void spatial_index_2d(const Angel::mat4& proj, const Angel::mat4& view)
+	{
+		const unsigned int shape_counts[] = { 10000, 100000 };
+		const unsigned int num_picks = 1000;
+		const unsigned int num_box_selections = 100;
+		for (unsigned int num_shapes : shape_counts)
+		{
+			// Keep the density roughly constant between runs
+			const float world_size = 100.0f * std::sqrt((float)num_shapes);
+			std::mt19937 rng(42);
+			DrawList list(proj, view);
+			populate_random_2d(list, num_shapes, world_size, rng);
+
+			std::uniform_real_distribution<float> pos_dist(0.0f, world_size);
+			std::uniform_real_distribution<float> box_dist(100.0f, 1000.0f);
+			std::vector<Angel::vec3> picks(num_picks);
+			for (auto& p : picks)
+			{
+				p = Angel::vec3(pos_dist(rng), pos_dist(rng), 0.0f);
+			}
+			std::vector<std::pair<Angel::vec3, Angel::vec3>> boxes(num_box_selections);
+			for (auto& b : boxes)
+			{
+				b.first = Angel::vec3(pos_dist(rng), pos_dist(rng), 0.0f);
+				b.second = Angel::vec3(box_dist(rng), box_dist(rng), 1.0f);
+			}
+
+			size_t hits_linear = 0, hits_indexed = 0;
+			size_t selected_linear = 0, selected_indexed = 0;
+			double pick_ms[2], box_ms[2];
+			for (int indexed = 0; indexed < 2; indexed++)
+			{
+				list.set_spatial_indexing(indexed == 1);
+				size_t& hits = indexed ? hits_indexed : hits_linear;
+				size_t& selected = indexed ? selected_indexed : selected_linear;
+				pick_ms[indexed] = time_ms([&]()
+					{
+						for (const auto& p : picks)
+						{
+							hits += list.frontmost_shape_2d(p) != nullptr;
+						}
+					});
+				box_ms[indexed] = time_ms([&]()
+					{
+						for (const auto& b : boxes)
+						{
+							selected += list.shapes_contained_in_2d(b.first, b.second).size();
+						}
+					});
+			}
+
+			std::cout << "Spatial index benchmark, " << num_shapes << " shapes" << std::endl;
+			std::cout << "\t" << num_picks << " point picks:\t\tlinear " << pick_ms[0] << " ms, indexed " << pick_ms[1]
+				<< " ms, speedup x" << pick_ms[0] / pick_ms[1] << std::endl;
+			std::cout << "\t" << num_box_selections << " box selections:\tlinear " << box_ms[0] << " ms, indexed " << box_ms[1]
+				<< " ms, speedup x" << box_ms[0] / box_ms[1] << std::endl;
+			if (hits_linear != hits_indexed || selected_linear != selected_indexed)
+			{
+				std::cout << "\tWarning, indexed results differ from the linear scan!" << std::endl;
+			}
+			list.shutdown();
+		}
+	}
+
+	void point_in_polygon()
+	{
+		const unsigned int corner_counts[] = { 8, 64, 1024 };
+		const unsigned int num_points = 100000;
+		const float two_pi = 6.28318530718f;
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> radius_dist(50.0f, 100.0f);
+		std::uniform_real_distribution<float> point_dist(-100.0f, 100.0f);
+
+		std::vector<float> pxs(num_points), pys(num_points);
+		std::vector<Angel::vec3> points(num_points);
+		for (unsigned int i = 0; i < num_points; i++)
+		{
+			pxs[i] = point_dist(rng);
+			pys[i] = point_dist(rng);
+			points[i] = Angel::vec3(pxs[i], pys[i], 0.0f);
+		}
+		std::vector<uint8_t> in_reference(num_points), in_scalar(num_points), in_edges(num_points), in_points(num_points);
+
+		std::cout << "Point in polygon benchmark, " << num_points << " points, kernels use "
+			<< PointInPolygon::instruction_set() << std::endl;
+		for (unsigned int num_corners : corner_counts)
+		{
+			// Random radius per corner gives a concave, but simple polygon
+			std::vector<float> xs(num_corners), ys(num_corners);
+			std::vector<Angel::vec3> corners(num_corners);
+			for (unsigned int i = 0; i < num_corners; i++)
+			{
+				float angle = two_pi * (float)i / (float)num_corners;
+				float r = radius_dist(rng);
+				xs[i] = r * std::cos(angle);
+				ys[i] = r * std::sin(angle);
+				corners[i] = Angel::vec3(xs[i], ys[i], 0.0f);
+			}
+
+			double reference_ms = time_ms([&]()
+				{
+					for (unsigned int i = 0; i < num_points; i++)
+					{
+						in_reference[i] = PointInPolygon::contains_reference(corners, points[i]);
+					}
+				});
+			double scalar_ms = time_ms([&]()
+				{
+					for (unsigned int i = 0; i < num_points; i++)
+					{
+						in_scalar[i] = PointInPolygon::contains_scalar(xs.data(), ys.data(), num_corners, pxs[i], pys[i]);
+					}
+				});
+			double edges_ms = time_ms([&]()
+				{
+					for (unsigned int i = 0; i < num_points; i++)
+					{
+						in_edges[i] = PointInPolygon::contains(xs.data(), ys.data(), num_corners, pxs[i], pys[i]);
+					}
+				});
+			double points_ms = time_ms([&]()
+				{
+					PointInPolygon::contains_many(xs.data(), ys.data(), num_corners,
+						pxs.data(), pys.data(), num_points, in_points.data());
+				});
+
+			unsigned int mismatches = 0;
+			for (unsigned int i = 0; i < num_points; i++)
+			{
+				mismatches += (in_scalar[i] != in_reference[i])
+					|| (in_edges[i] != in_reference[i])
+					|| (in_points[i] != in_reference[i]);
+			}
+			std::cout << "	" << num_corners << " corners:	reference " << reference_ms << " ms, scalar " << scalar_ms
+				<< " ms, simd over edges " << edges_ms << " ms, simd over points " << points_ms
+				<< " ms, speedup x" << reference_ms / std::min(edges_ms, points_ms) << std::endl;
+			if (mismatches != 0)
+			{
+				// Points lying exactly on an edge may be classified differently by the reference test
+				std::cout << "		" << mismatches << " points classified differently than the reference" << std::endl;
+			}
+		}
+	}
+
+	void allocations()
+	{
+		const unsigned int num_shapes = 20000;
+		const unsigned int num_polygon_corners = 16;
+		std::mt19937 rng(5);
+		std::uniform_real_distribution<float> pos_dist(0.0f, 10000.0f);
+		std::vector<Angel::vec3> corners(num_polygon_corners);
+		for (unsigned int i = 0; i < num_polygon_corners; i++)
+		{
+			float angle = 6.28318530718f * (float)i / (float)num_polygon_corners;
+			corners[i] = Angel::vec3(50.0f * std::cos(angle), 50.0f * std::sin(angle), 0.0f);
+		}
+		std::vector<Angel::vec3> positions(num_shapes);
+		for (auto& p : positions)
+		{
+			p = Angel::vec3(pos_dist(rng), pos_dist(rng), 0.0f);
+		}
+
+		enum class Mode { Global, Pooled, Arena };
+		const char* mode_names[] = { "global new/delete", "object pools", "scene arena" };
+		std::vector<ShapeModel*> shapes(num_shapes);
+		std::cout << "Allocation benchmark, " << num_shapes << " rectangles and polygons" << std::endl;
+		for (Mode mode : { Mode::Global, Mode::Pooled, Mode::Arena })
+		{
+			PooledAllocation::s_enabled = mode != Mode::Global;
+			SceneArena* arena = mode == Mode::Arena ? new SceneArena : nullptr;
+			size_t system_allocations = PooledAllocation::s_num_system_allocations;
+			double create_ms = time_ms([&]()
+				{
+					SceneArena::Scope arena_scope(arena);
+					for (unsigned int i = 0; i < num_shapes; i++)
+					{
+						if (i % 2 == 0)
+						{
+							shapes[i] = new ShapeModel(ShapeModel::StaticShape::RECTANGLE, positions[i],
+								Angel::vec3(0.0f), Angel::vec3(100.0f, 100.0f, 1.0f), Angel::vec4(1.0f));
+						}
+						else
+						{
+							std::vector<Angel::vec3> polygon = corners;
+							for (auto& c : polygon)
+							{
+								c += positions[i];
+							}
+							shapes[i] = new ShapeModel(polygon, Angel::vec4(1.0f));
+						}
+					}
+				});
+			double destroy_ms = time_ms([&]()
+				{
+					for (ShapeModel* s : shapes)
+					{
+						delete s;
+					}
+					delete arena;
+				});
+			std::cout << "\t" << mode_names[(int)mode] << ":\tcreate " << create_ms << " ms, delete " << destroy_ms
+				<< " ms, system allocations " << PooledAllocation::s_num_system_allocations - system_allocations << std::endl;
+		}
+		PooledAllocation::s_enabled = true;
+	}
+
+	void software_rasterizer()
+	{
+		const int width = 1920, height = 1080;
+		const unsigned int num_triangles = 20000;
+		std::mt19937 rng(5);
+		std::uniform_real_distribution<float> pos_dist(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> offset_dist(-0.1f, 0.1f);
+		std::uniform_real_distribution<float> col_dist(0.0f, 1.0f);
+
+		std::vector<float> positions(num_triangles * 9);
+		std::vector<float> colors(num_triangles * 12);
+		std::vector<unsigned int> indices(num_triangles * 3);
+		for (unsigned int i = 0; i < num_triangles; i++)
+		{
+			float x = pos_dist(rng), y = pos_dist(rng);
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				float* p = &positions[(i * 3 + k) * 3];
+				p[0] = x + offset_dist(rng);
+				p[1] = y + offset_dist(rng);
+				p[2] = 0.0f;
+				float* c = &colors[(i * 3 + k) * 4];
+				c[0] = col_dist(rng);
+				c[1] = col_dist(rng);
+				c[2] = col_dist(rng);
+				c[3] = 0.5f;
+				indices[i * 3 + k] = i * 3 + k;
+			}
+		}
+		SoftwareRasterizer::Mesh mesh;
+		mesh.positions = { positions.data(), num_triangles * 3, 3, 3 };
+		mesh.colors = { colors.data(), num_triangles * 3, 4, 4 };
+		mesh.indices = IndexView(indices.data(), indices.size());
+		mesh.shading = SoftwareRasterizer::Shading::Colored;
+		// Painter's order, like the 2D apps
+		mesh.depth_test = false;
+
+		ThreadPool single_pool(0);
+		ThreadPool pool;
+		ThreadPool* pools[2] = { &single_pool, &pool };
+		std::vector<uint8_t> images[2];
+		double frame_ms[2];
+		SoftwareRasterizer::Stats stats = {};
+		for (int i = 0; i < 2; i++)
+		{
+			SoftwareRasterizer rasterizer(width, height, *pools[i]);
+			rasterizer.set_frame(Angel::mat4(), Angel::mat4(), Angel::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+			frame_ms[i] = time_ms([&]()
+				{
+					rasterizer.clear(Angel::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+					rasterizer.draw(mesh);
+					rasterizer.flush();
+				});
+			images[i].assign(rasterizer.pixels(), rasterizer.pixels() + (size_t)width * height * 4);
+			stats = rasterizer.last_stats();
+		}
+
+		std::cout << "Software rasterizer benchmark, " << num_triangles << " blended triangles at "
+			<< width << "x" << height << ", " << stats.num_tiles << " tiles, " << stats.num_bin_entries << " bin entries" << std::endl;
+		std::cout << "\t1 thread " << frame_ms[0] << " ms, " << pool.num_threads() + 1 << " threads " << frame_ms[1]
+			<< " ms, speedup x" << frame_ms[0] / frame_ms[1] << std::endl;
+		if (std::memcmp(images[0].data(), images[1].data(), images[0].size()) != 0)
+		{
+			std::cout << "\tWarning, the images differ between thread counts!" << std::endl;
+		}
+	}
+}
@@ -46,4 +46,159 @@ bool __glLogCall(const char* function, const char* file, int line, int column, c
 		std::cout << std::endl;
 	}
 	return has_error;
-}
\ No newline at end of file
+}
+
+bool GLErrorCheck::s_check_calls = GL_ERROR_CHECKS != 0;
+bool GLErrorCheck::s_record_breadcrumbs = false;
+GLErrorCheck::Breadcrumb GLErrorCheck::s_breadcrumb = { "", std::source_location() };
+#if GL_ERROR_CHECKS
+GLErrorMode GLErrorCheck::s_mode = GLErrorMode::Full;
+#else
+GLErrorMode GLErrorCheck::s_mode = GLErrorMode::Sampled;
+#endif
+unsigned int GLErrorCheck::s_sample_interval = 60;
+unsigned int GLErrorCheck::s_frame = 0;
+bool GLErrorCheck::s_debug_output_enabled = false;
+
+static const char* debug_source_to_string(GLenum source)
+{
+	switch (source)
+	{
+	case GL_DEBUG_SOURCE_API: return "API";
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "Window System";
+	case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader Compiler";
+	case GL_DEBUG_SOURCE_THIRD_PARTY: return "Third Party";
+	case GL_DEBUG_SOURCE_APPLICATION: return "Application";
+	default: return "Other";
+	}
+}
+
+static const char* debug_type_to_string(GLenum type)
+{
+	switch (type)
+	{
+	case GL_DEBUG_TYPE_ERROR: return "Error";
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated Behavior";
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "Undefined Behavior";
+	case GL_DEBUG_TYPE_PORTABILITY: return "Portability";
+	case GL_DEBUG_TYPE_PERFORMANCE: return "Performance";
+	default: return "Other";
+	}
+}
+
+static const char* debug_severity_to_string(GLenum severity)
+{
+	switch (severity)
+	{
+	case GL_DEBUG_SEVERITY_HIGH: return "High";
+	case GL_DEBUG_SEVERITY_MEDIUM: return "Medium";
+	case GL_DEBUG_SEVERITY_LOW: return "Low";
+	default: return "Notification";
+	}
+}
+
+static void GLAPIENTRY debug_output_callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei, const GLchar* message, const void*)
+{
+	const GLErrorCheck::Breadcrumb& crumb = GLErrorCheck::s_breadcrumb;
+	std::cout << "[OpenGL Debug][" << debug_source_to_string(source) << "][" << debug_type_to_string(type) << "]"
+		<< "[" << debug_severity_to_string(severity) << "](" << id << ") " << message << std::endl;
+	if (GLErrorCheck::s_record_breadcrumbs && crumb.location.line() != 0)
+	{
+		std::cout << "    after `" << crumb.call << "` [" << crumb.location.file_name()
+			<< "(" << crumb.location.line() << ":" << crumb.location.column() << ") `"
+			<< crumb.location.function_name() << "`]" << std::endl;
+	}
+	ASSERT(type != GL_DEBUG_TYPE_ERROR);
+}
+
+/// <summary>
+/// Installs the driver callback, synchronous so that the breadcrumb
+/// is the call that produced the message. Notifications are muted.
+/// </summary>
+/// <returns>false when neither KHR_debug nor ARB_debug_output is available</returns>
+bool GLErrorCheck::enable_debug_output(bool enable)
+{
+	if (enable == s_debug_output_enabled)
+	{
+		return true;
+	}
+	if (GLEW_VERSION_4_3 || GLEW_KHR_debug)
+	{
+		if (enable)
+		{
+			glEnable(GL_DEBUG_OUTPUT);
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+			glDebugMessageCallback(debug_output_callback, nullptr);
+			glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+		}
+		else
+		{
+			glDebugMessageCallback(nullptr, nullptr);
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+			glDisable(GL_DEBUG_OUTPUT);
+		}
+	}
+	else if (GLEW_ARB_debug_output)
+	{
+		if (enable)
+		{
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+			glDebugMessageCallbackARB(debug_output_callback, nullptr);
+			glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_LOW_ARB, 0, nullptr, GL_FALSE);
+		}
+		else
+		{
+			glDebugMessageCallbackARB(nullptr, nullptr);
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+		}
+	}
+	else
+	{
+		std::cout << "Warning: The driver has no debug output, GL errors are not reported in this mode." << std::endl;
+		return false;
+	}
+	s_debug_output_enabled = enable;
+	return true;
+}
+
+void GLErrorCheck::update_flags()
+{
+#if GL_ERROR_CHECKS
+	s_check_calls = s_mode == GLErrorMode::Full
+		|| (s_mode == GLErrorMode::Sampled && s_frame % s_sample_interval == 0);
+	s_record_breadcrumbs = s_mode == GLErrorMode::DebugOutput;
+#else
+	s_check_calls = false;
+	s_record_breadcrumbs = false;
+#endif
+}
+
+bool GLErrorCheck::set_mode(GLErrorMode mode, unsigned int sample_interval)
+{
+	ASSERT(sample_interval > 0);
+	if (!enable_debug_output(mode == GLErrorMode::DebugOutput))
+	{
+		return false;
+	}
+	s_mode = mode;
+	s_sample_interval = sample_interval;
+	s_frame = 0;
+	update_flags();
+	return true;
+}
+
+void GLErrorCheck::begin_frame()
+{
+	s_frame++;
+#if !GL_ERROR_CHECKS
+	// The calls are not checked, poll the errors left by the sampled frames instead
+	bool poll = s_mode == GLErrorMode::Full
+		|| (s_mode == GLErrorMode::Sampled && s_frame % s_sample_interval == 0);
+	if (poll)
+	{
+		__glLogCall("errors since the last poll", "", 0, 0, "GLErrorCheck::begin_frame");
+	}
+#endif
+	update_flags();
+}
@@ -0,0 +1,329 @@
+#include "Core/ImageWriter.h"
+#include "Core/ErrorManager.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace ImageWriter
+{
+	static std::array<uint32_t, 256> make_crc_table()
+	{
+		std::array<uint32_t, 256> table;
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+			{
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		return table;
+	}
+
+	static const std::array<uint32_t, 256> s_crc_table = make_crc_table();
+
+	static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = s_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	static uint32_t adler32(const uint8_t* data, size_t size)
+	{
+		// 5552 bytes is the most that can be summed before the 32 bit sums could overflow
+		uint32_t a = 1, b = 0;
+		while (size > 0)
+		{
+			size_t block = std::min<size_t>(size, 5552);
+			for (size_t i = 0; i < block; i++)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += block;
+			size -= block;
+		}
+		return (b << 16) | a;
+	}
+
+	static void put_u32_be(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back((uint8_t)(value >> 24));
+		out.push_back((uint8_t)(value >> 16));
+		out.push_back((uint8_t)(value >> 8));
+		out.push_back((uint8_t)value);
+	}
+
+	/// <summary>
+	/// Deflate streams are written from the least significant bit of each byte
+	/// </summary>
+	class BitWriter
+	{
+	private:
+		std::vector<uint8_t>& m_out;
+		uint64_t m_bits;
+		unsigned int m_num_bits;
+	public:
+		BitWriter(std::vector<uint8_t>& out) : m_out(out), m_bits(0), m_num_bits(0) {}
+
+		inline void put(uint32_t value, unsigned int num_bits)
+		{
+			m_bits |= (uint64_t)value << m_num_bits;
+			m_num_bits += num_bits;
+			while (m_num_bits >= 8)
+			{
+				m_out.push_back((uint8_t)m_bits);
+				m_bits >>= 8;
+				m_num_bits -= 8;
+			}
+		}
+
+		// Huffman codes are stored from their most significant bit
+		inline void put_code(uint32_t code, unsigned int num_bits)
+		{
+			uint32_t reversed = 0;
+			for (unsigned int i = 0; i < num_bits; i++)
+			{
+				reversed = (reversed << 1) | ((code >> i) & 1);
+			}
+			put(reversed, num_bits);
+		}
+
+		inline void flush()
+		{
+			if (m_num_bits > 0)
+			{
+				m_out.push_back((uint8_t)m_bits);
+			}
+			m_bits = 0;
+			m_num_bits = 0;
+		}
+	};
+
+	// Lengths 3 to 258 of the length codes 257 to 285, and distances 1 to 32768 of the distance codes
+	static constexpr uint16_t s_length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static constexpr uint8_t s_length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static constexpr uint16_t s_distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static constexpr uint8_t s_distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	// The fixed literal/length code of RFC 1951, 3.2.6
+	static void put_literal(BitWriter& writer, unsigned int symbol)
+	{
+		if (symbol < 144)
+		{
+			writer.put_code(0x30 + symbol, 8);
+		}
+		else if (symbol < 256)
+		{
+			writer.put_code(0x190 + symbol - 144, 9);
+		}
+		else if (symbol < 280)
+		{
+			writer.put_code(symbol - 256, 7);
+		}
+		else
+		{
+			writer.put_code(0xC0 + symbol - 280, 8);
+		}
+	}
+
+	static void put_match(BitWriter& writer, unsigned int length, unsigned int distance)
+	{
+		int length_code = 28;
+		while (s_length_base[length_code] > length)
+		{
+			length_code--;
+		}
+		put_literal(writer, 257 + length_code);
+		writer.put(length - s_length_base[length_code], s_length_extra[length_code]);
+
+		int distance_code = 29;
+		while (s_distance_base[distance_code] > distance)
+		{
+			distance_code--;
+		}
+		writer.put_code(distance_code, 5);
+		writer.put(distance - s_distance_base[distance_code], s_distance_extra[distance_code]);
+	}
+
+	/// <summary>
+	/// zlib stream of a single fixed Huffman block. Each position looks up the last
+	/// position with the same next 3 bytes and takes the match if it is long enough,
+	/// there is no search for a longer one.
+	/// </summary>
+	static void deflate(const std::vector<uint8_t>& data, std::vector<uint8_t>& out)
+	{
+		const unsigned int window_size = 32768;
+		const unsigned int max_match = 258;
+		const unsigned int min_match = 3;
+		const unsigned int hash_bits = 15;
+		auto hash = [&data](size_t i)
+		{
+			uint32_t v = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+			return (v * 2654435761u) >> (32 - hash_bits);
+		};
+
+		// CMF and FLG, deflate with a 32k window at the fastest level
+		out.push_back(0x78);
+		out.push_back(0x01);
+		BitWriter writer(out);
+		// Final block, fixed Huffman codes
+		writer.put(1, 1);
+		writer.put(1, 2);
+
+		std::vector<int64_t> last_positions((size_t)1 << hash_bits, -1);
+		size_t size = data.size();
+		size_t i = 0;
+		while (i < size)
+		{
+			unsigned int match_length = 0;
+			size_t match_distance = 0;
+			if (i + min_match <= size)
+			{
+				uint32_t h = hash(i);
+				int64_t candidate = last_positions[h];
+				last_positions[h] = (int64_t)i;
+				if (candidate >= 0 && i - (size_t)candidate <= window_size)
+				{
+					unsigned int limit = (unsigned int)std::min<size_t>(max_match, size - i);
+					unsigned int length = 0;
+					while (length < limit && data[(size_t)candidate + length] == data[i + length])
+					{
+						length++;
+					}
+					if (length >= min_match)
+					{
+						match_length = length;
+						match_distance = i - (size_t)candidate;
+					}
+				}
+			}
+			if (match_length == 0)
+			{
+				put_literal(writer, data[i]);
+				i++;
+				continue;
+			}
+			put_match(writer, match_length, (unsigned int)match_distance);
+			for (size_t k = i + 1; k < i + match_length && k + min_match <= size; k++)
+			{
+				last_positions[hash(k)] = (int64_t)k;
+			}
+			i += match_length;
+		}
+		put_literal(writer, 256);
+		writer.flush();
+		put_u32_be(out, adler32(data.data(), data.size()));
+	}
+
+	static void put_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+	{
+		put_u32_be(out, (uint32_t)size);
+		size_t type_offset = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + size);
+		put_u32_be(out, crc32(out.data() + type_offset, size + 4));
+	}
+
+	/// <summary>
+	/// Filters the rows with None, Sub or Up, whichever gives the smallest sum of
+	/// the absolute values of the filtered bytes, the usual heuristic of encoders
+	/// </summary>
+	static std::vector<uint8_t> filter_rows(const uint8_t* rgba, int width, int height, bool bottom_row_first, bool alpha)
+	{
+		unsigned int channels = alpha ? 4 : 3;
+		size_t row_size = (size_t)width * channels;
+		std::vector<uint8_t> filtered;
+		filtered.reserve((row_size + 1) * height);
+		std::vector<uint8_t> previous(row_size, 0), current(row_size);
+		std::vector<uint8_t> candidates[3] = { std::vector<uint8_t>(row_size), std::vector<uint8_t>(row_size), std::vector<uint8_t>(row_size) };
+		for (int y = 0; y < height; y++)
+		{
+			const uint8_t* row = rgba + (size_t)(bottom_row_first ? height - 1 - y : y) * width * 4;
+			for (int x = 0; x < width; x++)
+			{
+				for (unsigned int c = 0; c < channels; c++)
+				{
+					current[(size_t)x * channels + c] = row[(size_t)x * 4 + c];
+				}
+			}
+			unsigned int best = 0;
+			unsigned int best_sum = 0xFFFFFFFF;
+			for (unsigned int filter = 0; filter < 3; filter++)
+			{
+				unsigned int sum = 0;
+				for (size_t i = 0; i < row_size; i++)
+				{
+					uint8_t value = current[i];
+					if (filter == 1)
+					{
+						value -= (i >= channels) ? current[i - channels] : 0;
+					}
+					else if (filter == 2)
+					{
+						value -= previous[i];
+					}
+					candidates[filter][i] = value;
+					sum += (unsigned int)std::abs((int8_t)value);
+				}
+				if (sum < best_sum)
+				{
+					best = filter;
+					best_sum = sum;
+				}
+			}
+			filtered.push_back((uint8_t)best);
+			filtered.insert(filtered.end(), candidates[best].begin(), candidates[best].end());
+			std::swap(previous, current);
+		}
+		return filtered;
+	}
+
+	std::vector<uint8_t> encode_png(const uint8_t* rgba, int width, int height, bool bottom_row_first, bool alpha)
+	{
+		ASSERT(rgba != nullptr && width > 0 && height > 0);
+		std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+		std::vector<uint8_t> header;
+		put_u32_be(header, (uint32_t)width);
+		put_u32_be(header, (uint32_t)height);
+		header.push_back(8);				// bits per channel
+		header.push_back(alpha ? 6 : 2);	// RGBA or RGB
+		header.push_back(0);				// deflate
+		header.push_back(0);				// adaptive filtering
+		header.push_back(0);				// not interlaced
+		put_chunk(png, "IHDR", header.data(), header.size());
+
+		std::vector<uint8_t> compressed;
+		deflate(filter_rows(rgba, width, height, bottom_row_first, alpha), compressed);
+		put_chunk(png, "IDAT", compressed.data(), compressed.size());
+		put_chunk(png, "IEND", nullptr, 0);
+		return png;
+	}
+
+	bool write_png(const std::filesystem::path& path, const uint8_t* rgba, int width, int height, bool bottom_row_first, bool alpha)
+	{
+		std::vector<uint8_t> png = encode_png(rgba, width, height, bottom_row_first, alpha);
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "Warning, could not open " << path.string() << " for writing" << std::endl;
+			return false;
+		}
+		file.write((const char*)png.data(), (std::streamsize)png.size());
+		return (bool)file;
+	}
+}
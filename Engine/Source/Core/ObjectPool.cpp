@@ -0,0 +1,7 @@
+#include "Core/ObjectPool.h"
+
+namespace PooledAllocation
+{
+	bool s_enabled = true;
+	size_t s_num_system_allocations = 0;
+}
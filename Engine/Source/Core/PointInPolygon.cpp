@@ -0,0 +1,293 @@
+#include "Core/PointInPolygon.h"
+#include <algorithm>
+#include <climits>
+
+#if PIP_USE_SSE
+#include <immintrin.h>
+#endif
+
+namespace PointInPolygon
+{
+	/// <summary>
+	/// Edge (a, b) toggles the inside state of p if it straddles the horizontal line through p
+	/// and crosses it on the right side of p. The half open comparison makes each vertex count once.
+	/// </summary>
+	static inline bool crosses(float ax, float ay, float bx, float by, float px, float py)
+	{
+		return ((ay > py) != (by > py))
+			&& (px < (bx - ax) * (py - ay) / (by - ay) + ax);
+	}
+
+	static inline unsigned int mask_bit_count(int mask)
+	{
+		unsigned int count = 0;
+		for (; mask; mask &= mask - 1)
+		{
+			count++;
+		}
+		return count;
+	}
+
+	bool contains_scalar(const float* xs, const float* ys, unsigned int num_corners, float px, float py)
+	{
+		if (num_corners < 3)
+		{
+			return false;
+		}
+		bool inside = false;
+		for (unsigned int i = 0, j = num_corners - 1; i < num_corners; j = i++)
+		{
+			inside ^= crosses(xs[j], ys[j], xs[i], ys[i], px, py);
+		}
+		return inside;
+	}
+
+	bool contains(const float* xs, const float* ys, unsigned int num_corners, float px, float py)
+	{
+		if (num_corners < 3)
+		{
+			return false;
+		}
+		// Edges are (i - 1, i), the wrapping edge (n - 1, 0) is handled first
+		unsigned int crossings = crosses(xs[num_corners - 1], ys[num_corners - 1], xs[0], ys[0], px, py) ? 1 : 0;
+		unsigned int i = 1;
+#if PIP_USE_AVX2
+		{
+			const __m256 vpx = _mm256_set1_ps(px);
+			const __m256 vpy = _mm256_set1_ps(py);
+			for (; i + 8 <= num_corners; i += 8)
+			{
+				__m256 ax = _mm256_loadu_ps(xs + i - 1);
+				__m256 ay = _mm256_loadu_ps(ys + i - 1);
+				__m256 bx = _mm256_loadu_ps(xs + i);
+				__m256 by = _mm256_loadu_ps(ys + i);
+				__m256 straddles = _mm256_xor_ps(_mm256_cmp_ps(ay, vpy, _CMP_GT_OQ), _mm256_cmp_ps(by, vpy, _CMP_GT_OQ));
+				// Lanes that do not straddle may divide by zero, they are masked out below
+				__m256 x_cross = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_sub_ps(bx, ax), _mm256_sub_ps(vpy, ay)), _mm256_sub_ps(by, ay)), ax);
+				__m256 hit = _mm256_and_ps(straddles, _mm256_cmp_ps(vpx, x_cross, _CMP_LT_OQ));
+				crossings += mask_bit_count(_mm256_movemask_ps(hit));
+			}
+		}
+#endif
+#if PIP_USE_SSE
+		{
+			const __m128 vpx = _mm_set1_ps(px);
+			const __m128 vpy = _mm_set1_ps(py);
+			for (; i + 4 <= num_corners; i += 4)
+			{
+				__m128 ax = _mm_loadu_ps(xs + i - 1);
+				__m128 ay = _mm_loadu_ps(ys + i - 1);
+				__m128 bx = _mm_loadu_ps(xs + i);
+				__m128 by = _mm_loadu_ps(ys + i);
+				__m128 straddles = _mm_xor_ps(_mm_cmpgt_ps(ay, vpy), _mm_cmpgt_ps(by, vpy));
+				__m128 x_cross = _mm_add_ps(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(bx, ax), _mm_sub_ps(vpy, ay)), _mm_sub_ps(by, ay)), ax);
+				__m128 hit = _mm_and_ps(straddles, _mm_cmplt_ps(vpx, x_cross));
+				crossings += mask_bit_count(_mm_movemask_ps(hit));
+			}
+		}
+#endif
+		for (; i < num_corners; i++)
+		{
+			crossings += crosses(xs[i - 1], ys[i - 1], xs[i], ys[i], px, py) ? 1 : 0;
+		}
+		return (crossings & 1) != 0;
+	}
+
+	void contains_many(const float* xs, const float* ys, unsigned int num_corners,
+		const float* pxs, const float* pys, unsigned int num_points, uint8_t* out)
+	{
+		if (num_corners < 3)
+		{
+			std::fill(out, out + num_points, (uint8_t)0);
+			return;
+		}
+		unsigned int p = 0;
+#if PIP_USE_AVX2
+		for (; p + 8 <= num_points; p += 8)
+		{
+			const __m256 vpx = _mm256_loadu_ps(pxs + p);
+			const __m256 vpy = _mm256_loadu_ps(pys + p);
+			__m256 inside = _mm256_setzero_ps();
+			for (unsigned int i = 0, j = num_corners - 1; i < num_corners; j = i++)
+			{
+				const __m256 ax = _mm256_set1_ps(xs[j]);
+				const __m256 ay = _mm256_set1_ps(ys[j]);
+				const __m256 bx = _mm256_set1_ps(xs[i]);
+				const __m256 by = _mm256_set1_ps(ys[i]);
+				__m256 straddles = _mm256_xor_ps(_mm256_cmp_ps(ay, vpy, _CMP_GT_OQ), _mm256_cmp_ps(by, vpy, _CMP_GT_OQ));
+				__m256 x_cross = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_sub_ps(bx, ax), _mm256_sub_ps(vpy, ay)), _mm256_sub_ps(by, ay)), ax);
+				inside = _mm256_xor_ps(inside, _mm256_and_ps(straddles, _mm256_cmp_ps(vpx, x_cross, _CMP_LT_OQ)));
+			}
+			int mask = _mm256_movemask_ps(inside);
+			for (unsigned int k = 0; k < 8; k++)
+			{
+				out[p + k] = (uint8_t)((mask >> k) & 1);
+			}
+		}
+#endif
+#if PIP_USE_SSE
+		for (; p + 4 <= num_points; p += 4)
+		{
+			const __m128 vpx = _mm_loadu_ps(pxs + p);
+			const __m128 vpy = _mm_loadu_ps(pys + p);
+			__m128 inside = _mm_setzero_ps();
+			for (unsigned int i = 0, j = num_corners - 1; i < num_corners; j = i++)
+			{
+				const __m128 ax = _mm_set1_ps(xs[j]);
+				const __m128 ay = _mm_set1_ps(ys[j]);
+				const __m128 bx = _mm_set1_ps(xs[i]);
+				const __m128 by = _mm_set1_ps(ys[i]);
+				__m128 straddles = _mm_xor_ps(_mm_cmpgt_ps(ay, vpy), _mm_cmpgt_ps(by, vpy));
+				__m128 x_cross = _mm_add_ps(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(bx, ax), _mm_sub_ps(vpy, ay)), _mm_sub_ps(by, ay)), ax);
+				inside = _mm_xor_ps(inside, _mm_and_ps(straddles, _mm_cmplt_ps(vpx, x_cross)));
+			}
+			int mask = _mm_movemask_ps(inside);
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				out[p + k] = (uint8_t)((mask >> k) & 1);
+			}
+		}
+#endif
+		for (; p < num_points; p++)
+		{
+			out[p] = contains_scalar(xs, ys, num_corners, pxs[p], pys[p]) ? 1 : 0;
+		}
+	}
+
+	bool contains_any(const float* xs, const float* ys, unsigned int num_corners,
+		const float* pxs, const float* pys, unsigned int num_points)
+	{
+		// Small fixed chunks, so that the typical selection queries do not allocate
+		constexpr unsigned int chunk_size = 64;
+		uint8_t inside[chunk_size];
+		for (unsigned int first = 0; first < num_points; first += chunk_size)
+		{
+			unsigned int count = std::min(chunk_size, num_points - first);
+			contains_many(xs, ys, num_corners, pxs + first, pys + first, count, inside);
+			for (unsigned int k = 0; k < count; k++)
+			{
+				if (inside[k])
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Polygon test function, taken from :
+	// https://www.geeksforgeeks.org/how-to-check-if-a-given-point-lies-inside-a-polygon
+	// The code was changed in the following way:
+	//  - Functions were converted into lambdas
+	//  - Since the point inclusion in the code was for integers, it was converted to floats
+	//  - The code in the link works for statically allocated arrays of Points, which is not compatible
+	//       with the API. It was modified so that it works with the Angel::vec3 data type
+	//  - Some of the names of the variables were changed so that code is cleaner
+	bool contains_reference(const std::vector<Angel::vec3>& model_coordinates, const Angel::vec3& model_pos)
+	{
+		struct Point {
+			float x, y;
+		};
+
+		struct line {
+			Point p1, p2;
+		};
+
+		auto on_line = [](line l1, Point p) -> bool
+		{
+			// Check whether p is on the line or not
+			if (p.x <= std::max(l1.p1.x, l1.p2.x)
+				&& p.x <= std::min(l1.p1.x, l1.p2.x)
+				&& (p.y <= std::max(l1.p1.y, l1.p2.y)
+					&& p.y <= std::min(l1.p1.y, l1.p2.y)))
+				return true;
+
+			return false;
+		};
+
+		auto direction = [](Point a, Point b, Point c) -> int
+		{
+			float val = (b.y - a.y) * (c.x - b.x)
+				- (b.x - a.x) * (c.y - b.y);
+			if (val == 0)
+				// Colinear
+				return 0;
+			else if (val < 0)
+				// Anti-clockwise direction
+				return 2;
+			// Clockwise direction
+			return 1;
+		};
+
+		auto is_intersect = [&, direction, on_line](line l1, line l2) -> bool
+		{
+			// Four direction for two lines and points of other line
+			int dir1 = direction(l1.p1, l1.p2, l2.p1);
+			int dir2 = direction(l1.p1, l1.p2, l2.p2);
+			int dir3 = direction(l2.p1, l2.p2, l1.p1);
+			int dir4 = direction(l2.p1, l2.p2, l1.p2);
+
+			// When intersecting
+			if (dir1 != dir2 && dir3 != dir4)
+				return true;
+
+			// When p2 of line2 are on the line1
+			if (dir1 == 0 && on_line(l1, l2.p1))
+				return true;
+
+			// When p1 of line2 are on the line1
+			if (dir2 == 0 && on_line(l1, l2.p2))
+				return true;
+
+			// When p2 of line1 are on the line2
+			if (dir3 == 0 && on_line(l2, l1.p1))
+				return true;
+
+			// When p1 of line1 are on the line2
+			if (dir4 == 0 && on_line(l2, l1.p2))
+				return true;
+
+			return false;
+		};
+
+		unsigned int num_vertices = (unsigned int)model_coordinates.size();
+
+		// When polygon has less than 3 edge, it is not polygon
+		if (num_vertices < 3)
+			return false;
+		Point p = { model_pos.x, model_pos.y };
+		// Create a point at infinity, y is same as point p
+		line exline = { p, { (float)INT_MAX, p.y } };
+		int count = 0;
+		int i = 0;
+		do {
+
+			// Forming a line from two consecutive points of our shape
+			Point p1 = { model_coordinates[i].x, model_coordinates[i].y };
+			Point p2 = { model_coordinates[(i + 1) % num_vertices].x, model_coordinates[(i + 1) % num_vertices].y };
+			line side = { p1, p2 };
+			if (is_intersect(side, exline)) {
+
+				// If exline is on top of this side
+				if (direction(side.p1, p, side.p2) == 0)
+						return on_line(side, p);
+				count++;
+			}
+			i = (i + 1) % num_vertices;
+		} while (i != 0);
+
+		// When count is odd
+		return count & 1;
+	}
+
+	const char* instruction_set()
+	{
+#if PIP_USE_AVX2
+		return "AVX2";
+#elif PIP_USE_SSE
+		return "SSE";
+#else
+		return "Scalar";
+#endif
+	}
+}
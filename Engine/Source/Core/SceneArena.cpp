@@ -0,0 +1,146 @@
+#include "Core/SceneArena.h"
+#include "Core/ErrorManager.h"
+#include <algorithm>
+#include <functional>
+#include <new>
+
+SceneArena* SceneArena::s_current = nullptr;
+std::vector<SceneArena::BlockRange> SceneArena::s_block_ranges;
+
+SceneArena::Scope::Scope(SceneArena* arena)
+	: m_previous(s_current)
+{
+	// A null arena keeps the regular pooled allocation
+	if (arena != nullptr)
+	{
+		s_current = arena;
+	}
+}
+
+SceneArena::Scope::~Scope()
+{
+	s_current = m_previous;
+}
+
+SceneArena::SceneArena(size_t block_size)
+	: m_block_size(block_size),
+	m_num_allocations(0),
+	m_num_block_allocations(0)
+{
+}
+
+SceneArena::~SceneArena()
+{
+	ASSERT(s_current != this);
+	release();
+}
+
+SceneArena::FreeList& SceneArena::free_list(size_t size, size_t alignment)
+{
+	for (FreeList& list : m_free_lists)
+	{
+		if (list.size == size && list.alignment == alignment)
+		{
+			return list;
+		}
+	}
+	m_free_lists.push_back({ size, alignment, nullptr });
+	return m_free_lists.back();
+}
+
+void* SceneArena::allocate(size_t size, size_t alignment)
+{
+	m_num_allocations++;
+	FreeList& list = free_list(size, alignment);
+	if (list.first != nullptr)
+	{
+		void* p = list.first;
+		list.first = *static_cast<void**>(p);
+		return p;
+	}
+	if (!m_blocks.empty())
+	{
+		Block& block = m_blocks.back();
+		size_t offset = (block.used + alignment - 1) & ~(alignment - 1);
+		if (offset + size <= block.size)
+		{
+			block.used = offset + size;
+			return block.data + offset;
+		}
+	}
+	// Oversized objects get a block of their own
+	size_t block_size = std::max(m_block_size, size + alignment);
+	char* data = static_cast<char*>(::operator new(block_size, std::align_val_t(alignof(std::max_align_t))));
+	m_num_block_allocations++;
+	m_blocks.push_back({ data, block_size, 0 });
+	BlockRange range = { data, data + block_size, this };
+	s_block_ranges.insert(std::upper_bound(s_block_ranges.begin(), s_block_ranges.end(), range,
+		[](const BlockRange& a, const BlockRange& b) { return std::less<const char*>()(a.begin, b.begin); }), range);
+	Block& block = m_blocks.back();
+	size_t offset = (alignment - 1) & ~(alignment - 1);
+	block.used = offset + size;
+	return block.data + offset;
+}
+
+/// <summary>
+/// Keeps the memory of a destroyed object for the next allocation of the same size.
+/// Objects too small to hold the link are left to the release of the arena.
+/// </summary>
+void SceneArena::deallocate(void* p, size_t size, size_t alignment)
+{
+	ASSERT(owns(p));
+	if (size < sizeof(void*) || alignment < alignof(void*))
+	{
+		return;
+	}
+	FreeList& list = free_list(size, alignment);
+	*static_cast<void**>(p) = list.first;
+	list.first = p;
+}
+
+bool SceneArena::owns(const void* p) const
+{
+	return owner_of(p) == this;
+}
+
+/// <summary>
+/// Frees every block at once. The objects in the arena must have been destroyed before.
+/// The arena stays usable, the next allocation starts a new block.
+/// </summary>
+void SceneArena::release()
+{
+	for (Block& block : m_blocks)
+	{
+		::operator delete(block.data, std::align_val_t(alignof(std::max_align_t)));
+	}
+	m_blocks.clear();
+	m_free_lists.clear();
+	s_block_ranges.erase(std::remove_if(s_block_ranges.begin(), s_block_ranges.end(),
+		[this](const BlockRange& range) { return range.arena == this; }), s_block_ranges.end());
+}
+
+size_t SceneArena::bytes_used() const
+{
+	size_t used = 0;
+	for (const Block& block : m_blocks)
+	{
+		used += block.used;
+	}
+	return used;
+}
+
+/// <summary>
+/// Binary search over the blocks of all live arenas, called for every pooled delete
+/// </summary>
+SceneArena* SceneArena::owner_of(const void* p)
+{
+	const char* c = static_cast<const char*>(p);
+	auto it = std::upper_bound(s_block_ranges.begin(), s_block_ranges.end(), c,
+		[](const char* address, const BlockRange& range) { return std::less<const char*>()(address, range.begin); });
+	if (it == s_block_ranges.begin())
+	{
+		return nullptr;
+	}
+	const BlockRange& range = *(it - 1);
+	return std::less<const char*>()(c, range.end) ? range.arena : nullptr;
+}
@@ -0,0 +1,108 @@
+#include "Core/Simplification.h"
+#include <algorithm>
+#include <utility>
+
+namespace Simplification
+{
+	// Squared distance of p to the segment (a, b)
+	static inline float distance_sq(float ax, float ay, float bx, float by, float px, float py)
+	{
+		float dx = bx - ax;
+		float dy = by - ay;
+		float len_sq = dx * dx + dy * dy;
+		float t = 0.0f;
+		if (len_sq > 0.0f)
+		{
+			t = std::min(1.0f, std::max(0.0f, ((px - ax) * dx + (py - ay) * dy) / len_sq));
+		}
+		float ex = ax + t * dx - px;
+		float ey = ay + t * dy - py;
+		return ex * ex + ey * ey;
+	}
+
+	void douglas_peucker_closed(const float* xs, const float* ys, unsigned int num_corners,
+		float tolerance, std::vector<unsigned int>& out_kept)
+	{
+		out_kept.clear();
+		if (num_corners <= 3)
+		{
+			for (unsigned int i = 0; i < num_corners; i++)
+			{
+				out_kept.push_back(i);
+			}
+			return;
+		}
+
+		// Split the loop into two chains at the corner farthest from corner 0
+		unsigned int far = 0;
+		float far_dist_sq = -1.0f;
+		for (unsigned int i = 1; i < num_corners; i++)
+		{
+			float dx = xs[i] - xs[0];
+			float dy = ys[i] - ys[0];
+			if (dx * dx + dy * dy > far_dist_sq)
+			{
+				far_dist_sq = dx * dx + dy * dy;
+				far = i;
+			}
+		}
+
+		std::vector<char> keep(num_corners, 0);
+		keep[0] = 1;
+		keep[far] = 1;
+		const float tolerance_sq = tolerance * tolerance;
+		// Chains are (first, last) pairs, last may wrap around to corner 0
+		std::vector<std::pair<unsigned int, unsigned int>> chains = { { 0, far }, { far, num_corners } };
+		while (!chains.empty())
+		{
+			auto [first, last] = chains.back();
+			chains.pop_back();
+			if (last - first < 2)
+			{
+				continue;
+			}
+			unsigned int a = first, b = last % num_corners;
+			unsigned int split = first;
+			float split_dist_sq = -1.0f;
+			for (unsigned int i = first + 1; i < last; i++)
+			{
+				float d = distance_sq(xs[a], ys[a], xs[b], ys[b], xs[i], ys[i]);
+				if (d > split_dist_sq)
+				{
+					split_dist_sq = d;
+					split = i;
+				}
+			}
+			if (split_dist_sq > tolerance_sq)
+			{
+				keep[split] = 1;
+				chains.push_back({ first, split });
+				chains.push_back({ split, last });
+			}
+		}
+
+		for (unsigned int i = 0; i < num_corners; i++)
+		{
+			if (keep[i])
+			{
+				out_kept.push_back(i);
+			}
+		}
+		if (out_kept.size() < 3)
+		{
+			// Degenerate at this tolerance, keep the corner farthest from the kept segment as well
+			unsigned int third = 0;
+			float third_dist_sq = -1.0f;
+			for (unsigned int i = 0; i < num_corners; i++)
+			{
+				float d = distance_sq(xs[0], ys[0], xs[far], ys[far], xs[i], ys[i]);
+				if (!keep[i] && d > third_dist_sq)
+				{
+					third_dist_sq = d;
+					third = i;
+				}
+			}
+			out_kept.insert(std::upper_bound(out_kept.begin(), out_kept.end(), third), third);
+		}
+	}
+}
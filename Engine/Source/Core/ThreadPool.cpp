@@ -0,0 +1,105 @@
+#include "Core/ThreadPool.h"
+#include <atomic>
+#include <latch>
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+	: m_num_busy(0),
+	m_stopping(false)
+{
+	if (num_threads == s_hardware_threads)
+	{
+		num_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+	m_workers.reserve(num_threads);
+	for (unsigned int i = 0; i < num_threads; i++)
+	{
+		m_workers.emplace_back(&ThreadPool::worker_loop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_job_available.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::worker_loop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_job_available.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+		// The queued jobs are finished before stopping
+		if (m_jobs.empty())
+		{
+			return;
+		}
+		std::function<void()> job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+		m_num_busy++;
+		lock.unlock();
+		job();
+		lock.lock();
+		m_num_busy--;
+		if (m_num_busy == 0 && m_jobs.empty())
+		{
+			m_idle.notify_all();
+		}
+	}
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+	if (m_workers.empty())
+	{
+		job();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_job_available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this] { return m_num_busy == 0 && m_jobs.empty(); });
+}
+
+/// <summary>
+/// The indices are handed out one by one from a shared counter, so uneven
+/// iterations balance themselves. Only the jobs of this call are waited for.
+/// </summary>
+void ThreadPool::parallel_for(unsigned int count, const std::function<void(unsigned int)>& body)
+{
+	std::atomic<unsigned int> next(0);
+	auto run = [&]()
+	{
+		for (unsigned int i = next++; i < count; i = next++)
+		{
+			body(i);
+		}
+	};
+	unsigned int num_helpers = std::min(num_threads(), count > 0 ? count - 1 : 0);
+	std::latch done(num_helpers);
+	for (unsigned int i = 0; i < num_helpers; i++)
+	{
+		submit([&]()
+		{
+			run();
+			done.count_down();
+		});
+	}
+	run();
+	done.wait();
+}
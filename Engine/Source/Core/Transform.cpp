@@ -0,0 +1,73 @@
+#include "Core/Transform.h"
+#include <cmath>
+
+namespace Transform
+{
+	// Upper 3x3 block of RotateX * RotateY * RotateZ, expanded by hand
+	static inline void rotation_3x3(const Angel::vec3& euler, float r[3][3])
+	{
+		float ax = Angel::DegreesToRadians * euler.x;
+		float ay = Angel::DegreesToRadians * euler.y;
+		float az = Angel::DegreesToRadians * euler.z;
+		float cx = std::cos(ax), sx = std::sin(ax);
+		float cy = std::cos(ay), sy = std::sin(ay);
+		float cz = std::cos(az), sz = std::sin(az);
+
+		r[0][0] = cy * cz;
+		r[0][1] = -cy * sz;
+		r[0][2] = sy;
+		r[1][0] = sx * sy * cz + cx * sz;
+		r[1][1] = cx * cz - sx * sy * sz;
+		r[1][2] = -sx * cy;
+		r[2][0] = sx * sz - cx * sy * cz;
+		r[2][1] = cx * sy * sz + sx * cz;
+		r[2][2] = cx * cy;
+	}
+
+	Angel::mat4 rotation(const Angel::vec3& euler)
+	{
+		float r[3][3];
+		rotation_3x3(euler, r);
+		Angel::mat4 m;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				m[i][j] = r[i][j];
+			}
+		}
+		return m;
+	}
+
+	/// <summary>
+	/// The columns of the rotation are scaled, and the translation column is
+	/// translation - (R * S) * pivot, which is what the full product reduces to
+	/// </summary>
+	Angel::mat4 trs(const Angel::vec3& translation, const Angel::vec3& euler,
+		const Angel::vec3& scale, const Angel::vec3& pivot)
+	{
+		float r[3][3];
+		rotation_3x3(euler, r);
+		Angel::mat4 m;
+		for (int i = 0; i < 3; i++)
+		{
+			m[i][0] = r[i][0] * scale.x;
+			m[i][1] = r[i][1] * scale.y;
+			m[i][2] = r[i][2] * scale.z;
+			m[i][3] = translation[i] - (m[i][0] * pivot.x + m[i][1] * pivot.y + m[i][2] * pivot.z);
+		}
+		return m;
+	}
+
+	Angel::mat4 scale_pivot(const Angel::vec3& scale, const Angel::vec3& pivot)
+	{
+		Angel::mat4 m;
+		m[0][0] = scale.x;
+		m[1][1] = scale.y;
+		m[2][2] = scale.z;
+		m[0][3] = -scale.x * pivot.x;
+		m[1][3] = -scale.y * pivot.y;
+		m[2][3] = -scale.z * pivot.z;
+		return m;
+	}
+}
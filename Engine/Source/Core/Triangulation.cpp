@@ -0,0 +1,139 @@
+#include "Core/Triangulation.h"
+
+namespace Triangulation
+{
+	// Twice the signed area of the triangle (a, b, c), positive if counter clockwise
+	static inline float cross(float ax, float ay, float bx, float by, float cx, float cy)
+	{
+		return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+	}
+
+	bool ear_clip(const float* xs, const float* ys, unsigned int num_corners, std::vector<unsigned int>& out_indices)
+	{
+		out_indices.clear();
+		if (num_corners < 3)
+		{
+			return false;
+		}
+		out_indices.reserve(3 * (num_corners - 2));
+
+		// Orientation of the whole polygon, so that convexity can be tested with the same sign
+		float area = 0.0f;
+		for (unsigned int i = 0, j = num_corners - 1; i < num_corners; j = i++)
+		{
+			area += xs[j] * ys[i] - xs[i] * ys[j];
+		}
+		const float orientation = (area >= 0.0f) ? 1.0f : -1.0f;
+
+		// Remaining corners as a doubly linked ring
+		std::vector<unsigned int> prev(num_corners), next(num_corners);
+		std::vector<char> reflex(num_corners);
+		for (unsigned int i = 0; i < num_corners; i++)
+		{
+			prev[i] = (i + num_corners - 1) % num_corners;
+			next[i] = (i + 1) % num_corners;
+		}
+		// Zero area corners, e.g. on a straight edge, count as convex so that they can be clipped
+		auto is_reflex = [&](unsigned int i) -> bool
+		{
+			return orientation * cross(xs[prev[i]], ys[prev[i]], xs[i], ys[i], xs[next[i]], ys[next[i]]) < 0.0f;
+		};
+		// Clipped and no longer reflex corners stay in the list until it is compacted
+		std::vector<unsigned int> reflex_corners;
+		unsigned int num_reflex = 0;
+		auto update_reflex = [&](unsigned int i)
+		{
+			bool r = is_reflex(i);
+			if (r && !reflex[i])
+			{
+				reflex_corners.push_back(i);
+				num_reflex++;
+			}
+			else if (!r && reflex[i])
+			{
+				num_reflex--;
+			}
+			reflex[i] = r;
+		};
+		for (unsigned int i = 0; i < num_corners; i++)
+		{
+			update_reflex(i);
+		}
+
+		// A convex corner is an ear if no reflex corner lies inside the triangle it spans,
+		// convex corners can never be inside, so they are not tested
+		auto is_ear = [&](unsigned int i) -> bool
+		{
+			if (reflex[i])
+			{
+				return false;
+			}
+			unsigned int a = prev[i], c = next[i];
+			for (unsigned int r : reflex_corners)
+			{
+				if (!reflex[r] || r == a || r == c)
+				{
+					continue;
+				}
+				if (orientation * cross(xs[a], ys[a], xs[i], ys[i], xs[r], ys[r]) >= 0.0f
+					&& orientation * cross(xs[i], ys[i], xs[c], ys[c], xs[r], ys[r]) >= 0.0f
+					&& orientation * cross(xs[c], ys[c], xs[a], ys[a], xs[r], ys[r]) >= 0.0f)
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		bool simple = true;
+		unsigned int remaining = num_corners;
+		unsigned int current = 0;
+		// Number of corners visited since the last clipped ear, a full loop without an ear means a degenerate polygon
+		unsigned int visited = 0;
+		while (remaining > 3)
+		{
+			if (is_ear(current) || visited > remaining)
+			{
+				if (visited > remaining)
+				{
+					simple = false;
+				}
+				unsigned int a = prev[current], c = next[current];
+				out_indices.insert(out_indices.end(), { a, current, c });
+				next[a] = c;
+				prev[c] = a;
+				remaining--;
+				// Only the neighbours of the clipped corner change
+				if (reflex[current])
+				{
+					reflex[current] = 0;
+					num_reflex--;
+				}
+				update_reflex(a);
+				update_reflex(c);
+				current = c;
+				visited = 0;
+				// Drop the stale entries once they outnumber the reflex corners
+				if (reflex_corners.size() > 2 * num_reflex + 16)
+				{
+					unsigned int kept = 0;
+					for (unsigned int r : reflex_corners)
+					{
+						if (reflex[r])
+						{
+							reflex_corners[kept++] = r;
+						}
+					}
+					reflex_corners.resize(kept);
+				}
+			}
+			else
+			{
+				current = next[current];
+				visited++;
+			}
+		}
+		out_indices.insert(out_indices.end(), { prev[current], current, next[current] });
+		return simple;
+	}
+}
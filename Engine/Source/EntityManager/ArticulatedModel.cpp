@@ -13,6 +13,8 @@ ArticulatedModel::ArticulatedModel(
 	m_texture = texture;
 	texture_slot = m_texture_slot;
 	m_num_nodes = 0;
+	m_use_instancing = false;
+	m_instancer = nullptr;
 	m_proj = const_cast<Angel::mat4*>(&proj);
 	m_view = const_cast<Angel::mat4*>(&view);
 	init_static_tree();
@@ -21,6 +23,7 @@ ArticulatedModel::ArticulatedModel(
 ArticulatedModel::~ArticulatedModel()
 {
 	destroy_tree();
+	delete m_instancer;
 }
 
 void ArticulatedModel::init_random_tree(
@@ -75,20 +78,45 @@ void ArticulatedModel::init_random_tree(
 	}
 }
 
-void ArticulatedModel::draw_model()
+void ArticulatedModel::draw_model(RenderQueue* queue)
 {
 	Angel::mat4& proj = *m_proj;
 	Angel::mat4& view = *m_view;
-	if (m_model_root)
+	if (m_model_root && m_use_instancing)
+	{
+		// All branches share the textured unit cube, draw them with a single instanced call
+		if (m_instancer == nullptr)
+		{
+			m_instancer = new ShapeInstancer;
+		}
+		m_instancer->begin(proj, view);
+		Angel::mat4 model_translation = Angel::Translate(m_position);
+		m_model_root->traverse_all([this, &model_translation](ArticulatedModelNode* node) -> void
+		{
+			if (node)
+			{
+				Angel::mat4 model_mat = model_translation * node->model_matrix() * node->cube_model_matrix();
+				m_instancer->submit(node->cube(), model_mat, node->is_selected());
+			}
+		});
+		m_instancer->end();
+	}
+	else if (m_model_root)
 	{
-		m_model_root->traverse_all([&proj, &view, tr_pos = m_position](ArticulatedModelNode* node) -> void
+		// Branches closer to the camera are drawn first, so that the hidden ones fail the depth test
+		RenderQueue& target_queue = (queue != nullptr) ? *queue : RenderQueue::immediate();
+		m_model_root->traverse_all([&target_queue, &proj, &view, tr_pos = m_position](ArticulatedModelNode* node) -> void
 		{
 			if (node)
 			{
-				node->draw_node(proj, view, tr_pos);
+				node->submit_node(target_queue, proj, view, tr_pos);
 			}
 
 		});
+		if (queue == nullptr)
+		{
+			target_queue.flush();
+		}
 	}
 }
 
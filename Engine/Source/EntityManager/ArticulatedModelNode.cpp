@@ -1,9 +1,14 @@
 #include "EntityManager/ArticulatedModelNode.h"
 #include "Renderer/Renderer.h"
 #include "Core/ErrorManager.h"
+#include "Core/Transform.h"
 
 #include <functional>
 
+static const ShaderUniform<Angel::mat4> s_model_uniform("u_model");
+static const ShaderUniform<int> s_texture_uniform("u_texture");
+static const ShaderUniform<int> s_selected_uniform("u_selected");
+
 ArticulatedModelNode::ArticulatedModelNode(
 	const Angel::vec3& scale,
 	const Angel::vec3& rotation,
@@ -15,7 +20,7 @@ ArticulatedModelNode::ArticulatedModelNode(
 		ShapeModel::StaticShape::TEX_CUBE, 
 		nullptr, // no position
 		nullptr, // no rotation
-		new Angel::vec3(scale), 
+		&scale, 
 		texture_slot, 
 		texture);
 	m_parent = nullptr;
@@ -23,6 +28,7 @@ ArticulatedModelNode::ArticulatedModelNode(
 	m_parent_joint_point = {}; // trivial for the torso
 	m_entity_id = entity_id;
 	m_is_selected = false;
+	m_local_matrix_valid = false;
 }
 
 ArticulatedModelNode::~ArticulatedModelNode()
@@ -34,19 +40,37 @@ ArticulatedModelNode::~ArticulatedModelNode()
 
 Angel::mat4 ArticulatedModelNode::rotation_u()
 {
-	return (Angel::RotateX(((m_rotation).x))
-		* Angel::RotateY(((m_rotation).y))
-		* Angel::RotateZ(((m_rotation).z)));
+	return Transform::rotation(m_rotation);
 }
 
 Angel::mat4 ArticulatedModelNode::translation_minus_p()
 {
-	return Angel::Translate(-joint_point());
+	return Transform::trs(Angel::vec3(0.0f), Angel::vec3(0.0f), Angel::vec3(1.0f), joint_point());
 }
 
 Angel::mat4 ArticulatedModelNode::translation_q()
 {
-	return Angel::Translate(m_parent_joint_point);
+	return Transform::trs(m_parent_joint_point, Angel::vec3(0.0f), Angel::vec3(1.0f), Angel::vec3(0.0f));
+}
+
+/// <summary>
+/// translation_q() * rotation_u() * translation_minus_p(), built in closed form
+/// and cached until the rotation of the node is changed
+/// </summary>
+/// <returns></returns>
+const Angel::mat4& ArticulatedModelNode::local_matrix()
+{
+	if (!m_local_matrix_valid
+		|| m_rotation.x != m_local_matrix_rotation.x
+		|| m_rotation.y != m_local_matrix_rotation.y
+		|| m_rotation.z != m_local_matrix_rotation.z)
+	{
+		// q is trivial for the torso
+		m_local_matrix = Transform::trs(m_parent_joint_point, m_rotation, Angel::vec3(1.0f), joint_point());
+		m_local_matrix_rotation = m_rotation;
+		m_local_matrix_valid = true;
+	}
+	return m_local_matrix;
 }
 
 Angel::vec3& ArticulatedModelNode::rotation_vec()
@@ -82,6 +106,7 @@ ArticulatedModelNode* ArticulatedModelNode::insert_child(
 	ASSERT(parent_joint_height_normalized >= 0.0f && parent_joint_height_normalized <= 1.0f);
 	child->m_parent_joint_point = (1 - parent_joint_height_normalized) * this->joint_point()
 		+ (parent_joint_height_normalized) * (this->joint_point() + Angel::vec3(0, this->m_cube->scale().y, 0));
+	child->m_local_matrix_valid = false;
 
 	child->m_parent = this;
 	this->m_children_nodes.push_back(child);
@@ -97,12 +122,12 @@ Angel::mat4 ArticulatedModelNode::model_matrix()
 {
 	if (m_parent != nullptr)
 	{
-		return m_parent->model_matrix()									// all parent transformations combined
-			* translation_q() * rotation_u() * translation_minus_p();	// current body transformations
+		return m_parent->model_matrix()		// all parent transformations combined
+			* local_matrix();				// current body transformations
 	}
 	else
 	{
-		return rotation_u() * translation_minus_p();
+		return local_matrix();
 	}
 }
 
@@ -140,29 +165,31 @@ void ArticulatedModelNode::draw_node(
 	const Angel::mat4& proj, 
 	const Angel::mat4& view,
 	const Angel::vec3& model_position)
+{
+	RenderQueue& queue = RenderQueue::immediate();
+	submit_node(queue, proj, view, model_position);
+	queue.flush();
+}
+
+void ArticulatedModelNode::submit_node(
+	RenderQueue& queue,
+	const Angel::mat4& proj,
+	const Angel::mat4& view,
+	const Angel::vec3& model_position)
 {
 	Angel::mat4 model_mat = Angel::Translate(model_position) * model_matrix() * m_cube->model_matrix();
-	Angel::mat4 MV_matrix = view * model_mat;
-	Angel::mat4 MVP_matrix = proj * view * model_mat;
-	m_cube->texture()->bind(m_cube->texture_slot());
-	Shape::textured_shader()->bind();
-	Shape::textured_shader()->set_uniform_1i("u_texture", m_cube->texture_slot());
-	Shape::textured_shader()->set_uniform_mat4f("u_MVP", MVP_matrix);
-	Shape::textured_shader()->set_uniform_mat4f("u_MV", MV_matrix);
-	Shape::textured_shader()->set_uniform_mat4f("u_P", proj);
-	Angel::vec4 light_source_pos = view * Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f);
-	Shape::textured_shader()->set_uniform_4f("u_light_position", 
-		light_source_pos.x, 
-		light_source_pos.y, 
-		light_source_pos.z, 
-		light_source_pos.w);
-	Shape::textured_shader()->set_uniform_4f("u_ambient", 0.32f, 0.173f, 0.118f, 1.0f);
-	Shape::textured_shader()->set_uniform_4f("u_diffuse", 0.75f, 0.5f, 0.0f, 1.0f);
-	Shape::textured_shader()->set_uniform_4f("u_specular", 1.0f, 1.0f, 1.0f, 1.0f);
-	Shape::textured_shader()->set_uniform_1f("u_shininess", 50.0f);
-	Shape::textured_shader()->set_uniform_1i("u_selected", m_is_selected);
-	m_cube->texture()->bind(m_cube->texture_slot());
-	Renderer::draw_triangles(m_cube->vertex_array(), m_cube->index_buffer(), Shape::textured_shader());
+	RenderQueue::DrawCommand draw;
+	draw.layer = RenderQueue::Layer::Scene;
+	draw.depth = -(view * model_mat)[2][3];
+	draw.shader = Shape::textured_shader();
+	draw.texture = m_cube->texture();
+	draw.texture_slot = m_cube->texture_slot();
+	draw.vertex_array = m_cube->vertex_array();
+	draw.index_buffer = m_cube->index_buffer();
+	queue.submit(draw);
+	queue.uniform_1i(s_texture_uniform, m_cube->texture_slot());
+	queue.uniform_mat4f(s_model_uniform, model_mat);
+	queue.uniform_1i(s_selected_uniform, m_is_selected);
 }
 
 void ArticulatedModelNode::traverse_all(const std::function<void(ArticulatedModelNode*)>& f)
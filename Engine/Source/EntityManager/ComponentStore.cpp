@@ -0,0 +1,86 @@
+#include "EntityManager/ComponentStore.h"
+#include "Core/ErrorManager.h"
+
+ComponentStore& ComponentStore::get_instance()
+{
+	static ComponentStore s;
+	return s;
+}
+
+ComponentStore::Entity ComponentStore::create(const Angel::vec3& position,
+	const Angel::vec3& rotation,
+	const Angel::vec3& scale,
+	const Angel::vec4& color)
+{
+	// The arguments may refer into the arrays, e.g. when a shape is copied, take them before growing
+	const Angel::vec3 new_position = position;
+	const Angel::vec3 new_rotation = rotation;
+	const Angel::vec3 new_scale = scale;
+	const Angel::vec4 new_color = color;
+
+	Entity e;
+	if (m_first_free != null_entity)
+	{
+		e = m_first_free;
+		m_first_free = m_next_free[e];
+		m_next_free[e] = null_entity;
+	}
+	else
+	{
+		e = (Entity)m_dense_indices.size();
+		m_dense_indices.push_back(0);
+		m_next_free.push_back(null_entity);
+	}
+	m_dense_indices[e] = (uint32_t)m_entities.size();
+	m_positions.push_back(new_position);
+	m_rotations.push_back(new_rotation);
+	m_scales.push_back(new_scale);
+	m_colors.push_back(new_color);
+	m_entities.push_back(e);
+	return e;
+}
+
+/// <summary>
+/// Frees the components of the entity, the last entity is moved into their place
+/// </summary>
+/// <param name="e"></param>
+void ComponentStore::destroy(Entity e)
+{
+	ASSERT(is_alive(e));
+	uint32_t dense = m_dense_indices[e];
+	uint32_t last = (uint32_t)m_entities.size() - 1;
+	if (dense != last)
+	{
+		m_positions[dense] = m_positions[last];
+		m_rotations[dense] = m_rotations[last];
+		m_scales[dense] = m_scales[last];
+		m_colors[dense] = m_colors[last];
+		m_entities[dense] = m_entities[last];
+		m_dense_indices[m_entities[dense]] = dense;
+	}
+	m_positions.pop_back();
+	m_rotations.pop_back();
+	m_scales.pop_back();
+	m_colors.pop_back();
+	m_entities.pop_back();
+
+	m_dense_indices[e] = UINT32_MAX;
+	m_next_free[e] = m_first_free;
+	m_first_free = e;
+}
+
+bool ComponentStore::is_alive(Entity e) const
+{
+	return e < m_dense_indices.size() && m_dense_indices[e] != UINT32_MAX;
+}
+
+void ComponentStore::reserve(size_t num_entities)
+{
+	m_positions.reserve(num_entities);
+	m_rotations.reserve(num_entities);
+	m_scales.reserve(num_entities);
+	m_colors.reserve(num_entities);
+	m_entities.reserve(num_entities);
+	m_dense_indices.reserve(num_entities);
+	m_next_free.reserve(num_entities);
+}
@@ -60,19 +60,18 @@ void DSerializer::serialize_drawlist(const std::vector<ShapeModel*>& drawlist, c
 			}
 			else
 			{
-				std::vector<float> translation_only_coords = shape->raw_vertices();
 				// ignore the 0th(center) vertex
-				translation_only_coords.erase(translation_only_coords.begin(), translation_only_coords.begin() + NUM_COORDINATES);
-				Angel::vec3 pos = shape->position();
+				VertexView raw_positions = shape->raw_positions();
+				VertexView corners = raw_positions.subview(1, raw_positions.size() - 1);
+				// The raw vertices are relative to the centroid of the polygon, which is at pos
+				Angel::vec3 pos = shape->position() - shape->center_raw();
 				Angel::vec3 rot = shape->rotation();
 				Angel::vec4 col = shape->color();
 				file << "\tBEGIN" << std::endl;
-				for (unsigned int i = 0; i < translation_only_coords.size(); i+=NUM_COORDINATES)
+				for (unsigned int i = 0; i < corners.size(); i++)
 				{
-					translation_only_coords[i] += pos.x;
-					translation_only_coords[i+1] += pos.y;
-					translation_only_coords[i+2] += pos.z;
-					file << "\t" << std::to_string(translation_only_coords[i]) << " " << std::to_string(translation_only_coords[i+1]) << " " << std::to_string(translation_only_coords[i+2]) << std::endl;
+					Angel::vec3 translation_only_coords = corners.vec3_at(i) + pos;
+					file << "\t" << std::to_string(translation_only_coords.x) << " " << std::to_string(translation_only_coords.y) << " " << std::to_string(translation_only_coords.z) << std::endl;
 				}
 				file << "\tEND" << std::endl;
 				file << "\t" << std::to_string(rot.x) << " " << std::to_string(rot.y) << " " << std::to_string(rot.z) << std::endl;
@@ -83,8 +82,11 @@ void DSerializer::serialize_drawlist(const std::vector<ShapeModel*>& drawlist, c
 	file.close();
 }
 
-std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem::path& file_path)
+std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem::path& file_path, SceneArena* arena)
 {
+	// Shapes, their geometry and GL objects go into the arena of the scene
+	SceneArena::Scope arena_scope(arena);
+
 	auto ltrim_then_split = [](std::string line) -> std::vector<float>
 	{
 		line.erase(0, line.find_first_not_of("\t"));
@@ -115,10 +117,10 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 	// Current shape state
 	unsigned int line_idx_for_cur_shape = -1;
 	ShapeModel::StaticShape type;
-	Angel::vec3* cur_pos = nullptr;
-	Angel::vec3* cur_rot = nullptr;
-	Angel::vec3* cur_scale = nullptr;
-	Angel::vec4* cur_col = nullptr;
+	Angel::vec3 cur_pos;
+	Angel::vec3 cur_rot;
+	Angel::vec3 cur_scale;
+	Angel::vec4 cur_col;
 	std::vector<Angel::vec3> cur_model_coords;
 
 	while (getline(stream, line))
@@ -126,10 +128,10 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 		if (line == "ShapeModel" && line_idx_for_cur_shape == -1)
 		{
 			line_idx_for_cur_shape = 0;
-			cur_pos = nullptr;
-			cur_rot = nullptr;
-			cur_scale = nullptr;
-			cur_col = nullptr;
+			cur_pos = Angel::vec3();
+			cur_rot = Angel::vec3();
+			cur_scale = Angel::vec3();
+			cur_col = Angel::vec4();
 			cur_model_coords = {};
 			getline(stream, line);
 			line_idx_for_cur_shape++;
@@ -152,7 +154,7 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 				line_idx_for_cur_shape++;
 				std::vector<float> positions = ltrim_then_split(line);
 				ASSERT(positions.size() >= NUM_COORDINATES);
-				cur_pos = new Angel::vec3{ positions[0], positions[1], positions[2] };
+				cur_pos = Angel::vec3{ positions[0], positions[1], positions[2] };
 				if (positions.size() > NUM_COORDINATES)
 				{
 					std::cout << "Warning, loaded ShapeModel position had more than " << NUM_COORDINATES << " coordinates!" << std::endl;
@@ -164,7 +166,7 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 				line_idx_for_cur_shape++;
 				std::vector<float> rotations = ltrim_then_split(line);
 				ASSERT(rotations.size() >= NUM_COORDINATES);
-				cur_rot = new Angel::vec3{ rotations[0], rotations[1], rotations[2] };
+				cur_rot = Angel::vec3{ rotations[0], rotations[1], rotations[2] };
 				if (rotations.size() > NUM_COORDINATES)
 				{
 					std::cout << "Warning, loaded ShapeModel rotation had more than " << NUM_COORDINATES << " coordinates!" << std::endl;
@@ -176,7 +178,7 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 				line_idx_for_cur_shape++;
 				std::vector<float> scales = ltrim_then_split(line);
 				ASSERT(scales.size() >= NUM_COORDINATES);
-				cur_scale = new Angel::vec3{ scales[0], scales[1], scales[2] };
+				cur_scale = Angel::vec3{ scales[0], scales[1], scales[2] };
 				if (scales.size() > NUM_COORDINATES)
 				{
 					std::cout << "Warning, loaded ShapeModel scales had more than " << NUM_COORDINATES << " coordinates!" << std::endl;
@@ -187,7 +189,7 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 				line_idx_for_cur_shape++;
 				std::vector<float> colors = ltrim_then_split(line);
 				ASSERT(colors.size() >= 4);
-				cur_col = new Angel::vec4{ colors[0], colors[1], colors[2], colors[3] };
+				cur_col = Angel::vec4{ colors[0], colors[1], colors[2], colors[3] };
 				if (colors.size() > 4)
 				{
 					std::cout << "Warning, loaded ShapeModel colors had more than 4 values!" << std::endl;
@@ -224,7 +226,7 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 				line_idx_for_cur_shape++;
 				std::vector<float> rotations = ltrim_then_split(line);
 				ASSERT(rotations.size() >= NUM_COORDINATES);
-				cur_rot = new Angel::vec3{ rotations[0], rotations[1], rotations[2] };
+				cur_rot = Angel::vec3{ rotations[0], rotations[1], rotations[2] };
 				if (rotations.size() > NUM_COORDINATES)
 				{
 					std::cout << "Warning, loaded ShapeModel rotation had more than " << NUM_COORDINATES << " coordinates!" << std::endl;
@@ -235,7 +237,7 @@ std::vector<ShapeModel*> DSerializer::deserialize_drawlist(const std::filesystem
 				line_idx_for_cur_shape++;
 				std::vector<float> colors = ltrim_then_split(line);
 				ASSERT(colors.size() >= 4);
-				cur_col = new Angel::vec4{ colors[0], colors[1], colors[2], colors[3] };
+				cur_col = Angel::vec4{ colors[0], colors[1], colors[2], colors[3] };
 				if (colors.size() > 4)
 				{
 					std::cout << "Warning, loaded ShapeModel colors had more than 4 values!" << std::endl;
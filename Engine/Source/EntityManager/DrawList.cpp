@@ -1,9 +1,34 @@
 #include "EntityManager/DrawList.h"
 #include "Core/ErrorManager.h"
+#include "Core/PointInPolygon.h"
+#include "Renderer/SoftwareRasterizer.h"
 #include "Angel-maths/mat.h"
 #include <glew.h>
+#include <algorithm>
+#include <cmath>
 
 DrawList::DrawList(const Angel::mat4& proj, const Angel::mat4& view)
+	: m_num_removed_shape_models(0),
+	m_scene_arena(nullptr),
+	m_use_spatial_index(true),
+	m_next_draw_order(0),
+	m_draw_mode(DrawMode::Immediate),
+	m_batch_renderer(nullptr),
+	m_instancer(nullptr),
+	m_num_draw_calls(0),
+	m_use_view_culling(true),
+	m_has_view_rect(false),
+	m_view_rect({ 0, 0, 0, 0 }),
+	m_cull_rect({ 0, 0, 0, 0 }),
+	m_num_submitted(0),
+	m_num_culled(0),
+	m_use_lod(false),
+	m_lod_tiny_as_points(true),
+	m_lod_min_screen_size_px(1.0f),
+	m_lod_tolerance_px(0.5f),
+	m_num_lod_skipped(0),
+	m_num_lod_points(0),
+	m_num_lod_simplified(0)
 {
 	m_proj_mat = const_cast<Angel::mat4*>(&proj);
 	m_view_mat = const_cast<Angel::mat4*>(&view);
@@ -15,24 +40,112 @@ DrawList::DrawList(const Angel::mat4& proj, const Angel::mat4& view)
 /// </summary>
 DrawList::~DrawList()
 {
+	m_entries.clear();
+	m_handles.clear();
 	m_shape_models.clear();
+	m_shape_model_orders.clear();
+	m_spatial_index.clear();
 }
 
-void DrawList::add_shape(ShapeModel* s)
+/// <summary>
+/// Adds the shape in front of all other shapes, the list takes the ownership
+/// </summary>
+/// <param name="s"></param>
+/// <returns>handle that stays valid until the shape is removed</returns>
+SlotHandle DrawList::add_shape(ShapeModel* s)
 {
-	m_shape_models.push_back(s);
+	ASSERT(m_handles.find(s) == m_handles.end());
+	uint64_t order = m_next_draw_order++;
+	SlotHandle handle = m_entries.insert({ s, order });
+	m_handles[s] = handle;
+	append_shape_model(s, order);
+	m_spatial_index.insert(s, bounds_2d_of(s), order);
+	return handle;
 }
 
 void DrawList::remove_shape(ShapeModel* s)
 {
-	unsigned int idx = idx_of(s);
-	m_shape_models.erase(m_shape_models.begin() + idx);
+	remove_shape(handle_of(s));
+}
+
+/// <summary>
+/// Removes and deletes the shape, does nothing if the handle is stale
+/// </summary>
+/// <param name="handle"></param>
+void DrawList::remove_shape(SlotHandle handle)
+{
+	Entry* entry = m_entries.get(handle);
+	if (entry == nullptr)
+	{
+		return;
+	}
+	ShapeModel* s = entry->shape;
+	erase_shape_model(entry->order);
+	m_handles.erase(s);
+	m_entries.remove(handle);
+	m_spatial_index.remove(s);
 	if (s != nullptr)
 	{
 		delete s;
 	}
 }
 
+ShapeModel* DrawList::get(SlotHandle handle)
+{
+	Entry* entry = m_entries.get(handle);
+	return (entry != nullptr) ? entry->shape : nullptr;
+}
+
+SlotHandle DrawList::handle_of(ShapeModel* s) const
+{
+	auto it = m_handles.find(s);
+	return (it != m_handles.end()) ? it->second : SlotHandle();
+}
+
+/// <summary>
+/// Shapes in draw order
+/// </summary>
+/// <returns></returns>
+const std::vector<ShapeModel*>& DrawList::shape_models()
+{
+	if (m_num_removed_shape_models > 0)
+	{
+		// One pass for all the removals since the last call
+		size_t kept = 0;
+		for (size_t i = 0; i < m_shape_models.size(); i++)
+		{
+			if (m_shape_models[i] != nullptr)
+			{
+				m_shape_models[kept] = m_shape_models[i];
+				m_shape_model_orders[kept] = m_shape_model_orders[i];
+				kept++;
+			}
+		}
+		m_shape_models.resize(kept);
+		m_shape_model_orders.resize(kept);
+		m_num_removed_shape_models = 0;
+	}
+	return m_shape_models;
+}
+
+/// <summary>
+/// The order keys only grow, so a new or moved shape always goes to the back
+/// </summary>
+void DrawList::append_shape_model(ShapeModel* s, uint64_t order)
+{
+	ASSERT(m_shape_model_orders.empty() || m_shape_model_orders.back() < order);
+	m_shape_models.push_back(s);
+	m_shape_model_orders.push_back(order);
+}
+
+void DrawList::erase_shape_model(uint64_t order)
+{
+	auto it = std::lower_bound(m_shape_model_orders.begin(), m_shape_model_orders.end(), order);
+	ASSERT(it != m_shape_model_orders.end() && *it == order);
+	m_shape_models[it - m_shape_model_orders.begin()] = nullptr;
+	m_num_removed_shape_models++;
+}
+
 /// <summary>
 /// Moves a specific shape to the tail of the draw list,
 /// so that the draw call for that shape is made last. This way,
@@ -42,20 +155,62 @@ void DrawList::remove_shape(ShapeModel* s)
 /// <param name="s"></param>
 void DrawList::move_shape_to_frontview(ShapeModel* s)
 {
-	unsigned int idx = idx_of(s);
-	ASSERT(idx != -1);
-	m_shape_models.erase(m_shape_models.begin() + idx);
-	m_shape_models.push_back(s);
+	Entry* entry = m_entries.get(handle_of(s));
+	ASSERT(entry != nullptr);
+	erase_shape_model(entry->order);
+	entry->order = m_next_draw_order++;
+	append_shape_model(s, entry->order);
+	m_spatial_index.set_order(s, entry->order);
+}
+
+/// <summary>
+/// Must be called after a shape in the list was moved, rotated, scaled
+/// or had its vertices changed, so that the spatial index stays in sync
+/// </summary>
+/// <param name="s"></param>
+void DrawList::on_shape_modified(ShapeModel* s)
+{
+	if (m_spatial_index.contains(s))
+	{
+		m_spatial_index.update(s, bounds_2d_of(s));
+	}
+}
+
+SpatialIndex2D::Bounds DrawList::bounds_2d_of(ShapeModel* s)
+{
+	const std::array<float, 6>& bounding_cube = s->shape_bounding_cube();
+	return { bounding_cube[0], bounding_cube[1], bounding_cube[2], bounding_cube[3] };
 }
 
 /// <summary>
 /// Assuming all shapes in the list are 2D, retrieves the 
-/// shape at the given 2D world coordinate
+/// shape at the given 2D world coordinate. Only the shapes
+/// whose bounds contain the point are tested, from front to back.
 /// </summary>
 /// <param name="model_pos"></param>
 /// <returns></returns>
 ShapeModel* DrawList::frontmost_shape_2d(const Angel::vec3& model_pos)
 {
+	if (!m_use_spatial_index)
+	{
+		return frontmost_shape_2d_linear(model_pos);
+	}
+	m_spatial_index.query_point(model_pos.x, model_pos.y, m_query_candidates);
+	std::sort(m_query_candidates.begin(), m_query_candidates.end(),
+		[](const SpatialIndex2D::Entry* a, const SpatialIndex2D::Entry* b) { return a->order > b->order; });
+	for (const SpatialIndex2D::Entry* candidate : m_query_candidates)
+	{
+		if (candidate->shape->contains_2d(model_pos))
+		{
+			return candidate->shape;
+		}
+	}
+	return nullptr;
+}
+
+ShapeModel* DrawList::frontmost_shape_2d_linear(const Angel::vec3& model_pos)
+{
+	shape_models();
 	for (int i = (int)m_shape_models.size() - 1; i >= 0; i--)
 	{
 		if (m_shape_models[i]->contains_2d(model_pos))
@@ -68,27 +223,65 @@ ShapeModel* DrawList::frontmost_shape_2d(const Angel::vec3& model_pos)
 
 /// <summary>
 /// Assuming all shapes in the list are 2D, retrieves the
-/// shapes at the given 2D bounding box</summary>
-/// <param name="selector_pos"></param>
-/// <param name="selector_scale"></param>
+/// shapes at the given 2D bounding box, in draw order.
+/// Only the shapes whose bounds overlap the box are tested.
+/// </summary>
+/// <param name="selector_pos">center of the box</param>
+/// <param name="selector_scale">size of the box, can be negative</param>
 /// <returns></returns>
 const std::vector<ShapeModel*> DrawList::shapes_contained_in_2d(
 	const Angel::vec3& selector_pos, 
 	const Angel::vec3& selector_scale)
 {
+	if (!m_use_spatial_index)
+	{
+		return shapes_contained_in_2d_linear(selector_pos, selector_scale);
+	}
+	const float half_w = std::abs(selector_scale.x) / 2.0f;
+	const float half_h = std::abs(selector_scale.y) / 2.0f;
+	m_spatial_index.query_rect({
+		selector_pos.x - half_w, selector_pos.x + half_w,
+		selector_pos.y - half_h, selector_pos.y + half_h },
+		m_query_candidates);
+	std::sort(m_query_candidates.begin(), m_query_candidates.end(),
+		[](const SpatialIndex2D::Entry* a, const SpatialIndex2D::Entry* b) { return a->order < b->order; });
+
+	std::vector<ShapeModel*> out;
+	out.reserve(m_query_candidates.size());
+	// The selection box is axis aligned, so its outline is known without building a ShapeModel
+	const float box_xs[4] = { selector_pos.x - half_w, selector_pos.x + half_w, selector_pos.x + half_w, selector_pos.x - half_w };
+	const float box_ys[4] = { selector_pos.y - half_h, selector_pos.y - half_h, selector_pos.y + half_h, selector_pos.y + half_h };
+	for (const SpatialIndex2D::Entry* candidate : m_query_candidates)
+	{
+		ShapeModel* shape = candidate->shape;
+		const std::vector<float>& shape_xs = shape->world_xs();
+		const std::vector<float>& shape_ys = shape->world_ys();
+		// If at least one vertex is inside the region - excluding the borders of this region
+		// Then the shape is inside this region
+		// Or, the shape might contain the selection rectangle
+		if (PointInPolygon::contains_any(box_xs, box_ys, 4, shape_xs.data(), shape_ys.data(), (unsigned int)shape_xs.size())
+			|| shape->contains_any_2d(box_xs, box_ys, 4))
+		{
+			out.emplace_back(shape);
+		}
+	}
+	return out;
+}
+
+const std::vector<ShapeModel*> DrawList::shapes_contained_in_2d_linear(
+	const Angel::vec3& selector_pos,
+	const Angel::vec3& selector_scale)
+{
+	shape_models();
 	std::vector<ShapeModel*> out;
 	out.reserve(m_shape_models.size());
-	auto* tmp_pos = new Angel::vec3(selector_pos);
-	auto* tmp_scale = new Angel::vec3(selector_scale);
-	auto* tmp_rot = new Angel::vec3(0, 0, 0);
-	auto* tmp_col = new Angel::vec4(0, 0, 0, 0);
-	ShapeModel selection_rectangle_sm = ShapeModel(ShapeModel::StaticShape::RECTANGLE, tmp_pos, tmp_rot, tmp_scale, tmp_col);
+	ShapeModel selection_rectangle_sm(ShapeModel::StaticShape::RECTANGLE, selector_pos, Angel::vec3(0, 0, 0), selector_scale);
 	for (unsigned int i = 0; i < m_shape_models.size(); i++)
 	{
 		bool in = false;
 		for (unsigned int j = 0; j < m_shape_models[i]->true_num_vertices(); j++)
 		{
-			Angel::vec3 point_j = m_shape_models[i]->model_coords()[j];
+			const Angel::vec3& point_j = m_shape_models[i]->model_coords()[j];
 			// If at least one vertex is inside the region - excluding the borders of this region
 			// Then the shape is inside this region
 			if (selection_rectangle_sm.contains_2d(point_j))
@@ -103,7 +296,7 @@ const std::vector<ShapeModel*> DrawList::shapes_contained_in_2d(
 			// Or, the shape might contain the selection rectangle
 			for (unsigned int j = 0; j < selection_rectangle_sm.true_num_vertices(); j++)
 			{
-				Angel::vec3 point_j = selection_rectangle_sm.model_coords()[j];
+				const Angel::vec3& point_j = selection_rectangle_sm.model_coords()[j];
 				if (m_shape_models[i]->contains_2d(point_j))
 				{
 					out.emplace_back(m_shape_models[i]);
@@ -115,86 +308,410 @@ const std::vector<ShapeModel*> DrawList::shapes_contained_in_2d(
 	return out;
 }
 
+/// <summary>
+/// Position of the shape in the draw order, -1 if it is not in the list
+/// </summary>
+/// <param name="s"></param>
+/// <returns></returns>
 unsigned int DrawList::idx_of(ShapeModel* s)
 {
-	for (unsigned int i = 0; i < m_shape_models.size(); i++)
+	Entry* entry = m_entries.get(handle_of(s));
+	if (entry == nullptr)
 	{
-		if (m_shape_models[i] == s)
-		{
-			return i;
-		}
+		return -1;
 	}
-	return -1;
+	shape_models();
+	auto it = std::lower_bound(m_shape_model_orders.begin(), m_shape_model_orders.end(), entry->order);
+	return (unsigned int)(it - m_shape_model_orders.begin());
 }
 
 void DrawList::undo_add_predefined(ShapeModel* s)
 {
 	std::cout << "Undo predefined shape creation" << std::endl;
-	unsigned int idx_of_s = idx_of(s);
-	m_shape_models[idx_of_s]->is_hidden() = true;
+	s->is_hidden() = true;
 }
 
 void DrawList::redo_add_predefined(ShapeModel* s)
 {
 	std::cout << "Redo predefined shape creation" << std::endl;
-	unsigned int idx_of_s = idx_of(s);
-	m_shape_models[idx_of_s]->is_hidden() = false;
+	s->is_hidden() = false;
 }
 
 void DrawList::undo_finish_poly(ShapeModel* s)
 {
 	std::cout << "Undo polygon finished" << std::endl;
-	unsigned int idx_of_s = idx_of(s);
-	m_shape_models[idx_of_s]->is_hidden() = true;
+	s->is_hidden() = true;
 }
 
 void DrawList::redo_finish_poly(ShapeModel* s)
 {
 	std::cout << "Redo polygon finished" << std::endl;
-	unsigned int idx_of_s = idx_of(s);
-	m_shape_models[idx_of_s]->is_hidden() = false;
+	s->is_hidden() = false;
 }
 
 void DrawList::undo_move(ShapeModel* s, const Angel::vec3& move_amount)
 {
 	s->position() -= move_amount;
+	on_shape_modified(s);
 }
 
 void DrawList::redo_move(ShapeModel* s, const Angel::vec3& move_amount)
 {
 	s->position() += move_amount;
+	on_shape_modified(s);
 }
 
 void DrawList::undo_rotate(ShapeModel* s, const Angel::vec3& rotate_amount)
 {
 	s->rotation() -= rotate_amount;
+	on_shape_modified(s);
 }
 
 void DrawList::redo_rotate(ShapeModel* s, const Angel::vec3& rotate_amount)
 {
 	s->rotation() += rotate_amount;
+	on_shape_modified(s);
 }
 
 /// <summary>
+/// Takes the ownership of the arena that the shapes of the list were loaded into,
+/// it is released with the next shutdown
+/// </summary>
+/// <param name="arena"></param>
+void DrawList::set_scene_arena(SceneArena* arena)
+{
+	ASSERT(m_scene_arena == nullptr || m_scene_arena == arena);
+	m_scene_arena = arena;
+}
+
+/// <summary>
+/// Deletes all the shapes and the scene arena but keeps the batch renderer and the
+/// instancer, so the list can be refilled without reallocating their buffers.
 /// Must be called only when there is a valid OpenGL context!
 /// </summary>
-void DrawList::shutdown()
+void DrawList::clear()
 {
-	for (auto& ptr : m_shape_models)
+	for (auto& entry : m_entries.items())
 	{
-		delete ptr;
+		delete entry.shape;
 	}
+	m_entries.clear();
+	m_handles.clear();
 	m_shape_models.clear();
+	m_shape_model_orders.clear();
+	m_num_removed_shape_models = 0;
+	m_spatial_index.clear();
+	// All the shapes allocated into the arena were deleted above, free its memory at once
+	delete m_scene_arena;
+	m_scene_arena = nullptr;
+}
+
+/// <summary>
+/// Must be called only when there is a valid OpenGL context!
+/// </summary>
+void DrawList::shutdown()
+{
+	clear();
+	delete m_batch_renderer;
+	m_batch_renderer = nullptr;
+	delete m_instancer;
+	m_instancer = nullptr;
+}
+
+/// <summary>
+/// Sets the world rectangle that is visible on the screen, shapes outside of it are
+/// not drawn. Until it is set, e.g. for 3D scenes, nothing is culled.
+/// </summary>
+/// <param name="world_rect"></param>
+void DrawList::set_view_rect(const SpatialIndex2D::Bounds& world_rect)
+{
+	m_view_rect = world_rect;
+	m_has_view_rect = true;
+}
+
+/// <summary>
+/// Counts the shape as culled or submitted, cubes are never culled.
+/// The cached bounds of the shape are used, so this is cheap for unmodified shapes.
+/// </summary>
+/// <param name="s"></param>
+/// <returns>true if the shape should not be drawn</returns>
+bool DrawList::cull(ShapeModel* s)
+{
+	if (m_use_view_culling
+		&& m_has_view_rect
+		&& s->shape_def() != ShapeModel::StaticShape::COL_CUBE
+		&& s->shape_def() != ShapeModel::StaticShape::TEX_CUBE
+		&& !bounds_2d_of(s).overlaps(m_cull_rect))
+	{
+		m_num_culled++;
+		return true;
+	}
+	m_num_submitted++;
+	return false;
+}
+
+/// <summary>
+/// Picks how much detail a 2D shape is drawn with at the current zoom, cubes are always drawn fully
+/// </summary>
+/// <param name="s"></param>
+/// <param name="pixels_per_unit">scale of the view matrix, i.e. zoom_ratio / 100</param>
+/// <returns></returns>
+DrawList::LodTier DrawList::lod_tier(ShapeModel* s, float pixels_per_unit)
+{
+	if (!m_use_lod
+		|| s->shape_def() == ShapeModel::StaticShape::COL_CUBE
+		|| s->shape_def() == ShapeModel::StaticShape::TEX_CUBE)
+	{
+		return LodTier::Full;
+	}
+	const std::array<float, 6>& bounds = s->shape_bounding_cube();
+	float size_px = std::max(bounds[1] - bounds[0], bounds[3] - bounds[2]) * pixels_per_unit;
+	if (size_px < m_lod_min_screen_size_px)
+	{
+		if (m_lod_tiny_as_points)
+		{
+			m_num_lod_points++;
+			return LodTier::Point;
+		}
+		m_num_lod_skipped++;
+		return LodTier::Skip;
+	}
+	if (s->is_poly()
+		&& s->true_num_vertices() >= s_lod_min_simplified_vertices
+		&& pixels_per_unit * 100.0f < s_lod_full_detail_zoom_ratio)
+	{
+		m_num_lod_simplified++;
+		return LodTier::Simplified;
+	}
+	return LodTier::Full;
+}
+
+/// <summary>
+/// Resets the counters of the frame and the culling rectangle for the current view
+/// </summary>
+void DrawList::begin_draw_all()
+{
+	m_num_submitted = 0;
+	m_num_culled = 0;
+	m_num_lod_skipped = 0;
+	m_num_lod_points = 0;
+	m_num_lod_simplified = 0;
+	// Selection outlines may reach out of the bounds of their shapes by half of their width
+	float pixels_per_unit = std::abs((*m_view_mat)[0][0]);
+	float outline_margin = (pixels_per_unit != 0.0f) ? s_outline_width_px / pixels_per_unit : s_outline_width_px;
+	m_cull_rect = {
+		m_view_rect.x_min - outline_margin, m_view_rect.x_max + outline_margin,
+		m_view_rect.y_min - outline_margin, m_view_rect.y_max + outline_margin };
 }
 
 /// <summary>
 /// Draws all shape models in the list
 /// </summary>
-void DrawList::draw_all()
+void DrawList::draw_all(RenderQueue* queue)
 {
-	for (auto shape : m_shape_models)
+	begin_draw_all();
+	if (m_draw_mode == DrawMode::Batched)
 	{
-		shape->draw_shape(*m_proj_mat, *m_view_mat);		
+		draw_all_batched();
+	}
+	else if (m_draw_mode == DrawMode::Instanced)
+	{
+		draw_all_instanced();
+	}
+	else if (queue != nullptr)
+	{
+		draw_all_immediate(*queue);
+	}
+	else
+	{
+		draw_all_immediate(m_render_queue);
+		m_render_queue.flush();
+	}
+}
+
+/// <summary>
+/// Draws all shape models in the list with the CPU backend, in list order.
+/// The shapes are drawn fully, the LOD tiers only save GPU work.
+/// The caller sets the frame of the rasterizer before and flushes it after.
+/// </summary>
+/// <param name="rasterizer"></param>
+void DrawList::draw_all(SoftwareRasterizer& rasterizer)
+{
+	begin_draw_all();
+	m_num_draw_calls = 0;
+	for (auto shape : shape_models())
+	{
+		if (shape->is_hidden() || cull(shape))
+		{
+			continue;
+		}
+		shape->submit_software(rasterizer);
+		m_num_draw_calls++;
+	}
+}
+
+/// <summary>
+/// Submits the shapes to the render queue, the 2D shapes keep the list order
+/// and the cubes are sorted by state when the queue is flushed
+/// </summary>
+/// <param name="queue"></param>
+void DrawList::draw_all_immediate(RenderQueue& queue)
+{
+	m_num_draw_calls = 0;
+	float pixels_per_unit = std::abs((*m_view_mat)[0][0]);
+	for (auto shape : shape_models())
+	{
+		if (shape->is_hidden() || cull(shape))
+		{
+			continue;
+		}
+		switch (lod_tier(shape, pixels_per_unit))
+		{
+		case LodTier::Skip:
+			break;
+		case LodTier::Point:
+			shape->submit_point(queue);
+			m_num_draw_calls++;
+			break;
+		case LodTier::Simplified:
+			shape->submit_polygon_lod(queue, shape->polygon_lod(pixels_per_unit, m_lod_tolerance_px));
+			m_num_draw_calls += shape->is_selected() ? 2 : 1;
+			break;
+		default:
+			shape->submit_shape(queue, *m_proj_mat, *m_view_mat);
+			m_num_draw_calls += shape->is_selected() ? 2 : 1;
+			break;
+		}
 	}
 }
 
+/// <summary>
+/// Streams the world space geometry of the 2D shapes into one batch, in list order.
+/// Cubes are not batched, they flush the batch and are drawn on their own
+/// so that the painter's order is kept.
+/// </summary>
+void DrawList::draw_all_batched()
+{
+	if (m_batch_renderer == nullptr)
+	{
+		m_batch_renderer = new BatchRenderer2D(Shape::colored_shader(), Shape::colored_layout());
+	}
+	// The view matrix only scales uniformly in 2D, convert the outline width from pixels to world units
+	float pixels_per_unit = (*m_view_mat)[0][0];
+	float outline_width = (pixels_per_unit != 0.0f) ? s_outline_width_px / std::abs(pixels_per_unit) : s_outline_width_px;
+	const Angel::vec4 outline_color(0.0f, 0.0f, 0.0f, 1.0f);
+
+	unsigned int num_unbatched_draw_calls = 0;
+	m_batch_renderer->begin((*m_proj_mat) * (*m_view_mat));
+	for (auto shape : shape_models())
+	{
+		if (shape->is_hidden() || cull(shape))
+		{
+			continue;
+		}
+		ShapeModel::StaticShape def = shape->shape_def();
+		if (def == ShapeModel::StaticShape::COL_CUBE
+			|| def == ShapeModel::StaticShape::TEX_CUBE)
+		{
+			m_batch_renderer->flush();
+			shape->draw_shape(*m_proj_mat, *m_view_mat);
+			num_unbatched_draw_calls++;
+			continue;
+		}
+		LodTier tier = lod_tier(shape, std::abs(pixels_per_unit));
+		if (tier == LodTier::Skip)
+		{
+			continue;
+		}
+		if (tier == LodTier::Point)
+		{
+			const std::array<float, 6>& bounds = shape->shape_bounding_cube();
+			Angel::vec3 center((bounds[0] + bounds[1]) / 2.0f, (bounds[2] + bounds[3]) / 2.0f, (bounds[4] + bounds[5]) / 2.0f);
+			// One pixel wide, like the outline width it is converted to world units
+			m_batch_renderer->submit_point(center, outline_width / s_outline_width_px, shape->color());
+			continue;
+		}
+		const std::vector<Angel::vec3>& world_coords = shape->model_coords();
+		if (tier == LodTier::Simplified)
+		{
+			const Shape::PolygonLod& lod = shape->polygon_lod(std::abs(pixels_per_unit), m_lod_tolerance_px);
+			m_lod_coords.clear();
+			for (unsigned int corner : lod.corners)
+			{
+				m_lod_coords.push_back(world_coords[corner]);
+			}
+			m_batch_renderer->submit_triangles(m_lod_coords, lod.triangles, shape->color());
+			if (shape->is_selected())
+			{
+				m_batch_renderer->submit_outline(m_lod_coords, outline_width, outline_color);
+			}
+			continue;
+		}
+		if (shape->is_poly())
+		{
+			m_batch_renderer->submit_triangles(world_coords, shape->polygon_triangles(), shape->color());
+		}
+		else
+		{
+			m_batch_renderer->submit_convex_polygon(world_coords, shape->color());
+		}
+		if (shape->is_selected())
+		{
+			m_batch_renderer->submit_outline(world_coords, outline_width, outline_color);
+		}
+	}
+	m_batch_renderer->end();
+	m_num_draw_calls = m_batch_renderer->num_draw_calls() + num_unbatched_draw_calls;
+}
+
+/// <summary>
+/// Draws the runs of the same predefined shape with one instanced draw call each,
+/// polygons are drawn on their own in between so that the list order is kept
+/// </summary>
+void DrawList::draw_all_instanced()
+{
+	if (m_instancer == nullptr)
+	{
+		m_instancer = new ShapeInstancer;
+	}
+	unsigned int num_unbatched_draw_calls = 0;
+	float pixels_per_unit = std::abs((*m_view_mat)[0][0]);
+	m_instancer->begin(*m_proj_mat, *m_view_mat);
+	for (auto shape : shape_models())
+	{
+		if (shape->is_hidden() || cull(shape))
+		{
+			continue;
+		}
+		LodTier tier = lod_tier(shape, pixels_per_unit);
+		if (tier == LodTier::Skip)
+		{
+			continue;
+		}
+		if (ShapeInstancer::is_instanceable(shape->shape_def()))
+		{
+			// A tiny instance costs as much as a point, it stays in the batch
+			m_instancer->submit(shape);
+		}
+		else if (tier == LodTier::Point)
+		{
+			m_instancer->flush();
+			shape->draw_point();
+			num_unbatched_draw_calls++;
+		}
+		else if (tier == LodTier::Simplified)
+		{
+			m_instancer->flush();
+			shape->draw_polygon_lod(shape->polygon_lod(pixels_per_unit, m_lod_tolerance_px));
+			num_unbatched_draw_calls += shape->is_selected() ? 2 : 1;
+		}
+		else
+		{
+			m_instancer->flush();
+			shape->draw_shape(*m_proj_mat, *m_view_mat);
+			num_unbatched_draw_calls += shape->is_selected() ? 2 : 1;
+		}
+	}
+	m_instancer->end();
+	m_num_draw_calls = m_instancer->num_draw_calls() + num_unbatched_draw_calls;
+}
@@ -2,40 +2,82 @@
 
 #include "Renderer/Renderer.h"
 
+#include <cstring>
+
 #define NUM_ROWS m_row_subdiv
 #define NUM_COLUMNS m_col_subdiv
 #define NUM_MESH_ELEMENTS 4
 #define NUM_MESH_COORDINATES 3
 #define NUM_UV_COORDINATES 2
+#define NUM_FLOATS_PER_VERTEX ((NUM_MESH_ELEMENTS - 1) * NUM_MESH_COORDINATES + NUM_UV_COORDINATES)
 
-#define NUM_VERTICES_PER_QUAD 4
 #define NUM_INDICES_PER_QUAD 6
-#define NUM_WIREFRAME_INDICES_PER_QUAD 8
 
 #define NUM_QUADS (NUM_ROWS-1) * (NUM_COLUMNS-1)
 
-#define NUM_VERTICES NUM_QUADS * NUM_VERTICES_PER_QUAD
+// The vertices of the grid are shared by the quads around them
+#define NUM_VERTICES NUM_ROWS * NUM_COLUMNS
 #define NUM_INDICES NUM_QUADS * NUM_INDICES_PER_QUAD
-#define NUM_WIREFRAME_INDICES NUM_QUADS * NUM_WIREFRAME_INDICES_PER_QUAD
+#define NUM_WIREFRAME_INDICES 2 * ((NUM_ROWS - 1) * NUM_COLUMNS + NUM_ROWS * (NUM_COLUMNS - 1))
 
 Shader* ParametricMesh::s_g_shader = nullptr;
 Shader* ParametricMesh::s_p_shader = nullptr;
 Shader* ParametricMesh::s_wireframe_shader = nullptr;
 VertexBufferLayout* ParametricMesh::s_parametric_mesh_layout = nullptr;
+GeometryArena* ParametricMesh::s_arena = nullptr;
+VertexBufferLayout* ParametricMesh::s_packed_layout = nullptr;
+GeometryArena* ParametricMesh::s_packed_arena = nullptr;
+
+static const ShaderUniform<Angel::mat4> s_mvp_uniform("u_MVP");
+static const ShaderUniform<Angel::mat4> s_model_uniform("u_model");
+static const ShaderUniform<Angel::vec4> s_color_uniform("u_color");
+static const ShaderUniform<Angel::vec4> s_ambient_uniform("u_ambient");
+static const ShaderUniform<Angel::vec4> s_diffuse_uniform("u_diffuse");
+static const ShaderUniform<Angel::vec4> s_specular_uniform("u_specular");
+static const ShaderUniform<float> s_shininess_uniform("u_shininess");
+static const ShaderUniform<int> s_bump_texture_uniform("u_bump_texture");
 
 /// <summary>
-/// Constructs the mesh. If its already constructed, it reconstructs w.r.t new parameters
+/// Packed copy of the float vertices for VertexFormat::Packed. The positions stay float,
+/// half floats would visibly crack the larger meshes; the tangent is normalized first,
+/// the shaders only use its direction.
 /// </summary>
-void ParametricMesh::construct_mesh()
+static std::vector<uint8_t> pack_vertices(const float* data, unsigned int num_vertices)
 {
-	if (m_vao != nullptr)
-	{
-		delete m_vao;
-	}
-	if (m_vbo != nullptr)
+	const unsigned int packed_vertex_size = NUM_MESH_COORDINATES * sizeof(float)
+		+ sizeof(PackedNormal) + NUM_UV_COORDINATES * sizeof(uint16_t) + sizeof(PackedNormal);
+	std::vector<uint8_t> packed((size_t)num_vertices * packed_vertex_size);
+	uint8_t* dst = packed.data();
+	for (unsigned int i = 0; i < num_vertices; i++)
 	{
-		delete m_vbo;
+		const float* vertex = data + (size_t)i * NUM_FLOATS_PER_VERTEX;
+		Angel::vec3 tangent(vertex[8], vertex[9], vertex[10]);
+		float tangent_length = Angel::length(tangent);
+		if (tangent_length > 0.0f)
+		{
+			tangent = tangent / tangent_length;
+		}
+		PackedNormal normal = VertexPacking::snorm_10_10_10_2(vertex[3], vertex[4], vertex[5]);
+		uint16_t uv[NUM_UV_COORDINATES] = { VertexPacking::unorm16(vertex[6]), VertexPacking::unorm16(vertex[7]) };
+		PackedNormal packed_tangent = VertexPacking::snorm_10_10_10_2(tangent.x, tangent.y, tangent.z);
+
+		std::memcpy(dst, vertex, NUM_MESH_COORDINATES * sizeof(float));
+		dst += NUM_MESH_COORDINATES * sizeof(float);
+		std::memcpy(dst, &normal, sizeof(normal));
+		dst += sizeof(normal);
+		std::memcpy(dst, uv, sizeof(uv));
+		dst += sizeof(uv);
+		std::memcpy(dst, &packed_tangent, sizeof(packed_tangent));
+		dst += sizeof(packed_tangent);
 	}
+	return packed;
+}
+
+/// <summary>
+/// Constructs the mesh. If its already constructed, it reconstructs w.r.t new parameters
+/// </summary>
+void ParametricMesh::construct_mesh()
+{
 	if (m_mesh_points != nullptr)
 	{
 		for (unsigned int i = 0; i < m_old_row_subdiv; i++)
@@ -59,7 +101,7 @@ void ParametricMesh::construct_mesh()
 	}
 	m_mesh_points = new Angel::vec3*[m_row_subdiv];
 	m_mesh_normals = new Angel::vec3 * [m_row_subdiv];
-	m_mesh_buffer_data = new float[NUM_VERTICES * ((NUM_MESH_ELEMENTS - 1) * NUM_MESH_COORDINATES + NUM_UV_COORDINATES)];
+	m_mesh_buffer_data = new float[NUM_VERTICES * NUM_FLOATS_PER_VERTEX];
 
 	Angel::vec3** l_del_p_del_u = new Angel::vec3*[m_row_subdiv];
 	unsigned int data_idx = 0;
@@ -110,141 +152,31 @@ void ParametricMesh::construct_mesh()
 			}
 		}
 	}
-	for (unsigned int i = 0; i < m_row_subdiv - 1; i++)
+	for (unsigned int i = 0; i < m_row_subdiv; i++)
 	{
-		for (unsigned int j = 0; j < m_col_subdiv - 1; j++)
+		for (unsigned int j = 0; j < m_col_subdiv; j++)
 		{
 			float u = i / (float)(m_row_subdiv - 1);
 			float v = j / (float)(m_col_subdiv - 1);
-			float u_1 = (i + 1) / (float)(m_row_subdiv - 1);
-			float v_1 = (j + 1) / (float)(m_col_subdiv - 1);
-
-			// VERTEX 0
-			// Points
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i][j].x; // P_X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i][j].y; // P_Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i][j].z; // P_Z
-			data_idx++;
-
-			// Normals
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i][j].x; // N_X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i][j].y; // N_Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i][j].z; // N_Z
-			data_idx++;
-
-			// Parametric Coordinates
-			m_mesh_buffer_data[data_idx] = u;						// U
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = v;						// V
-			data_idx++;
-
-			// ∂p/∂u - Tangent Vector
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i][j].x; // ∂p/∂u.X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i][j].y; // ∂p/∂u.Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i][j].z; // ∂p/∂u.Z
-			data_idx++;
 
-
-			// VERTEX 1
 			// Points
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i + 1][j].x; // X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i + 1][j].y; // Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i + 1][j].z; // Z
-			data_idx++;
+			m_mesh_buffer_data[data_idx++] = m_mesh_points[i][j].x; // P_X
+			m_mesh_buffer_data[data_idx++] = m_mesh_points[i][j].y; // P_Y
+			m_mesh_buffer_data[data_idx++] = m_mesh_points[i][j].z; // P_Z
 
 			// Normals
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i + 1][j].x; // X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i + 1][j].y; // Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i + 1][j].z; // Z		
-			data_idx++;
+			m_mesh_buffer_data[data_idx++] = m_mesh_normals[i][j].x; // N_X
+			m_mesh_buffer_data[data_idx++] = m_mesh_normals[i][j].y; // N_Y
+			m_mesh_buffer_data[data_idx++] = m_mesh_normals[i][j].z; // N_Z
 
 			// Parametric Coordinates
-			m_mesh_buffer_data[data_idx] = u_1;						// U
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = v;							// V
-			data_idx++;
+			m_mesh_buffer_data[data_idx++] = u;						// U
+			m_mesh_buffer_data[data_idx++] = v;						// V
 
 			// ∂p/∂u - Tangent Vector
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i + 1][j].x; // ∂p/∂u.X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i + 1][j].y; // ∂p/∂u.Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i + 1][j].z; // ∂p/∂u.Z
-			data_idx++;
-
-
-			// VERTEX 2
-			// Points
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i + 1][j + 1].x; // X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i + 1][j + 1].y; // Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i + 1][j + 1].z; // Z
-			data_idx++;
-
-			// Normals
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i + 1][j + 1].x; // X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i + 1][j + 1].y; // Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i + 1][j + 1].z; // Z	
-			data_idx++;
-
-			// Parametric Coordinates
-			m_mesh_buffer_data[data_idx] = u_1;							// U
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = v_1;							// V
-			data_idx++;
-
-			// ∂p/∂u - Tangent Vector
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i + 1][j + 1].x; // ∂p/∂u.X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i + 1][j + 1].y; // ∂p/∂u.Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i + 1][j + 1].z; // ∂p/∂u.Z
-			data_idx++;
-
-
-			// VERTEX 3
-			// Points
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i][j + 1].x; // X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i][j + 1].y; // Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_points[i][j + 1].z; // Z
-			data_idx++;
-
-			// Normals
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i][j + 1].x; // X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i][j + 1].y; // Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = m_mesh_normals[i][j + 1].z; // Z	
-			data_idx++;
-
-			// Parametric Coordinates
-			m_mesh_buffer_data[data_idx] = u;							// U
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = v_1;						// V
-			data_idx++;
-
-			// ∂p/∂u - Tangent Vector
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i][j + 1].x; // ∂p/∂u.X
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i][j + 1].y; // ∂p/∂u.Y
-			data_idx++;
-			m_mesh_buffer_data[data_idx] = l_del_p_del_u[i][j + 1].z; // ∂p/∂u.Z
-			data_idx++;
+			m_mesh_buffer_data[data_idx++] = l_del_p_del_u[i][j].x; // ∂p/∂u.X
+			m_mesh_buffer_data[data_idx++] = l_del_p_del_u[i][j].y; // ∂p/∂u.Y
+			m_mesh_buffer_data[data_idx++] = l_del_p_del_u[i][j].z; // ∂p/∂u.Z
 		}
 	}
 
@@ -254,68 +186,111 @@ void ParametricMesh::construct_mesh()
 	}
 	delete[] l_del_p_del_u;
 
-	m_vbo = new VertexBuffer(m_mesh_buffer_data, 
-		NUM_VERTICES 
-		* ((NUM_MESH_ELEMENTS - 1) * NUM_MESH_COORDINATES + NUM_UV_COORDINATES) 
-		* sizeof(float));
-	m_vao = new VertexArray;
-	m_vao->add_buffer(*m_vbo, *s_parametric_mesh_layout);
+	// The range of the mesh moves only when it grows, the index buffers follow it
+	if (m_vbo == nullptr)
+	{
+		m_vbo = new VertexBuffer(*arena());
+	}
+	if (m_vertex_format == VertexFormat::Packed)
+	{
+		std::vector<uint8_t> packed = pack_vertices(m_mesh_buffer_data, NUM_VERTICES);
+		m_vbo->set_data(packed.data(), (unsigned int)packed.size());
+	}
+	else
+	{
+		m_vbo->set_data(m_mesh_buffer_data, NUM_VERTICES * NUM_FLOATS_PER_VERTEX * sizeof(float));
+	}
+	m_vao = arena()->vertex_array();
 
+	// A change of vertex format deleted the index buffers
 	if (m_old_row_subdiv != m_row_subdiv ||
-		m_old_col_subdiv != m_col_subdiv)
+		m_old_col_subdiv != m_col_subdiv ||
+		m_ibo == nullptr ||
+		m_rebuild_indices)
 	{
+		// Vertex (i, j) of the grid is i * NUM_COLUMNS + j
 		std::vector<unsigned int> l_indices = {};
-		l_indices.reserve(NUM_INDICES);
-		for (unsigned int i = 0; i < NUM_QUADS; i++)
+		if (m_triangle_strips)
 		{
-			l_indices.emplace_back(i * NUM_VERTICES_PER_QUAD);
-			l_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 1);
-			l_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 2);
-
-			l_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 2);
-			l_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 3);
-			l_indices.emplace_back(i * NUM_VERTICES_PER_QUAD);
+			IndexBuffer::grid_triangle_strips(m_row_subdiv, m_col_subdiv, l_indices);
 		}
-		delete m_ibo;
-		m_ibo = new IndexBuffer(l_indices.data(), (unsigned int)l_indices.size());
+		else
+		{
+			l_indices.reserve(NUM_INDICES);
+			for (unsigned int i = 0; i < m_row_subdiv - 1; i++)
+			{
+				for (unsigned int j = 0; j < m_col_subdiv - 1; j++)
+				{
+					unsigned int v0 = i * m_col_subdiv + j;
+					unsigned int v1 = v0 + m_col_subdiv;
+					unsigned int v2 = v1 + 1;
+					unsigned int v3 = v0 + 1;
+
+					l_indices.emplace_back(v0);
+					l_indices.emplace_back(v1);
+					l_indices.emplace_back(v2);
+
+					l_indices.emplace_back(v2);
+					l_indices.emplace_back(v3);
+					l_indices.emplace_back(v0);
+				}
+			}
+		}
+		if (m_ibo == nullptr)
+		{
+			m_ibo = new IndexBuffer(*arena(), 0);
+		}
+		m_ibo->set_data(l_indices.data(), (unsigned int)l_indices.size());
 
+		// Every edge of the grid once
 		std::vector<unsigned int> l_wireframe_indices = {};
 		l_wireframe_indices.reserve(NUM_WIREFRAME_INDICES);
-		for (unsigned int i = 0; i < NUM_QUADS; i++)
+		for (unsigned int i = 0; i < m_row_subdiv; i++)
 		{
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD);
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 1);
-
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 1);
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 2);
-
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 2);
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 3);
-
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD + 3);
-			l_wireframe_indices.emplace_back(i * NUM_VERTICES_PER_QUAD);
+			for (unsigned int j = 0; j < m_col_subdiv; j++)
+			{
+				unsigned int v0 = i * m_col_subdiv + j;
+				if (i + 1 < m_row_subdiv)
+				{
+					l_wireframe_indices.emplace_back(v0);
+					l_wireframe_indices.emplace_back(v0 + m_col_subdiv);
+				}
+				if (j + 1 < m_col_subdiv)
+				{
+					l_wireframe_indices.emplace_back(v0);
+					l_wireframe_indices.emplace_back(v0 + 1);
+				}
+			}
 		}
-		delete m_wireframe_ibo;
-		m_wireframe_ibo = new IndexBuffer(l_wireframe_indices.data(), (unsigned int)l_wireframe_indices.size());
+		if (m_wireframe_ibo == nullptr)
+		{
+			m_wireframe_ibo = new IndexBuffer(*arena(), 0);
+		}
+		m_wireframe_ibo->set_data(l_wireframe_indices.data(), (unsigned int)l_wireframe_indices.size());
 
-		m_ibo->unbind();
-		m_wireframe_ibo->unbind();
 		m_old_col_subdiv = m_col_subdiv;
 		m_old_row_subdiv = m_row_subdiv;
+		m_rebuild_indices = false;
 	}
-	m_vao->unbind();
-	m_vbo->unbind();
+	m_ibo->set_base_vertex((int)m_vbo->first_vertex());
+	m_wireframe_ibo->set_base_vertex((int)m_vbo->first_vertex());
 	m_just_changed = false;
 }
 
-ParametricMesh::ParametricMesh(float R, float r, float l, float q, unsigned int row_subdiv, unsigned int col_subdiv, const Angel::vec4& col, BumpMap* bumpmap)
+ParametricMesh::ParametricMesh(float R, float r, float l, float q, unsigned int row_subdiv, unsigned int col_subdiv, const Angel::vec4& col, BumpMap* bumpmap,
+	VertexFormat vertex_format)
 {
 	m_R = R; m_r = r; m_l = l; m_q = q; m_color = col; m_bumpmap = bumpmap; 
 	m_row_subdiv = row_subdiv; m_col_subdiv = col_subdiv;
 	m_old_row_subdiv = 0; m_old_col_subdiv = 0;
+	m_vertex_format = vertex_format;
+	m_triangle_strips = false;
+	m_rebuild_indices = false;
 	m_just_changed = false;
 	m_vao = nullptr;
 	m_vbo = nullptr;
+	m_ibo = nullptr;
+	m_wireframe_ibo = nullptr;
 	m_mesh_points = nullptr;
 	m_mesh_normals = nullptr;
 	m_mesh_buffer_data = nullptr;
@@ -324,10 +299,6 @@ ParametricMesh::ParametricMesh(float R, float r, float l, float q, unsigned int
 
 ParametricMesh::~ParametricMesh()
 {
-	if (m_vao != nullptr)
-	{
-		delete m_vao;
-	}
 	if (m_vbo != nullptr)
 	{
 		delete m_vbo;
@@ -361,62 +332,61 @@ ParametricMesh::~ParametricMesh()
 void ParametricMesh::update_and_draw(
 	const Angel::mat4& proj, 
 	const Angel::mat4& view, 
-	DisplayType display_type)
+	DisplayType display_type,
+	RenderQueue* queue)
 {
 	if (m_just_changed)
 	{
 		construct_mesh();
 	}
 
+	RenderQueue& target_queue = (queue != nullptr) ? *queue : RenderQueue::immediate();
+	RenderQueue::DrawCommand draw;
+	draw.layer = RenderQueue::Layer::Scene;
+	draw.translucent = m_color.w < 1.0f;
+	draw.depth = -view[2][3];
+	draw.vertex_array = m_vao;
+
 	// Draw
 	if (display_type == ParametricMesh::DisplayType::Wireframe)
 	{
-		Angel::mat4 MVP_matrix = proj * view;
-		s_wireframe_shader->bind();
-		s_wireframe_shader->set_uniform_mat4f("u_MVP", MVP_matrix);
-		s_wireframe_shader->set_uniform_4f("u_color",
-			m_color.x,
-			m_color.y,
-			m_color.z,
-			m_color.w);
-		Renderer::draw_seperate_lines(m_vao, m_wireframe_ibo, s_wireframe_shader);
+		draw.shader = s_wireframe_shader;
+		draw.index_buffer = m_wireframe_ibo;
+		draw.primitive = RenderQueue::Primitive::Lines;
+		target_queue.submit(draw);
+		target_queue.uniform_mat4f(s_mvp_uniform, proj * view);
+		target_queue.uniform_4f(s_color_uniform, m_color);
 	}
 	else
 	{
-		Shader* shader_to_use = nullptr;
 		if (display_type == ParametricMesh::DisplayType::Gouraud)
 		{
-			shader_to_use = s_g_shader;
+			draw.shader = s_g_shader;
 		}
 		else if (display_type == ParametricMesh::DisplayType::Phong)
 		{
-			shader_to_use = s_p_shader;
+			draw.shader = s_p_shader;
 		}
 		else
 		{
 			return;
 		}
-		shader_to_use->bind();
-		shader_to_use->set_uniform_mat4f("u_MV", view);
-		shader_to_use->set_uniform_mat4f("u_P", proj);
-		Angel::vec4 u_light_position(0.0f, 1000.0f, 1000.0f, 1.0f);
-		shader_to_use->set_uniform_4f("u_light_position",
-			u_light_position.x,
-			u_light_position.y,
-			u_light_position.z,
-			u_light_position.w);
-		shader_to_use->set_uniform_4f("u_color",
-			m_color.x,
-			m_color.y,
-			m_color.z,
-			m_color.w);
-		shader_to_use->set_uniform_4f("u_ambient", m_ambient.x, m_ambient.y, m_ambient.z, m_ambient.w);
-		shader_to_use->set_uniform_4f("u_diffuse", m_diffuse.x, m_diffuse.y, m_diffuse.z, m_diffuse.w);
-		shader_to_use->set_uniform_4f("u_specular", m_specular.x, m_specular.y, m_specular.z, m_specular.w);
-		shader_to_use->set_uniform_1f("u_shininess", m_shininess);
-		m_bumpmap->bump_texture()->bind(0);
-		shader_to_use->set_uniform_1i("u_bump_texture", 0);
-		Renderer::draw_triangles(m_vao, m_ibo, shader_to_use);
+		draw.texture = m_bumpmap->bump_texture();
+		draw.texture_slot = 0;
+		draw.index_buffer = m_ibo;
+		draw.primitive = m_triangle_strips ? RenderQueue::Primitive::TriangleStrip : RenderQueue::Primitive::Triangles;
+		target_queue.submit(draw);
+		target_queue.uniform_mat4f(s_model_uniform, Angel::mat4());
+		target_queue.uniform_4f(s_color_uniform, m_color);
+		target_queue.uniform_4f(s_ambient_uniform, m_ambient);
+		target_queue.uniform_4f(s_diffuse_uniform, m_diffuse);
+		target_queue.uniform_4f(s_specular_uniform, m_specular);
+		target_queue.uniform_1f(s_shininess_uniform, m_shininess);
+		target_queue.uniform_1i(s_bump_texture_uniform, 0);
+	}
+	if (queue == nullptr)
+	{
+		target_queue.flush();
 	}
 }
 
@@ -477,6 +447,32 @@ void ParametricMesh::set_col_subdiv(unsigned int c_sbd)
 	}
 }
 
+void ParametricMesh::set_vertex_format(VertexFormat vertex_format)
+{
+	if (vertex_format != m_vertex_format)
+	{
+		// The ranges belong to the arena of the old layout, construct_mesh allocates new ones
+		delete m_vbo;
+		delete m_ibo;
+		delete m_wireframe_ibo;
+		m_vbo = nullptr;
+		m_ibo = nullptr;
+		m_wireframe_ibo = nullptr;
+		m_vertex_format = vertex_format;
+		m_just_changed = true;
+	}
+}
+
+void ParametricMesh::set_triangle_strips(bool triangle_strips)
+{
+	if (triangle_strips != m_triangle_strips)
+	{
+		m_triangle_strips = triangle_strips;
+		m_rebuild_indices = true;
+		m_just_changed = true;
+	}
+}
+
 void ParametricMesh::init_static_members()
 {
 	s_g_shader = new Shader("../../Engine/Shaders/g_shaded_triangle.glsl");
@@ -489,6 +485,25 @@ void ParametricMesh::init_static_members()
 	s_parametric_mesh_layout->push_back_elements<float>(NUM_UV_COORDINATES);
 	s_parametric_mesh_layout->push_back_elements<float>(NUM_MESH_COORDINATES);
 
+	// Same attributes in the order of pack_vertices
+	s_packed_layout = new VertexBufferLayout;
+	s_packed_layout->push_back_elements<float>(NUM_MESH_COORDINATES);
+	s_packed_layout->push_back_elements<PackedNormal>(1);
+	s_packed_layout->push_back_elements<unsigned short>(NUM_UV_COORDINATES);
+	s_packed_layout->push_back_elements<PackedNormal>(1);
+
+	// The shaders and the layout are edited separately, report a mismatch at startup
+	s_g_shader->check_layout(*s_parametric_mesh_layout);
+	s_p_shader->check_layout(*s_parametric_mesh_layout);
+	s_wireframe_shader->check_layout(*s_parametric_mesh_layout);
+	s_g_shader->check_layout(*s_packed_layout);
+	s_p_shader->check_layout(*s_packed_layout);
+	s_wireframe_shader->check_layout(*s_packed_layout);
+
+	// Room for one mesh at the default subdivision, larger meshes grow the arena
+	s_arena = new GeometryArena(*s_parametric_mesh_layout, 1 << 16, 1 << 17);
+	s_packed_arena = new GeometryArena(*s_packed_layout, 1 << 16, 1 << 17);
+
 	s_g_shader->unbind();
 	s_p_shader->unbind();
 	s_wireframe_shader->unbind();
@@ -499,5 +514,8 @@ void ParametricMesh::destroy_static_members()
 	delete s_g_shader;
 	delete s_p_shader;
 	delete s_wireframe_shader;
+	delete s_arena;
+	delete s_packed_arena;
 	delete s_parametric_mesh_layout;
+	delete s_packed_layout;
 }
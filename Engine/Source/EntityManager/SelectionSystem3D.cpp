@@ -4,6 +4,8 @@
 #include <functional>
 #include <glew.h>
 
+static const ShaderUniform<Angel::mat4> s_model_uniform("u_model");
+
 SelectionSystem3D::SelectionSystem3D(DrawList* draw_list, ArticulatedModel* model, int width, int height)
 {
 	// Initialize FrameBuffer
@@ -39,24 +41,21 @@ unsigned int SelectionSystem3D::on_update(int window_x, int window_y)
 					u_shape_model_id[0],
 					u_shape_model_id[1],
 					u_shape_model_id[2]);
-				Angel::mat4 mvp = m_draw_list->projection_matrix() * m_draw_list->view_matrix() * shape_model->model_matrix();
-				m_picker_shader->set_uniform_mat4f("u_MVP", mvp);
+				m_picker_shader->set_uniform(s_model_uniform, shape_model->model_matrix());
 				if (!shape_model->is_poly())
 				{
 					Renderer::draw_triangles(shape_model->vertex_array(), shape_model->index_buffer(), m_picker_shader);
 				}
 				else
 				{
-					Renderer::draw_polygon(shape_model->vertex_array(), shape_model->index_buffer(), m_picker_shader);
+					Renderer::draw_polygon(shape_model->vertex_array(), shape_model->polygon_triangle_index_buffer(), m_picker_shader);
 				}
 				index++;
 			}
 
 			// Render Articulated Model into the FBO texture
-			const Angel::mat4& proj = m_draw_list->projection_matrix();
-			const Angel::mat4& view = m_draw_list->view_matrix();
 			const Angel::vec3& tr_position = m_hierarchical_model->position();
-			m_hierarchical_model->traverse_all_nodes([picker_shader = m_picker_shader, &proj, &view, tr_pos = tr_position](ArticulatedModelNode* node) -> void
+			m_hierarchical_model->traverse_all_nodes([picker_shader = m_picker_shader, tr_pos = tr_position](ArticulatedModelNode* node) -> void
 			{
 				if (node)
 				{
@@ -66,8 +65,7 @@ unsigned int SelectionSystem3D::on_update(int window_x, int window_y)
 						u_shape_model_id[1],
 						u_shape_model_id[2]);
 					Angel::mat4 model_mat = Angel::Translate(tr_pos) * node->model_matrix() * node->cube_model_matrix();
-					Angel::mat4 MVP_matrix = proj * view * model_mat;
-					picker_shader->set_uniform_mat4f("u_MVP", MVP_matrix);
+					picker_shader->set_uniform(s_model_uniform, model_mat);
 					Renderer::draw_triangles(node->cube_vao(), node->cube_ibo(), picker_shader);
 				}
 			});
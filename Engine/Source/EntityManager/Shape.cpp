@@ -3,8 +3,13 @@
 #include "Core/ErrorManager.h"
 
 #include "Renderer/Shader.h"
+#include "Renderer/FrameUniforms.h"
+#include "Core/Triangulation.h"
+#include "Core/Simplification.h"
 
 #include <glew.h>
+#include <iostream>
+#include <cstring>
 
 // Declare static members
 Shader* Shape::s_basic_shader = nullptr;
@@ -13,6 +18,16 @@ Shader* Shape::s_colored_shader = nullptr;
 VertexBufferLayout* Shape::s_basic_layout = nullptr;
 VertexBufferLayout* Shape::s_textured_layout = nullptr;
 VertexBufferLayout* Shape::s_colored_layout = nullptr;
+VertexBufferLayout* Shape::s_packed_textured_layout = nullptr;
+VertexBufferLayout* Shape::s_packed_colored_layout = nullptr;
+VertexFormat Shape::s_cube_format = VertexFormat::Float;
+Shader* Shape::s_instanced_basic_shader = nullptr;
+Shader* Shape::s_instanced_colored_shader = nullptr;
+Shader* Shape::s_instanced_textured_shader = nullptr;
+VertexBufferLayout* Shape::s_instance_layout = nullptr;
+GeometryArena* Shape::s_basic_arena = nullptr;
+GeometryArena* Shape::s_textured_arena = nullptr;
+GeometryArena* Shape::s_colored_arena = nullptr;
 Shape* Shape::s_unit_eq_triangle = new Shape;
 Shape* Shape::s_unit_square = new Shape;
 Shape* Shape::s_colored_unit_cube = new Shape;
@@ -21,40 +36,64 @@ Shape* Shape::s_textured_unit_cube = new Shape;
 Shape::Shape(const std::vector<Angel::vec3>& model_coords_center_translated_to_origin)
 {
 	ASSERT(model_coords_center_translated_to_origin.size() >= 3);
+	m_vertex_array = nullptr;
+	m_vertex_buffer = nullptr;
+	m_index_buffer = nullptr;
+	m_revision = 0;
+	m_triangle_index_buffer = nullptr;
+	m_triangulation_revision = 0;
+	m_triangulation_valid = false;
+	m_triangle_index_buffer_valid = false;
+	m_self_intersection_reported = false;
+	m_lods_revision = 0;
+	m_lods_clock = 0;
+	m_vertex_stride = NUM_COORDINATES;
+	unsigned int num_corners = (unsigned int)model_coords_center_translated_to_origin.size();
+
+	// The 0th vertex is the center of the triangle fan, it is kept at the centroid of the corners
+	m_vertex_sum = Angel::vec3(0.0f, 0.0f, 0.0f);
+	for (const Angel::vec3& corner : model_coords_center_translated_to_origin)
+	{
+		m_vertex_sum += corner;
+	}
+	Angel::vec3 centroid = m_vertex_sum / (float)num_corners;
 
 	m_no_transform_vertex_positions = new std::vector<float>;
-	m_no_transform_vertex_positions->reserve((model_coords_center_translated_to_origin.size() + 1) * NUM_COORDINATES);
-	m_no_transform_vertex_positions->insert(m_no_transform_vertex_positions->begin(), 
-		{
-			0.0f,	0.0f,	0.0f
-		});
-
-	for (unsigned int i = NUM_COORDINATES/* 0*/; i < m_no_transform_vertex_positions->capacity(); i++)
+	m_no_transform_vertex_positions->reserve((num_corners + 1) * NUM_COORDINATES);
+	m_no_transform_vertex_positions->insert(m_no_transform_vertex_positions->end(), { centroid.x, centroid.y, centroid.z });
+	for (const Angel::vec3& corner : model_coords_center_translated_to_origin)
 	{
-		m_no_transform_vertex_positions->emplace_back(model_coords_center_translated_to_origin[i / 3 - 1][i % 3]);
+		m_no_transform_vertex_positions->insert(m_no_transform_vertex_positions->end(), { corner.x, corner.y, corner.z });
 	}
 
-	m_vertex_array = new VertexArray;
-	m_vertex_buffer = new VertexBuffer(m_no_transform_vertex_positions->data(),
-		(uint16_t)m_no_transform_vertex_positions->size() * sizeof(float));
-	m_vertex_array->add_buffer(*m_vertex_buffer, *s_basic_layout);
-	
+	// Indices of the fan: center, corners, then the first corner again to close it.
+	// Only the outline uses them, the fill is drawn from the triangulation
 	m_indices = new std::vector<unsigned int>;
-	m_indices->reserve(model_coords_center_translated_to_origin.size() + 2);
-	for (unsigned int i = 0; i < model_coords_center_translated_to_origin.size() + 1; i++)
+	m_indices->reserve(num_corners + 2);
+	for (unsigned int i = 0; i < num_corners + 1; i++)
 	{
 		m_indices->emplace_back(i);
 	}
 	m_indices->emplace_back(1);
-	m_index_buffer = new IndexBuffer(m_indices->data(), (uint16_t)m_indices->size());
+
+	// Without a GL context only the CPU copies are kept, see init_static_members
+	if (s_basic_arena == nullptr)
+	{
+		return;
+	}
+	// Leave room on the GPU so that the next vertices can be appended without reallocation
+	unsigned int vertex_capacity = polygon_capacity_for(num_corners + 1);
+	m_vertex_array = s_basic_arena->vertex_array();
+	m_vertex_buffer = new VertexBuffer(*s_basic_arena);
+	m_vertex_buffer->reallocate(m_no_transform_vertex_positions->data(),
+		(unsigned int)(m_no_transform_vertex_positions->size() * sizeof(float)),
+		vertex_capacity * NUM_COORDINATES * sizeof(float));
+	m_index_buffer = new IndexBuffer(*s_basic_arena, (int)m_vertex_buffer->first_vertex());
+	m_index_buffer->reallocate(m_indices->data(), (unsigned int)m_indices->size(), vertex_capacity + 1, vertex_capacity - 1);
 }
 
 Shape::~Shape()
 {
-	if (m_vertex_array)
-	{
-		delete m_vertex_array;
-	}
 	if (m_vertex_buffer)
 	{
 		delete m_vertex_buffer;
@@ -63,6 +102,11 @@ Shape::~Shape()
 	{
 		delete m_index_buffer;
 	}
+	if (m_triangle_index_buffer)
+	{
+		delete m_triangle_index_buffer;
+	}
+	clear_polygon_lods();
 	if (m_indices)
 	{
 		delete m_indices;
@@ -74,83 +118,362 @@ Shape::~Shape()
 }
 
 /// <summary>
-/// This function will be called whenever a vertex is added to the polygon
+/// Positions of the vertices, including the fan center of polygons.
+/// No copy is made, the view is valid until the next push_back_vertex.
+/// </summary>
+VertexView Shape::positions() const
+{
+	return attribute(0, NUM_COORDINATES);
+}
+
+/// <summary>
+/// One attribute of the interleaved vertices, e.g. the normals of the textured cube
+/// are at offset NUM_COORDINATES + NUM_TEXTURE_COORDINATES
+/// </summary>
+/// <param name="offset">first float of the attribute within a vertex</param>
+/// <param name="components">floats of the attribute</param>
+VertexView Shape::attribute(unsigned int offset, unsigned int components) const
+{
+	ASSERT(offset + components <= m_vertex_stride);
+	if (m_no_transform_vertex_positions == nullptr)
+	{
+		return {};
+	}
+	return { m_no_transform_vertex_positions->data() + offset, num_vertices(), m_vertex_stride, components };
+}
+
+IndexView Shape::indices() const
+{
+	if (m_indices == nullptr)
+	{
+		return {};
+	}
+	return *m_indices;
+}
+
+/// <summary>
+/// Smallest power of two capacity, in vertices, that can hold the given number of vertices
 /// </summary>
-/// <param name="centered_model_pos"></param>
-Angel::vec3 Shape::push_back_vertex(const Angel::vec3& new_vertex_pos_where_origin_is_old_center, const Angel::vec3& old_center)
+unsigned int Shape::polygon_capacity_for(unsigned int num_vertices)
+{
+	unsigned int capacity = 8;
+	while (capacity < num_vertices)
+	{
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+/// <summary>
+/// This function will be called whenever a vertex is added to the polygon.
+/// The existing vertices are not moved, only the new vertex, the fan center
+/// and the closing indices are uploaded. The GPU buffers double their
+/// capacity when they are full.
+/// </summary>
+/// <param name="raw_vertex_pos">position of the new vertex, in the same space as the existing ones</param>
+/// <returns>how much the centroid of the polygon moved</returns>
+Angel::vec3 Shape::push_back_vertex(const Angel::vec3& raw_vertex_pos)
 {
 	ASSERT(this != s_unit_eq_triangle);
 	ASSERT(this != s_unit_square);
 	ASSERT(m_no_transform_vertex_positions->size() >= 3);
-	delete m_vertex_buffer;
-	delete m_vertex_array;
-	delete m_index_buffer;
-	m_no_transform_vertex_positions->insert(m_no_transform_vertex_positions->end(), 
-		{
-			new_vertex_pos_where_origin_is_old_center.x, new_vertex_pos_where_origin_is_old_center.y, new_vertex_pos_where_origin_is_old_center.z
-		});
+	unsigned int old_num_corners = num_vertices() - 1;
+	Angel::vec3 old_centroid = m_vertex_sum / (float)old_num_corners;
+
+	// Update the centroid incrementally
+	m_vertex_sum += raw_vertex_pos;
+	Angel::vec3 centroid = m_vertex_sum / (float)(old_num_corners + 1);
+	std::vector<float>& positions = *m_no_transform_vertex_positions;
+	positions[0] = centroid.x;
+	positions[1] = centroid.y;
+	positions[2] = centroid.z;
+	positions.insert(positions.end(), { raw_vertex_pos.x, raw_vertex_pos.y, raw_vertex_pos.z });
+
+	// The closing index is replaced by the new vertex, and the fan is closed again
+	unsigned int new_vertex_index = num_vertices() - 1;
+	(*m_indices)[m_indices->size() - 1] = new_vertex_index;
+	m_indices->emplace_back(1);
+
+	m_revision++;
 
-	// Update the center
-	Angel::vec3 center(0.0f, 0.0f, 0.0f);
-	for (unsigned int i = NUM_COORDINATES; i < num_vertices() * NUM_COORDINATES; i+=3)
+	// Without a GL context there is no GPU copy to update
+	if (m_vertex_buffer == nullptr)
+	{
+		return centroid - old_centroid;
+	}
+	unsigned int positions_size = (unsigned int)(positions.size() * sizeof(float));
+	if (positions_size > m_vertex_buffer->capacity())
+	{
+		unsigned int vertex_capacity = polygon_capacity_for(num_vertices());
+		m_vertex_buffer->reallocate(positions.data(), positions_size, vertex_capacity * NUM_COORDINATES * sizeof(float));
+		m_index_buffer->reallocate(m_indices->data(), (unsigned int)m_indices->size(), vertex_capacity + 1, vertex_capacity - 1);
+		rebase_index_buffers();
+	}
+	else
 	{
-		center.x += (*m_no_transform_vertex_positions)[i];
-		center.y += (*m_no_transform_vertex_positions)[i+1];
-		center.z += (*m_no_transform_vertex_positions)[i+2];
+		constexpr unsigned int vertex_size = NUM_COORDINATES * sizeof(float);
+		m_vertex_buffer->update(&positions[0], 0, vertex_size);
+		m_vertex_buffer->update(&positions[new_vertex_index * NUM_COORDINATES], new_vertex_index * vertex_size, vertex_size);
+		m_index_buffer->update(&(*m_indices)[m_indices->size() - 2], (unsigned int)m_indices->size() - 2, 2);
 	}
-	center /= (float)num_vertices() - 1;
 
-	// Move the vertices towards the new center
-	for (unsigned int i = NUM_COORDINATES; i < num_vertices() * NUM_COORDINATES; i++)
+	return centroid - old_centroid;
+}
+
+/// <summary>
+/// Ear clips the corners of the polygon, in the raw space. The model transform is affine,
+/// so the same triangles stay valid in the world space and only geometry changes rebuild them.
+/// </summary>
+void Shape::update_triangulation()
+{
+	const std::vector<float>& positions = *m_no_transform_vertex_positions;
+	unsigned int num_corners = num_vertices() - 1;
+	std::vector<float> xs(num_corners), ys(num_corners);
+	for (unsigned int i = 0; i < num_corners; i++)
 	{
-		(*m_no_transform_vertex_positions)[i] = ((*m_no_transform_vertex_positions)[i] - center[i % 3]);
+		xs[i] = positions[(i + 1) * NUM_COORDINATES];
+		ys[i] = positions[(i + 1) * NUM_COORDINATES + 1];
 	}
+	if (!Triangulation::ear_clip(xs.data(), ys.data(), num_corners, m_triangle_indices)
+		&& !m_self_intersection_reported)
+	{
+		std::cout << "Warning, polygon with " << num_corners << " corners intersects itself, it may not be filled correctly" << std::endl;
+		m_self_intersection_reported = true;
+	}
+	m_triangulation_revision = m_revision;
+	m_triangulation_valid = true;
+	m_triangle_index_buffer_valid = false;
+}
 
-	// Recreate the vertex buffer & array
-	m_vertex_array = new VertexArray;
-	m_vertex_buffer = new VertexBuffer(m_no_transform_vertex_positions->data()
-		, (uint16_t)m_no_transform_vertex_positions->size() * sizeof(float));
-	m_vertex_array->add_buffer(*m_vertex_buffer, *s_basic_layout);
-	(*m_indices)[m_indices->size()-1] = num_vertices()-1;
-	m_indices->emplace_back(1);
-	m_index_buffer = new IndexBuffer(m_indices->data(), (uint16_t)m_indices->size());
+/// <summary>
+/// Triangle list of the polygon as indices into its corners, i.e. excluding the fan center
+/// </summary>
+const std::vector<unsigned int>& Shape::polygon_triangles()
+{
+	ASSERT(m_indices != nullptr);
+	if (!m_triangulation_valid || m_triangulation_revision != m_revision)
+	{
+		update_triangulation();
+	}
+	return m_triangle_indices;
+}
 
-	// Return the new center as the position of the model
-	return center + old_center;
+/// <summary>
+/// GL_TRIANGLES index buffer of the polygon, over the vertex array of the shape
+/// </summary>
+const IndexBuffer* Shape::polygon_triangle_index_buffer()
+{
+	const std::vector<unsigned int>& triangles = polygon_triangles();
+	if (!m_triangle_index_buffer_valid)
+	{
+		std::vector<unsigned int> shifted(triangles.size());
+		for (size_t i = 0; i < triangles.size(); i++)
+		{
+			shifted[i] = triangles[i] + 1;
+		}
+		if (m_triangle_index_buffer == nullptr)
+		{
+			m_triangle_index_buffer = new IndexBuffer(*s_basic_arena, (int)m_vertex_buffer->first_vertex());
+		}
+		// The index type was picked for the vertex capacity at the last reallocation
+		if (shifted.size() > m_triangle_index_buffer->capacity() || !m_triangle_index_buffer->holds(num_vertices() - 1))
+		{
+			unsigned int vertex_capacity = polygon_capacity_for(num_vertices());
+			m_triangle_index_buffer->reallocate(shifted.data(), (unsigned int)shifted.size(), 3 * vertex_capacity, vertex_capacity - 1);
+		}
+		else
+		{
+			m_triangle_index_buffer->update(shifted.data(), 0, (unsigned int)shifted.size());
+		}
+		m_triangle_index_buffer_valid = true;
+	}
+	return m_triangle_index_buffer;
 }
 
-std::vector<float> Shape::vertices()
+/// <summary>
+/// The indices of a shape are relative to its vertex range in the arena,
+/// so they follow the range when it moves
+/// </summary>
+void Shape::rebase_index_buffers()
 {
-	return std::vector<float>(*m_no_transform_vertex_positions);
+	int base_vertex = (int)m_vertex_buffer->first_vertex();
+	m_index_buffer->set_base_vertex(base_vertex);
+	if (m_triangle_index_buffer)
+	{
+		m_triangle_index_buffer->set_base_vertex(base_vertex);
+	}
+	for (auto& [zoom_key, lod] : m_lods)
+	{
+		if (lod->fill_index_buffer)
+		{
+			lod->fill_index_buffer->set_base_vertex(base_vertex);
+			lod->outline_index_buffer->set_base_vertex(base_vertex);
+		}
+	}
 }
 
+void Shape::clear_polygon_lods()
+{
+	for (auto& [zoom_key, lod] : m_lods)
+	{
+		delete lod->fill_index_buffer;
+		delete lod->outline_index_buffer;
+		delete lod;
+	}
+	m_lods.clear();
+}
 
-void Shape::init_static_members()
+/// <summary>
+/// Douglas-Peucker simplification of the polygon, cached per zoom level.
+/// A cached level is rebuilt if the geometry or the requested tolerance changed,
+/// the least recently used level is evicted when the cache is full.
+/// </summary>
+/// <param name="zoom_key">zoom level the simplification is used for</param>
+/// <param name="tolerance">in the raw space of the shape</param>
+/// <returns></returns>
+Shape::PolygonLod& Shape::polygon_lod(int zoom_key, float tolerance)
 {
-	// Layout for basic shader
-	s_basic_layout = new VertexBufferLayout();
-	s_basic_layout->push_back_elements<float>(NUM_COORDINATES);
+	ASSERT(m_indices != nullptr && m_vertex_array != nullptr);
+	if (m_lods_revision != m_revision)
+	{
+		clear_polygon_lods();
+		m_lods_revision = m_revision;
+	}
+	if (m_lods.size() >= s_max_polygon_lods && m_lods.find(zoom_key) == m_lods.end())
+	{
+		auto oldest = m_lods.begin();
+		for (auto it = m_lods.begin(); it != m_lods.end(); it++)
+		{
+			if (it->second->last_use < oldest->second->last_use)
+			{
+				oldest = it;
+			}
+		}
+		delete oldest->second->fill_index_buffer;
+		delete oldest->second->outline_index_buffer;
+		delete oldest->second;
+		m_lods.erase(oldest);
+	}
+	PolygonLod*& lod = m_lods[zoom_key];
+	if (lod == nullptr)
+	{
+		lod = new PolygonLod{ tolerance, {}, {}, nullptr, nullptr, 0 };
+	}
+	else if (lod->tolerance == tolerance)
+	{
+		lod->last_use = ++m_lods_clock;
+		return *lod;
+	}
+	lod->tolerance = tolerance;
+	lod->last_use = ++m_lods_clock;
 
-	// Basic shader
-	s_basic_shader = new Shader("../../Engine/Shaders/triangle.glsl");
+	const std::vector<float>& positions = *m_no_transform_vertex_positions;
+	unsigned int num_corners = num_vertices() - 1;
+	std::vector<float> xs(num_corners), ys(num_corners);
+	for (unsigned int i = 0; i < num_corners; i++)
+	{
+		xs[i] = positions[(i + 1) * NUM_COORDINATES];
+		ys[i] = positions[(i + 1) * NUM_COORDINATES + 1];
+	}
+	Simplification::douglas_peucker_closed(xs.data(), ys.data(), num_corners, tolerance, lod->corners);
 
-	// Layout for textured and smooth shaded shader
-	s_textured_layout = new VertexBufferLayout();
-	s_textured_layout->push_back_elements<float>(NUM_COORDINATES);
-	s_textured_layout->push_back_elements<float>(NUM_TEXTURE_COORDINATES);
-	// Vertex normals for optional lighting - complete opaque object will still display the albedo color
-	s_textured_layout->push_back_elements<float>(NUM_COORDINATES); 
+	std::vector<float> kept_xs, kept_ys;
+	kept_xs.reserve(lod->corners.size());
+	kept_ys.reserve(lod->corners.size());
+	for (unsigned int corner : lod->corners)
+	{
+		kept_xs.push_back(xs[corner]);
+		kept_ys.push_back(ys[corner]);
+	}
+	Triangulation::ear_clip(kept_xs.data(), kept_ys.data(), (unsigned int)lod->corners.size(), lod->triangles);
+
+	// Outdated GPU copies are rebuilt on the next upload
+	delete lod->fill_index_buffer;
+	delete lod->outline_index_buffer;
+	lod->fill_index_buffer = nullptr;
+	lod->outline_index_buffer = nullptr;
+	return *lod;
+}
 
-	// Textured Shader
-	s_textured_shader = new Shader("../../Engine/Shaders/textured_shaded_triangle.glsl");
+/// <summary>
+/// Creates the index buffers of the level, if they do not exist yet
+/// </summary>
+/// <param name="lod"></param>
+void Shape::upload_polygon_lod(PolygonLod& lod)
+{
+	if (lod.fill_index_buffer != nullptr)
+	{
+		return;
+	}
+	// The fan center is the 0th vertex, corners start from 1
+	std::vector<unsigned int> fill, outline;
+	fill.reserve(lod.triangles.size());
+	for (unsigned int index : lod.triangles)
+	{
+		fill.push_back(lod.corners[index] + 1);
+	}
+	outline.reserve(lod.corners.size());
+	for (unsigned int corner : lod.corners)
+	{
+		outline.push_back(corner + 1);
+	}
+	int base_vertex = (int)m_vertex_buffer->first_vertex();
+	lod.fill_index_buffer = new IndexBuffer(*s_basic_arena, base_vertex);
+	lod.fill_index_buffer->set_data(fill.data(), (unsigned int)fill.size());
+	lod.outline_index_buffer = new IndexBuffer(*s_basic_arena, base_vertex);
+	lod.outline_index_buffer->set_data(outline.data(), (unsigned int)outline.size());
+}
 
-	// Colored Shader
-	s_colored_shader = new Shader("../../Engine/Shaders/colored_triangle.glsl");
+/// <summary>
+/// GPU copy of the colored cube for VertexFormat::Packed: 4 half floats for the position,
+/// w = 1 keeps the rows 4 byte aligned, and 4 unorm8 for the color. 12 bytes instead of 28.
+/// </summary>
+static std::vector<uint8_t> pack_colored_cube(const std::vector<float>& vertices)
+{
+	const unsigned int floats_per_vertex = NUM_COORDINATES + NUM_RGBA;
+	const unsigned int num_vertices = (unsigned int)vertices.size() / floats_per_vertex;
+	std::vector<uint8_t> packed;
+	packed.reserve((size_t)num_vertices * (4 * sizeof(HalfFloat) + NUM_RGBA));
+	for (unsigned int i = 0; i < num_vertices; i++)
+	{
+		const float* vertex = vertices.data() + (size_t)i * floats_per_vertex;
+		HalfFloat position[4] = { VertexPacking::half(vertex[0]), VertexPacking::half(vertex[1]),
+			VertexPacking::half(vertex[2]), VertexPacking::half(1.0f) };
+		uint8_t color[NUM_RGBA] = { VertexPacking::unorm8(vertex[3]), VertexPacking::unorm8(vertex[4]),
+			VertexPacking::unorm8(vertex[5]), VertexPacking::unorm8(vertex[6]) };
+		packed.insert(packed.end(), (const uint8_t*)position, (const uint8_t*)position + sizeof(position));
+		packed.insert(packed.end(), color, color + sizeof(color));
+	}
+	return packed;
+}
 
-	// Colored layout
-	s_colored_layout = new VertexBufferLayout();
-	s_colored_layout->push_back_elements<float>(NUM_COORDINATES);
-	s_colored_layout->push_back_elements<float>(NUM_RGBA);
+/// <summary>
+/// GPU copy of the textured cube for VertexFormat::Packed: 4 half floats for the position,
+/// 2 unorm16 for the uvs and a 10-10-10-2 normal. 16 bytes instead of 32.
+/// </summary>
+static std::vector<uint8_t> pack_textured_cube(const std::vector<float>& vertices)
+{
+	const unsigned int floats_per_vertex = NUM_COORDINATES + NUM_TEXTURE_COORDINATES + NUM_COORDINATES;
+	const unsigned int num_vertices = (unsigned int)vertices.size() / floats_per_vertex;
+	std::vector<uint8_t> packed;
+	packed.reserve((size_t)num_vertices * (4 * sizeof(HalfFloat) + NUM_TEXTURE_COORDINATES * sizeof(uint16_t) + sizeof(PackedNormal)));
+	for (unsigned int i = 0; i < num_vertices; i++)
+	{
+		const float* vertex = vertices.data() + (size_t)i * floats_per_vertex;
+		HalfFloat position[4] = { VertexPacking::half(vertex[0]), VertexPacking::half(vertex[1]),
+			VertexPacking::half(vertex[2]), VertexPacking::half(1.0f) };
+		uint16_t uv[NUM_TEXTURE_COORDINATES] = { VertexPacking::unorm16(vertex[3]), VertexPacking::unorm16(vertex[4]) };
+		PackedNormal normal = VertexPacking::snorm_10_10_10_2(vertex[5], vertex[6], vertex[7]);
+		packed.insert(packed.end(), (const uint8_t*)position, (const uint8_t*)position + sizeof(position));
+		packed.insert(packed.end(), (const uint8_t*)uv, (const uint8_t*)uv + sizeof(uv));
+		packed.insert(packed.end(), (const uint8_t*)&normal, (const uint8_t*)&normal + sizeof(normal));
+	}
+	return packed;
+}
+
+void Shape::init_static_members(VertexFormat cube_format, bool gpu)
+{
+	s_cube_format = cube_format;
 
 	float unit = 1.0f;
 	float unit_half = 0.5f;
@@ -203,7 +526,7 @@ void Shape::init_static_members()
 		22, 20, 23
 		});
 
-	// Create VAO, VBO & IBO for a rectangle
+	// Vertices of a rectangle
 	constexpr unsigned int rect_num_vertices = 4;
 	auto* rectangle_positions = new std::vector<float>;
 	rectangle_positions->reserve(rect_num_vertices * NUM_COORDINATES);
@@ -214,13 +537,7 @@ void Shape::init_static_members()
 		0.0f, unit, global_z_pos_2d, // 3
 	});
 
-	auto* rect_va = new VertexArray;
-	auto* rect_vb = new VertexBuffer(rectangle_positions->data(),
-		(uint16_t)rectangle_positions->size() * sizeof(float));
-	rect_va->add_buffer(*rect_vb, *s_basic_layout);
-	auto* rect_ib = new IndexBuffer(quad_indices->data(), num_indices);
-
-	// Create VAO, VBO & IBO for an equilateral triangle
+	// Vertices of an equilateral triangle
 	constexpr unsigned int tri_num_vertices = 3;
 	auto* equilateral_triangle_positions = new std::vector<float>;
 	equilateral_triangle_positions->reserve(tri_num_vertices * NUM_COORDINATES);
@@ -230,13 +547,7 @@ void Shape::init_static_members()
 		unit,		sqrtf(3)* unit / 2.0f,		global_z_pos_2d	 // 2
 	});
 
-	auto* eq_tri_va = new VertexArray;
-	auto* eq_tri_vb = new VertexBuffer(equilateral_triangle_positions->data(),
-		(uint16_t)equilateral_triangle_positions->size() * sizeof(float));
-	eq_tri_va->add_buffer(*eq_tri_vb, *s_basic_layout);
-	auto* eq_tri_ib = new IndexBuffer(tri_indices->data(), num_indices / 2);
-
-	// Create VAO, VBO & IBO for a colored cube
+	// Vertices of a colored cube
 	auto* col_cube_positions = new std::vector<float>;
 	col_cube_positions->reserve(num_cube_vertices * (NUM_COORDINATES + NUM_RGBA));
 
@@ -279,12 +590,7 @@ void Shape::init_static_members()
 		unit_half,	-unit_half,	-unit_half,		0.5f, 0.5f, 1.0f,	1.0f,
 		});
 
-	auto* col_cube_va = new VertexArray;
-	auto* col_cube_vb = new VertexBuffer(col_cube_positions->data(),
-		(uint16_t)col_cube_positions->size() * sizeof(float));
-	col_cube_va->add_buffer(*col_cube_vb, *s_colored_layout);
-
-	// Create VAO, VBO & IBO for a textured cube
+	// Vertices of a textured cube
 	auto* tex_cube_positions = new std::vector<float>;
 	tex_cube_positions->reserve(num_cube_vertices* (NUM_COORDINATES + NUM_TEXTURE_COORDINATES + NUM_COORDINATES));
 
@@ -327,57 +633,151 @@ void Shape::init_static_members()
 		unit_half,	-unit_half,	-unit_half,		0.0f, 1.0f,		0.0f,	-1.0f,	0.0f,
 		});
 
-	auto* tex_cube_va = new VertexArray;
-	auto* tex_cube_vb = new VertexBuffer(tex_cube_positions->data(),
-		(uint16_t)tex_cube_positions->size() * sizeof(float));
-	tex_cube_va->add_buffer(*tex_cube_vb, *s_textured_layout);
-	
-	// One IBO for both unit cubes
-	auto* cube_ib = new IndexBuffer(cube_indices->data(), (uint16_t)cube_indices->size());
-
-	// Init static unit square
+	// Init the CPU copies of the static shapes
 	s_unit_square->m_no_transform_vertex_positions = rectangle_positions;
 	s_unit_square->m_indices = quad_indices;
-	s_unit_square->m_vertex_array = rect_va;
+	s_unit_eq_triangle->m_no_transform_vertex_positions = equilateral_triangle_positions;
+	s_unit_eq_triangle->m_indices = tri_indices;
+	s_colored_unit_cube->m_no_transform_vertex_positions = col_cube_positions;
+	s_colored_unit_cube->m_vertex_stride = NUM_COORDINATES + NUM_RGBA;
+	s_textured_unit_cube->m_no_transform_vertex_positions = tex_cube_positions;
+	s_textured_unit_cube->m_vertex_stride = NUM_COORDINATES + NUM_TEXTURE_COORDINATES + NUM_COORDINATES;
+	// Same indices for both cubes
+	s_textured_unit_cube->m_indices = s_colored_unit_cube->m_indices = cube_indices;
+	if (!gpu)
+	{
+		return;
+	}
+
+	// Layout for basic shader
+	s_basic_layout = new VertexBufferLayout();
+	s_basic_layout->push_back_elements<float>(NUM_COORDINATES);
+
+	// Basic shader
+	s_basic_shader = new Shader("../../Engine/Shaders/triangle.glsl");
+
+	// Layout for textured and smooth shaded shader
+	s_textured_layout = new VertexBufferLayout();
+	s_textured_layout->push_back_elements<float>(NUM_COORDINATES);
+	s_textured_layout->push_back_elements<float>(NUM_TEXTURE_COORDINATES);
+	// Vertex normals for optional lighting - complete opaque object will still display the albedo color
+	s_textured_layout->push_back_elements<float>(NUM_COORDINATES); 
+
+	// Textured Shader
+	s_textured_shader = new Shader("../../Engine/Shaders/textured_shaded_triangle.glsl");
+	// The material is the same for all the textured shapes, uniforms keep their values in the program
+	s_textured_shader->set_uniform_4f("u_ambient", 0.32f, 0.173f, 0.118f, 1.0f);
+	s_textured_shader->set_uniform_4f("u_diffuse", 0.75f, 0.5f, 0.0f, 1.0f);
+	s_textured_shader->set_uniform_4f("u_specular", 1.0f, 1.0f, 1.0f, 1.0f);
+	s_textured_shader->set_uniform_1f("u_shininess", 50.0f);
+
+	// Colored Shader
+	s_colored_shader = new Shader("../../Engine/Shaders/colored_triangle.glsl");
+
+	// Colored layout
+	s_colored_layout = new VertexBufferLayout();
+	s_colored_layout->push_back_elements<float>(NUM_COORDINATES);
+	s_colored_layout->push_back_elements<float>(NUM_RGBA);
+
+	// Packed cube layouts, same attributes as above
+	s_packed_textured_layout = new VertexBufferLayout();
+	s_packed_textured_layout->push_back_elements<HalfFloat>(4);
+	s_packed_textured_layout->push_back_elements<unsigned short>(NUM_TEXTURE_COORDINATES);
+	s_packed_textured_layout->push_back_elements<PackedNormal>(1);
+	s_packed_colored_layout = new VertexBufferLayout();
+	s_packed_colored_layout->push_back_elements<HalfFloat>(4);
+	s_packed_colored_layout->push_back_elements<unsigned char>(NUM_RGBA);
+
+	// The shaders and the layouts are edited separately, report a mismatch at startup
+	s_basic_shader->check_layout(*s_basic_layout);
+	s_textured_shader->check_layout(*s_textured_layout);
+	s_colored_shader->check_layout(*s_colored_layout);
+	s_textured_shader->check_layout(*s_packed_textured_layout);
+	s_colored_shader->check_layout(*s_packed_colored_layout);
+
+	// Instanced shaders & the per-instance layout
+	s_instanced_basic_shader = new Shader("../../Engine/Shaders/instanced_triangle.glsl");
+	s_instanced_colored_shader = new Shader("../../Engine/Shaders/instanced_colored_triangle.glsl");
+	s_instanced_textured_shader = new Shader("../../Engine/Shaders/instanced_textured_shaded_triangle.glsl");
+	s_instance_layout = new VertexBufferLayout();
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		// mat4 attributes take one location per column
+		s_instance_layout->push_back_elements<float>(4);
+	}
+	s_instance_layout->push_back_elements<float>(NUM_RGBA);
+	s_instance_layout->push_back_elements<float>(1);
+
+	// Room for a few thousand small polygons before the first growth, the cubes only need their own vertices
+	s_basic_arena = new GeometryArena(*s_basic_layout, 1 << 16, 1 << 17);
+	s_textured_arena = new GeometryArena(textured_cube_layout(), 64, 64);
+	s_colored_arena = new GeometryArena(colored_cube_layout(), 64, 64);
+
+	// Create the VBO & IBO ranges for a rectangle
+	auto* rect_vb = new VertexBuffer(*s_basic_arena);
+	rect_vb->set_data(rectangle_positions->data(), (unsigned int)(rectangle_positions->size() * sizeof(float)));
+	auto* rect_ib = new IndexBuffer(*s_basic_arena, (int)rect_vb->first_vertex());
+	rect_ib->set_data(quad_indices->data(), num_indices);
+
+	// Create the VBO & IBO ranges for an equilateral triangle
+	auto* eq_tri_vb = new VertexBuffer(*s_basic_arena);
+	eq_tri_vb->set_data(equilateral_triangle_positions->data(),
+		(unsigned int)(equilateral_triangle_positions->size() * sizeof(float)));
+	auto* eq_tri_ib = new IndexBuffer(*s_basic_arena, (int)eq_tri_vb->first_vertex());
+	eq_tri_ib->set_data(tri_indices->data(), num_indices / 2);
+
+	// Create the VBO & IBO ranges for a colored cube
+	auto* col_cube_vb = new VertexBuffer(*s_colored_arena);
+	if (cube_format == VertexFormat::Packed)
+	{
+		std::vector<uint8_t> packed = pack_colored_cube(*col_cube_positions);
+		col_cube_vb->set_data(packed.data(), (unsigned int)packed.size());
+	}
+	else
+	{
+		col_cube_vb->set_data(col_cube_positions->data(), (unsigned int)(col_cube_positions->size() * sizeof(float)));
+	}
+	auto* col_cube_ib = new IndexBuffer(*s_colored_arena, (int)col_cube_vb->first_vertex());
+	col_cube_ib->set_data(cube_indices->data(), (unsigned int)cube_indices->size());
+
+	// Create the VBO & IBO ranges for a textured cube
+	auto* tex_cube_vb = new VertexBuffer(*s_textured_arena);
+	if (cube_format == VertexFormat::Packed)
+	{
+		std::vector<uint8_t> packed = pack_textured_cube(*tex_cube_positions);
+		tex_cube_vb->set_data(packed.data(), (unsigned int)packed.size());
+	}
+	else
+	{
+		tex_cube_vb->set_data(tex_cube_positions->data(), (unsigned int)(tex_cube_positions->size() * sizeof(float)));
+	}
+	auto* tex_cube_ib = new IndexBuffer(*s_textured_arena, (int)tex_cube_vb->first_vertex());
+	tex_cube_ib->set_data(cube_indices->data(), (unsigned int)cube_indices->size());
+
+	// Init static unit square
+	s_unit_square->m_vertex_array = s_basic_arena->vertex_array();
 	s_unit_square->m_vertex_buffer = rect_vb;
 	s_unit_square->m_index_buffer = rect_ib;
 
 	// Init static unit triangle
-	s_unit_eq_triangle->m_no_transform_vertex_positions = equilateral_triangle_positions;
-	s_unit_eq_triangle->m_indices = tri_indices;
-	s_unit_eq_triangle->m_vertex_array = eq_tri_va;
+	s_unit_eq_triangle->m_vertex_array = s_basic_arena->vertex_array();
 	s_unit_eq_triangle->m_vertex_buffer = eq_tri_vb;
 	s_unit_eq_triangle->m_index_buffer = eq_tri_ib;
 
 	// Init static colored unit cube
-	s_colored_unit_cube->m_no_transform_vertex_positions = col_cube_positions;
-	s_colored_unit_cube->m_vertex_array = col_cube_va;
+	s_colored_unit_cube->m_vertex_array = s_colored_arena->vertex_array();
 	s_colored_unit_cube->m_vertex_buffer = col_cube_vb;
+	s_colored_unit_cube->m_index_buffer = col_cube_ib;
 	
 	// Init static textured unit cube
-	s_textured_unit_cube->m_no_transform_vertex_positions = tex_cube_positions;
-	s_textured_unit_cube->m_indices = cube_indices;
-	s_textured_unit_cube->m_vertex_array = tex_cube_va;
+	s_textured_unit_cube->m_vertex_array = s_textured_arena->vertex_array();
 	s_textured_unit_cube->m_vertex_buffer = tex_cube_vb;
+	s_textured_unit_cube->m_index_buffer = tex_cube_ib;
 
-	// Same IBO & indices for both cubes
-	s_textured_unit_cube->m_indices = s_colored_unit_cube->m_indices = cube_indices;
-	s_textured_unit_cube->m_index_buffer = s_colored_unit_cube->m_index_buffer = cube_ib;
-
-	rect_va->unbind();
-	rect_vb->unbind();
-	rect_ib->unbind();
-	eq_tri_va->unbind();
-	eq_tri_vb->unbind();
-	eq_tri_ib->unbind();
-	col_cube_va->unbind();
-	col_cube_vb->unbind();
-	tex_cube_va->unbind();
-	tex_cube_vb->unbind();
-	cube_ib->unbind();
 	s_basic_shader->unbind();
 	s_textured_shader->unbind();
 	s_colored_shader->unbind();
+	s_instanced_textured_shader->unbind();
 }
 
 void Shape::destroy_static_members_allocated_on_the_heap()
@@ -386,11 +786,22 @@ void Shape::destroy_static_members_allocated_on_the_heap()
 	delete s_unit_square;
 	delete s_colored_unit_cube;
 	s_textured_unit_cube->m_indices = nullptr;
-	s_textured_unit_cube->m_index_buffer = nullptr;
 	delete s_textured_unit_cube;
 
+	// After the shapes, which return their ranges
+	delete s_basic_arena;
+	delete s_textured_arena;
+	delete s_colored_arena;
+
 	delete s_textured_layout;
+	delete s_packed_textured_layout;
+	delete s_packed_colored_layout;
 	delete s_basic_layout;
 	delete s_basic_shader;
 	delete s_textured_shader;
+	delete s_instance_layout;
+	delete s_instanced_basic_shader;
+	delete s_instanced_colored_shader;
+	delete s_instanced_textured_shader;
+	FrameUniforms::destroy();
 }
@@ -0,0 +1,200 @@
+#include "EntityManager/ShapeInstancer.h"
+#include "Renderer/Renderer.h"
+#include "Core/ErrorManager.h"
+
+ShapeInstancer::ShapeInstancer()
+	: m_pending_def(ShapeModel::StaticShape::NONE),
+	m_pending_batch(nullptr),
+	m_pending_texture(nullptr),
+	m_pending_texture_slot(-1),
+	m_pending_has_selection(false),
+	m_num_draw_calls(0)
+{
+	const Shape* unit_square = Shape::unit_square();
+	const Shape* unit_eq_triangle = Shape::unit_eq_triangle();
+	const Shape* colored_unit_cube = Shape::colored_unit_cube();
+	const Shape* textured_unit_cube = Shape::textured_unit_cube();
+	m_rect_batch = new InstanceBatch(*unit_square->vertex_buffer(), Shape::basic_layout(),
+		*unit_square->index_buffer(), Shape::instance_layout(), FIRST_INSTANCE_ATTRIBUTE);
+	m_tri_batch = new InstanceBatch(*unit_eq_triangle->vertex_buffer(), Shape::basic_layout(),
+		*unit_eq_triangle->index_buffer(), Shape::instance_layout(), FIRST_INSTANCE_ATTRIBUTE);
+	m_col_cube_batch = new InstanceBatch(*colored_unit_cube->vertex_buffer(), Shape::colored_cube_layout(),
+		*colored_unit_cube->index_buffer(), Shape::instance_layout(), FIRST_INSTANCE_ATTRIBUTE);
+	m_tex_cube_batch = new InstanceBatch(*textured_unit_cube->vertex_buffer(), Shape::textured_cube_layout(),
+		*textured_unit_cube->index_buffer(), Shape::instance_layout(), FIRST_INSTANCE_ATTRIBUTE);
+}
+
+ShapeInstancer::~ShapeInstancer()
+{
+	delete m_rect_batch;
+	delete m_tri_batch;
+	delete m_col_cube_batch;
+	delete m_tex_cube_batch;
+}
+
+bool ShapeInstancer::is_instanceable(ShapeModel::StaticShape def)
+{
+	return def == ShapeModel::StaticShape::RECTANGLE
+		|| def == ShapeModel::StaticShape::ISOSCELES_TRIANGLE
+		|| def == ShapeModel::StaticShape::COL_CUBE
+		|| def == ShapeModel::StaticShape::TEX_CUBE;
+}
+
+InstanceBatch* ShapeInstancer::batch_of(ShapeModel::StaticShape def)
+{
+	switch (def)
+	{
+	case ShapeModel::StaticShape::RECTANGLE:
+		return m_rect_batch;
+	case ShapeModel::StaticShape::ISOSCELES_TRIANGLE:
+		return m_tri_batch;
+	case ShapeModel::StaticShape::COL_CUBE:
+		return m_col_cube_batch;
+	case ShapeModel::StaticShape::TEX_CUBE:
+		return m_tex_cube_batch;
+	default:
+		ASSERT(false && "Only the predefined unit shapes can be instanced!");
+		return nullptr;
+	}
+}
+
+void ShapeInstancer::begin(const Angel::mat4& proj, const Angel::mat4& view)
+{
+	m_proj = proj;
+	m_view = view;
+	m_num_draw_calls = 0;
+}
+
+void ShapeInstancer::submit(ShapeModel* s)
+{
+	submit(s, s->model_matrix(), s->is_selected());
+}
+
+/// <summary>
+/// Adds an instance of the unit shape of s, with the given model matrix
+/// </summary>
+/// <param name="s">provides the unit shape, color & texture</param>
+/// <param name="model_matrix"></param>
+/// <param name="selected"></param>
+void ShapeInstancer::submit(ShapeModel* s, const Angel::mat4& model_matrix, bool selected)
+{
+	ShapeModel::StaticShape def = s->shape_def();
+	if (def != m_pending_def
+		|| (def == ShapeModel::StaticShape::TEX_CUBE
+			&& (s->texture() != m_pending_texture || s->texture_slot() != m_pending_texture_slot)))
+	{
+		flush();
+		m_pending_def = def;
+		m_pending_batch = batch_of(def);
+		m_pending_texture = s->texture();
+		m_pending_texture_slot = s->texture_slot();
+	}
+
+	Instance instance;
+	for (unsigned int col = 0; col < 4; col++)
+	{
+		for (unsigned int row = 0; row < 4; row++)
+		{
+			instance.model[col * 4 + row] = model_matrix[row][col];
+		}
+	}
+	bool is_2d = def == ShapeModel::StaticShape::RECTANGLE || def == ShapeModel::StaticShape::ISOSCELES_TRIANGLE;
+	if (is_2d)
+	{
+		const Angel::vec4& color = s->color();
+		instance.color[0] = color.x;
+		instance.color[1] = color.y;
+		instance.color[2] = color.z;
+		instance.color[3] = color.w;
+	}
+	else
+	{
+		instance.color[0] = instance.color[1] = instance.color[2] = instance.color[3] = 1.0f;
+	}
+	instance.selected = selected ? 1.0f : 0.0f;
+	m_pending_batch->push_instance(&instance.model[0]);
+	m_pending_has_selection |= selected;
+
+	if (is_2d && selected)
+	{
+		// The outline must be drawn before the shapes that come after this one
+		flush();
+	}
+}
+
+/// <summary>
+/// Draws the pending instances
+/// </summary>
+void ShapeInstancer::flush()
+{
+	if (m_pending_batch == nullptr || m_pending_batch->num_instances() == 0)
+	{
+		return;
+	}
+	InstanceBatch* batch = m_pending_batch;
+	batch->upload();
+	Angel::mat4 view_proj = m_proj * m_view;
+	if (m_pending_def == ShapeModel::StaticShape::RECTANGLE
+		|| m_pending_def == ShapeModel::StaticShape::ISOSCELES_TRIANGLE)
+	{
+		Shader* shader = Shape::instanced_basic_shader();
+		shader->bind();
+		shader->set_uniform_mat4f("u_VP", view_proj);
+		shader->set_uniform_1i("u_outline_pass", 0);
+		Renderer::draw_triangles_instanced(batch->vertex_array(), batch->index_buffer(), shader, batch->num_instances());
+		m_num_draw_calls++;
+		if (m_pending_has_selection)
+		{
+			shader->set_uniform_1i("u_outline_pass", 1);
+			if (m_pending_def == ShapeModel::StaticShape::RECTANGLE)
+			{
+				Renderer::draw_lines_instanced(batch->vertex_array(), batch->index_buffer(), shader, batch->num_instances());
+			}
+			else
+			{
+				Renderer::draw_lines_instanced(batch->vertex_array(), batch->index_buffer(), shader, batch->num_instances(), 3);
+			}
+			m_num_draw_calls++;
+		}
+	}
+	else if (m_pending_def == ShapeModel::StaticShape::COL_CUBE)
+	{
+		Shader* shader = Shape::instanced_colored_shader();
+		shader->bind();
+		shader->set_uniform_mat4f("u_VP", view_proj);
+		Renderer::draw_triangles_instanced(batch->vertex_array(), batch->index_buffer(), shader, batch->num_instances());
+		m_num_draw_calls++;
+	}
+	else
+	{
+		Shader* shader = Shape::instanced_textured_shader();
+		m_pending_texture->bind(m_pending_texture_slot);
+		shader->bind();
+		shader->set_uniform_1i("u_texture", m_pending_texture_slot);
+		shader->set_uniform_mat4f("u_V", m_view);
+		shader->set_uniform_mat4f("u_P", m_proj);
+		Angel::vec4 light_source_pos = m_view * Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f);
+		shader->set_uniform_4f("u_light_position",
+			light_source_pos.x,
+			light_source_pos.y,
+			light_source_pos.z,
+			light_source_pos.w);
+		shader->set_uniform_4f("u_ambient", 0.32f, 0.173f, 0.118f, 1.0f);
+		shader->set_uniform_4f("u_diffuse", 0.75f, 0.5f, 0.0f, 1.0f);
+		shader->set_uniform_4f("u_specular", 1.0f, 1.0f, 1.0f, 1.0f);
+		shader->set_uniform_1f("u_shininess", 50.0f);
+		Renderer::draw_triangles_instanced(batch->vertex_array(), batch->index_buffer(), shader, batch->num_instances());
+		m_num_draw_calls++;
+	}
+	batch->clear();
+	m_pending_has_selection = false;
+}
+
+void ShapeInstancer::end()
+{
+	flush();
+	m_pending_def = ShapeModel::StaticShape::NONE;
+	m_pending_batch = nullptr;
+	m_pending_texture = nullptr;
+	m_pending_texture_slot = -1;
+}
@@ -1,16 +1,26 @@
 #include "EntityManager/ShapeModel.h"
 #include "Core/ErrorManager.h"
-#include "Renderer/Renderer.h"
+#include "Core/PointInPolygon.h"
+#include "Core/Transform.h"
+#include "Renderer/SoftwareRasterizer.h"
 #include <glew.h>
+#include <algorithm>
+#include <cmath>
+
+// Per-draw uniforms, resolved to handles once
+static const ShaderUniform<Angel::mat4> s_mvp_uniform("u_MVP");
+static const ShaderUniform<Angel::mat4> s_model_uniform("u_model");
+static const ShaderUniform<Angel::vec4> s_color_uniform("u_color");
+static const ShaderUniform<int> s_texture_uniform("u_texture");
+static const ShaderUniform<int> s_selected_uniform("u_selected");
 
 ShapeModel::ShapeModel(StaticShape def,
-	Angel::vec3* pos,
-	Angel::vec3* rot,
-	Angel::vec3* scale,
-	Angel::vec4* rgba)
+	const Angel::vec3& pos,
+	const Angel::vec3& rot,
+	const Angel::vec3& scale,
+	const Angel::vec4& rgba)
 {
 	m_shape_def = nullptr;
-	m_color = nullptr;
 	switch (def)
 	{
 	case ShapeModel::StaticShape::RECTANGLE:
@@ -27,49 +37,42 @@ ShapeModel::ShapeModel(StaticShape def,
 		break;
 	}
 	m_is_poly = false;
-	m_position = pos;
-	m_rotation = rot;
-	m_scale = scale;
-	if (def != ShapeModel::StaticShape::COL_CUBE)
-	{
-		m_color = rgba;
-	}
+	m_entity = ComponentStore::get_instance().create(pos, rot, scale, rgba);
 	m_e_def = def;
 	m_is_hidden = false;
 }
 
 ShapeModel::ShapeModel(const std::vector<Angel::vec3>& poly_mouse_model_coords,
-	Angel::vec4* rgba)
+	const Angel::vec4& rgba)
 {
 	m_is_poly = true;
 	m_is_hidden = false;
 
-	m_position = new Angel::vec3(0.0f, 0.0f, 0.0f);
-	m_rotation = new Angel::vec3(0.0f, 0.0f, 0.0f);
-	m_scale = new Angel::vec3(1.0f, 1.0f, 1.0f);
-
+	Angel::vec3 position(0.0f, 0.0f, 0.0f);
 	for (unsigned int i = 0; i < poly_mouse_model_coords.size(); i++)
 	{
-		*m_position += poly_mouse_model_coords[i];
+		position += poly_mouse_model_coords[i];
 	}
-	*m_position /= (float)poly_mouse_model_coords.size();
-
+	position /= (float)poly_mouse_model_coords.size();
 
 	std::vector<Angel::vec3> poly_mouse_model_coords_minus_center;
 	poly_mouse_model_coords_minus_center.reserve(poly_mouse_model_coords.size());
 	for (unsigned int i = 0; i < poly_mouse_model_coords.size(); i++)
 	{
-		poly_mouse_model_coords_minus_center.emplace_back(poly_mouse_model_coords[i] - (*m_position));
+		poly_mouse_model_coords_minus_center.emplace_back(poly_mouse_model_coords[i] - position);
 	}
 	m_shape_def = new Shape(poly_mouse_model_coords_minus_center);
-	m_color = rgba;
+	m_entity = ComponentStore::get_instance().create(position,
+		Angel::vec3(0.0f, 0.0f, 0.0f),
+		Angel::vec3(1.0f, 1.0f, 1.0f),
+		rgba);
 	m_e_def = StaticShape::NONE;
 }
 
 ShapeModel::ShapeModel(StaticShape def, 
-	Angel::vec3* pos, 
-	Angel::vec3* rot, 
-	Angel::vec3* scale, 
+	const Angel::vec3* pos, 
+	const Angel::vec3* rot, 
+	const Angel::vec3* scale, 
 	int texture_slot,
 	Texture* texture)
 {
@@ -78,9 +81,13 @@ ShapeModel::ShapeModel(StaticShape def,
 	m_shape_def = const_cast<Shape*>(Shape::textured_unit_cube());
 	m_texture = texture;
 	m_is_poly = false;
-	m_position = pos;
-	m_rotation = rot;
-	m_scale = scale;
+	// Cubes of the articulated models only have a scale, their nodes place them
+	m_scale_only = (pos == nullptr && rot == nullptr);
+	m_entity = ComponentStore::get_instance().create(
+		(pos != nullptr) ? *pos : Angel::vec3(0.0f, 0.0f, 0.0f),
+		(rot != nullptr) ? *rot : Angel::vec3(0.0f, 0.0f, 0.0f),
+		(scale != nullptr) ? *scale : Angel::vec3(1.0f, 1.0f, 1.0f),
+		Angel::vec4(0.0f, 0.0f, 0.0f, 0.0f));
 	m_texture_slot = texture_slot;
 	m_e_def = def;
 	m_is_hidden = false;
@@ -92,116 +99,29 @@ ShapeModel::~ShapeModel()
 	{
 		delete m_shape_def;
 	}
-	delete m_position;
-	delete m_rotation;
-	delete m_scale;
-	delete m_color;
+	ComponentStore::get_instance().destroy(m_entity);
 }
 
-// Polygon test function, taken from :
-// https://www.geeksforgeeks.org/how-to-check-if-a-given-point-lies-inside-a-polygon
-// The code was changed in the following way:
-//  - Functions were converted into lambdas
-//  - Since the point inclusion in the code was for integers, it was converted to floats
-//  - The code in the link works for statically allocated arrays of Points, which is not compatible
-//       with the API. It was modified so that it works with the Angel::vec3 data type
-//  - Some of the names of the variables were changed so that code is cleaner
+/// <summary>
+/// Even-odd test of a world space point against the cached outline of the shape,
+/// see PointInPolygon for the kernel
+/// </summary>
 bool ShapeModel::contains_2d(const Angel::vec3& model_pos)
 {
-	struct Point {
-		float x, y;
-	};
-
-	struct line {
-		Point p1, p2;
-	};
-
-	auto on_line = [](line l1, Point p) -> bool
-	{
-		// Check whether p is on the line or not
-		if (p.x <= std::max(l1.p1.x, l1.p2.x)
-			&& p.x <= std::min(l1.p1.x, l1.p2.x)
-			&& (p.y <= std::max(l1.p1.y, l1.p2.y)
-				&& p.y <= std::min(l1.p1.y, l1.p2.y)))
-			return true;
-
-		return false;
-	};
-
-	auto direction = [](Point a, Point b, Point c) -> int
-	{
-		float val = (b.y - a.y) * (c.x - b.x)
-			- (b.x - a.x) * (c.y - b.y);
-		if (val == 0)
-			// Colinear
-			return 0;
-		else if (val < 0)
-			// Anti-clockwise direction
-			return 2;
-		// Clockwise direction
-		return 1;
-	};
-
-	auto is_intersect = [&, direction, on_line](line l1, line l2) -> bool
-	{
-		// Four direction for two lines and points of other line
-		int dir1 = direction(l1.p1, l1.p2, l2.p1);
-		int dir2 = direction(l1.p1, l1.p2, l2.p2);
-		int dir3 = direction(l2.p1, l2.p2, l1.p1);
-		int dir4 = direction(l2.p1, l2.p2, l1.p2);
-
-		// When intersecting
-		if (dir1 != dir2 && dir3 != dir4)
-			return true;
-
-		// When p2 of line2 are on the line1
-		if (dir1 == 0 && on_line(l1, l2.p1))
-			return true;
-
-		// When p1 of line2 are on the line1
-		if (dir2 == 0 && on_line(l1, l2.p2))
-			return true;
-
-		// When p2 of line1 are on the line2
-		if (dir3 == 0 && on_line(l2, l1.p1))
-			return true;
-
-		// When p1 of line1 are on the line2
-		if (dir4 == 0 && on_line(l2, l1.p2))
-			return true;
-
-		return false;
-	};
-
-	auto model_coordinates = model_coords();
-	unsigned int num_vertices = (uint16_t)model_coordinates.size();
-
-	// When polygon has less than 3 edge, it is not polygon
-	if (num_vertices < 3)
-		return false;
-	Point p = { model_pos.x, model_pos.y };
-	// Create a point at infinity, y is same as point p
-	line exline = { p, { (float)INT_MAX, p.y } };
-	int count = 0;
-	int i = 0;
-	do {
-
-		// Forming a line from two consecutive points of our shape
-		Point p1 = { model_coordinates[i].x, model_coordinates[i].y };
-		Point p2 = { model_coordinates[(i + 1) % num_vertices].x, model_coordinates[(i + 1) % num_vertices].y };
-		line side = { p1, p2 };
-		if (is_intersect(side, exline)) {
-
-			// If exline is on top of this side
-			if (direction(side.p1, p, side.p2) == 0)
-					return on_line(side, p);
-			count++;
-		}
-		i = (i + 1) % num_vertices;
-	} while (i != 0);
+	model_coords();
+	return PointInPolygon::contains(m_world_xs.data(), m_world_ys.data(),
+		(unsigned int)m_world_xs.size(), model_pos.x, model_pos.y);
+}
 
-	// When count is odd
-	return count & 1;
+/// <summary>
+/// True if any of the given world space points is inside the shape,
+/// the points are tested several at a time
+/// </summary>
+bool ShapeModel::contains_any_2d(const float* xs, const float* ys, unsigned int num_points)
+{
+	model_coords();
+	return PointInPolygon::contains_any(m_world_xs.data(), m_world_ys.data(),
+		(unsigned int)m_world_xs.size(), xs, ys, num_points);
 }
 
 unsigned int ShapeModel::true_num_vertices()
@@ -214,202 +134,214 @@ unsigned int ShapeModel::true_num_vertices()
 	return n_vert;
 }
 
-std::vector<Angel::vec3> ShapeModel::model_coords()
+/// <summary>
+/// Recomputes the centers of the untransformed vertices,
+/// only needed after the geometry of the shape was changed
+/// </summary>
+void ShapeModel::update_raw_cache()
 {
-	std::vector<float> raw_vertices = m_shape_def->vertices();
-
-	int stride = NUM_COORDINATES;
-	if (m_e_def == StaticShape::COL_CUBE)
+	if (m_e_def == StaticShape::NONE)
 	{
-		stride += NUM_RGBA;
+		// The fan center of polygons is their centroid
+		Angel::vec3 centroid = m_shape_def->polygon_centroid();
+		m_raw_center = centroid;
+		m_raw_center_bottom = Angel::vec3(centroid.x, -0.5f, centroid.z);	// TODO-GENERALIZE
+		m_raw_cache_revision = m_shape_def->revision();
+		m_raw_cache_valid = true;
+		return;
 	}
-	else if (m_e_def == StaticShape::TEX_CUBE)
+	VertexView positions = m_shape_def->positions();
+	Angel::vec3 center(0.0f, 0.0f, 0.0f);
+	for (unsigned int i = 0; i < positions.size(); i++)
 	{
-		stride += NUM_TEXTURE_COORDINATES + NUM_COORDINATES;
+		const float* p = positions[i];
+		center.x += p[0];
+		center.y += p[1];
+		center.z += p[2];
 	}
+	center /= (float)positions.size();
+	m_raw_center = center;
+	m_raw_center_bottom = Angel::vec3(center.x, -0.5f, center.z);	// TODO-GENERALIZE
+	m_raw_cache_revision = m_shape_def->revision();
+	m_raw_cache_valid = true;
+}
 
-
-	if (m_e_def == StaticShape::NONE)
-	{
-		// Exclude the first vertex, which is the precomputed mid point
-		raw_vertices.erase(raw_vertices.begin(), raw_vertices.begin() + stride);
+/// <summary>
+/// Transforms the vertices into the world space and recomputes the bounding cube.
+/// The transform used is remembered, so that the next call is only made after the
+/// position, rotation, scale or the geometry of the shape is changed.
+/// </summary>
+void ShapeModel::update_world_cache()
+{
+	VertexView positions = m_shape_def->positions();
+	// Exclude the first vertex of polygons, which is the precomputed mid point
+	unsigned int first = (m_e_def == StaticShape::NONE) ? 1 : 0;
+	unsigned int num_out = true_num_vertices();
+
+	const Angel::mat4& mat_model = model_matrix();
+	m_world_coords.clear();
+	m_world_coords.reserve(num_out);
+	m_world_xs.clear();
+	m_world_xs.reserve(num_out);
+	m_world_ys.clear();
+	m_world_ys.reserve(num_out);
+	for (unsigned int i = first; i < first + num_out; i++)
+	{
+		const float* p = positions[i];
+		Angel::vec4 tmp = mat_model * Angel::vec4(p[0], p[1], p[2], 1.0f);
+		m_world_coords.emplace_back(tmp.x, tmp.y, tmp.z);
+		m_world_xs.push_back(tmp.x);
+		m_world_ys.push_back(tmp.y);
 	}
-	Angel::mat4 mat_model = model_matrix();
-	std::vector<Angel::vec3> out;
-	if (m_e_def == StaticShape::NONE)
+
+	if (m_world_coords.empty())
 	{
-		out.reserve(m_shape_def->num_vertices() - 1);
+		m_world_bounding_cube = { 0, 0, 0, 0, 0, 0 };
 	}
 	else
 	{
-		out.reserve(m_shape_def->num_vertices());
+		m_world_bounding_cube = { (float)INT_MAX, (float)INT_MIN, (float)INT_MAX, (float)INT_MIN, (float)INT_MAX, (float)INT_MIN };
+		for (const Angel::vec3& vert_coord : m_world_coords)
+		{
+			m_world_bounding_cube[0] = std::min(m_world_bounding_cube[0], vert_coord.x);
+			m_world_bounding_cube[1] = std::max(m_world_bounding_cube[1], vert_coord.x);
+			m_world_bounding_cube[2] = std::min(m_world_bounding_cube[2], vert_coord.y);
+			m_world_bounding_cube[3] = std::max(m_world_bounding_cube[3], vert_coord.y);
+			m_world_bounding_cube[4] = std::min(m_world_bounding_cube[4], vert_coord.z);
+			m_world_bounding_cube[5] = std::max(m_world_bounding_cube[5], vert_coord.z);
+		}
 	}
-	for (unsigned int i = 0; i < out.capacity(); i++)
+
+	m_cached_position = position();
+	m_cached_rotation = rotation();
+	m_cached_scale = scale();
+	m_world_cache_revision = m_shape_def->revision();
+	m_world_cache_valid = true;
+}
+
+/// <summary>
+/// Vertices of the shape in world space, excluding the center of polygons.
+/// The returned reference is valid until the shape is modified.
+/// </summary>
+const std::vector<Angel::vec3>& ShapeModel::model_coords()
+{
+	auto changed = [](const Angel::vec3& cur, const Angel::vec3& cached) -> bool
+	{
+		return cur.x != cached.x || cur.y != cached.y || cur.z != cached.z;
+	};
+	if (!m_world_cache_valid
+		|| m_world_cache_revision != m_shape_def->revision()
+		|| changed(position(), m_cached_position)
+		|| changed(rotation(), m_cached_rotation)
+		|| changed(scale(), m_cached_scale))
 	{
-		float x = raw_vertices[i * stride];
-		float y = raw_vertices[i * stride + 1];
-		float z = raw_vertices[i * stride + 2];
-		Angel::vec4 tmp = mat_model * Angel::vec4(x, y, z, 1.0f);
-		out.emplace_back(tmp.x, tmp.y, tmp.z);
+		update_world_cache();
 	}
-	return out;
+	return m_world_coords;
+}
+
+const std::vector<float>& ShapeModel::world_xs()
+{
+	model_coords();
+	return m_world_xs;
 }
 
-Angel::mat4 ShapeModel::model_matrix()
+const std::vector<float>& ShapeModel::world_ys()
 {
-	if (m_position == nullptr 
-		&& m_rotation == nullptr
-		&& m_scale != nullptr
+	model_coords();
+	return m_world_ys;
+}
+
+/// <summary>
+/// Translate(position) * RotateX * RotateY * RotateZ * Scale * Translate(-center), cached.
+/// The returned reference is valid until the shape is modified.
+/// </summary>
+const Angel::mat4& ShapeModel::model_matrix()
+{
+	auto changed = [](const Angel::vec3& cur, const Angel::vec3& cached) -> bool
+	{
+		return cur.x != cached.x || cur.y != cached.y || cur.z != cached.z;
+	};
+	if (m_matrix_valid
+		&& m_matrix_revision == m_shape_def->revision()
+		&& !changed(position(), m_matrix_position)
+		&& !changed(rotation(), m_matrix_rotation)
+		&& !changed(scale(), m_matrix_scale))
+	{
+		return m_model_matrix;
+	}
+
+	if (m_scale_only
 		&& m_e_def == StaticShape::TEX_CUBE) // fallback code for articulated models
 	{
-		return Angel::Scale(*m_scale) * Angel::Translate(-center_raw_bottom());
+		m_model_matrix = Transform::scale_pivot(scale(), center_raw_bottom());
 	}
 	else if (m_e_def == StaticShape::COL_CUBE
 		|| m_e_def == StaticShape::TEX_CUBE)
 	{
-		return ((Angel::Translate((*m_position))
-			* Angel::RotateX(((*m_rotation).x))
-			* Angel::RotateY(((*m_rotation).y))
-			* Angel::RotateZ(((*m_rotation).z)))
-			* Angel::Scale(*m_scale))
-			* Angel::Translate(-center_raw_bottom());
+		m_model_matrix = Transform::trs(position(), rotation(), scale(), center_raw_bottom());
 	}
 	else
 	{
-		return ((Angel::Translate((*m_position))
-			* Angel::RotateX(((*m_rotation).x))
-			* Angel::RotateY(((*m_rotation).y))
-			* Angel::RotateZ(((*m_rotation).z)))
-			* Angel::Scale(*m_scale))
-			* Angel::Translate(-center_raw());
+		m_model_matrix = Transform::trs(position(), rotation(), scale(), center_raw());
 	}
+	m_matrix_position = position();
+	m_matrix_rotation = rotation();
+	m_matrix_scale = scale();
+	m_matrix_revision = m_shape_def->revision();
+	m_matrix_valid = true;
+	return m_model_matrix;
 }
 
+/// <summary>
+/// Appends a corner to a polygon that is being drawn. Like the polygon
+/// constructor, the polygon is assumed to be unrotated and unscaled.
+/// The position follows the centroid, so the existing corners stay in place.
+/// </summary>
+/// <param name="model_pos">world position of the new corner</param>
 void ShapeModel::push_back_vertex(const Angel::vec3& model_pos)
 {
-	*m_position = m_shape_def->push_back_vertex(model_pos - (*m_position), (*m_position));
+	ASSERT(m_is_poly);
+	Angel::vec3 raw_vertex_pos = model_pos - position() + center_raw();
+	position() += m_shape_def->push_back_vertex(raw_vertex_pos);
 }
 
 Angel::vec3 ShapeModel::center_raw()
 {
-	Angel::vec3 center(0.0f, 0.0f, 0.0f);
-	std::vector<float> vert = m_shape_def->vertices();
-	int stride = NUM_COORDINATES;
-	if (m_e_def == StaticShape::COL_CUBE)
-	{
-		stride += NUM_RGBA;
-	}
-	else if (m_e_def == StaticShape::TEX_CUBE)
-	{
-		stride += NUM_TEXTURE_COORDINATES + NUM_COORDINATES;
-	}
-	for (unsigned int i = 0; i < vert.size(); i+= stride)
-	{
-		center.x += vert[i]    ;
-		center.y += vert[i + 1];
-		center.z += vert[i + 2];
-	}
-	if (m_e_def == StaticShape::NONE)
+	if (!m_raw_cache_valid || m_raw_cache_revision != m_shape_def->revision())
 	{
-		center /= (float)m_shape_def->num_vertices() - 1;
+		update_raw_cache();
 	}
-	else
-	{
-		center /= (float)m_shape_def->num_vertices();
-	}
-	return center;
+	return m_raw_center;
 }
 
 Angel::vec3 ShapeModel::center_raw_bottom()
 {
-	Angel::vec3 center(0.0f, 0.0f, 0.0f);
-	center.y = -0.5f;	// TODO-GENERALIZE
-	std::vector<float> vert = m_shape_def->vertices();
-	int stride = NUM_COORDINATES;
-	if (m_e_def == StaticShape::COL_CUBE)
-	{
-		stride += NUM_RGBA;
-	}
-	else if (m_e_def == StaticShape::TEX_CUBE)
-	{
-		stride += NUM_TEXTURE_COORDINATES + NUM_COORDINATES;
-	}
-	for (unsigned int i = 0; i < vert.size(); i += stride)
-	{
-		center.x += vert[i];
-		center.z += vert[i + 2];
-	}
-	float y_tmp = center.y;
-	if (m_e_def == StaticShape::NONE)
+	if (!m_raw_cache_valid || m_raw_cache_revision != m_shape_def->revision())
 	{
-		center /= (float)m_shape_def->num_vertices() - 1;
+		update_raw_cache();
 	}
-	else if (m_e_def != StaticShape::COL_CUBE
-		&& m_e_def != StaticShape::TEX_CUBE)
-	{
-		center /= (float)m_shape_def->num_vertices();
-	}
-	else
-	{
-		float y_tmp = center.y;
-		center /= ((float)vert.size() / stride);
-	}
-	center.y = y_tmp;
-	return center;
+	return m_raw_center_bottom;
 }
 
 Angel::vec3 ShapeModel::center_true()
 {
-	return center_raw() + *m_position;
+	return center_raw() + position();
 }
 
-std::array<float, 6> ShapeModel::shape_bounding_cube()
+const std::array<float, 6>& ShapeModel::shape_bounding_cube()
 {
-	float x_min = (float)INT_MAX, x_max = (float)INT_MIN, y_min = (float)INT_MAX, y_max = (float)INT_MIN, z_min = (float)INT_MAX, z_max = (float)INT_MIN;
-	auto model_coordinates = model_coords();
-	if (model_coordinates.empty())
-	{
-		return { 0, 0, 0, 0, 0, 0 };
-	}
-	for (auto& vert_coord : model_coordinates)
-	{
-		if (vert_coord.x < x_min)
-		{
-			x_min = vert_coord.x;
-		}
-		if (vert_coord.x > x_max)
-		{
-			x_max = vert_coord.x;
-		}
-		if (vert_coord.y < y_min)
-		{
-			y_min = vert_coord.y;
-		}
-		if (vert_coord.y > y_max)
-		{
-			y_max = vert_coord.y;
-		}
-		if (vert_coord.z < z_min)
-		{
-			z_min = vert_coord.z;
-		}
-		if (vert_coord.z > z_max)
-		{
-			z_max = vert_coord.z;
-		}
-	}
-	return {
-		x_min, x_max, y_min, y_max, z_min, z_max
-	};
+	model_coords();
+	return m_world_bounding_cube;
 }
 
 Angel::vec3 ShapeModel::shape_size()
 {
-	std::array<float, 6> bounding_cube = this->shape_bounding_cube();
+	const std::array<float, 6>& bounding_cube = this->shape_bounding_cube();
 	return {
-		(bounding_cube[1] - bounding_cube[0]) * (*m_scale).x,
-		(bounding_cube[3] - bounding_cube[2]) * (*m_scale).y,
-		(bounding_cube[5] - bounding_cube[4]) * (*m_scale).z
+		(bounding_cube[1] - bounding_cube[0]) * scale().x,
+		(bounding_cube[3] - bounding_cube[2]) * scale().y,
+		(bounding_cube[5] - bounding_cube[4]) * scale().z
 	};
 }
 
@@ -420,98 +352,133 @@ Angel::vec3 ShapeModel::shape_size()
 /// <param name="view"></param>
 void ShapeModel::draw_shape(const Angel::mat4& proj, const Angel::mat4& view)
 {
-	if (!is_hidden())
-	{
-		Angel::mat4 MV_matrix = view * model_matrix();
-		Angel::mat4 MVP_matrix = proj * view * model_matrix();
-		Shape::basic_shader()->bind();
-		Shape::basic_shader()->set_uniform_mat4f("u_MVP", MVP_matrix);
+	RenderQueue& queue = RenderQueue::immediate();
+	submit_shape(queue, proj, view);
+	queue.flush();
+}
 
-		// Update locations and colors
-		if (m_e_def !=  StaticShape::COL_CUBE && m_e_def != StaticShape::TEX_CUBE)
-		{
-			Shape::basic_shader()->bind();
-			Shape::basic_shader()->set_uniform_4f("u_color",
-				color()[0],
-				color()[1],
-				color()[2],
-				color()[3]);
-		}
-		else if (m_e_def == StaticShape::COL_CUBE)
-		{
-			Shape::colored_shader()->bind();
-			Shape::colored_shader()->set_uniform_mat4f("u_MVP", MVP_matrix);
-		}
-		else
-		{
-			m_texture->bind(m_texture_slot);
-			Shape::textured_shader()->bind();
-			Shape::textured_shader()->set_uniform_1i("u_texture", m_texture_slot);
-			Shape::textured_shader()->set_uniform_mat4f("u_MVP", MVP_matrix);
-			Shape::textured_shader()->set_uniform_mat4f("u_MV", MV_matrix);
-			Shape::textured_shader()->set_uniform_mat4f("u_P", proj);
-			Angel::vec4 light_source_pos = view * Angel::vec4(0.0f, 1000.0f, 1000.0f, 1.0f);
-			Shape::textured_shader()->set_uniform_4f("u_light_position",
-				light_source_pos.x,
-				light_source_pos.y,
-				light_source_pos.z,
-				light_source_pos.w);
-			Shape::textured_shader()->set_uniform_4f("u_ambient", 0.32f, 0.173f, 0.118f, 1.0f);
-			Shape::textured_shader()->set_uniform_4f("u_diffuse", 0.75f, 0.5f, 0.0f, 1.0f);
-			Shape::textured_shader()->set_uniform_4f("u_specular", 1.0f, 1.0f, 1.0f, 1.0f);
-			Shape::textured_shader()->set_uniform_1f("u_shininess", 50.0f);
-		}
+/// <summary>
+/// Records the draw commands of the shape given the projection and view matrices.
+/// 2D shapes keep the submission order, cubes are sorted by their state and depth.
+/// The lit and basic shaders read the camera from FrameUniforms, the matrices passed
+/// here must be the ones of the current frame.
+/// </summary>
+/// <param name="queue"></param>
+/// <param name="proj"></param>
+/// <param name="view"></param>
+void ShapeModel::submit_shape(RenderQueue& queue, const Angel::mat4& proj, const Angel::mat4& view)
+{
+	if (is_hidden())
+	{
+		return;
+	}
+	Angel::mat4 MV_matrix = view * model_matrix();
+	Angel::mat4 MVP_matrix = proj * MV_matrix;
+	const Angel::vec4 outline_color(0.0f, 0.0f, 0.0f, 1.0f);
 
-		// draw
-		if (!is_poly() 
-			&& m_e_def != StaticShape::COL_CUBE
-			&& m_e_def != StaticShape::TEX_CUBE)
+	RenderQueue::DrawCommand draw;
+	draw.vertex_array = vertex_array();
+	if (m_e_def == StaticShape::COL_CUBE)
+	{
+		draw.layer = RenderQueue::Layer::Scene;
+		draw.depth = -MV_matrix[2][3];
+		draw.shader = Shape::colored_shader();
+		draw.index_buffer = index_buffer();
+		queue.submit(draw);
+		queue.uniform_mat4f(s_mvp_uniform, MVP_matrix);
+	}
+	else if (m_e_def == StaticShape::TEX_CUBE)
+	{
+		draw.layer = RenderQueue::Layer::Scene;
+		draw.depth = -MV_matrix[2][3];
+		draw.shader = Shape::textured_shader();
+		draw.texture = m_texture;
+		draw.texture_slot = m_texture_slot;
+		draw.index_buffer = index_buffer();
+		queue.submit(draw);
+		queue.uniform_1i(s_texture_uniform, m_texture_slot);
+		queue.uniform_mat4f(s_model_uniform, model_matrix());
+		queue.uniform_1i(s_selected_uniform, 0);
+	}
+	else
+	{
+		draw.layer = RenderQueue::Layer::World2D;
+		draw.shader = Shape::basic_shader();
+		draw.index_buffer = is_poly() ? polygon_triangle_index_buffer() : index_buffer();
+		queue.submit(draw);
+		queue.uniform_mat4f(s_model_uniform, model_matrix());
+		queue.uniform_4f(s_color_uniform, color());
+		if (is_selected())
 		{
-			Renderer::draw_triangles(vertex_array(), index_buffer(), Shape::basic_shader());
-			if (is_selected())
+			draw.index_buffer = index_buffer();
+			if (is_poly())
 			{
-				Shape::basic_shader()->set_uniform_4f("u_color",
-					0.0f,
-					0.0f,
-					0.0f,
-					1.0f);
-				if (shape_def() == ShapeModel::StaticShape::RECTANGLE)
-				{
-					Renderer::draw_lines(vertex_array(), index_buffer(), Shape::basic_shader());
-				}
-				else
-				{
-					Renderer::draw_lines(vertex_array(), index_buffer(), Shape::basic_shader(), true_num_vertices());
-				}
+				// Polygon IB has offset of 1 to the actual starting vertex (not the center)
+				draw.primitive = RenderQueue::Primitive::LineLoop;
+				draw.count = (int)true_num_vertices();
+				draw.first_index = 1;
 			}
+			else if (shape_def() == ShapeModel::StaticShape::RECTANGLE)
+			{
+				draw.primitive = RenderQueue::Primitive::LineStrip;
+			}
+			else
+			{
+				draw.primitive = RenderQueue::Primitive::LineLoop;
+				draw.count = (int)true_num_vertices();
+			}
+			queue.submit(draw);
+			queue.uniform_mat4f(s_model_uniform, model_matrix());
+			queue.uniform_4f(s_color_uniform, outline_color);
 		}
-		else if (m_e_def == StaticShape::COL_CUBE)
-		{
-			Renderer::draw_triangles(vertex_array(), index_buffer(), Shape::colored_shader());
-		}
-		else if (m_e_def == StaticShape::TEX_CUBE)
+	}
+}
+
+/// <summary>
+/// Draws the shape with the CPU backend, from the vertices and indices that the shape
+/// keeps on the CPU, so no GL context is needed. The fill matches submit_shape, the
+/// selection outline is not drawn since the backend only rasterizes triangles.
+/// Textures are uploaded without keeping their pixels, textured cubes are drawn lit white.
+/// </summary>
+/// <param name="rasterizer"></param>
+void ShapeModel::submit_software(SoftwareRasterizer& rasterizer)
+{
+	if (is_hidden())
+	{
+		return;
+	}
+	SoftwareRasterizer::Mesh mesh;
+	mesh.positions = m_shape_def->positions();
+	mesh.model = model_matrix();
+	if (m_e_def == StaticShape::COL_CUBE)
+	{
+		mesh.shading = SoftwareRasterizer::Shading::Colored;
+		mesh.colors = m_shape_def->attribute(NUM_COORDINATES, NUM_RGBA);
+		mesh.indices = m_shape_def->indices();
+	}
+	else if (m_e_def == StaticShape::TEX_CUBE)
+	{
+		mesh.shading = SoftwareRasterizer::Shading::Textured;
+		mesh.uvs = m_shape_def->attribute(NUM_COORDINATES, NUM_TEXTURE_COORDINATES);
+		mesh.normals = m_shape_def->attribute(NUM_COORDINATES + NUM_TEXTURE_COORDINATES, NUM_COORDINATES);
+		mesh.indices = m_shape_def->indices();
+	}
+	else
+	{
+		mesh.shading = SoftwareRasterizer::Shading::Flat;
+		mesh.color = color();
+		if (is_poly())
 		{
-			m_texture->bind(m_texture_slot);
-			Renderer::draw_triangles(vertex_array(), index_buffer(), Shape::textured_shader());
+			// The triangles index the corners, which start after the fan center
+			mesh.indices = polygon_triangles();
+			mesh.base_vertex = 1;
 		}
 		else
 		{
-			Renderer::draw_polygon(vertex_array(), index_buffer(), Shape::basic_shader());
-			if (is_selected())
-			{
-				Shape::basic_shader()->set_uniform_4f("u_color",
-					0.0f,
-					0.0f,
-					0.0f,
-					1.0f);
-#pragma warning(push)
-#pragma warning( disable : 4312 )
-				unsigned int offset = sizeof(unsigned int); // Polygon IB has offset of 1 to the actual starting vertex (not the center)
-				Renderer::draw_lines(vertex_array(), index_buffer(), Shape::basic_shader(), true_num_vertices(), (const void*)offset);
-#pragma warning(pop)
-			}
+			mesh.indices = m_shape_def->indices();
 		}
 	}
+	rasterizer.draw(mesh);
 }
 
 std::array<float, 6> ShapeModel::bounding_cube(const std::vector<ShapeModel*>& shapes)
@@ -519,7 +486,7 @@ std::array<float, 6> ShapeModel::bounding_cube(const std::vector<ShapeModel*>& s
 	std::array<float, 6> out_bounding_cube = {(float)INT_MAX, (float)INT_MIN, (float)INT_MAX, (float)INT_MIN, (float)INT_MAX, (float)INT_MIN};
 	for (unsigned int i = 0; i < shapes.size(); i++)
 	{
-		std::array<float, 6> cur_bounding_cube = shapes[i]->shape_bounding_cube();
+		const std::array<float, 6>& cur_bounding_cube = shapes[i]->shape_bounding_cube();
 		for (unsigned int j = 0; j < out_bounding_cube.size(); j += 2)
 		{
 			if (cur_bounding_cube[j] < out_bounding_cube[j])
@@ -538,3 +505,84 @@ std::array<float, 6> ShapeModel::bounding_cube(const std::vector<ShapeModel*>& s
 	return out_bounding_cube;
 }
 
+/// <summary>
+/// Simplified outline of the polygon for the given zoom, the dropped
+/// corners are within tolerance_px pixels of the simplified outline.
+/// The zoom is rounded up to half octaves, so that a smooth zoom reuses
+/// the cached levels instead of simplifying the polygon every frame.
+/// </summary>
+/// <param name="pixels_per_unit">zoom_ratio / 100 of the orthographic camera</param>
+/// <param name="tolerance_px"></param>
+/// <returns></returns>
+Shape::PolygonLod& ShapeModel::polygon_lod(float pixels_per_unit, float tolerance_px)
+{
+	ASSERT(m_is_poly && pixels_per_unit > 0.0f);
+	int zoom_key = (int)std::ceil(std::log2(pixels_per_unit) * 2.0f);
+	float level_pixels_per_unit = std::exp2(zoom_key / 2.0f);
+	// The simplification is done on the raw vertices, undo the scaling of the model
+	float max_scale = std::max(std::abs(scale().x), std::abs(scale().y));
+	float tolerance = tolerance_px / (level_pixels_per_unit * std::max(max_scale, 1e-6f));
+	return m_shape_def->polygon_lod(zoom_key, tolerance);
+}
+
+void ShapeModel::draw_polygon_lod(Shape::PolygonLod& lod)
+{
+	RenderQueue& queue = RenderQueue::immediate();
+	submit_polygon_lod(queue, lod);
+	queue.flush();
+}
+
+void ShapeModel::submit_polygon_lod(RenderQueue& queue, Shape::PolygonLod& lod)
+{
+	if (is_hidden())
+	{
+		return;
+	}
+	m_shape_def->upload_polygon_lod(lod);
+	RenderQueue::DrawCommand draw;
+	draw.layer = RenderQueue::Layer::World2D;
+	draw.shader = Shape::basic_shader();
+	draw.vertex_array = vertex_array();
+	draw.index_buffer = lod.fill_index_buffer;
+	queue.submit(draw);
+	queue.uniform_mat4f(s_model_uniform, model_matrix());
+	queue.uniform_4f(s_color_uniform, color());
+	if (is_selected())
+	{
+		draw.index_buffer = lod.outline_index_buffer;
+		draw.primitive = RenderQueue::Primitive::LineLoop;
+		queue.submit(draw);
+		queue.uniform_mat4f(s_model_uniform, model_matrix());
+		queue.uniform_4f(s_color_uniform, Angel::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	}
+}
+
+/// <summary>
+/// Draws the shape as a single point, for shapes smaller than a pixel.
+/// The point is the first vertex: the centroid for polygons, whose fan starts
+/// from it, and the first corner for the unit shapes, which have no center vertex.
+/// </summary>
+void ShapeModel::draw_point()
+{
+	RenderQueue& queue = RenderQueue::immediate();
+	submit_point(queue);
+	queue.flush();
+}
+
+void ShapeModel::submit_point(RenderQueue& queue)
+{
+	if (is_hidden())
+	{
+		return;
+	}
+	RenderQueue::DrawCommand draw;
+	draw.layer = RenderQueue::Layer::World2D;
+	draw.shader = Shape::basic_shader();
+	draw.vertex_array = vertex_array();
+	draw.index_buffer = index_buffer();
+	draw.primitive = RenderQueue::Primitive::Points;
+	draw.count = 1;
+	queue.submit(draw);
+	queue.uniform_mat4f(s_model_uniform, model_matrix());
+	queue.uniform_4f(s_color_uniform, color());
+}
@@ -0,0 +1,245 @@
+#include "EntityManager/SpatialIndex2D.h"
+#include "Core/ErrorManager.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialIndex2D::SpatialIndex2D(float cell_size)
+	: m_cell_size(cell_size),
+	m_query_stamp(0)
+{
+	ASSERT(cell_size > 0.0f);
+}
+
+SpatialIndex2D::~SpatialIndex2D()
+{
+	clear();
+}
+
+int SpatialIndex2D::cell_coord(float v) const
+{
+	return (int)std::floor(v / m_cell_size);
+}
+
+int64_t SpatialIndex2D::cell_key(int cx, int cy)
+{
+	return ((int64_t)cx << 32) | (int64_t)(uint32_t)cy;
+}
+
+/// <summary>
+/// Registers the entry into the cells covered by its bounds
+/// </summary>
+/// <param name="e"></param>
+void SpatialIndex2D::link(Entry* e)
+{
+	e->cx_min = cell_coord(e->bounds.x_min);
+	e->cx_max = cell_coord(e->bounds.x_max);
+	e->cy_min = cell_coord(e->bounds.y_min);
+	e->cy_max = cell_coord(e->bounds.y_max);
+	int64_t num_cells = (int64_t)(e->cx_max - e->cx_min + 1) * (int64_t)(e->cy_max - e->cy_min + 1);
+	e->oversized = num_cells > s_max_cells_per_entry;
+	if (e->oversized)
+	{
+		m_oversized.push_back(e);
+		return;
+	}
+	for (int cx = e->cx_min; cx <= e->cx_max; cx++)
+	{
+		for (int cy = e->cy_min; cy <= e->cy_max; cy++)
+		{
+			m_cells[cell_key(cx, cy)].push_back(e);
+		}
+	}
+}
+
+void SpatialIndex2D::unlink(Entry* e)
+{
+	if (e->oversized)
+	{
+		m_oversized.erase(std::find(m_oversized.begin(), m_oversized.end(), e));
+		return;
+	}
+	for (int cx = e->cx_min; cx <= e->cx_max; cx++)
+	{
+		for (int cy = e->cy_min; cy <= e->cy_max; cy++)
+		{
+			auto cell = m_cells.find(cell_key(cx, cy));
+			ASSERT(cell != m_cells.end());
+			std::vector<Entry*>& entries = cell->second;
+			auto it = std::find(entries.begin(), entries.end(), e);
+			ASSERT(it != entries.end());
+			// Order inside a cell does not matter, swap & pop
+			*it = entries.back();
+			entries.pop_back();
+			if (entries.empty())
+			{
+				m_cells.erase(cell);
+			}
+		}
+	}
+}
+
+unsigned int SpatialIndex2D::next_query_stamp()
+{
+	m_query_stamp++;
+	if (m_query_stamp == 0)
+	{
+		// Wrapped around, reset the stamps so that no entry is skipped
+		for (auto& [shape, entry] : m_entries)
+		{
+			entry.last_query = 0;
+		}
+		m_query_stamp = 1;
+	}
+	return m_query_stamp;
+}
+
+void SpatialIndex2D::insert(ShapeModel* s, const Bounds& bounds, uint64_t order)
+{
+	ASSERT(!contains(s));
+	Entry& e = m_entries[s];
+	e.shape = s;
+	e.bounds = bounds;
+	e.order = order;
+	e.last_query = 0;
+	link(&e);
+}
+
+/// <summary>
+/// Re-registers a shape after its bounds were changed,
+/// e.g. after a move or a rotation
+/// </summary>
+/// <param name="s"></param>
+/// <param name="bounds"></param>
+void SpatialIndex2D::update(ShapeModel* s, const Bounds& bounds)
+{
+	auto it = m_entries.find(s);
+	ASSERT(it != m_entries.end());
+	Entry* e = &it->second;
+	if (!e->oversized
+		&& cell_coord(bounds.x_min) == e->cx_min
+		&& cell_coord(bounds.x_max) == e->cx_max
+		&& cell_coord(bounds.y_min) == e->cy_min
+		&& cell_coord(bounds.y_max) == e->cy_max)
+	{
+		// Still covers the same cells, nothing to relink
+		e->bounds = bounds;
+		return;
+	}
+	unlink(e);
+	e->bounds = bounds;
+	link(e);
+}
+
+void SpatialIndex2D::set_order(ShapeModel* s, uint64_t order)
+{
+	auto it = m_entries.find(s);
+	ASSERT(it != m_entries.end());
+	it->second.order = order;
+}
+
+void SpatialIndex2D::remove(ShapeModel* s)
+{
+	auto it = m_entries.find(s);
+	if (it != m_entries.end())
+	{
+		unlink(&it->second);
+		m_entries.erase(it);
+	}
+}
+
+void SpatialIndex2D::clear()
+{
+	m_cells.clear();
+	m_oversized.clear();
+	m_entries.clear();
+}
+
+bool SpatialIndex2D::contains(ShapeModel* s) const
+{
+	return m_entries.find(s) != m_entries.end();
+}
+
+/// <summary>
+/// Collects the entries whose bounds contain the given point.
+/// The output is not sorted w.r.t. draw order.
+/// </summary>
+void SpatialIndex2D::query_point(float x, float y, std::vector<const Entry*>& out)
+{
+	out.clear();
+	auto cell = m_cells.find(cell_key(cell_coord(x), cell_coord(y)));
+	if (cell != m_cells.end())
+	{
+		for (const Entry* e : cell->second)
+		{
+			if (e->bounds.contains(x, y))
+			{
+				out.push_back(e);
+			}
+		}
+	}
+	for (const Entry* e : m_oversized)
+	{
+		if (e->bounds.contains(x, y))
+		{
+			out.push_back(e);
+		}
+	}
+}
+
+/// <summary>
+/// Collects the entries whose bounds overlap the given rectangle,
+/// each entry is reported once. The output is not sorted w.r.t. draw order.
+/// </summary>
+void SpatialIndex2D::query_rect(const Bounds& rect, std::vector<const Entry*>& out)
+{
+	out.clear();
+	unsigned int stamp = next_query_stamp();
+	int cx_min = cell_coord(rect.x_min);
+	int cx_max = cell_coord(rect.x_max);
+	int cy_min = cell_coord(rect.y_min);
+	int cy_max = cell_coord(rect.y_max);
+	int64_t num_cells = (int64_t)(cx_max - cx_min + 1) * (int64_t)(cy_max - cy_min + 1);
+	auto visit = [&](const Entry* e)
+	{
+		if (e->last_query != stamp)
+		{
+			e->last_query = stamp;
+			if (e->bounds.overlaps(rect))
+			{
+				out.push_back(e);
+			}
+		}
+	};
+	if (num_cells > (int64_t)m_cells.size())
+	{
+		// The rectangle covers more cells than there are occupied, walk the occupied ones
+		for (auto& [key, entries] : m_cells)
+		{
+			for (const Entry* e : entries)
+			{
+				visit(e);
+			}
+		}
+	}
+	else
+	{
+		for (int cx = cx_min; cx <= cx_max; cx++)
+		{
+			for (int cy = cy_min; cy <= cy_max; cy++)
+			{
+				auto cell = m_cells.find(cell_key(cx, cy));
+				if (cell != m_cells.end())
+				{
+					for (const Entry* e : cell->second)
+					{
+						visit(e);
+					}
+				}
+			}
+		}
+	}
+	for (const Entry* e : m_oversized)
+	{
+		visit(e);
+	}
+}
@@ -26,20 +26,52 @@ void UndoRedoStack::on_operation_performed(const Operation& operation)
 			m_undo_stack.push(tmp);
 		}
 	}
-	m_undo_stack.push(operation);
+	Operation performed = operation;
+	performed.set_shape_handle(m_draw_list->handle_of(performed.shape_manipulated()));
+	m_undo_stack.push(performed);
 	while (!m_redo_stack.empty())
 	{
 		Operation op = m_redo_stack.top();
-		ShapeModel* manipulated_shape = op.shape_manipulated();
+		m_redo_stack.pop();
 		if (op.type() == Operation::OperationType::AddPredefined ||
 			op.type() == Operation::OperationType::FinishPoly)
 		{
-			if (manipulated_shape != nullptr)
-			{
-				m_draw_list->remove_shape(manipulated_shape);
-			}
+			// The creation can no longer be redone, the shape goes away with its history
+			erase_operations_on(m_undo_stack, op.shape_handle());
+			m_draw_list->remove_shape(op.shape_handle());
 		}
-		m_redo_stack.pop();
+	}
+}
+
+/// <summary>
+/// Removes the shape from the draw list together with the operations on it,
+/// so that the remaining history can still be undone in order
+/// </summary>
+/// <param name="s"></param>
+void UndoRedoStack::remove_shape(ShapeModel* s)
+{
+	SlotHandle handle = m_draw_list->handle_of(s);
+	erase_operations_on(m_undo_stack, handle);
+	erase_operations_on(m_redo_stack, handle);
+	m_draw_list->remove_shape(handle);
+}
+
+void UndoRedoStack::erase_operations_on(std::stack<Operation>& stack, const SlotHandle& handle)
+{
+	std::stack<Operation> kept_reversed;
+	while (!stack.empty())
+	{
+		Operation op = stack.top();
+		stack.pop();
+		if (op.shape_handle() != handle)
+		{
+			kept_reversed.push(op);
+		}
+	}
+	while (!kept_reversed.empty())
+	{
+		stack.push(kept_reversed.top());
+		kept_reversed.pop();
 	}
 }
 
@@ -51,19 +83,22 @@ void UndoRedoStack::on_undo()
 		Operation top = Operation(m_undo_stack.top());
 		m_undo_stack.pop();
 
+		// The operations on a shape are erased when it is removed
+		ShapeModel* shape = m_draw_list->get(top.shape_handle());
+		ASSERT(shape != nullptr);
 		switch (top.type())
 		{
 		case Operation::OperationType::AddPredefined:
-			m_draw_list->undo_add_predefined(top.shape_manipulated());
+			m_draw_list->undo_add_predefined(shape);
 			break;
 		case Operation::OperationType::FinishPoly:
-			m_draw_list->undo_finish_poly(top.shape_manipulated());
+			m_draw_list->undo_finish_poly(shape);
 			break;
 		case Operation::OperationType::MoveShape:
-			m_draw_list->undo_move(top.shape_manipulated(), top.move_amount());
+			m_draw_list->undo_move(shape, top.move_amount());
 			break;
 		case Operation::OperationType::RotateShape:
-			m_draw_list->undo_rotate(top.shape_manipulated(), top.rotate_amount());
+			m_draw_list->undo_rotate(shape, top.rotate_amount());
 			break;
 		default:
 			ASSERT(false);
@@ -81,19 +116,21 @@ void UndoRedoStack::on_redo()
 		Operation top = Operation(m_redo_stack.top());
 		m_redo_stack.pop();
 
+		ShapeModel* shape = m_draw_list->get(top.shape_handle());
+		ASSERT(shape != nullptr);
 		switch (top.type())
 		{
 		case Operation::OperationType::AddPredefined:
-			m_draw_list->redo_add_predefined(top.shape_manipulated());
+			m_draw_list->redo_add_predefined(shape);
 			break;
 		case Operation::OperationType::FinishPoly:
-			m_draw_list->redo_finish_poly(top.shape_manipulated());
+			m_draw_list->redo_finish_poly(shape);
 			break;
 		case Operation::OperationType::MoveShape:
-			m_draw_list->redo_move(top.shape_manipulated(), top.move_amount());
+			m_draw_list->redo_move(shape, top.move_amount());
 			break;
 		case Operation::OperationType::RotateShape:
-			m_draw_list->redo_rotate(top.shape_manipulated(), top.rotate_amount());
+			m_draw_list->redo_rotate(shape, top.rotate_amount());
 			break;
 		default:
 			ASSERT(false);
@@ -0,0 +1,191 @@
+#include "Renderer/BatchRenderer2D.h"
+#include "Core/ErrorManager.h"
+#include <glew.h>
+#include <cmath>
+#include <cstdint>
+
+BatchRenderer2D::BatchRenderer2D(Shader* shader, const VertexBufferLayout& layout, unsigned int max_vertices)
+	: m_shader(shader),
+	m_max_vertices(max_vertices),
+	m_num_draw_calls(0)
+{
+	ASSERT(layout.stride() == sizeof(Vertex));
+	m_vertex_stream = new StreamingBuffer(s_frames_in_flight * s_typical_frame_vertices * sizeof(Vertex));
+	m_index_stream = new StreamingBuffer(s_frames_in_flight * s_typical_frame_vertices * 2 * sizeof(unsigned int));
+	m_vertex_array = new VertexArray;
+	m_vertex_array->add_stream(*m_vertex_stream, layout);
+	m_index_stream->bind_as_index_buffer();
+	m_vertex_array->unbind();
+}
+
+BatchRenderer2D::~BatchRenderer2D()
+{
+	delete m_vertex_array;
+	delete m_vertex_stream;
+	delete m_index_stream;
+}
+
+void BatchRenderer2D::begin(const Angel::mat4& view_proj)
+{
+	m_view_proj = view_proj;
+	m_num_draw_calls = 0;
+	m_vertices.clear();
+	m_indices.clear();
+}
+
+/// <summary>
+/// Makes sure that the given number of vertices fits into the current batch
+/// </summary>
+/// <param name="num_vertices"></param>
+void BatchRenderer2D::reserve(unsigned int num_vertices)
+{
+	if (m_vertices.size() + num_vertices > m_max_vertices)
+	{
+		flush();
+	}
+}
+
+void BatchRenderer2D::push_vertex(const Angel::vec3& pos, const Angel::vec4& color)
+{
+	m_vertices.push_back({ pos.x, pos.y, pos.z, color.x, color.y, color.z, color.w });
+}
+
+/// <summary>
+/// Triangulates the convex polygon as a fan, rectangles and triangles are
+/// submitted the same way with their 4 and 3 corners
+/// </summary>
+/// <param name="world_coords">corners in winding order</param>
+/// <param name="color"></param>
+void BatchRenderer2D::submit_convex_polygon(const std::vector<Angel::vec3>& world_coords, const Angel::vec4& color)
+{
+	unsigned int n = (unsigned int)world_coords.size();
+	if (n < 3)
+	{
+		return;
+	}
+	reserve(n);
+	unsigned int base = (unsigned int)m_vertices.size();
+	for (const Angel::vec3& coord : world_coords)
+	{
+		push_vertex(coord, color);
+	}
+	for (unsigned int i = 1; i < n - 1; i++)
+	{
+		m_indices.insert(m_indices.end(), { base, base + i, base + i + 1 });
+	}
+}
+
+/// <summary>
+/// Submits an already triangulated shape, e.g. a concave polygon
+/// </summary>
+/// <param name="world_coords">corners of the shape</param>
+/// <param name="indices">GL_TRIANGLES indices into world_coords</param>
+/// <param name="color"></param>
+void BatchRenderer2D::submit_triangles(const std::vector<Angel::vec3>& world_coords, const std::vector<unsigned int>& indices, const Angel::vec4& color)
+{
+	if (indices.empty())
+	{
+		return;
+	}
+	reserve((unsigned int)world_coords.size());
+	unsigned int base = (unsigned int)m_vertices.size();
+	for (const Angel::vec3& coord : world_coords)
+	{
+		push_vertex(coord, color);
+	}
+	for (unsigned int index : indices)
+	{
+		m_indices.push_back(base + index);
+	}
+}
+
+/// <summary>
+/// Emits an axis aligned square centered at the position, used in place of tiny shapes
+/// </summary>
+/// <param name="world_pos"></param>
+/// <param name="size">in world units</param>
+/// <param name="color"></param>
+void BatchRenderer2D::submit_point(const Angel::vec3& world_pos, float size, const Angel::vec4& color)
+{
+	reserve(4);
+	float h = size / 2.0f;
+	unsigned int base = (unsigned int)m_vertices.size();
+	push_vertex(Angel::vec3(world_pos.x - h, world_pos.y - h, world_pos.z), color);
+	push_vertex(Angel::vec3(world_pos.x + h, world_pos.y - h, world_pos.z), color);
+	push_vertex(Angel::vec3(world_pos.x + h, world_pos.y + h, world_pos.z), color);
+	push_vertex(Angel::vec3(world_pos.x - h, world_pos.y + h, world_pos.z), color);
+	m_indices.insert(m_indices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+}
+
+/// <summary>
+/// Emits every edge of the closed loop as a thin quad. Edges are extended
+/// by half of the width on both ends, so that the corners are filled.
+/// </summary>
+/// <param name="world_coords">corners in winding order</param>
+/// <param name="width">in world units</param>
+/// <param name="color"></param>
+void BatchRenderer2D::submit_outline(const std::vector<Angel::vec3>& world_coords, float width, const Angel::vec4& color)
+{
+	unsigned int n = (unsigned int)world_coords.size();
+	if (n < 2)
+	{
+		return;
+	}
+	reserve(4 * n);
+	float half_width = width / 2.0f;
+	for (unsigned int i = 0; i < n; i++)
+	{
+		const Angel::vec3& p0 = world_coords[i];
+		const Angel::vec3& p1 = world_coords[(i + 1) % n];
+		float dx = p1.x - p0.x;
+		float dy = p1.y - p0.y;
+		float len = std::sqrt(dx * dx + dy * dy);
+		if (len == 0.0f)
+		{
+			continue;
+		}
+		// Direction and normal of the edge, scaled by the half width
+		Angel::vec3 d(dx / len * half_width, dy / len * half_width, 0.0f);
+		Angel::vec3 nrm(-d.y, d.x, 0.0f);
+		unsigned int base = (unsigned int)m_vertices.size();
+		push_vertex(p0 - d + nrm, color);
+		push_vertex(p1 + d + nrm, color);
+		push_vertex(p1 + d - nrm, color);
+		push_vertex(p0 - d - nrm, color);
+		m_indices.insert(m_indices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+	}
+}
+
+/// <summary>
+/// Uploads and draws everything submitted since the last flush
+/// </summary>
+void BatchRenderer2D::flush()
+{
+	if (m_indices.empty())
+	{
+		m_vertices.clear();
+		return;
+	}
+	// Vertex ranges are aligned to whole vertices, so the base vertex addresses them
+	unsigned int vertex_offset = m_vertex_stream->push(m_vertices.data(), (unsigned int)(m_vertices.size() * sizeof(Vertex)), sizeof(Vertex));
+	unsigned int index_offset = m_index_stream->push(m_indices.data(), (unsigned int)(m_indices.size() * sizeof(unsigned int)), sizeof(unsigned int));
+	m_vertex_array->bind();
+	m_shader->bind();
+	m_shader->set_uniform_mat4f("u_MVP", m_view_proj);
+	__glCallVoid(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)m_indices.size(), GL_UNSIGNED_INT,
+		(void*)(uintptr_t)index_offset, (GLint)(vertex_offset / sizeof(Vertex))));
+	m_vertex_array->unbind();
+	m_num_draw_calls++;
+	m_vertices.clear();
+	m_indices.clear();
+}
+
+/// <summary>
+/// Draws what is left and fences the ranges of the rings used by this batch
+/// </summary>
+void BatchRenderer2D::end()
+{
+	flush();
+	m_vertex_stream->end_frame();
+	m_index_stream->end_frame();
+}
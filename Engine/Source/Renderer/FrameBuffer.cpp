@@ -1,26 +1,25 @@
 #include "Renderer/FrameBuffer.h"
+#include "Renderer/RenderState.h"
 #include <glew.h>
 #include <array>
 #include <functional>
 
-FrameBuffer::FrameBuffer(int width, int height)
+FrameBuffer::FrameBuffer(int width, int height, ColorFormat color_format)
 	: m_viewport_width(width),
-	m_viewport_height(height)
+	m_viewport_height(height),
+	m_color_format(color_format)
 {
 	// Create Texture for FB 
 	__glCallVoid(glGenTextures(1, &m_fb_texture_id));
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, m_fb_texture_id));
+	RenderState::bind_texture(m_fb_texture_id);
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-	__glCallVoid(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8UI,
-		m_viewport_width, m_viewport_height, 0,
-		GL_RGB_INTEGER, GL_UNSIGNED_BYTE, nullptr));
 
 	// Create Depth render buffer for FB
 	__glCallVoid(glGenRenderbuffers(1, &m_fb_depth_buffer_id));
-	__glCallVoid(glBindRenderbuffer(GL_RENDERBUFFER, m_fb_depth_buffer_id));
+	allocate_attachments();
 
 	// Create the actual frame buffer
 	__glCallVoid(glGenFramebuffers(1, &m_frame_buffer_id));
@@ -36,6 +35,7 @@ FrameBuffer::FrameBuffer(int width, int height)
 FrameBuffer::~FrameBuffer()
 {
 	// Delete FB and their attachments
+	RenderState::on_delete_texture(m_fb_texture_id);
 	__glCallVoid(glDeleteTextures(1, &m_fb_texture_id));
 	__glCallVoid(glDeleteRenderbuffers(1, &m_fb_depth_buffer_id));
 	__glCallVoid(glDeleteFramebuffers(1, &m_frame_buffer_id));
@@ -62,14 +62,31 @@ void FrameBuffer::on_screen_resize(int new_width, int new_height)
 {
 	m_viewport_width = new_width;
 	m_viewport_height = new_height;
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, m_fb_texture_id));
+	allocate_attachments();
+}
+
+/// <summary>
+/// (Re)creates the storage of the color texture and the depth buffer at the viewport size
+/// </summary>
+void FrameBuffer::allocate_attachments()
+{
+	RenderState::bind_texture(m_fb_texture_id);
 
-	// Level = 0, Border = 0, RGB8 - 8 bit opaque color range
+	// Level = 0, Border = 0, 8 bits per channel
 	// But the data is mull
 	// This way, an empty texture will be reinitialized to our bound texture
-	__glCallVoid(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8UI,
-		m_viewport_width, m_viewport_height, 0,
-		GL_RGB_INTEGER, GL_UNSIGNED_BYTE, nullptr));
+	if (m_color_format == ColorFormat::IntegerRGB)
+	{
+		__glCallVoid(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8UI,
+			m_viewport_width, m_viewport_height, 0,
+			GL_RGB_INTEGER, GL_UNSIGNED_BYTE, nullptr));
+	}
+	else
+	{
+		__glCallVoid(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8,
+			m_viewport_width, m_viewport_height, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
 
 	__glCallVoid(glBindRenderbuffer(GL_RENDERBUFFER, m_fb_depth_buffer_id));
 	__glCallVoid(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, m_viewport_width, m_viewport_height));
@@ -77,7 +94,7 @@ void FrameBuffer::on_screen_resize(int new_width, int new_height)
 
 void FrameBuffer::bind()
 {
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, m_fb_texture_id));
+	RenderState::bind_texture(m_fb_texture_id);
 	__glCallVoid(glBindRenderbuffer(GL_RENDERBUFFER, m_fb_depth_buffer_id));
 	__glCallVoid(glBindFramebuffer(GL_FRAMEBUFFER, m_frame_buffer_id));
 }
@@ -86,7 +103,7 @@ void FrameBuffer::unbind()
 {
 	__glCallVoid(glBindFramebuffer(GL_FRAMEBUFFER, 0));
 	// Also unbinds the texture used & depth buffer in this FB
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, 0));
+	RenderState::bind_texture(0);
 	__glCallVoid(glBindRenderbuffer(GL_RENDERBUFFER, 0));
 }
 
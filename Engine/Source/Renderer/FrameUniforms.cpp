@@ -0,0 +1,70 @@
+#include "Renderer/FrameUniforms.h"
+#include "Renderer/RenderState.h"
+#include "Core/ErrorManager.h"
+#include <glew.h>
+#include <cstring>
+
+unsigned int FrameUniforms::s_buffer_id = 0;
+FrameUniforms::Block FrameUniforms::s_block;
+unsigned int FrameUniforms::s_num_uploads = 0;
+
+/// <summary>
+/// Uploads the data of the frame, nothing is sent when the camera
+/// and the light did not change since the last frame
+/// </summary>
+/// <param name="proj"></param>
+/// <param name="view"></param>
+/// <param name="light_position">in view space</param>
+void FrameUniforms::update(const Angel::mat4& proj, const Angel::mat4& view, const Angel::vec4& light_position)
+{
+	Block block;
+	block.proj = proj;
+	block.view = view;
+	block.light_position = light_position;
+	if (s_buffer_id == 0)
+	{
+		__glCallVoid(glGenBuffers(1, &s_buffer_id));
+		__glCallVoid(glBindBuffer(GL_UNIFORM_BUFFER, s_buffer_id));
+		__glCallVoid(glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW));
+		// Nothing else uses uniform buffers, the binding point stays attached to this buffer
+		__glCallVoid(glBindBufferBase(GL_UNIFORM_BUFFER, s_binding_point, s_buffer_id));
+	}
+	else if (std::memcmp(&block, &s_block, sizeof(Block)) == 0)
+	{
+		return;
+	}
+	else
+	{
+		__glCallVoid(glBindBuffer(GL_UNIFORM_BUFFER, s_buffer_id));
+	}
+	__glCallVoid(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block));
+	s_block = block;
+	s_num_uploads++;
+}
+
+/// <summary>
+/// Connects the FrameData block of the program to the binding point of the buffer.
+/// GLSL 150 has no binding qualifier, so this is done once after linking.
+/// Programs that do not declare the block are left untouched.
+/// </summary>
+/// <param name="program_id"></param>
+void FrameUniforms::bind_block(unsigned int program_id)
+{
+	unsigned int block_index;
+	__glCallReturn(glGetUniformBlockIndex(program_id, s_block_name), block_index);
+	if (block_index != GL_INVALID_INDEX)
+	{
+		__glCallVoid(glUniformBlockBinding(program_id, block_index, s_binding_point));
+	}
+}
+
+void FrameUniforms::destroy()
+{
+	if (s_buffer_id != 0)
+	{
+		RenderState::on_delete_buffer(s_buffer_id);
+		__glCallVoid(glDeleteBuffers(1, &s_buffer_id));
+		s_buffer_id = 0;
+	}
+	s_num_uploads = 0;
+}
@@ -0,0 +1,218 @@
+#include "Renderer/GeometryArena.h"
+#include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
+#include <glew.h>
+#include <algorithm>
+
+RangeAllocator::RangeAllocator(unsigned int capacity)
+	: m_capacity(capacity),
+	m_used(0)
+{
+	if (capacity > 0)
+	{
+		m_free_blocks[0] = capacity;
+	}
+}
+
+unsigned int RangeAllocator::allocate(unsigned int count)
+{
+	ASSERT(count > 0);
+	for (auto it = m_free_blocks.begin(); it != m_free_blocks.end(); ++it)
+	{
+		if (it->second < count)
+		{
+			continue;
+		}
+		unsigned int first = it->first;
+		unsigned int remaining = it->second - count;
+		m_free_blocks.erase(it);
+		if (remaining > 0)
+		{
+			m_free_blocks[first + count] = remaining;
+		}
+		m_used += count;
+		return first;
+	}
+	return s_invalid;
+}
+
+void RangeAllocator::free(unsigned int first, unsigned int count)
+{
+	ASSERT(count > 0 && first + count <= m_capacity && count <= m_used);
+	m_used -= count;
+	auto next = m_free_blocks.lower_bound(first);
+	ASSERT(next == m_free_blocks.end() || first + count <= next->first);
+	if (next != m_free_blocks.end() && next->first == first + count)
+	{
+		count += next->second;
+		next = m_free_blocks.erase(next);
+	}
+	if (next != m_free_blocks.begin())
+	{
+		auto previous = std::prev(next);
+		ASSERT(previous->first + previous->second <= first);
+		if (previous->first + previous->second == first)
+		{
+			previous->second += count;
+			return;
+		}
+	}
+	m_free_blocks[first] = count;
+}
+
+void RangeAllocator::grow(unsigned int capacity)
+{
+	ASSERT(capacity > m_capacity);
+	unsigned int first = m_capacity;
+	unsigned int count = capacity - m_capacity;
+	m_capacity = capacity;
+	// Counted as used so that free merges the new tail like any released range
+	m_used += count;
+	free(first, count);
+}
+
+unsigned int RangeAllocator::largest_free_block() const
+{
+	unsigned int largest = 0;
+	for (const auto& [first, count] : m_free_blocks)
+	{
+		largest = std::max(largest, count);
+	}
+	return largest;
+}
+
+float GeometryArena::Report::vertex_fragmentation() const
+{
+	unsigned int num_free = vertex_capacity - num_vertices;
+	return num_free == 0 ? 0.0f : 1.0f - (float)largest_vertex_free_block / (float)num_free;
+}
+
+float GeometryArena::Report::index_fragmentation() const
+{
+	unsigned int num_free = index_capacity - num_indices;
+	return num_free == 0 ? 0.0f : 1.0f - (float)largest_index_free_block / (float)num_free;
+}
+
+unsigned int GeometryArena::Report::reserved_bytes() const
+{
+	return vertex_capacity * vertex_size + index_capacity * (unsigned int)sizeof(unsigned int);
+}
+
+unsigned int GeometryArena::Report::used_bytes() const
+{
+	return num_vertices * vertex_size + num_indices * (unsigned int)sizeof(unsigned int);
+}
+
+GeometryArena::GeometryArena(const VertexBufferLayout& layout, unsigned int vertex_capacity, unsigned int index_capacity)
+	: m_vertex_size(layout.stride()),
+	m_vertices(vertex_capacity),
+	m_indices(index_capacity),
+	m_num_growths(0)
+{
+	ASSERT(vertex_capacity > 0 && index_capacity > 0);
+	m_vertex_array = new VertexArray;
+	m_vertex_storage = new VertexBuffer;
+	m_vertex_storage->reallocate(nullptr, 0, vertex_capacity * m_vertex_size);
+	m_vertex_array->add_buffer(*m_vertex_storage, layout);
+	// The element buffer becomes part of the state of the vertex array
+	m_index_storage = new IndexBuffer;
+	// 32 bit slots, the ranges of 16 bit index buffers pack two indices per slot
+	m_index_storage->reallocate(nullptr, 0, index_capacity, IndexBuffer::s_restart_index - 1);
+	m_vertex_array->unbind();
+}
+
+GeometryArena::~GeometryArena()
+{
+	delete m_vertex_array;
+	delete m_vertex_storage;
+	delete m_index_storage;
+}
+
+/// <summary>
+/// Gives the buffer a larger storage and copies the old contents back into it,
+/// through a temporary buffer. The copy stays on the GPU.
+/// </summary>
+/// <param name="target">GL_COPY_READ_BUFFER or GL_COPY_WRITE_BUFFER, neither is part of the vertex array state</param>
+void GeometryArena::grow_storage(unsigned int target, unsigned int buffer_id, unsigned int old_size, unsigned int new_size)
+{
+	unsigned int other_target = (target == GL_COPY_READ_BUFFER) ? GL_COPY_WRITE_BUFFER : GL_COPY_READ_BUFFER;
+	unsigned int scratch_id;
+	__glCallVoid(glGenBuffers(1, &scratch_id));
+	__glCallVoid(glBindBuffer(target, buffer_id));
+	__glCallVoid(glBindBuffer(other_target, scratch_id));
+	__glCallVoid(glBufferData(other_target, old_size, nullptr, GL_STREAM_COPY));
+	__glCallVoid(glCopyBufferSubData(target, other_target, 0, 0, old_size));
+	__glCallVoid(glBufferData(target, new_size, nullptr, GL_DYNAMIC_DRAW));
+	__glCallVoid(glCopyBufferSubData(other_target, target, 0, 0, old_size));
+	__glCallVoid(glDeleteBuffers(1, &scratch_id));
+	m_num_growths++;
+}
+
+unsigned int GeometryArena::allocate_vertices(unsigned int count)
+{
+	unsigned int first = m_vertices.allocate(count);
+	if (first == RangeAllocator::s_invalid)
+	{
+		unsigned int capacity = m_vertices.capacity();
+		unsigned int new_capacity = std::max(2 * capacity, capacity + count);
+		grow_storage(GL_COPY_READ_BUFFER, m_vertex_storage->id(), capacity * m_vertex_size, new_capacity * m_vertex_size);
+		m_vertices.grow(new_capacity);
+		first = m_vertices.allocate(count);
+	}
+	return first;
+}
+
+unsigned int GeometryArena::allocate_indices(unsigned int count)
+{
+	unsigned int first = m_indices.allocate(count);
+	if (first == RangeAllocator::s_invalid)
+	{
+		unsigned int capacity = m_indices.capacity();
+		unsigned int new_capacity = std::max(2 * capacity, capacity + count);
+		grow_storage(GL_COPY_WRITE_BUFFER, m_index_storage->id(),
+			capacity * sizeof(unsigned int), new_capacity * sizeof(unsigned int));
+		m_indices.grow(new_capacity);
+		first = m_indices.allocate(count);
+	}
+	return first;
+}
+
+void GeometryArena::free_vertices(unsigned int first, unsigned int count)
+{
+	m_vertices.free(first, count);
+}
+
+void GeometryArena::free_indices(unsigned int first, unsigned int count)
+{
+	m_indices.free(first, count);
+}
+
+void GeometryArena::upload_vertices(const void* data, unsigned int offset, unsigned int size)
+{
+	ASSERT(offset + size <= m_vertices.capacity() * m_vertex_size);
+	__glCallVoid(glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertex_storage->id()));
+	__glCallVoid(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+}
+
+void GeometryArena::upload_indices(const void* data, unsigned int offset, unsigned int size)
+{
+	ASSERT(offset + size <= m_indices.capacity() * sizeof(unsigned int));
+	__glCallVoid(glBindBuffer(GL_COPY_WRITE_BUFFER, m_index_storage->id()));
+	__glCallVoid(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+}
+
+GeometryArena::Report GeometryArena::report() const
+{
+	Report report;
+	report.vertex_size = m_vertex_size;
+	report.vertex_capacity = m_vertices.capacity();
+	report.num_vertices = m_vertices.used();
+	report.num_vertex_free_blocks = m_vertices.num_free_blocks();
+	report.largest_vertex_free_block = m_vertices.largest_free_block();
+	report.index_capacity = m_indices.capacity();
+	report.num_indices = m_indices.used();
+	report.num_index_free_blocks = m_indices.num_free_blocks();
+	report.largest_index_free_block = m_indices.largest_free_block();
+	report.num_growths = m_num_growths;
+	return report;
+}
@@ -1,32 +1,253 @@
 #include "Renderer/IndexBuffer.h"
 #include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/GeometryArena.h"
 #include <glew.h>
+#include <cstdint>
+#include <algorithm>
 
-IndexBuffer::IndexBuffer() : m_count(0)
+/// <summary>
+/// Largest index of the data, the restart markers excluded
+/// </summary>
+static unsigned int max_index_of(const unsigned int* data, unsigned int count)
+{
+	unsigned int max_index = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (data[i] != IndexBuffer::s_restart_index && data[i] > max_index)
+		{
+			max_index = data[i];
+		}
+	}
+	return max_index;
+}
+
+// Arena ranges are counted in 32 bit slots
+static unsigned int slots_for(unsigned int count, unsigned int index_type)
+{
+	return (count * IndexBuffer::size_of_type(index_type) + sizeof(unsigned int) - 1) / sizeof(unsigned int);
+}
+
+unsigned int IndexBuffer::type_for(unsigned int max_index)
+{
+	// 0xFFFF is the restart value of 16 bit indices
+	return (max_index < 0xFFFF) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+unsigned int IndexBuffer::size_of_type(unsigned int index_type)
+{
+	switch (index_type)
+	{
+	case GL_UNSIGNED_SHORT:	return sizeof(uint16_t);
+	case GL_UNSIGNED_INT:	return sizeof(uint32_t);
+	}
+	ASSERT(false);
+	return 0;
+}
+
+unsigned int IndexBuffer::restart_index_of(unsigned int index_type)
+{
+	return (index_type == GL_UNSIGNED_SHORT) ? 0xFFFF : 0xFFFFFFFF;
+}
+
+void IndexBuffer::grid_triangle_strips(unsigned int num_rows, unsigned int num_columns, std::vector<unsigned int>& strips)
+{
+	strips.clear();
+	if (num_rows < 2 || num_columns < 2)
+	{
+		return;
+	}
+	strips.reserve((num_rows - 1) * (2 * num_columns + 1));
+	for (unsigned int i = 0; i < num_rows - 1; i++)
+	{
+		if (i > 0)
+		{
+			strips.emplace_back(s_restart_index);
+		}
+		for (unsigned int j = 0; j < num_columns; j++)
+		{
+			strips.emplace_back(i * num_columns + j);
+			strips.emplace_back((i + 1) * num_columns + j);
+		}
+	}
+}
+
+IndexBuffer::IndexBuffer()
+	: m_count(0),
+	m_capacity(0),
+	m_index_type(GL_UNSIGNED_SHORT),
+	m_arena(nullptr),
+	m_first_slot(0),
+	m_num_slots(0),
+	m_base_vertex(0)
 {
 	__glCallVoid(glGenBuffers(1, &m_index_buffer_id));
 }
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
-	: m_count(count)
+	: m_count(0),
+	m_capacity(0),
+	m_index_type(GL_UNSIGNED_SHORT),
+	m_arena(nullptr),
+	m_first_slot(0),
+	m_num_slots(0),
+	m_base_vertex(0)
 {
 	ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 	__glCallVoid(glGenBuffers(1, &m_index_buffer_id));
-	__glCallVoid(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer_id));
-	__glCallVoid(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+	m_index_type = type_for(max_index_of(data, count));
+	m_count = count;
+	m_capacity = count;
+	RenderState::bind_element_buffer(m_index_buffer_id);
+	__glCallVoid(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * index_size(), nullptr, GL_STATIC_DRAW));
+	upload(data, 0, count);
+}
+
+IndexBuffer::IndexBuffer(GeometryArena& arena, int base_vertex)
+	: m_index_buffer_id(arena.index_buffer_id()),
+	m_count(0),
+	m_capacity(0),
+	m_index_type(GL_UNSIGNED_SHORT),
+	m_arena(&arena),
+	m_first_slot(0),
+	m_num_slots(0),
+	m_base_vertex(base_vertex)
+{
 }
 
 IndexBuffer::~IndexBuffer()
 {
+	if (m_arena)
+	{
+		if (m_num_slots > 0)
+		{
+			m_arena->free_indices(m_first_slot, m_num_slots);
+		}
+		return;
+	}
+	RenderState::on_delete_buffer(m_index_buffer_id);
 	__glCallVoid(glDeleteBuffers(1, &m_index_buffer_id));
 }
 
 void IndexBuffer::bind() const
 {
-	__glCallVoid(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer_id));
+	RenderState::bind_element_buffer(m_index_buffer_id);
 }
 
 void IndexBuffer::unbind() const
 {
-	__glCallVoid(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+	RenderState::bind_element_buffer(0);
+}
+
+/// <summary>
+/// Converts count indices to the type of the buffer and writes them from the given index on
+/// </summary>
+void IndexBuffer::upload(const unsigned int* data, unsigned int first, unsigned int count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	const void* src = data;
+	std::vector<uint16_t> narrow;
+	if (m_index_type == GL_UNSIGNED_SHORT)
+	{
+		narrow.resize(count);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			ASSERT(data[i] == s_restart_index || data[i] < 0xFFFF);
+			narrow[i] = (data[i] == s_restart_index) ? (uint16_t)0xFFFF : (uint16_t)data[i];
+		}
+		src = narrow.data();
+	}
+	unsigned int offset = (unsigned int)(uintptr_t)offset_of(first);
+	unsigned int size = count * index_size();
+	if (m_arena)
+	{
+		m_arena->upload_indices(src, offset, size);
+		return;
+	}
+	RenderState::bind_element_buffer(m_index_buffer_id);
+	__glCallVoid(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, src));
+}
+
+/// <summary>
+/// Replaces the whole storage of the buffer, meant for
+/// buffers that are refilled every frame. The type follows the new data.
+/// </summary>
+/// <param name="data"></param>
+/// <param name="count">number of indices</param>
+void IndexBuffer::set_data(const unsigned int* data, unsigned int count)
+{
+	unsigned int index_type = type_for(max_index_of(data, count));
+	if (m_arena)
+	{
+		// Ranges keep their slots, only a larger data moves them
+		if (count * size_of_type(index_type) > m_num_slots * sizeof(unsigned int))
+		{
+			reallocate(data, count, count);
+		}
+		else
+		{
+			m_index_type = index_type;
+			m_capacity = m_num_slots * sizeof(unsigned int) / index_size();
+			upload(data, 0, count);
+			m_count = count;
+		}
+		return;
+	}
+	m_index_type = index_type;
+	m_count = count;
+	m_capacity = count;
+	RenderState::bind_element_buffer(m_index_buffer_id);
+	__glCallVoid(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * index_size(), nullptr, GL_STREAM_DRAW));
+	upload(data, 0, count);
+}
+
+/// <summary>
+/// Allocates a new storage for capacity indices, and fills its beginning with data.
+/// A range of an arena is moved to a new range.
+/// </summary>
+/// <param name="data"></param>
+/// <param name="count">number of indices in data</param>
+/// <param name="capacity">number of indices</param>
+/// <param name="max_index">largest index the buffer has to hold, beyond the ones of data</param>
+void IndexBuffer::reallocate(const unsigned int* data, unsigned int count, unsigned int capacity, unsigned int max_index)
+{
+	ASSERT(count <= capacity);
+	m_index_type = type_for(std::max(max_index, max_index_of(data, count)));
+	m_count = count;
+	m_capacity = capacity;
+	if (m_arena)
+	{
+		if (m_num_slots > 0)
+		{
+			m_arena->free_indices(m_first_slot, m_num_slots);
+		}
+		m_num_slots = slots_for(capacity, m_index_type);
+		m_first_slot = (m_num_slots > 0) ? m_arena->allocate_indices(m_num_slots) : 0;
+		upload(data, 0, count);
+		return;
+	}
+	RenderState::bind_element_buffer(m_index_buffer_id);
+	__glCallVoid(glBufferData(GL_ELEMENT_ARRAY_BUFFER, capacity * index_size(), nullptr, GL_DYNAMIC_DRAW));
+	upload(data, 0, count);
+}
+
+/// <summary>
+/// Overwrites count indices starting from first, the count of the
+/// buffer grows if the range goes past the current count.
+/// The indices must fit the current type, see reallocate.
+/// </summary>
+/// <param name="data"></param>
+/// <param name="first"></param>
+/// <param name="count"></param>
+void IndexBuffer::update(const unsigned int* data, unsigned int first, unsigned int count)
+{
+	ASSERT(first + count <= m_capacity);
+	if (first + count > m_count)
+	{
+		m_count = first + count;
+	}
+	upload(data, first, count);
 }
@@ -0,0 +1,47 @@
+#include "Renderer/InstanceBatch.h"
+#include "Core/ErrorManager.h"
+#include <glew.h>
+
+InstanceBatch::InstanceBatch(const VertexBuffer& vertex_buffer,
+	const VertexBufferLayout& vertex_layout,
+	const IndexBuffer& index_buffer,
+	const VertexBufferLayout& instance_layout,
+	unsigned int first_instance_attribute)
+	: m_index_buffer(&index_buffer),
+	m_num_instances(0)
+{
+	ASSERT(instance_layout.stride() % sizeof(float) == 0);
+	m_floats_per_instance = instance_layout.stride() / sizeof(float);
+	m_vertex_array = new VertexArray;
+	m_instance_buffer = new VertexBuffer;
+	m_vertex_array->add_buffer(vertex_buffer, vertex_layout);
+	m_vertex_array->add_instance_buffer(*m_instance_buffer, instance_layout, first_instance_attribute);
+	index_buffer.bind();
+	m_vertex_array->unbind();
+}
+
+InstanceBatch::~InstanceBatch()
+{
+	delete m_vertex_array;
+	delete m_instance_buffer;
+}
+
+void InstanceBatch::clear()
+{
+	m_instance_data.clear();
+	m_num_instances = 0;
+}
+
+void InstanceBatch::push_instance(const float* data)
+{
+	m_instance_data.insert(m_instance_data.end(), data, data + m_floats_per_instance);
+	m_num_instances++;
+}
+
+/// <summary>
+/// Streams the collected instances to the GPU, must be called before drawing
+/// </summary>
+void InstanceBatch::upload()
+{
+	m_instance_buffer->set_data(m_instance_data.data(), (unsigned int)(m_instance_data.size() * sizeof(float)));
+}
@@ -0,0 +1,112 @@
+#include "Renderer/PixelReadback.h"
+#include "Renderer/FrameBuffer.h"
+#include "Core/ErrorManager.h"
+#include <glew.h>
+#include <array>
+#include <cstring>
+
+PixelReadback::PixelReadback(unsigned int num_buffers)
+	: m_next_slot(0),
+	m_num_pending(0),
+	m_stats({ 0, 0 })
+{
+	// One buffer would make every collect wait for the read right before it
+	ASSERT(num_buffers >= 2);
+	m_slots.resize(num_buffers);
+	for (Slot& slot : m_slots)
+	{
+		__glCallVoid(glGenBuffers(1, &slot.buffer_id));
+		slot.capacity = 0;
+		slot.sync = nullptr;
+		slot.width = 0;
+		slot.height = 0;
+		slot.tag = 0;
+	}
+}
+
+PixelReadback::~PixelReadback()
+{
+	for (Slot& slot : m_slots)
+	{
+		if (slot.sync != nullptr)
+		{
+			__glCallVoid(glDeleteSync(slot.sync));
+		}
+		__glCallVoid(glDeleteBuffers(1, &slot.buffer_id));
+	}
+}
+
+void PixelReadback::read(FrameBuffer& frame_buffer, uint64_t tag)
+{
+	ASSERT(!full());
+	ASSERT(frame_buffer.color_format() == FrameBuffer::ColorFormat::RGBA);
+	std::array<int, 2> size = frame_buffer.viewport_size();
+	Slot& slot = m_slots[m_next_slot];
+	unsigned int num_bytes = (unsigned int)size[0] * (unsigned int)size[1] * 4;
+
+	__glCallVoid(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id));
+	if (slot.capacity < num_bytes)
+	{
+		__glCallVoid(glBufferData(GL_PIXEL_PACK_BUFFER, num_bytes, nullptr, GL_STREAM_READ));
+		slot.capacity = num_bytes;
+	}
+	frame_buffer.bind();
+	__glCallVoid(glReadBuffer(GL_COLOR_ATTACHMENT0));
+	// With a pack buffer bound, the last argument is an offset into it and the call returns right away
+	__glCallVoid(glReadPixels(0, 0, size[0], size[1], GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	__glCallReturn(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), slot.sync);
+	// Otherwise later glReadPixels calls, like the picking of FrameBuffer, would write into the buffer
+	__glCallVoid(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	// Submits the copy, a fence that is polled without flushing may never signal
+	__glCallVoid(glFlush());
+
+	slot.width = size[0];
+	slot.height = size[1];
+	slot.tag = tag;
+	m_next_slot = (m_next_slot + 1) % (unsigned int)m_slots.size();
+	m_num_pending++;
+	m_stats.num_reads++;
+}
+
+bool PixelReadback::collect(Image& image, bool wait)
+{
+	if (m_num_pending == 0)
+	{
+		return false;
+	}
+	unsigned int num_slots = (unsigned int)m_slots.size();
+	Slot& slot = m_slots[(m_next_slot + num_slots - m_num_pending) % num_slots];
+
+	GLenum status;
+	__glCallReturn(glClientWaitSync(slot.sync, 0, 0), status);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		if (!wait)
+		{
+			return false;
+		}
+		m_stats.num_stalls++;
+		do
+		{
+			__glCallReturn(glClientWaitSync(slot.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000), status);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		ASSERT(status != GL_WAIT_FAILED);
+	}
+	__glCallVoid(glDeleteSync(slot.sync));
+	slot.sync = nullptr;
+
+	unsigned int num_bytes = (unsigned int)slot.width * (unsigned int)slot.height * 4;
+	image.width = slot.width;
+	image.height = slot.height;
+	image.tag = slot.tag;
+	image.pixels.resize(num_bytes);
+	__glCallVoid(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id));
+	void* src;
+	__glCallReturn(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, num_bytes, GL_MAP_READ_BIT), src);
+	ASSERT(src != nullptr);
+	std::memcpy(image.pixels.data(), src, num_bytes);
+	__glCallVoid(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	__glCallVoid(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	m_num_pending--;
+	return true;
+}
@@ -0,0 +1,310 @@
+#include "Renderer/RenderQueue.h"
+#include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
+#include <glew.h>
+#include <cstring>
+#include <algorithm>
+
+RenderQueue::RenderQueue()
+	: m_sequence(0),
+	m_last_stats({ 0, 0, 0, 0, 0 })
+{
+}
+
+RenderQueue& RenderQueue::immediate()
+{
+	static RenderQueue queue;
+	return queue;
+}
+
+/// <summary>
+/// Distances are quantized through their float bits, which are ordered
+/// like the distances themselves for non negative values
+/// </summary>
+static inline uint64_t quantize_depth(float depth, uint32_t num_bits)
+{
+	depth = std::max(depth, 0.0f);
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits >> (32 - num_bits);
+}
+
+uint64_t RenderQueue::sort_key(const DrawCommand& draw)
+{
+	const uint64_t depth_mask = (1ull << s_depth_bits) - 1;
+	uint64_t shader = draw.shader ? (draw.shader->id() & 0x3FF) : 0;
+	uint64_t texture = draw.texture ? (draw.texture->id() & 0x3FF) : 0;
+	uint64_t vertex_array = draw.vertex_array ? (draw.vertex_array->id() & 0xFFF) : 0;
+	uint64_t state = (shader << 22) | (texture << 12) | vertex_array;
+
+	uint64_t key = (uint64_t)draw.layer << 62;
+	if (draw.layer != Layer::Scene)
+	{
+		// Painter's order, the sequence wraps only after 16M submissions
+		key |= (uint64_t)(m_sequence++ & depth_mask) << 37;
+		key |= state << 5;
+	}
+	else if (draw.translucent)
+	{
+		key |= 1ull << 61;
+		key |= (depth_mask - quantize_depth(draw.depth, s_depth_bits)) << 37;
+		key |= state << 5;
+	}
+	else
+	{
+		key |= state << 29;
+		key |= quantize_depth(draw.depth, s_depth_bits) << 5;
+	}
+	return key;
+}
+
+void RenderQueue::submit(const DrawCommand& draw)
+{
+	ASSERT(draw.shader != nullptr && draw.vertex_array != nullptr && draw.index_buffer != nullptr);
+	m_commands.push_back({ draw, (unsigned int)m_uniforms.size(), 0 });
+	m_keys.push_back(sort_key(draw));
+}
+
+RenderQueue::Uniform& RenderQueue::push_uniform(unsigned int index, UniformType type)
+{
+	ASSERT(!m_commands.empty());
+	m_commands.back().num_uniforms++;
+	Uniform& uniform = m_uniforms.emplace_back();
+	uniform.index = index;
+	uniform.type = type;
+	return uniform;
+}
+
+void RenderQueue::uniform_1i(const ShaderUniform<int>& uniform, int value)
+{
+	push_uniform(uniform.index(), UniformType::Int).i = value;
+}
+
+void RenderQueue::uniform_1f(const ShaderUniform<float>& uniform, float value)
+{
+	push_uniform(uniform.index(), UniformType::Float).f[0] = value;
+}
+
+void RenderQueue::uniform_4f(const ShaderUniform<Angel::vec4>& handle, const Angel::vec4& value)
+{
+	Uniform& uniform = push_uniform(handle.index(), UniformType::Vec4);
+	for (int i = 0; i < 4; i++)
+	{
+		uniform.f[i] = value[i];
+	}
+}
+
+void RenderQueue::uniform_mat4f(const ShaderUniform<Angel::mat4>& handle, const Angel::mat4& value)
+{
+	Uniform& uniform = push_uniform(handle.index(), UniformType::Mat4);
+	for (int row = 0; row < 4; row++)
+	{
+		for (int col = 0; col < 4; col++)
+		{
+			uniform.f[row * 4 + col] = value[row][col];
+		}
+	}
+}
+
+/// <summary>
+/// LSD radix sort of the command indices on the keys, one byte per pass.
+/// Passes over bytes that are equal in every key are skipped, which is
+/// the common case for the unused layers and the low bits.
+/// </summary>
+void RenderQueue::radix_sort()
+{
+	uint32_t n = (uint32_t)m_keys.size();
+	m_order.resize(n);
+	m_order_scratch.resize(n);
+	for (uint32_t i = 0; i < n; i++)
+	{
+		m_order[i] = i;
+	}
+	uint32_t counts[256];
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		std::memset(counts, 0, sizeof(counts));
+		for (uint32_t i = 0; i < n; i++)
+		{
+			counts[(m_keys[i] >> shift) & 0xFF]++;
+		}
+		if (counts[(m_keys[0] >> shift) & 0xFF] == n)
+		{
+			continue;
+		}
+		uint32_t offset = 0;
+		for (uint32_t& count : counts)
+		{
+			uint32_t c = count;
+			count = offset;
+			offset += c;
+		}
+		for (uint32_t index : m_order)
+		{
+			m_order_scratch[counts[(m_keys[index] >> shift) & 0xFF]++] = index;
+		}
+		m_order.swap(m_order_scratch);
+	}
+}
+
+void RenderQueue::apply_state(const Command& command)
+{
+	const DrawCommand& draw = command.draw;
+	Shader* shader = draw.shader;
+	shader->bind();
+	for (unsigned int i = command.first_uniform; i < command.first_uniform + command.num_uniforms; i++)
+	{
+		const Uniform& uniform = m_uniforms[i];
+		switch (uniform.type)
+		{
+		case UniformType::Int:
+			shader->set_uniform(ShaderUniform<int>::from_index(uniform.index), uniform.i);
+			break;
+		case UniformType::Float:
+			shader->set_uniform(ShaderUniform<float>::from_index(uniform.index), uniform.f[0]);
+			break;
+		case UniformType::Vec4:
+			shader->set_uniform(ShaderUniform<Angel::vec4>::from_index(uniform.index),
+				Angel::vec4(uniform.f[0], uniform.f[1], uniform.f[2], uniform.f[3]));
+			break;
+		case UniformType::Mat4:
+			shader->set_uniform(ShaderUniform<Angel::mat4>::from_index(uniform.index), Angel::mat4(
+				uniform.f[0], uniform.f[4], uniform.f[8], uniform.f[12],
+				uniform.f[1], uniform.f[5], uniform.f[9], uniform.f[13],
+				uniform.f[2], uniform.f[6], uniform.f[10], uniform.f[14],
+				uniform.f[3], uniform.f[7], uniform.f[11], uniform.f[15]));
+			break;
+		}
+	}
+	if (draw.texture)
+	{
+		draw.texture->bind(draw.texture_slot);
+	}
+	draw.vertex_array->bind();
+	draw.index_buffer->bind();
+}
+
+static GLenum gl_primitive(RenderQueue::Primitive primitive)
+{
+	switch (primitive)
+	{
+	case RenderQueue::Primitive::TriangleStrip:	return GL_TRIANGLE_STRIP;
+	case RenderQueue::Primitive::Lines:		return GL_LINES;
+	case RenderQueue::Primitive::LineStrip:	return GL_LINE_STRIP;
+	case RenderQueue::Primitive::LineLoop:	return GL_LINE_LOOP;
+	case RenderQueue::Primitive::Points:	return GL_POINTS;
+	default:								return GL_TRIANGLES;
+	}
+}
+
+/// <summary>
+/// Whether the second command can be drawn in the same multi draw as the first one.
+/// GL 3.3 has no per draw index in the shaders, so the uniforms must be the same too
+/// and only the index ranges and base vertices of the commands may differ.
+/// </summary>
+bool RenderQueue::can_merge(const Command& first, const Command& second) const
+{
+	const DrawCommand& a = first.draw;
+	const DrawCommand& b = second.draw;
+	if (a.shader != b.shader || a.texture != b.texture || a.texture_slot != b.texture_slot
+		|| a.vertex_array != b.vertex_array || a.index_buffer->id() != b.index_buffer->id()
+		|| a.index_buffer->index_type() != b.index_buffer->index_type()
+		|| a.primitive != b.primitive || first.num_uniforms != second.num_uniforms)
+	{
+		return false;
+	}
+	for (unsigned int i = 0; i < first.num_uniforms; i++)
+	{
+		const Uniform& u = m_uniforms[first.first_uniform + i];
+		const Uniform& v = m_uniforms[second.first_uniform + i];
+		if (u.index != v.index || u.type != v.type || u.i != v.i || std::memcmp(u.f, v.f, sizeof(u.f)) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Draws the commands of m_order in [begin, end), which share their state.
+/// A run of one command is a plain draw, longer runs are one glMultiDrawElementsBaseVertex.
+/// The index type is the same for the whole run, see can_merge.
+/// </summary>
+void RenderQueue::execute(uint32_t begin, uint32_t end)
+{
+	apply_state(m_commands[m_order[begin]]);
+	GLenum mode = gl_primitive(m_commands[m_order[begin]].draw.primitive);
+	const IndexBuffer* first_index_buffer = m_commands[m_order[begin]].draw.index_buffer;
+	GLenum index_type = first_index_buffer->index_type();
+	m_multi_counts.clear();
+	m_multi_offsets.clear();
+	m_multi_base_vertices.clear();
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const DrawCommand& draw = m_commands[m_order[i]].draw;
+		unsigned int count = (draw.count == -1) ? draw.index_buffer->count() : (unsigned int)draw.count;
+		m_multi_counts.push_back((int)count);
+		m_multi_offsets.push_back(draw.index_buffer->offset_of(draw.first_index));
+		m_multi_base_vertices.push_back(draw.index_buffer->base_vertex());
+	}
+	if (mode == GL_TRIANGLE_STRIP)
+	{
+		RenderState::set_primitive_restart(true, first_index_buffer->restart_index());
+	}
+	if (end - begin == 1)
+	{
+		__glCallVoid(glDrawElementsBaseVertex(mode, m_multi_counts[0], index_type,
+			(void*)m_multi_offsets[0], m_multi_base_vertices[0]));
+	}
+	else
+	{
+		__glCallVoid(glMultiDrawElementsBaseVertex(mode, m_multi_counts.data(), index_type,
+			(void**)m_multi_offsets.data(), (GLsizei)(end - begin), m_multi_base_vertices.data()));
+	}
+	if (mode == GL_TRIANGLE_STRIP)
+	{
+		RenderState::set_primitive_restart(false);
+	}
+}
+
+void RenderQueue::flush()
+{
+	Stats stats = { (unsigned int)m_commands.size(), 0, 0, 0, 0 };
+	if (!m_commands.empty())
+	{
+		radix_sort();
+		const Shader* last_shader = nullptr;
+		const Texture* last_texture = nullptr;
+		const VertexArray* last_vertex_array = nullptr;
+		uint32_t n = (uint32_t)m_order.size();
+		for (uint32_t begin = 0; begin < n; )
+		{
+			const Command& command = m_commands[m_order[begin]];
+			uint32_t end = begin + 1;
+			while (end < n && can_merge(command, m_commands[m_order[end]]))
+			{
+				end++;
+			}
+			const DrawCommand& draw = command.draw;
+			stats.num_shader_changes += draw.shader != last_shader;
+			stats.num_texture_changes += draw.texture != nullptr && draw.texture != last_texture;
+			stats.num_vertex_array_changes += draw.vertex_array != last_vertex_array;
+			stats.num_draw_calls++;
+			last_shader = draw.shader;
+			last_texture = draw.texture ? draw.texture : last_texture;
+			last_vertex_array = draw.vertex_array;
+			execute(begin, end);
+			begin = end;
+		}
+	}
+	m_last_stats = stats;
+	clear();
+}
+
+void RenderQueue::clear()
+{
+	m_commands.clear();
+	m_uniforms.clear();
+	m_keys.clear();
+	m_sequence = 0;
+}
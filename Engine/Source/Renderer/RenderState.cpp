@@ -0,0 +1,299 @@
+#include "Renderer/RenderState.h"
+#include "Core/ErrorManager.h"
+#include <glew.h>
+#include <unordered_map>
+
+unsigned int RenderState::s_program = RenderState::s_unknown;
+unsigned int RenderState::s_vertex_array = RenderState::s_unknown;
+unsigned int RenderState::s_array_buffer = RenderState::s_unknown;
+unsigned int RenderState::s_active_texture_unit = RenderState::s_unknown;
+unsigned int RenderState::s_textures[RenderState::s_max_texture_units];
+int RenderState::s_blend = -1;
+int RenderState::s_depth_test = -1;
+int RenderState::s_primitive_restart = -1;
+long long RenderState::s_primitive_restart_index = -1;
+unsigned int RenderState::s_blend_src = RenderState::s_unknown;
+unsigned int RenderState::s_blend_dst = RenderState::s_unknown;
+unsigned int RenderState::s_depth_func = RenderState::s_unknown;
+RenderState::Counters RenderState::s_frame_counters = { 0, 0 };
+RenderState::Counters RenderState::s_last_frame_counters = { 0, 0 };
+
+// Element buffer bound to each vertex array, missing while unknown
+static std::unordered_map<unsigned int, unsigned int> s_element_buffers;
+
+// The texture bindings cannot be listed in the initializer above, start from a fully unknown state
+static const bool s_initial_state_unknown = []()
+{
+	RenderState::invalidate();
+	return true;
+}();
+
+/// <summary>
+/// Updates the cached value and counts the request
+/// </summary>
+/// <returns>true if GL has to be called</returns>
+bool RenderState::changes(unsigned int& cached, unsigned int value)
+{
+	if (cached == value)
+	{
+		s_frame_counters.num_elided_binds++;
+		return false;
+	}
+	cached = value;
+	s_frame_counters.num_binds++;
+	return true;
+}
+
+unsigned int& RenderState::element_buffer_of_current_vertex_array()
+{
+	auto it = s_element_buffers.find(s_vertex_array);
+	if (it == s_element_buffers.end())
+	{
+		it = s_element_buffers.emplace(s_vertex_array, s_unknown).first;
+	}
+	return it->second;
+}
+
+void RenderState::use_program(unsigned int program_id)
+{
+	if (changes(s_program, program_id))
+	{
+		__glCallVoid(glUseProgram(program_id));
+	}
+}
+
+void RenderState::bind_vertex_array(unsigned int vertex_array_id)
+{
+	if (changes(s_vertex_array, vertex_array_id))
+	{
+		__glCallVoid(glBindVertexArray(vertex_array_id));
+	}
+}
+
+void RenderState::bind_element_buffer(unsigned int buffer_id)
+{
+	if (s_vertex_array == s_unknown)
+	{
+		// The element buffer would be recorded for the wrong vertex array
+		s_frame_counters.num_binds++;
+		__glCallVoid(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_id));
+		return;
+	}
+	if (changes(element_buffer_of_current_vertex_array(), buffer_id))
+	{
+		__glCallVoid(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_id));
+	}
+}
+
+void RenderState::bind_array_buffer(unsigned int buffer_id)
+{
+	if (changes(s_array_buffer, buffer_id))
+	{
+		__glCallVoid(glBindBuffer(GL_ARRAY_BUFFER, buffer_id));
+	}
+}
+
+/// <summary>
+/// Binds a 2D texture to the active texture unit
+/// </summary>
+void RenderState::bind_texture(unsigned int texture_id)
+{
+	if (s_active_texture_unit >= s_max_texture_units)
+	{
+		s_frame_counters.num_binds++;
+		__glCallVoid(glBindTexture(GL_TEXTURE_2D, texture_id));
+		return;
+	}
+	if (changes(s_textures[s_active_texture_unit], texture_id))
+	{
+		__glCallVoid(glBindTexture(GL_TEXTURE_2D, texture_id));
+	}
+}
+
+void RenderState::bind_texture(unsigned int unit, unsigned int texture_id)
+{
+	ASSERT(unit < s_max_texture_units);
+	if (s_textures[unit] == texture_id && s_active_texture_unit == unit)
+	{
+		s_frame_counters.num_elided_binds++;
+		return;
+	}
+	if (s_textures[unit] == texture_id)
+	{
+		// Only the unit has to be selected, the texture is already bound to it.
+		// The unit is still changed, since the caller may modify the texture afterwards.
+		s_active_texture_unit = unit;
+		s_frame_counters.num_binds++;
+		__glCallVoid(glActiveTexture(GL_TEXTURE0 + unit));
+		return;
+	}
+	if (changes(s_active_texture_unit, unit))
+	{
+		__glCallVoid(glActiveTexture(GL_TEXTURE0 + unit));
+	}
+	bind_texture(texture_id);
+}
+
+void RenderState::set_blend(bool enabled)
+{
+	if (s_blend == (int)enabled)
+	{
+		s_frame_counters.num_elided_binds++;
+		return;
+	}
+	s_blend = (int)enabled;
+	s_frame_counters.num_binds++;
+	if (enabled)
+	{
+		__glCallVoid(glEnable(GL_BLEND));
+	}
+	else
+	{
+		__glCallVoid(glDisable(GL_BLEND));
+	}
+}
+
+void RenderState::set_blend_func(unsigned int src, unsigned int dst)
+{
+	if (s_blend_src == src && s_blend_dst == dst)
+	{
+		s_frame_counters.num_elided_binds++;
+		return;
+	}
+	s_blend_src = src;
+	s_blend_dst = dst;
+	s_frame_counters.num_binds++;
+	__glCallVoid(glBlendFunc(src, dst));
+}
+
+void RenderState::set_depth_test(bool enabled)
+{
+	if (s_depth_test == (int)enabled)
+	{
+		s_frame_counters.num_elided_binds++;
+		return;
+	}
+	s_depth_test = (int)enabled;
+	s_frame_counters.num_binds++;
+	if (enabled)
+	{
+		__glCallVoid(glEnable(GL_DEPTH_TEST));
+	}
+	else
+	{
+		__glCallVoid(glDisable(GL_DEPTH_TEST));
+	}
+}
+
+void RenderState::set_depth_func(unsigned int func)
+{
+	if (changes(s_depth_func, func))
+	{
+		__glCallVoid(glDepthFunc(func));
+	}
+}
+
+void RenderState::set_primitive_restart(bool enabled, unsigned int index)
+{
+	if (s_primitive_restart != (int)enabled)
+	{
+		s_primitive_restart = (int)enabled;
+		s_frame_counters.num_binds++;
+		if (enabled)
+		{
+			__glCallVoid(glEnable(GL_PRIMITIVE_RESTART));
+		}
+		else
+		{
+			__glCallVoid(glDisable(GL_PRIMITIVE_RESTART));
+		}
+	}
+	else
+	{
+		s_frame_counters.num_elided_binds++;
+	}
+	if (enabled)
+	{
+		if (s_primitive_restart_index == (long long)index)
+		{
+			s_frame_counters.num_elided_binds++;
+			return;
+		}
+		s_primitive_restart_index = (long long)index;
+		s_frame_counters.num_binds++;
+		__glCallVoid(glPrimitiveRestartIndex(index));
+	}
+}
+
+void RenderState::on_delete_program(unsigned int program_id)
+{
+	// A deleted program stays in use until another one is bound, but its name may be
+	// reused by a new program, which must not be mistaken for the bound one
+	if (s_program == program_id)
+	{
+		s_program = s_unknown;
+	}
+}
+
+void RenderState::on_delete_vertex_array(unsigned int vertex_array_id)
+{
+	if (s_vertex_array == vertex_array_id)
+	{
+		s_vertex_array = 0;
+	}
+	s_element_buffers.erase(vertex_array_id);
+}
+
+void RenderState::on_delete_buffer(unsigned int buffer_id)
+{
+	if (s_array_buffer == buffer_id)
+	{
+		s_array_buffer = 0;
+	}
+	// Only the binding of the current vertex array is reset by GL, the other
+	// vertex arrays keep referring to the name, so forget them as well
+	for (auto& [vertex_array_id, element_buffer_id] : s_element_buffers)
+	{
+		if (element_buffer_id == buffer_id)
+		{
+			element_buffer_id = (vertex_array_id == s_vertex_array) ? 0 : s_unknown;
+		}
+	}
+}
+
+void RenderState::on_delete_texture(unsigned int texture_id)
+{
+	for (unsigned int& bound_texture_id : s_textures)
+	{
+		if (bound_texture_id == texture_id)
+		{
+			bound_texture_id = 0;
+		}
+	}
+}
+
+void RenderState::invalidate()
+{
+	s_program = s_unknown;
+	s_vertex_array = s_unknown;
+	s_array_buffer = s_unknown;
+	s_active_texture_unit = s_unknown;
+	for (unsigned int& texture_id : s_textures)
+	{
+		texture_id = s_unknown;
+	}
+	s_blend = -1;
+	s_depth_test = -1;
+	s_primitive_restart = -1;
+	s_primitive_restart_index = -1;
+	s_blend_src = s_unknown;
+	s_blend_dst = s_unknown;
+	s_depth_func = s_unknown;
+	s_element_buffers.clear();
+}
+
+void RenderState::begin_frame()
+{
+	s_last_frame_counters = s_frame_counters;
+	s_frame_counters = { 0, 0 };
+}
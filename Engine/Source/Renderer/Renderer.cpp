@@ -1,7 +1,9 @@
 #include "Renderer/Renderer.h"
 #include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
 #include <glew.h>
 #include <glfw3.h>
+#include <cstdint>
 
 void Renderer::draw_triangles(const VertexArray* vertex_array_obj,
 	const IndexBuffer* index_buffer_obj,
@@ -10,15 +12,33 @@ void Renderer::draw_triangles(const VertexArray* vertex_array_obj,
 	shader_obj->bind();
 	vertex_array_obj->bind();
 	index_buffer_obj->bind();
-	__glCallVoid(glDrawElements(GL_TRIANGLES, index_buffer_obj->count(), GL_UNSIGNED_INT, nullptr));
+	__glCallVoid(glDrawElementsBaseVertex(GL_TRIANGLES, index_buffer_obj->count(), index_buffer_obj->index_type(),
+		(void*)index_buffer_obj->offset_of(0), index_buffer_obj->base_vertex()));
 }
 
+void Renderer::draw_triangle_strips(const VertexArray* vertex_array_obj,
+	const IndexBuffer* index_buffer_obj,
+	const Shader* shader_obj)
+{
+	shader_obj->bind();
+	vertex_array_obj->bind();
+	index_buffer_obj->bind();
+	RenderState::set_primitive_restart(true, index_buffer_obj->restart_index());
+	__glCallVoid(glDrawElementsBaseVertex(GL_TRIANGLE_STRIP, index_buffer_obj->count(), index_buffer_obj->index_type(),
+		(void*)index_buffer_obj->offset_of(0), index_buffer_obj->base_vertex()));
+	RenderState::set_primitive_restart(false);
+}
+
+/// <summary>
+/// Polygons are drawn from their triangulated index buffer, so that concave ones are filled correctly
+/// </summary>
 void Renderer::draw_polygon(const VertexArray* vertex_array_obj, const IndexBuffer* index_buffer_obj, const Shader* shader_obj)
 {
 	shader_obj->bind();
 	vertex_array_obj->bind();
 	index_buffer_obj->bind();
-	__glCallVoid(glDrawElements(GL_TRIANGLE_FAN, index_buffer_obj->count(), GL_UNSIGNED_INT, nullptr));
+	__glCallVoid(glDrawElementsBaseVertex(GL_TRIANGLES, index_buffer_obj->count(), index_buffer_obj->index_type(),
+		(void*)index_buffer_obj->offset_of(0), index_buffer_obj->base_vertex()));
 }
 
 void Renderer::draw_lines(const VertexArray* vertex_array_obj,
@@ -32,20 +52,76 @@ void Renderer::draw_lines(const VertexArray* vertex_array_obj,
 	index_buffer_obj->bind();
 	if (count == -1 && offset == nullptr)
 	{
-		__glCallVoid(glDrawElements(GL_LINE_STRIP, index_buffer_obj->count(), GL_UNSIGNED_INT, nullptr));
+		__glCallVoid(glDrawElementsBaseVertex(GL_LINE_STRIP, index_buffer_obj->count(), index_buffer_obj->index_type(),
+			(void*)index_buffer_obj->offset_of(0), index_buffer_obj->base_vertex()));
 	}
 	else
 	{
-		__glCallVoid(glDrawElements(GL_LINE_LOOP, (unsigned int)count, GL_UNSIGNED_INT, offset));
+		__glCallVoid(glDrawElementsBaseVertex(GL_LINE_LOOP, (unsigned int)count, index_buffer_obj->index_type(),
+			(void*)index_buffer_obj->offset_of((unsigned int)((uintptr_t)offset / sizeof(unsigned int))), index_buffer_obj->base_vertex()));
 	}
 }
 
+void Renderer::draw_triangles_instanced(const VertexArray* vertex_array_obj,
+	const IndexBuffer* index_buffer_obj,
+	const Shader* shader_obj,
+	unsigned int instance_count)
+{
+	shader_obj->bind();
+	vertex_array_obj->bind();
+	index_buffer_obj->bind();
+	__glCallVoid(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_buffer_obj->count(), index_buffer_obj->index_type(),
+		index_buffer_obj->offset_of(0), instance_count, index_buffer_obj->base_vertex()));
+}
+
+/// <summary>
+/// Same as draw_lines, the whole index buffer is drawn as a
+/// line strip, or the first count indices as a line loop
+/// </summary>
+void Renderer::draw_lines_instanced(const VertexArray* vertex_array_obj,
+	const IndexBuffer* index_buffer_obj,
+	const Shader* shader_obj,
+	unsigned int instance_count,
+	int count)
+{
+	shader_obj->bind();
+	vertex_array_obj->bind();
+	index_buffer_obj->bind();
+	if (count == -1)
+	{
+		__glCallVoid(glDrawElementsInstancedBaseVertex(GL_LINE_STRIP, index_buffer_obj->count(), index_buffer_obj->index_type(),
+			index_buffer_obj->offset_of(0), instance_count, index_buffer_obj->base_vertex()));
+	}
+	else
+	{
+		__glCallVoid(glDrawElementsInstancedBaseVertex(GL_LINE_LOOP, (unsigned int)count, index_buffer_obj->index_type(),
+			index_buffer_obj->offset_of(0), instance_count, index_buffer_obj->base_vertex()));
+	}
+}
+
+/// <summary>
+/// Draws the first count indices, or the whole index buffer, as points
+/// </summary>
+void Renderer::draw_points(const VertexArray* vertex_array_obj,
+	const IndexBuffer* index_buffer_obj,
+	const Shader* shader_obj,
+	int count)
+{
+	shader_obj->bind();
+	vertex_array_obj->bind();
+	index_buffer_obj->bind();
+	unsigned int num_points = (count == -1) ? index_buffer_obj->count() : (unsigned int)count;
+	__glCallVoid(glDrawElementsBaseVertex(GL_POINTS, num_points, index_buffer_obj->index_type(),
+		(void*)index_buffer_obj->offset_of(0), index_buffer_obj->base_vertex()));
+}
+
 void Renderer::draw_seperate_lines(const VertexArray* vertex_array_obj, const IndexBuffer* index_buffer_obj, const Shader* shader_obj)
 {
 	shader_obj->bind();
 	vertex_array_obj->bind();
 	index_buffer_obj->bind();
-	__glCallVoid(glDrawElements(GL_LINES, index_buffer_obj->count(), GL_UNSIGNED_INT, nullptr));
+	__glCallVoid(glDrawElementsBaseVertex(GL_LINES, index_buffer_obj->count(), index_buffer_obj->index_type(),
+		(void*)index_buffer_obj->offset_of(0), index_buffer_obj->base_vertex()));
 }
 
 void Renderer::clear(const float* clear_color)
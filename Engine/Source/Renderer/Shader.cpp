@@ -1,32 +1,40 @@
 #include "Renderer/Shader.h"
 #include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/FrameUniforms.h"
+#include "Renderer/VertexBufferLayout.h"
 #include <glew.h>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <filesystem>
+#include <deque>
+#include <algorithm>
 
 Shader::Shader(const char* path)
 {
 	m_shader_path = std::filesystem::absolute(path).string();
 	const std::string& program_src = parse_shader_file(m_shader_path.c_str());
 	m_shader_id = create_program_from_shaders(program_src);
-	__glCallVoid(glUseProgram(m_shader_id));
+	reflect();
+	FrameUniforms::bind_block(m_shader_id);
+	RenderState::use_program(m_shader_id);
 }
 
 Shader::~Shader()
 {
+	RenderState::on_delete_program(m_shader_id);
 	__glCallVoid(glDeleteProgram(m_shader_id));
 }
 
 void Shader::bind() const
 {
-	__glCallVoid(glUseProgram(m_shader_id));
+	RenderState::use_program(m_shader_id);
 }
 
 void Shader::unbind() const
 {
-	__glCallVoid(glUseProgram(0));
+	RenderState::use_program(0);
 }
 
 void Shader::set_uniform_1i(const std::string& name, int value)
@@ -54,6 +62,236 @@ void Shader::set_uniform_mat4f(const std::string& name, Angel::mat4 mat)
 	__glCallVoid(glUniformMatrix4fv(uniform_location(name), 1, GL_TRUE, &mat[0][0]));
 }
 
+void Shader::set_uniform(const ShaderUniform<int>& uniform, int value)
+{
+	__glCallVoid(glUniform1i(handle_location(uniform.index()), value));
+}
+
+void Shader::set_uniform(const ShaderUniform<float>& uniform, float value)
+{
+	__glCallVoid(glUniform1f(handle_location(uniform.index()), value));
+}
+
+void Shader::set_uniform(const ShaderUniform<Angel::vec4>& uniform, const Angel::vec4& value)
+{
+	__glCallVoid(glUniform4f(handle_location(uniform.index()), value.x, value.y, value.z, value.w));
+}
+
+void Shader::set_uniform(const ShaderUniform<Angel::mat4>& uniform, const Angel::mat4& value)
+{
+	__glCallVoid(glUniformMatrix4fv(handle_location(uniform.index()), 1, GL_TRUE, static_cast<const float*>(value)));
+}
+
+// Names of the handles, a deque keeps the references stable while it grows
+static std::deque<std::string>& uniform_names()
+{
+	static std::deque<std::string> names;
+	return names;
+}
+
+static std::unordered_map<std::string, unsigned int>& uniform_indices()
+{
+	static std::unordered_map<std::string, unsigned int> indices;
+	return indices;
+}
+
+/// <summary>
+/// Interns the name of a uniform, the same name always gets the same index
+/// </summary>
+/// <param name="name"></param>
+/// <returns>index to give to ShaderUniform</returns>
+unsigned int Shader::register_uniform(const char* name)
+{
+	auto [it, inserted] = uniform_indices().try_emplace(name, (unsigned int)uniform_names().size());
+	if (inserted)
+	{
+		uniform_names().push_back(name);
+	}
+	return it->second;
+}
+
+const std::string& Shader::uniform_name(unsigned int index)
+{
+	ASSERT(index < uniform_names().size());
+	return uniform_names()[index];
+}
+
+/// <summary>
+/// Location of a handle in this program, the name is looked up
+/// only the first time the handle is used with this shader
+/// </summary>
+int Shader::handle_location(unsigned int index)
+{
+	if (index >= m_handle_locations.size())
+	{
+		m_handle_locations.resize(index + 1, s_unresolved);
+	}
+	int& location = m_handle_locations[index];
+	if (location == s_unresolved)
+	{
+		location = uniform_location(uniform_name(index));
+	}
+	return location;
+}
+
+/// <summary>
+/// Lists the active uniforms and attributes of the linked program and
+/// fills the location cache with them
+/// </summary>
+void Shader::reflect()
+{
+	m_uniforms.clear();
+	m_attributes.clear();
+	m_uniform_location_cache.clear();
+	m_handle_locations.clear();
+
+	int num_uniforms = 0, max_uniform_length = 0;
+	__glCallVoid(glGetProgramiv(m_shader_id, GL_ACTIVE_UNIFORMS, &num_uniforms));
+	__glCallVoid(glGetProgramiv(m_shader_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_uniform_length));
+	std::vector<char> name_buffer(std::max(max_uniform_length, 1));
+	for (int i = 0; i < num_uniforms; i++)
+	{
+		int length = 0, size = 0, block_index = -1;
+		unsigned int type = 0;
+		unsigned int uniform_index = (unsigned int)i;
+		__glCallVoid(glGetActiveUniform(m_shader_id, uniform_index, (int)name_buffer.size(), &length, &size, &type, name_buffer.data()));
+		__glCallVoid(glGetActiveUniformsiv(m_shader_id, 1, &uniform_index, GL_UNIFORM_BLOCK_INDEX, &block_index));
+		std::string name(name_buffer.data(), length);
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+		{
+			name.resize(name.size() - 3);
+		}
+		int location = -1;
+		if (block_index == -1)
+		{
+			__glCallReturn(glGetUniformLocation(m_shader_id, name.c_str()), location);
+			m_uniform_location_cache[name] = location;
+		}
+		m_uniforms.push_back({ name, location, type, size, block_index });
+	}
+
+	int num_attributes = 0, max_attribute_length = 0;
+	__glCallVoid(glGetProgramiv(m_shader_id, GL_ACTIVE_ATTRIBUTES, &num_attributes));
+	__glCallVoid(glGetProgramiv(m_shader_id, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_attribute_length));
+	name_buffer.assign(std::max(max_attribute_length, 1), '\0');
+	for (int i = 0; i < num_attributes; i++)
+	{
+		int length = 0, size = 0;
+		unsigned int type = 0;
+		__glCallVoid(glGetActiveAttrib(m_shader_id, (unsigned int)i, (int)name_buffer.size(), &length, &size, &type, name_buffer.data()));
+		std::string name(name_buffer.data(), length);
+		if (name.starts_with("gl_"))
+		{
+			continue;
+		}
+		int location;
+		__glCallReturn(glGetAttribLocation(m_shader_id, name.c_str()), location);
+		m_attributes.push_back({ name, location, type, size });
+	}
+}
+
+const Shader::UniformInfo* Shader::find_uniform(const std::string& name) const
+{
+	for (const UniformInfo& info : m_uniforms)
+	{
+		if (info.name == name)
+		{
+			return &info;
+		}
+	}
+	return nullptr;
+}
+
+const Shader::AttributeInfo* Shader::find_attribute(const std::string& name) const
+{
+	for (const AttributeInfo& info : m_attributes)
+	{
+		if (info.name == name)
+		{
+			return &info;
+		}
+	}
+	return nullptr;
+}
+
+static bool is_compatible(const ShaderUniform<int>*, unsigned int type)
+{
+	return type == GL_INT || type == GL_BOOL
+		|| type == GL_SAMPLER_2D || type == GL_SAMPLER_3D || type == GL_SAMPLER_CUBE
+		|| type == GL_INT_SAMPLER_2D || type == GL_UNSIGNED_INT_SAMPLER_2D;
+}
+
+static bool is_compatible(const ShaderUniform<float>*, unsigned int type)
+{
+	return type == GL_FLOAT;
+}
+
+static bool is_compatible(const ShaderUniform<Angel::vec4>*, unsigned int type)
+{
+	return type == GL_FLOAT_VEC4;
+}
+
+static bool is_compatible(const ShaderUniform<Angel::mat4>*, unsigned int type)
+{
+	return type == GL_FLOAT_MAT4;
+}
+
+/// <summary>
+/// Whether the program has an active uniform of the handle's name and type,
+/// meant for validating the shaders at startup
+/// </summary>
+template <typename T>
+bool Shader::has_uniform(const ShaderUniform<T>& uniform) const
+{
+	const UniformInfo* info = find_uniform(uniform.name());
+	return info != nullptr && info->block_index == -1 && is_compatible(&uniform, info->type);
+}
+
+template bool Shader::has_uniform(const ShaderUniform<int>&) const;
+template bool Shader::has_uniform(const ShaderUniform<float>&) const;
+template bool Shader::has_uniform(const ShaderUniform<Angel::vec4>&) const;
+template bool Shader::has_uniform(const ShaderUniform<Angel::mat4>&) const;
+
+/// <summary>
+/// Checks that every active attribute is fed by the layout, i.e. that its
+/// location has an element with no more components than the attribute takes.
+/// Missing components are filled by GL, so fewer are accepted.
+/// </summary>
+/// <param name="layout"></param>
+/// <returns>false and a warning per mismatch otherwise</returns>
+bool Shader::check_layout(const VertexBufferLayout& layout) const
+{
+	bool matches = true;
+	const auto& elements = layout.elements();
+	for (const AttributeInfo& attribute : m_attributes)
+	{
+		unsigned int num_components = 1;
+		switch (attribute.type)
+		{
+		case GL_FLOAT_VEC2: num_components = 2; break;
+		case GL_FLOAT_VEC3: num_components = 3; break;
+		case GL_FLOAT_VEC4: num_components = 4; break;
+		case GL_FLOAT_MAT4: num_components = 4; break;	// one column per location
+		}
+		if (attribute.location < 0 || (unsigned int)attribute.location >= elements.size())
+		{
+			std::cout << "Warning: The attribute " << attribute.name << " in " << m_shader_path
+				<< " has no element in the vertex layout." << std::endl;
+			matches = false;
+		}
+		// Packed 10-10-10-2 elements always have 4 components, a vec3 attribute drops the w bits
+		else if (elements[attribute.location].count > num_components
+			&& !(elements[attribute.location].type == GL_INT_2_10_10_10_REV && num_components == 3))
+		{
+			std::cout << "Warning: The attribute " << attribute.name << " in " << m_shader_path
+				<< " takes " << num_components << " components, the vertex layout has "
+				<< elements[attribute.location].count << "." << std::endl;
+			matches = false;
+		}
+	}
+	return matches;
+}
+
 int Shader::uniform_location(const std::string& name)
 {
 	if (m_uniform_location_cache.find(name)
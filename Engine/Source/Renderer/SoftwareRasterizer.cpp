@@ -0,0 +1,641 @@
+#include "Renderer/SoftwareRasterizer.h"
+#include "Core/ThreadPool.h"
+#include "Core/ErrorManager.h"
+#include <algorithm>
+#include <cmath>
+#include <climits>
+
+#if SR_USE_SSE
+#include <immintrin.h>
+#endif
+
+static inline uint32_t pack_color(const Angel::vec4& color)
+{
+	auto to_unorm8 = [](float c) { return (uint32_t)(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f); };
+	return to_unorm8(color.x) | (to_unorm8(color.y) << 8) | (to_unorm8(color.z) << 16) | (to_unorm8(color.w) << 24);
+}
+
+static inline Angel::vec4 unpack_color(uint32_t color)
+{
+	return Angel::vec4((float)(color & 0xFF), (float)((color >> 8) & 0xFF),
+		(float)((color >> 16) & 0xFF), (float)(color >> 24)) / 255.0f;
+}
+
+static inline Angel::vec3 transform_normal(const float m[3][3], const float* n)
+{
+	return Angel::vec3(m[0][0] * n[0] + m[0][1] * n[1] + m[0][2] * n[2],
+		m[1][0] * n[0] + m[1][1] * n[1] + m[1][2] * n[2],
+		m[2][0] * n[0] + m[2][1] * n[1] + m[2][2] * n[2]);
+}
+
+/// <summary>
+/// transpose(inverse(MV)) of the shaders, only the upper 3x3 part reaches the normals
+/// of an affine transform. The transposed inverse is the cofactor matrix over the determinant.
+/// </summary>
+static void normal_matrix(const Angel::mat4& mv, float out[3][3])
+{
+	float a = mv[0][0], b = mv[0][1], c = mv[0][2];
+	float d = mv[1][0], e = mv[1][1], f = mv[1][2];
+	float g = mv[2][0], h = mv[2][1], i = mv[2][2];
+	float cofactors[3][3] = {
+		{ e * i - f * h, f * g - d * i, d * h - e * g },
+		{ c * h - b * i, a * i - c * g, b * g - a * h },
+		{ b * f - c * e, c * d - a * f, a * e - b * d },
+	};
+	float det = a * cofactors[0][0] + b * cofactors[0][1] + c * cofactors[0][2];
+	float inv_det = (det != 0.0f) ? 1.0f / det : 0.0f;
+	for (int row = 0; row < 3; row++)
+	{
+		for (int col = 0; col < 3; col++)
+		{
+			out[row][col] = cofactors[row][col] * inv_det;
+		}
+	}
+}
+
+static inline void store(float* out, const Angel::vec3& v)
+{
+	out[0] = v.x;
+	out[1] = v.y;
+	out[2] = v.z;
+}
+
+static inline Angel::vec3 load(const float* in)
+{
+	return Angel::vec3(in[0], in[1], in[2]);
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, ThreadPool& pool)
+	: m_width(0),
+	m_height(0),
+	m_tiles_x(0),
+	m_tiles_y(0),
+	m_pool(pool),
+	m_light_position(0.0f, 0.0f, 1.0f, 0.0f),
+	m_stats({ 0, 0, 0, 0 }),
+	m_last_stats({ 0, 0, 0, 0 })
+{
+	resize(width, height);
+}
+
+void SoftwareRasterizer::resize(int width, int height)
+{
+	// Keeps the sub-pixel edge functions of a tile within 32 bits
+	ASSERT(width > 0 && height > 0 && width <= s_max_size && height <= s_max_size);
+	ASSERT(m_triangles.empty());
+	m_width = width;
+	m_height = height;
+	m_tiles_x = (width + s_tile_size - 1) / s_tile_size;
+	m_tiles_y = (height + s_tile_size - 1) / s_tile_size;
+	m_color.assign((size_t)width * height, 0);
+	m_depth.assign((size_t)width * height, 1.0f);
+	m_bins.clear();
+	m_bins.resize((size_t)m_tiles_x * m_tiles_y);
+}
+
+void SoftwareRasterizer::set_frame(const Angel::mat4& proj, const Angel::mat4& view, const Angel::vec4& light_position)
+{
+	m_proj = proj;
+	m_view = view;
+	m_light_position = light_position;
+}
+
+void SoftwareRasterizer::clear(const Angel::vec4& color, float depth)
+{
+	ASSERT(m_triangles.empty());
+	std::fill(m_color.begin(), m_color.end(), pack_color(color));
+	std::fill(m_depth.begin(), m_depth.end(), depth);
+}
+
+/// <summary>
+/// The vertex shaders of the engine. Every vertex of the positions view is transformed
+/// once into m_clip_vertices, whatever the indices reference.
+/// </summary>
+/// <returns>number of varyings the shading passes to the pixels</returns>
+unsigned int SoftwareRasterizer::shade_vertices(const Mesh& mesh)
+{
+	Angel::mat4 MV = m_view * mesh.model;
+	Angel::mat4 MVP = m_proj * MV;
+	float NM[3][3];
+	normal_matrix(MV, NM);
+	Angel::vec3 light = Angel::vec3(m_light_position.x, m_light_position.y, m_light_position.z);
+	bool directional = m_light_position.w == 0.0f;
+	bool normal_mapped = mesh.shading == Shading::Phong && mesh.texture != nullptr;
+
+	unsigned int num_vertices = mesh.positions.size();
+	m_clip_vertices.resize(num_vertices);
+	unsigned int num_varyings = 0;
+	for (unsigned int i = 0; i < num_vertices; i++)
+	{
+		const float* p = mesh.positions[i];
+		Angel::vec4 position(p[0], p[1], p[2], 1.0f);
+		ClipVertex& out = m_clip_vertices[i];
+		out.position = MVP * position;
+		switch (mesh.shading)
+		{
+		case Shading::Flat:
+			num_varyings = 0;
+			break;
+		case Shading::Colored:
+		{
+			const float* color = mesh.colors[i];
+			std::copy(color, color + 4, out.varyings);
+			num_varyings = 4;
+			break;
+		}
+		case Shading::Textured:
+		{
+			Angel::vec4 view_position = MV * position;
+			Angel::vec3 vertex_pos(view_position.x, view_position.y, view_position.z);
+			const float* uv = mesh.uvs[i];
+			out.varyings[0] = uv[0];
+			out.varyings[1] = uv[1];
+			store(out.varyings + 2, Angel::normalize(transform_normal(NM, mesh.normals[i])));
+			store(out.varyings + 5, Angel::normalize(directional ? light : light - vertex_pos));
+			store(out.varyings + 8, -Angel::normalize(vertex_pos));
+			num_varyings = 11;
+			break;
+		}
+		case Shading::Phong:
+		{
+			Angel::vec4 view_position = MV * position;
+			Angel::vec3 vertex_pos(view_position.x, view_position.y, view_position.z);
+			Angel::vec3 N = Angel::normalize(transform_normal(NM, mesh.normals[i]));
+			Angel::vec3 L = directional ? light : light - vertex_pos;
+			Angel::vec3 E = -vertex_pos;
+			if (normal_mapped)
+			{
+				// L and E in the tangent space of the normal map
+				Angel::vec3 T = Angel::normalize(transform_normal(NM, mesh.tangents[i]));
+				Angel::vec3 B = Angel::cross(N, T);
+				const float* uv = mesh.uvs[i];
+				out.varyings[0] = uv[0];
+				out.varyings[1] = uv[1];
+				store(out.varyings + 2, Angel::normalize(Angel::vec3(Angel::dot(T, L), Angel::dot(B, L), Angel::dot(N, L))));
+				store(out.varyings + 5, Angel::normalize(Angel::vec3(Angel::dot(T, E), Angel::dot(B, E), Angel::dot(N, E))));
+				num_varyings = 8;
+			}
+			else
+			{
+				store(out.varyings, N);
+				store(out.varyings + 3, Angel::normalize(L));
+				store(out.varyings + 6, Angel::normalize(E));
+				num_varyings = 9;
+			}
+			break;
+		}
+		}
+	}
+	return num_varyings;
+}
+
+void SoftwareRasterizer::draw(const Mesh& mesh)
+{
+	ASSERT(mesh.indices.size() % 3 == 0);
+	ASSERT(mesh.shading != Shading::Colored || mesh.colors.size() >= mesh.positions.size());
+	ASSERT(mesh.shading != Shading::Textured || (mesh.uvs.size() >= mesh.positions.size() && mesh.normals.size() >= mesh.positions.size()));
+	ASSERT(mesh.shading != Shading::Phong || mesh.normals.size() >= mesh.positions.size());
+	ASSERT(mesh.shading != Shading::Phong || mesh.texture == nullptr || mesh.tangents.size() >= mesh.positions.size());
+	m_meshes.push_back(mesh);
+	unsigned int num_varyings = shade_vertices(mesh);
+	m_num_varyings.push_back(num_varyings);
+
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		m_stats.num_triangles++;
+		const ClipVertex& a = m_clip_vertices[mesh.indices[i] + mesh.base_vertex];
+		const ClipVertex& b = m_clip_vertices[mesh.indices[i + 1] + mesh.base_vertex];
+		const ClipVertex& c = m_clip_vertices[mesh.indices[i + 2] + mesh.base_vertex];
+		clip_and_setup(a, b, c, num_varyings);
+	}
+}
+
+/// <summary>
+/// Sutherland-Hodgman clipping against the 6 planes of the view volume, in clip space.
+/// Triangles that are inside all the planes, the common case, skip the clipping.
+/// </summary>
+void SoftwareRasterizer::clip_and_setup(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int num_varyings)
+{
+	auto distance = [](const ClipVertex& v, int plane)
+	{
+		const Angel::vec4& p = v.position;
+		float coordinate = (plane / 2 == 0) ? p.x : (plane / 2 == 1) ? p.y : p.z;
+		return (plane % 2 == 0) ? p.w + coordinate : p.w - coordinate;
+	};
+	unsigned int outside_any = 0;
+	for (int plane = 0; plane < 6; plane++)
+	{
+		unsigned int outside = (distance(a, plane) < 0.0f) + (distance(b, plane) < 0.0f) + (distance(c, plane) < 0.0f);
+		if (outside == 3)
+		{
+			m_stats.num_clipped++;
+			return;
+		}
+		outside_any += outside;
+	}
+	if (outside_any == 0)
+	{
+		setup(a, b, c, num_varyings);
+		return;
+	}
+
+	// A triangle clipped by 6 planes has at most 9 corners
+	ClipVertex buffers[2][9];
+	unsigned int counts[2] = { 3, 0 };
+	buffers[0][0] = a;
+	buffers[0][1] = b;
+	buffers[0][2] = c;
+	int current = 0;
+	for (int plane = 0; plane < 6; plane++)
+	{
+		const ClipVertex* in = buffers[current];
+		ClipVertex* out = buffers[1 - current];
+		unsigned int num_in = counts[current];
+		unsigned int num_out = 0;
+		for (unsigned int i = 0; i < num_in; i++)
+		{
+			const ClipVertex& from = in[i];
+			const ClipVertex& to = in[(i + 1) % num_in];
+			float d_from = distance(from, plane);
+			float d_to = distance(to, plane);
+			if (d_from >= 0.0f)
+			{
+				out[num_out++] = from;
+			}
+			if ((d_from >= 0.0f) != (d_to >= 0.0f))
+			{
+				float t = d_from / (d_from - d_to);
+				ClipVertex& v = out[num_out++];
+				v.position = from.position + t * (to.position - from.position);
+				for (unsigned int k = 0; k < num_varyings; k++)
+				{
+					v.varyings[k] = from.varyings[k] + t * (to.varyings[k] - from.varyings[k]);
+				}
+			}
+		}
+		counts[1 - current] = num_out;
+		current = 1 - current;
+		if (num_out < 3)
+		{
+			m_stats.num_clipped++;
+			return;
+		}
+	}
+	const ClipVertex* polygon = buffers[current];
+	for (unsigned int i = 1; i + 1 < counts[current]; i++)
+	{
+		setup(polygon[0], polygon[i], polygon[i + 1], num_varyings);
+	}
+}
+
+/// <summary>
+/// Perspective division, snapping to the sub-pixel grid and binning. Window
+/// coordinates have the origin at the bottom left corner, like in GL.
+/// </summary>
+void SoftwareRasterizer::setup(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int num_varyings)
+{
+	const Mesh& mesh = m_meshes.back();
+	const float sub_pixels = (float)(1 << s_sub_pixel_bits);
+	const ClipVertex* vertices[3] = { &a, &b, &c };
+	Triangle triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		const Angel::vec4& p = vertices[i]->position;
+		float inv_w = 1.0f / p.w;
+		triangle.x[i] = (int32_t)std::lround(((p.x * inv_w) * 0.5f + 0.5f) * m_width * sub_pixels);
+		triangle.y[i] = (int32_t)std::lround(((p.y * inv_w) * 0.5f + 0.5f) * m_height * sub_pixels);
+		triangle.z[i] = (p.z * inv_w) * 0.5f + 0.5f;
+		triangle.inv_w[i] = inv_w;
+		for (unsigned int k = 0; k < num_varyings; k++)
+		{
+			triangle.varyings[i][k] = vertices[i]->varyings[k] * inv_w;
+		}
+	}
+	triangle.area = (int64_t)(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0])
+		- (int64_t)(triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+	if (triangle.area == 0 || (triangle.area < 0 && mesh.cull_back_faces))
+	{
+		m_stats.num_clipped++;
+		return;
+	}
+	if (triangle.area < 0)
+	{
+		// Counter clockwise from here on, the interior is on the left of every edge
+		std::swap(triangle.x[1], triangle.x[2]);
+		std::swap(triangle.y[1], triangle.y[2]);
+		std::swap(triangle.z[1], triangle.z[2]);
+		std::swap(triangle.inv_w[1], triangle.inv_w[2]);
+		std::swap(triangle.varyings[1], triangle.varyings[2]);
+		triangle.area = -triangle.area;
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		triangle.a[i] = triangle.y[from] - triangle.y[to];
+		triangle.b[i] = triangle.x[to] - triangle.x[from];
+		triangle.c[i] = -((int64_t)triangle.a[i] * triangle.x[from] + (int64_t)triangle.b[i] * triangle.y[from]);
+		// Left edges go down, top edges go left
+		triangle.top_left[i] = triangle.a[i] > 0 || (triangle.a[i] == 0 && triangle.b[i] < 0);
+	}
+
+	// Pixels whose centers, at half a pixel, are within the bounds
+	const int half_pixel = 1 << (s_sub_pixel_bits - 1);
+	const int pixel_mask = (1 << s_sub_pixel_bits) - 1;
+	int min_x = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+	int max_x = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+	int min_y = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+	int max_y = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+	triangle.min_x = std::max((min_x - half_pixel + pixel_mask) >> s_sub_pixel_bits, 0);
+	triangle.min_y = std::max((min_y - half_pixel + pixel_mask) >> s_sub_pixel_bits, 0);
+	triangle.max_x = std::min((max_x - half_pixel) >> s_sub_pixel_bits, m_width - 1);
+	triangle.max_y = std::min((max_y - half_pixel) >> s_sub_pixel_bits, m_height - 1);
+	if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y)
+	{
+		// Falls between the pixel centers
+		return;
+	}
+	triangle.mesh = (unsigned int)m_meshes.size() - 1;
+
+	uint32_t index = (uint32_t)m_triangles.size();
+	m_triangles.push_back(triangle);
+	for (int tile_y = triangle.min_y / s_tile_size; tile_y <= triangle.max_y / s_tile_size; tile_y++)
+	{
+		for (int tile_x = triangle.min_x / s_tile_size; tile_x <= triangle.max_x / s_tile_size; tile_x++)
+		{
+			m_bins[(size_t)tile_y * m_tiles_x + tile_x].push_back(index);
+			m_stats.num_bin_entries++;
+		}
+	}
+}
+
+void SoftwareRasterizer::flush()
+{
+	m_pool.parallel_for((unsigned int)m_bins.size(), [this](unsigned int tile)
+	{
+		rasterize_tile(tile);
+	});
+	for (std::vector<uint32_t>& bin : m_bins)
+	{
+		m_stats.num_tiles += !bin.empty();
+		bin.clear();
+	}
+	m_last_stats = m_stats;
+	m_stats = { 0, 0, 0, 0 };
+	m_triangles.clear();
+	m_meshes.clear();
+	m_num_varyings.clear();
+}
+
+/// <summary>
+/// Runs on the worker threads, a tile is only written by the thread that rasterizes it
+/// </summary>
+void SoftwareRasterizer::rasterize_tile(unsigned int tile)
+{
+	int tile_x = (int)(tile % m_tiles_x);
+	int tile_y = (int)(tile / m_tiles_x);
+	for (uint32_t index : m_bins[tile])
+	{
+		rasterize(m_triangles[index], tile_x, tile_y);
+	}
+}
+
+/// <summary>
+/// Coverage of the triangle over the part of the tile within its bounds. An edge that
+/// keeps one sign over the whole rectangle rejects the triangle or needs no test; the
+/// other edges stay within 32 bits over a tile, and are stepped 4 pixels at a time.
+/// </summary>
+void SoftwareRasterizer::rasterize(const Triangle& triangle, int tile_x, int tile_y)
+{
+	const int pixel = 1 << s_sub_pixel_bits;
+	const int half_pixel = pixel / 2;
+	int x0 = std::max(triangle.min_x, tile_x * s_tile_size);
+	int x1 = std::min(triangle.max_x, tile_x * s_tile_size + s_tile_size - 1);
+	int y0 = std::max(triangle.min_y, tile_y * s_tile_size);
+	int y1 = std::min(triangle.max_y, tile_y * s_tile_size + s_tile_size - 1);
+	// Groups of 4 pixels start at multiples of 4, which the tiles are aligned to
+	int group_x0 = x0 & ~3;
+
+	int32_t row_values[3], lane_steps[3], group_steps[3], row_steps[3], thresholds[3];
+	for (int i = 0; i < 3; i++)
+	{
+		int64_t a = triangle.a[i];
+		int64_t b = triangle.b[i];
+		int64_t origin = a * (group_x0 * pixel + half_pixel) + b * (y0 * pixel + half_pixel) + triangle.c[i];
+		int64_t dx = a * (x1 - group_x0) * pixel;
+		int64_t dy = b * (y1 - y0) * pixel;
+		int64_t min_value = origin + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0);
+		int64_t max_value = origin + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0);
+		// Covered if value >= 0 on top-left edges, value > 0 on the others
+		int64_t threshold = triangle.top_left[i] ? -1 : 0;
+		if (max_value <= threshold)
+		{
+			return;
+		}
+		if (min_value > threshold)
+		{
+			row_values[i] = INT_MAX / 2;
+			lane_steps[i] = group_steps[i] = row_steps[i] = 0;
+		}
+		else
+		{
+			row_values[i] = (int32_t)origin;
+			lane_steps[i] = (int32_t)(a * pixel);
+			group_steps[i] = 4 * lane_steps[i];
+			row_steps[i] = (int32_t)(b * pixel);
+		}
+		thresholds[i] = (int32_t)threshold;
+	}
+
+	for (int y = y0; y <= y1; y++)
+	{
+#if SR_USE_SSE
+		__m128i values[3], steps[3], limits[3];
+		for (int i = 0; i < 3; i++)
+		{
+			values[i] = _mm_add_epi32(_mm_set1_epi32(row_values[i]),
+				_mm_set_epi32(3 * lane_steps[i], 2 * lane_steps[i], lane_steps[i], 0));
+			steps[i] = _mm_set1_epi32(group_steps[i]);
+			limits[i] = _mm_set1_epi32(thresholds[i]);
+		}
+		for (int x = group_x0; x <= x1; x += 4)
+		{
+			__m128i inside = _mm_and_si128(_mm_cmpgt_epi32(values[0], limits[0]),
+				_mm_and_si128(_mm_cmpgt_epi32(values[1], limits[1]), _mm_cmpgt_epi32(values[2], limits[2])));
+			int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+			for (int i = 0; i < 3; i++)
+			{
+				values[i] = _mm_add_epi32(values[i], steps[i]);
+			}
+#else
+		int32_t values[3] = { row_values[0], row_values[1], row_values[2] };
+		for (int x = group_x0; x <= x1; x += 4)
+		{
+			int mask = 0;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				bool inside = true;
+				for (int i = 0; i < 3; i++)
+				{
+					inside = inside && values[i] + lane * lane_steps[i] > thresholds[i];
+				}
+				mask |= inside << lane;
+			}
+			for (int i = 0; i < 3; i++)
+			{
+				values[i] += group_steps[i];
+			}
+#endif
+			for (; mask != 0; mask &= mask - 1)
+			{
+				int lane = 0;
+				while (!(mask & (1 << lane)))
+				{
+					lane++;
+				}
+				if (x + lane >= x0 && x + lane <= x1)
+				{
+					write_pixel(triangle, x + lane, y);
+				}
+			}
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			row_values[i] += row_steps[i];
+		}
+	}
+}
+
+/// <summary>
+/// Interpolates, depth tests, shades and blends one covered pixel
+/// </summary>
+void SoftwareRasterizer::write_pixel(const Triangle& triangle, int x, int y)
+{
+	const int pixel = 1 << s_sub_pixel_bits;
+	int64_t px = (int64_t)x * pixel + pixel / 2;
+	int64_t py = (int64_t)y * pixel + pixel / 2;
+	float inv_area = 1.0f / (float)triangle.area;
+	float weights[3];
+	for (int i = 0; i < 3; i++)
+	{
+		weights[i] = (float)(triangle.a[i] * px + triangle.b[i] * py + triangle.c[i]) * inv_area;
+	}
+
+	const Mesh& mesh = m_meshes[triangle.mesh];
+	size_t offset = (size_t)y * m_width + x;
+	float z = weights[0] * triangle.z[0] + weights[1] * triangle.z[1] + weights[2] * triangle.z[2];
+	if (mesh.depth_test)
+	{
+		if (z > m_depth[offset])
+		{
+			return;
+		}
+		m_depth[offset] = z;
+	}
+
+	// The varyings were divided by w, dividing by the interpolated 1 / w restores them
+	unsigned int num_varyings = m_num_varyings[triangle.mesh];
+	float varyings[s_max_varyings];
+	float inv_w = weights[0] * triangle.inv_w[0] + weights[1] * triangle.inv_w[1] + weights[2] * triangle.inv_w[2];
+	float w = 1.0f / inv_w;
+	for (unsigned int k = 0; k < num_varyings; k++)
+	{
+		varyings[k] = (weights[0] * triangle.varyings[0][k] + weights[1] * triangle.varyings[1][k]
+			+ weights[2] * triangle.varyings[2][k]) * w;
+	}
+
+	Angel::vec4 color = shade_pixel(mesh, varyings);
+	if (mesh.blend)
+	{
+		Angel::vec4 destination = unpack_color(m_color[offset]);
+		color = color * color.w + destination * (1.0f - color.w);
+	}
+	m_color[offset] = pack_color(color);
+}
+
+/// <summary>
+/// The pixel shaders of the engine, with the same lighting terms
+/// </summary>
+Angel::vec4 SoftwareRasterizer::shade_pixel(const Mesh& mesh, const float* varyings) const
+{
+	auto lighting = [&mesh](const Angel::vec3& N, const Angel::vec3& L, const Angel::vec3& E)
+	{
+		const Material& material = mesh.material;
+		Angel::vec3 H = Angel::normalize(L + E);
+		float Kd = std::max(Angel::dot(L, N), 0.0f);
+		float Ks = std::pow(std::max(Angel::dot(N, H), 0.0f), material.shininess);
+		Angel::vec4 specular = Ks * material.specular;
+		if (Angel::dot(L, N) < 0.0f)
+		{
+			specular = Angel::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+		return material.ambient + Kd * material.diffuse + specular;
+	};
+	auto modulate = [](const Angel::vec4& a, const Angel::vec4& b)
+	{
+		return Angel::vec4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
+	};
+
+	switch (mesh.shading)
+	{
+	case Shading::Colored:
+		return Angel::vec4(varyings[0], varyings[1], varyings[2], varyings[3]);
+	case Shading::Textured:
+	{
+		Angel::vec4 texture_color = mesh.texture ? sample(*mesh.texture, varyings[0], varyings[1]) : Angel::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		// Like the shader, the interpolated vectors are not normalized again
+		Angel::vec4 color = modulate(lighting(load(varyings + 2), load(varyings + 5), load(varyings + 8)), texture_color);
+		color.w = 1.0f;
+		if (mesh.selected)
+		{
+			color.x = 0.0f;
+			color.z = 0.0f;
+		}
+		return color;
+	}
+	case Shading::Phong:
+	{
+		Angel::vec3 N, L, E;
+		if (mesh.texture)
+		{
+			Angel::vec4 texel = sample(*mesh.texture, varyings[0], varyings[1]);
+			N = Angel::normalize(Angel::vec3(2.0f * texel.x - 1.0f, 2.0f * texel.y - 1.0f, 2.0f * texel.z - 1.0f));
+			L = Angel::normalize(load(varyings + 2));
+			E = Angel::normalize(load(varyings + 5));
+		}
+		else
+		{
+			N = Angel::normalize(load(varyings));
+			L = Angel::normalize(load(varyings + 3));
+			E = Angel::normalize(load(varyings + 6));
+		}
+		Angel::vec4 color = modulate(lighting(N, L, E), mesh.color);
+		color.w = 1.0f;
+		return color;
+	}
+	default:
+		return mesh.color;
+	}
+}
+
+Angel::vec4 SoftwareRasterizer::sample(const Image& image, float u, float v)
+{
+	ASSERT(image.pixels != nullptr && image.width > 0 && image.height > 0);
+	// Texel centers are at half texels
+	float x = std::clamp(u * image.width - 0.5f, 0.0f, (float)(image.width - 1));
+	float y = std::clamp(v * image.height - 0.5f, 0.0f, (float)(image.height - 1));
+	int x0 = (int)x;
+	int y0 = (int)y;
+	int x1 = std::min(x0 + 1, image.width - 1);
+	int y1 = std::min(y0 + 1, image.height - 1);
+	float fx = x - x0;
+	float fy = y - y0;
+	auto texel = [&image](int tx, int ty)
+	{
+		const uint8_t* p = image.pixels + ((size_t)ty * image.width + tx) * 4;
+		return Angel::vec4(p[0], p[1], p[2], p[3]) / 255.0f;
+	};
+	Angel::vec4 bottom = texel(x0, y0) * (1.0f - fx) + texel(x1, y0) * fx;
+	Angel::vec4 top = texel(x0, y1) * (1.0f - fx) + texel(x1, y1) * fx;
+	return bottom * (1.0f - fy) + top * fy;
+}
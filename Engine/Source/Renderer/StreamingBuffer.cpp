@@ -0,0 +1,192 @@
+#include "Renderer/StreamingBuffer.h"
+#include "Renderer/RenderState.h"
+#include "Core/ErrorManager.h"
+#include <glew.h>
+#include <cstring>
+
+StreamingBuffer::StreamingBuffer(unsigned int capacity)
+	: m_capacity(0),
+	m_head(0),
+	m_pending_begin(0),
+	m_stats({ 0, 0, 0 })
+{
+	ASSERT(capacity > 0);
+	__glCallVoid(glGenBuffers(1, &m_buffer_id));
+	allocate_storage(capacity);
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	delete_fences();
+	RenderState::on_delete_buffer(m_buffer_id);
+	__glCallVoid(glDeleteBuffers(1, &m_buffer_id));
+}
+
+/// <summary>
+/// Gives the buffer a new storage, the old one is released by the driver once
+/// the GPU is done with it. Writes go through GL_COPY_WRITE_BUFFER, which is not
+/// part of the vertex array state and is not tracked by RenderState.
+/// </summary>
+/// <param name="capacity">in bytes</param>
+void StreamingBuffer::allocate_storage(unsigned int capacity)
+{
+	m_capacity = capacity;
+	m_head = 0;
+	m_pending_begin = 0;
+	delete_fences();
+	__glCallVoid(glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer_id));
+	__glCallVoid(glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_DRAW));
+}
+
+void StreamingBuffer::delete_fences()
+{
+	for (const Fence& fence : m_fences)
+	{
+		__glCallVoid(glDeleteSync(fence.sync));
+	}
+	m_fences.clear();
+}
+
+/// <summary>
+/// Deletes the oldest fences the GPU has passed, so that the number of live
+/// fences stays bounded by the frames in flight even if the ring rarely wraps
+/// </summary>
+void StreamingBuffer::retire_signaled_fences()
+{
+	while (!m_fences.empty())
+	{
+		GLenum status;
+		__glCallReturn(glClientWaitSync(m_fences.front().sync, 0, 0), status);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			return;
+		}
+		__glCallVoid(glDeleteSync(m_fences.front().sync));
+		m_fences.pop_front();
+	}
+}
+
+/// <summary>
+/// Guards the bytes written since the last fence
+/// </summary>
+void StreamingBuffer::fence_pending()
+{
+	if (m_head == m_pending_begin)
+	{
+		return;
+	}
+	GLsync sync;
+	__glCallReturn(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), sync);
+	m_fences.push_back({ sync, m_pending_begin, m_head });
+	m_pending_begin = m_head;
+}
+
+/// <summary>
+/// Whether the GPU is done reading the byte range. Fences signal in
+/// submission order, so only the newest overlapping one is polled,
+/// and the ones before it are dropped together with it.
+/// </summary>
+bool StreamingBuffer::is_free(unsigned int begin, unsigned int end)
+{
+	int newest_overlap = -1;
+	for (int i = (int)m_fences.size() - 1; i >= 0; i--)
+	{
+		if (m_fences[i].begin < end && begin < m_fences[i].end)
+		{
+			newest_overlap = i;
+			break;
+		}
+	}
+	if (newest_overlap == -1)
+	{
+		return true;
+	}
+	GLenum status;
+	__glCallReturn(glClientWaitSync(m_fences[newest_overlap].sync, 0, 0), status);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		return false;
+	}
+	for (int i = 0; i <= newest_overlap; i++)
+	{
+		__glCallVoid(glDeleteSync(m_fences.front().sync));
+		m_fences.pop_front();
+	}
+	return true;
+}
+
+/// <summary>
+/// Finds the offset of the next write, wrapping around the ring
+/// </summary>
+unsigned int StreamingBuffer::reserve(unsigned int size, unsigned int alignment)
+{
+	if (size > m_capacity)
+	{
+		// Grows once, later frames of the same size fit
+		unsigned int capacity = m_capacity;
+		while (capacity < size)
+		{
+			capacity *= 2;
+		}
+		allocate_storage(capacity);
+		m_stats.num_reallocations++;
+	}
+	unsigned int offset = (m_head + alignment - 1) / alignment * alignment;
+	if (offset + size > m_capacity)
+	{
+		// The draws that read the end of the ring may still be queued
+		fence_pending();
+		offset = 0;
+		m_pending_begin = 0;
+	}
+	if (!is_free(offset, offset + size))
+	{
+		allocate_storage(m_capacity);
+		m_stats.num_orphans++;
+		offset = 0;
+	}
+	return offset;
+}
+
+unsigned int StreamingBuffer::push(const void* data, unsigned int size, unsigned int alignment)
+{
+	ASSERT(alignment > 0);
+	if (size == 0)
+	{
+		return 0;
+	}
+	unsigned int offset = reserve(size, alignment);
+	__glCallVoid(glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer_id));
+	void* dst;
+	__glCallReturn(glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT), dst);
+	ASSERT(dst != nullptr);
+	std::memcpy(dst, data, size);
+	__glCallVoid(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+	m_head = offset + size;
+	m_stats.num_bytes += size;
+	return offset;
+}
+
+/// <summary>
+/// Fences the writes of the frame, to be called after their draws were issued
+/// </summary>
+void StreamingBuffer::end_frame()
+{
+	fence_pending();
+	retire_signaled_fences();
+	m_stats.num_bytes = 0;
+}
+
+void StreamingBuffer::bind_as_vertex_buffer() const
+{
+	RenderState::bind_array_buffer(m_buffer_id);
+}
+
+/// <summary>
+/// The element buffer is vertex array state, bind the vertex array first
+/// </summary>
+void StreamingBuffer::bind_as_index_buffer() const
+{
+	RenderState::bind_element_buffer(m_buffer_id);
+}
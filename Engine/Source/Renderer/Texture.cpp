@@ -1,5 +1,6 @@
 #include "Renderer/Texture.h"
 #include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
 #include <glew.h>
 #include <nothings-stb/stb_image.h>
 
@@ -11,7 +12,7 @@ Texture::Texture(const std::string& path) :
 	m_local_buffer = stbi_load(path.c_str(), &m_width, &m_height, &m_bytes_per_pixel, 4);
 
 	__glCallVoid(glGenTextures(1, &m_texture_id));
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, m_texture_id));
+	RenderState::bind_texture(m_texture_id);
 
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -32,7 +33,7 @@ Texture::Texture(unsigned char* buffer, int width, int height, int bpp,
 	m_texture_id(0), m_local_buffer(buffer), m_bytes_per_pixel(bpp)
 {
 	__glCallVoid(glGenTextures(1, &m_texture_id));
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, m_texture_id));
+	RenderState::bind_texture(m_texture_id);
 
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 	__glCallVoid(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -44,16 +45,16 @@ Texture::Texture(unsigned char* buffer, int width, int height, int bpp,
 
 Texture::~Texture()
 {
+	RenderState::on_delete_texture(m_texture_id);
 	__glCallVoid(glDeleteTextures(1, &m_texture_id));
 }
 
 void Texture::bind(unsigned int slot_number /*= 0*/) const
 {
-	__glCallVoid(glActiveTexture(GL_TEXTURE0 + slot_number));
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, m_texture_id));
+	RenderState::bind_texture(slot_number, m_texture_id);
 }
 
 void Texture::unbind() const
 {
-	__glCallVoid(glBindTexture(GL_TEXTURE_2D, 0));
+	RenderState::bind_texture(0);
 }
@@ -1,32 +1,38 @@
 #include "Renderer/VertexArray.h"
 #include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
 #include <glew.h>
 
 VertexArray::VertexArray() :
 	m_num_vertices(0)
 {
 	__glCallVoid(glGenVertexArrays(1, &m_vertex_array_id));
-	__glCallVoid(glBindVertexArray(m_vertex_array_id));
+	RenderState::bind_vertex_array(m_vertex_array_id);
 }
 
 VertexArray::~VertexArray()
 {
+	RenderState::on_delete_vertex_array(m_vertex_array_id);
 	__glCallVoid(glDeleteVertexArrays(1, &m_vertex_array_id));
 }
 
-void VertexArray::add_buffer(const VertexBuffer& vertex_buffer, const VertexBufferLayout& layout)
+/// <summary>
+/// Points the attributes starting from first_attribute into the currently bound array buffer
+/// </summary>
+/// <param name="layout"></param>
+/// <param name="first_attribute"></param>
+/// <param name="divisor">0 for per-vertex attributes, 1 for per-instance ones</param>
+void VertexArray::set_attribute_pointers(const VertexBufferLayout& layout, unsigned int first_attribute, unsigned int divisor)
 {
-	bind();
-	vertex_buffer.bind();
 	const auto& elements = layout.elements();
 	unsigned int offset = 0;
 	for (unsigned int i = 0; i < elements.size(); i++)
 	{
 		const auto& element = elements[i];
-		__glCallVoid(glEnableVertexAttribArray(m_num_vertices + i));
+		__glCallVoid(glEnableVertexAttribArray(first_attribute + i));
 #pragma warning(push)
 #pragma warning( disable : 4312 )
-		__glCallVoid(glVertexAttribPointer(m_num_vertices + i,
+		__glCallVoid(glVertexAttribPointer(first_attribute + i,
 			element.count,
 			element.type,		//type
 			element.normalized,	// normalized flag
@@ -34,18 +40,56 @@ void VertexArray::add_buffer(const VertexBuffer& vertex_buffer, const VertexBuff
 			(const void*)offset	// offset to the first item of the next attribute
 		));
 #pragma warning(pop)
-		offset += element.count * VertexBufferElement::get_size_of_type(element.type);
+		if (divisor != 0)
+		{
+			__glCallVoid(glVertexAttribDivisor(first_attribute + i, divisor));
+		}
+		offset += element.size();
 	}
+}
+
+void VertexArray::add_buffer(const VertexBuffer& vertex_buffer, const VertexBufferLayout& layout)
+{
+	bind();
+	vertex_buffer.bind();
+	set_attribute_pointers(layout, m_num_vertices, 0);
 	m_num_vertices += vertex_buffer.size() / layout.stride();
 }
 
+/// <summary>
+/// Adds a buffer whose attributes advance once per instance instead of once per vertex.
+/// The attributes are placed starting from first_attribute, so that the shaders can
+/// use fixed locations regardless of the vertex layout.
+/// </summary>
+/// <param name="instance_buffer"></param>
+/// <param name="layout"></param>
+/// <param name="first_attribute"></param>
+void VertexArray::add_instance_buffer(const VertexBuffer& instance_buffer, const VertexBufferLayout& layout, unsigned int first_attribute)
+{
+	bind();
+	instance_buffer.bind();
+	set_attribute_pointers(layout, first_attribute, 1);
+}
+
+/// <summary>
+/// Reads the vertices from a streaming ring, the draws pick their
+/// range of the ring through the base vertex
+/// </summary>
+/// <param name="stream"></param>
+/// <param name="layout"></param>
+void VertexArray::add_stream(const StreamingBuffer& stream, const VertexBufferLayout& layout)
+{
+	bind();
+	stream.bind_as_vertex_buffer();
+	set_attribute_pointers(layout, 0, 0);
+}
+
 void VertexArray::bind() const
 {
-	__glCallVoid(glBindVertexArray(m_vertex_array_id));
+	RenderState::bind_vertex_array(m_vertex_array_id);
 }
 
 void VertexArray::unbind() const
 {
-
-	__glCallVoid(glBindVertexArray(0));
+	RenderState::bind_vertex_array(0);
 }
@@ -1,33 +1,141 @@
 #include "Renderer/VertexBuffer.h"
 #include "Core/ErrorManager.h"
+#include "Renderer/RenderState.h"
+#include "Renderer/GeometryArena.h"
 #include <glew.h>
 
 VertexBuffer::VertexBuffer() :
-	m_size(0)
+	m_size(0),
+	m_capacity(0),
+	m_arena(nullptr),
+	m_first_vertex(0)
 {
 	__glCallVoid(glGenBuffers(1, &m_vertex_buffer_id));
 }
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size) :
-	m_size(size)
+	m_size(size),
+	m_capacity(size),
+	m_arena(nullptr),
+	m_first_vertex(0)
 {
 	__glCallVoid(glGenBuffers(1, &m_vertex_buffer_id));
-	__glCallVoid(glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer_id));
+	RenderState::bind_array_buffer(m_vertex_buffer_id);
 	__glCallVoid(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
+VertexBuffer::VertexBuffer(GeometryArena& arena) :
+	m_vertex_buffer_id(arena.vertex_buffer_id()),
+	m_size(0),
+	m_capacity(0),
+	m_arena(&arena),
+	m_first_vertex(0)
+{
+}
+
 VertexBuffer::~VertexBuffer()
 {
+	if (m_arena)
+	{
+		if (m_capacity > 0)
+		{
+			m_arena->free_vertices(m_first_vertex, m_capacity / m_arena->vertex_size());
+		}
+		return;
+	}
+	RenderState::on_delete_buffer(m_vertex_buffer_id);
 	__glCallVoid(glDeleteBuffers(1, &m_vertex_buffer_id));
 }
 
 void VertexBuffer::bind() const
 {
-	__glCallVoid(glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer_id));
+	RenderState::bind_array_buffer(m_vertex_buffer_id);
 }
 
 void VertexBuffer::unbind() const
 {
-	__glCallVoid(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	RenderState::bind_array_buffer(0);
+}
+
+/// <summary>
+/// Replaces the whole storage of the buffer, meant for
+/// buffers that are refilled every frame
+/// </summary>
+/// <param name="data"></param>
+/// <param name="size">in bytes</param>
+void VertexBuffer::set_data(const void* data, unsigned int size)
+{
+	if (m_arena)
+	{
+		// Ranges keep their capacity, only a larger data moves them
+		if (size > m_capacity)
+		{
+			reallocate(data, size, size);
+		}
+		else
+		{
+			update(data, 0, size);
+			m_size = size;
+		}
+		return;
+	}
+	m_size = size;
+	m_capacity = size;
+	RenderState::bind_array_buffer(m_vertex_buffer_id);
+	__glCallVoid(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW));
+}
+
+/// <summary>
+/// Allocates a new storage of the given capacity, and fills its beginning with data.
+/// Meant for buffers that grow, the vertex arrays using this buffer stay valid.
+/// A range of an arena is moved to a new range, so its first vertex changes.
+/// </summary>
+/// <param name="data"></param>
+/// <param name="size">in bytes</param>
+/// <param name="capacity">in bytes</param>
+void VertexBuffer::reallocate(const void* data, unsigned int size, unsigned int capacity)
+{
+	ASSERT(size <= capacity);
+	if (m_arena)
+	{
+		unsigned int vertex_size = m_arena->vertex_size();
+		ASSERT(capacity % vertex_size == 0);
+		if (m_capacity > 0)
+		{
+			m_arena->free_vertices(m_first_vertex, m_capacity / vertex_size);
+		}
+		m_size = size;
+		m_capacity = capacity;
+		m_first_vertex = (capacity > 0) ? m_arena->allocate_vertices(capacity / vertex_size) : 0;
+		m_arena->upload_vertices(data, m_first_vertex * vertex_size, size);
+		return;
+	}
+	m_size = size;
+	m_capacity = capacity;
+	RenderState::bind_array_buffer(m_vertex_buffer_id);
+	__glCallVoid(glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW));
+	__glCallVoid(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+}
+
+/// <summary>
+/// Uploads a sub range of the buffer, the range must fit into the capacity
+/// </summary>
+/// <param name="data"></param>
+/// <param name="offset">in bytes</param>
+/// <param name="size">in bytes</param>
+void VertexBuffer::update(const void* data, unsigned int offset, unsigned int size)
+{
+	ASSERT(offset + size <= m_capacity);
+	if (offset + size > m_size)
+	{
+		m_size = offset + size;
+	}
+	if (m_arena)
+	{
+		m_arena->upload_vertices(data, m_first_vertex * m_arena->vertex_size() + offset, size);
+		return;
+	}
+	RenderState::bind_array_buffer(m_vertex_buffer_id);
+	__glCallVoid(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
 }
 
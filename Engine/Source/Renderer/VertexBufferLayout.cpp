@@ -1,6 +1,9 @@
 #include "Core/ErrorManager.h"
 #include "Renderer/VertexBufferLayout.h"
 #include <glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 unsigned int VertexBufferElement::get_size_of_type(unsigned int type)
 {
@@ -9,11 +12,23 @@ unsigned int VertexBufferElement::get_size_of_type(unsigned int type)
 	case GL_FLOAT:			return sizeof(float);
 	case GL_UNSIGNED_INT:	return sizeof(unsigned int);
 	case GL_UNSIGNED_BYTE:	return sizeof(unsigned char);
+	case GL_UNSIGNED_SHORT:	return sizeof(unsigned short);
+	case GL_HALF_FLOAT:		return sizeof(HalfFloat);
+	case GL_INT_2_10_10_10_REV:	return sizeof(PackedNormal);
 	}
 	ASSERT(false);
 	return 0;
 }
 
+unsigned int VertexBufferElement::size() const
+{
+	if (type == GL_INT_2_10_10_10_REV)
+	{
+		return sizeof(PackedNormal);
+	}
+	return get_size_of_type(type) * count;
+}
+
 template <>
 void VertexBufferLayout::push_back_elements<float>(unsigned int count)
 {
@@ -38,8 +53,106 @@ void VertexBufferLayout::push_back_elements<unsigned char>(unsigned int count)
 	m_tot_elemets += count;
 }
 
+template <>
+void VertexBufferLayout::push_back_elements<unsigned short>(unsigned int count)
+{
+	m_elements.push_back({ GL_UNSIGNED_SHORT, count, GL_TRUE });
+	m_stride += m_elements.back().size();
+	m_tot_elemets += count;
+}
+
+template <>
+void VertexBufferLayout::push_back_elements<HalfFloat>(unsigned int count)
+{
+	m_elements.push_back({ GL_HALF_FLOAT, count, GL_FALSE });
+	m_stride += m_elements.back().size();
+	m_tot_elemets += count;
+}
+
+template <>
+void VertexBufferLayout::push_back_elements<PackedNormal>(unsigned int count)
+{
+	// GL reads the packed value as a whole vec4
+	ASSERT(count == 1);
+	m_elements.push_back({ GL_INT_2_10_10_10_REV, 4, GL_TRUE });
+	m_stride += m_elements.back().size();
+	m_tot_elemets += 4;
+}
+
 const std::vector<VertexBufferElement>& VertexBufferLayout::elements() const { return m_elements; }
 unsigned int VertexBufferLayout::stride() const { return m_stride; }
 unsigned int VertexBufferLayout::tot_elements() const { return m_tot_elemets; };
 
+namespace VertexPacking
+{
+	HalfFloat half(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t float_exponent = (bits >> 23) & 0xFF;
+		uint32_t mantissa = bits & 0x7FFFFF;
+		int exponent = (int)float_exponent - 127 + 15;
+
+		if (float_exponent == 0xFF)
+		{
+			// Infinity stays infinity, NaN stays a quiet NaN
+			return { (uint16_t)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0)) };
+		}
+		if (exponent >= 31)
+		{
+			return { (uint16_t)(sign | 0x7C00) };
+		}
+		if (exponent <= 0)
+		{
+			// Denormal half, the implicit 1 becomes explicit before the shift
+			if (exponent < -10)
+			{
+				return { (uint16_t)sign };
+			}
+			mantissa |= 0x800000;
+			unsigned int shift = (unsigned int)(14 - exponent);
+			uint32_t half_mantissa = mantissa >> shift;
+			uint32_t remainder = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+			{
+				half_mantissa++;
+			}
+			return { (uint16_t)(sign | half_mantissa) };
+		}
+		// Round to nearest even, a carry out of the mantissa correctly bumps the exponent
+		uint32_t result = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+		uint32_t remainder = mantissa & 0x1FFF;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+		{
+			result++;
+		}
+		return { (uint16_t)result };
+	}
 
+	static uint32_t snorm_bits(float value, float max_value, uint32_t mask)
+	{
+		float clamped = std::clamp(value, -1.0f, 1.0f);
+		int quantized = (int)std::lround(clamped * max_value);
+		return (uint32_t)quantized & mask;
+	}
+
+	PackedNormal snorm_10_10_10_2(float x, float y, float z, float w)
+	{
+		return { snorm_bits(x, 511.0f, 0x3FF)
+			| (snorm_bits(y, 511.0f, 0x3FF) << 10)
+			| (snorm_bits(z, 511.0f, 0x3FF) << 20)
+			| (snorm_bits(w, 1.0f, 0x3) << 30) };
+	}
+
+	uint16_t unorm16(float value)
+	{
+		return (uint16_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+	}
+
+	uint8_t unorm8(float value)
+	{
+		return (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+	}
+}